@@ -0,0 +1,132 @@
+// Skinned-crowd throughput: samples a synthetic clip on N skeleton instances
+// and builds their joint palettes, reporting skinned instances per millisecond
+// for thread counts doubling from 1 up to the requested number.
+//
+// Usage: teo_bench_animation [instances] [joints] [frames] [threads]
+
+#include "core/JobSystem.hpp"
+#include "scene/AnimationSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+std::shared_ptr<Skeleton> makeSkeleton(size_t jointCount) {
+    auto skeleton = std::make_shared<Skeleton>();
+    for (size_t j = 0; j < jointCount; ++j) {
+        // Binary tree, parents always precede their children
+        skeleton->parents.push_back(j == 0 ? -1 : static_cast<int>((j - 1) / 2));
+        skeleton->inverseBindMatrices.push_back(glm::mat4(1.0f));
+        skeleton->restTranslations.push_back(glm::vec3(0.0f, 0.1f, 0.0f));
+        skeleton->restRotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        skeleton->restScales.push_back(glm::vec3(1.0f));
+        skeleton->rootParentTransforms.push_back(glm::mat4(1.0f));
+        skeleton->names.push_back("joint" + std::to_string(j));
+    }
+    return skeleton;
+}
+
+std::shared_ptr<AnimationClip> makeClip(size_t jointCount, uint32_t keyCount, float duration) {
+    auto clip = std::make_shared<AnimationClip>();
+    clip->name = "synthetic";
+    clip->duration = duration;
+
+    for (size_t j = 0; j < jointCount; ++j) {
+        for (AnimationPath path : { AnimationPath::Translation, AnimationPath::Rotation }) {
+            AnimationChannel channel;
+            channel.joint = static_cast<uint32_t>(j);
+            channel.path = path;
+            channel.interpolation = AnimationInterpolation::Linear;
+            channel.firstKey = static_cast<uint32_t>(clip->times.size());
+            channel.keyCount = keyCount;
+            channel.firstValue = static_cast<uint32_t>(clip->values.size());
+
+            for (uint32_t k = 0; k < keyCount; ++k) {
+                float t = duration * k / (keyCount - 1);
+                clip->times.push_back(t);
+                if (path == AnimationPath::Rotation) {
+                    float angle = 0.5f * std::sin(t * 6.2831853f + j);
+                    clip->values.push_back(glm::vec4(0.0f, std::sin(angle), 0.0f, std::cos(angle)));
+                } else {
+                    clip->values.push_back(glm::vec4(0.0f, 0.1f + 0.02f * std::sin(t + j), 0.0f, 0.0f));
+                }
+            }
+            clip->channels.push_back(channel);
+        }
+    }
+    return clip;
+}
+
+double runFrames(AnimationSystem& system, int frames) {
+    const float dt = 1.0f / 60.0f;
+
+    // One warm-up frame grows the per-thread scratch buffers
+    system.update(dt);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        system.update(dt);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t instanceCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    size_t jointCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    int frames = argc > 3 ? std::atoi(argv[3]) : 200;
+    unsigned threads = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4])) : 0;
+
+    if (instanceCount == 0 || jointCount == 0 || frames <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [instances] [joints] [frames] [threads]" << std::endl;
+        return 1;
+    }
+
+    auto skeleton = makeSkeleton(jointCount);
+    auto clip = makeClip(jointCount, 30, 2.0f);
+
+    std::cout << "Animation benchmark: " << instanceCount << " instances x " << jointCount
+              << " joints, " << clip->channels.size() << " channels, " << frames << " frames" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms/frame" << std::setw(16) << "instances/ms"
+              << std::setw(10) << "speedup" << std::endl;
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned n = 1; n < threads; n *= 2) {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(threads);
+
+    double singleThreaded = 0.0;
+    for (unsigned threadCount : threadCounts) {
+        JobSystem jobs(threadCount);
+        AnimationSystem system(jobs);
+        for (size_t i = 0; i < instanceCount; ++i) {
+            // Staggered start times so instances don't share cursor positions
+            system.createInstance(skeleton, clip, clip->duration * i / instanceCount);
+        }
+
+        double msPerFrame = runFrames(system, frames);
+        if (threadCount == 1) {
+            singleThreaded = msPerFrame;
+        }
+        std::cout << std::setw(8) << system.getThreadCount()
+                  << std::setw(12) << std::fixed << std::setprecision(3) << msPerFrame
+                  << std::setw(16) << std::setprecision(1) << instanceCount / msPerFrame
+                  << std::setw(9) << std::setprecision(2) << singleThreaded / msPerFrame << "x" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Job system scaling: times a parallel loop of matrix work and a fan-out /
+// fan-in dependency graph for thread counts doubling from 1 up to the
+// requested number, reporting speedup over one thread and stolen jobs.
+//
+// Usage: teo_bench_jobs [items] [rounds] [threads]
+
+#include "core/JobSystem.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Enough arithmetic per item that the loop is compute bound, like skinning or culling
+void transformRange(const std::vector<glm::mat4>& in, std::vector<glm::mat4>& out, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        glm::mat4 m = in[i];
+        for (int k = 0; k < 8; ++k) {
+            m = glm::rotate(m, 0.01f, glm::vec3(0.0f, 1.0f, 0.0f)) * in[i];
+        }
+        out[i] = m;
+    }
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One parallelFor over all items per round
+double runParallelFor(JobSystem& jobs, const std::vector<glm::mat4>& in, std::vector<glm::mat4>& out, int rounds) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        jobs.parallelFor(in.size(), 256, [&](size_t begin, size_t end) {
+            transformRange(in, out, begin, end);
+        });
+    }
+    return millisecondsSince(start) / rounds;
+}
+
+// Per round: a root job fans out one job per chunk, each followed by a
+// dependent job over the same chunk, and a final job joins them all
+double runGraph(JobSystem& jobs, const std::vector<glm::mat4>& in, std::vector<glm::mat4>& out, int rounds) {
+    constexpr size_t kChunk = 512;
+    const size_t chunks = (in.size() + kChunk - 1) / kChunk;
+    std::vector<glm::mat4> scratch(in.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        JobCounter root;
+        JobCounter firstPass;
+        JobCounter secondPass;
+        JobCounter done;
+
+        jobs.run([] {}, &root);
+        for (size_t c = 0; c < chunks; ++c) {
+            const size_t begin = c * kChunk;
+            const size_t end = std::min(begin + kChunk, in.size());
+            jobs.runAfter(root, [&, begin, end] { transformRange(in, scratch, begin, end); }, &firstPass);
+        }
+        for (size_t c = 0; c < chunks; ++c) {
+            const size_t begin = c * kChunk;
+            const size_t end = std::min(begin + kChunk, in.size());
+            jobs.runAfter(firstPass, [&, begin, end] { transformRange(scratch, out, begin, end); }, &secondPass);
+        }
+        jobs.runAfter(secondPass, [] {}, &done);
+        jobs.wait(done);
+        // Counters are destroyed at the end of the round, everything tied to them has finished
+        jobs.wait(secondPass);
+        jobs.wait(firstPass);
+        jobs.wait(root);
+    }
+    return millisecondsSince(start) / rounds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t itemCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+    unsigned threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 0;
+
+    if (itemCount == 0 || rounds <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [items] [rounds] [threads]" << std::endl;
+        return 1;
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<unsigned> threadCounts;
+    for (unsigned n = 1; n < threads; n *= 2) {
+        threadCounts.push_back(n);
+    }
+    threadCounts.push_back(threads);
+
+    std::vector<glm::mat4> in(itemCount);
+    for (size_t i = 0; i < itemCount; ++i) {
+        in[i] = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i % 97), 0.0f, 0.0f));
+    }
+    std::vector<glm::mat4> out(itemCount);
+
+    std::cout << "Job system benchmark: " << itemCount << " items, " << rounds << " rounds" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "for ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "graph ms" << std::setw(10) << "speedup" << std::setw(10) << "stolen" << std::endl;
+
+    double singleFor = 0.0;
+    double singleGraph = 0.0;
+    for (unsigned threadCount : threadCounts) {
+        JobSystem jobs(threadCount);
+
+        // One warm-up round each so worker start-up is not timed
+        runParallelFor(jobs, in, out, 1);
+        runGraph(jobs, in, out, 1);
+        const uint64_t stolenBefore = jobs.getStolenCount();
+
+        double forMs = runParallelFor(jobs, in, out, rounds);
+        double graphMs = runGraph(jobs, in, out, rounds);
+        if (threadCount == 1) {
+            singleFor = forMs;
+            singleGraph = graphMs;
+        }
+
+        std::cout << std::setw(8) << jobs.getThreadCount() << std::fixed
+                  << std::setw(14) << std::setprecision(3) << forMs
+                  << std::setw(9) << std::setprecision(2) << singleFor / forMs << "x"
+                  << std::setw(14) << std::setprecision(3) << graphMs
+                  << std::setw(9) << std::setprecision(2) << singleGraph / graphMs << "x"
+                  << std::setw(10) << (jobs.getStolenCount() - stolenBefore) << std::endl;
+    }
+
+    return 0;
+}
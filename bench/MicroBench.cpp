@@ -0,0 +1,373 @@
+// Loader and kernel microbenchmarks on a generated asset: glTF parse, accessor
+// decode, index widening, image decode, meshlet building, meshlet culling and
+// transform updates. Prints a table and, with --json, writes the results for
+// comparison between builds; --baseline compares against such a file and
+// fails on regressions.
+//
+// Usage: teo_bench [--triangles n] [--primitives n] [--materials n] [--textures n]
+//                  [--texture-size px] [--nodes n] [--filter text] [--min-time ms]
+//                  [--json out.json] [--baseline in.json] [--tolerance t]
+//        teo_bench --generate <out.gltf | out.glb> [asset options]
+
+#include "SyntheticGltf.hpp"
+#include "core/MemoryStats.hpp"
+#include "graphics/Mesh.hpp"
+#include "graphics/Meshlets.hpp"
+#include "loader/GLTFLoader.hpp"
+#include "scene/Transform.hpp"
+
+#include "json.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Result {
+    std::string name;
+    size_t items = 0;  // work per iteration, in the benchmark's own unit
+    const char* unit = "";
+    int iterations = 0;
+    double medianMs = 0.0;
+    double minMs = 0.0;
+    double meanMs = 0.0;
+    double heapAllocations = 0.0;  // per iteration
+};
+
+struct Settings {
+    std::string filter;
+    double minMilliseconds = 200.0;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs fn once to warm up, then at least 5 times and until minMilliseconds have passed
+template <typename Fn>
+bool measure(const Settings& settings, const char* name, size_t items, const char* unit,
+             std::vector<Result>& results, Fn fn) {
+    if (!settings.filter.empty() && std::strstr(name, settings.filter.c_str()) == nullptr) {
+        return false;
+    }
+    fn();
+
+    std::vector<double> times;
+    uint64_t heapAllocations = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (times.size() < 5 || millisecondsSince(start) < settings.minMilliseconds) {
+        const uint64_t heapBefore = MemoryStats::getHeapAllocationCount();
+        const auto iterationStart = std::chrono::steady_clock::now();
+        fn();
+        const double milliseconds = millisecondsSince(iterationStart);
+        heapAllocations += MemoryStats::getHeapAllocationCount() - heapBefore;
+        times.push_back(milliseconds);
+    }
+
+    Result result;
+    result.name = name;
+    result.items = items;
+    result.unit = unit;
+    result.iterations = static_cast<int>(times.size());
+    result.heapAllocations = static_cast<double>(heapAllocations) / times.size();
+    for (double time : times) {
+        result.meanMs += time / times.size();
+    }
+    std::sort(times.begin(), times.end());
+    result.minMs = times.front();
+    result.medianMs = times[times.size() / 2];
+    results.push_back(result);
+
+    std::cout << std::left << std::setw(20) << result.name << std::right << std::fixed
+              << std::setw(8) << result.iterations
+              << std::setw(12) << std::setprecision(3) << result.medianMs
+              << std::setw(12) << std::setprecision(3) << result.minMs
+              << std::setw(14) << std::setprecision(1) << result.items / result.medianMs * 1000.0 / 1.0e6
+              << " M" << std::left << std::setw(10) << (std::string(result.unit) + "/s") << std::right
+              << std::setw(10) << std::setprecision(1) << result.heapAllocations << std::endl;
+    return true;
+}
+
+// Several cameras around the ring of patches, each sees part of it and the rest faces away
+std::vector<glm::mat4> makeViews(const glm::vec3& center, float radius, std::vector<glm::vec3>& positions) {
+    std::vector<glm::mat4> views;
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 4.0f * radius);
+    for (int i = 0; i < 16; ++i) {
+        const float angle = 6.2831853f * i / 16.0f;
+        const glm::vec3 eye = center + glm::vec3(std::sin(angle), 0.3f, std::cos(angle)) * radius * 1.5f;
+        views.push_back(projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)));
+        positions.push_back(eye);
+    }
+    return views;
+}
+
+bool writeResults(const std::string& path, const SyntheticGltf::Desc& desc, const SyntheticGltf::Stats& stats,
+                  const std::vector<Result>& results) {
+    nlohmann::json doc;
+    doc["asset"] = { { "triangles", stats.triangles }, { "vertices", stats.vertices },
+                     { "primitives", desc.primitives }, { "materials", desc.materials },
+                     { "textures", desc.textures }, { "textureSize", desc.textureSize } };
+    doc["benchmarks"] = nlohmann::json::array();
+    for (const Result& result : results) {
+        doc["benchmarks"].push_back({
+            { "name", result.name },
+            { "items", result.items },
+            { "unit", result.unit },
+            { "iterations", result.iterations },
+            { "median_ms", result.medianMs },
+            { "min_ms", result.minMs },
+            { "mean_ms", result.meanMs },
+            { "items_per_second", result.items / result.medianMs * 1000.0 },
+            { "heap_allocations", result.heapAllocations },
+        });
+    }
+
+    std::ofstream file(path);
+    file << doc.dump(2) << std::endl;
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Returns the number of benchmarks whose median is slower than the baseline's by more than tolerance
+int compareBaseline(const std::string& path, double tolerance, const std::vector<Result>& results) {
+    std::ifstream file(path);
+    nlohmann::json baseline = nlohmann::json::parse(file, nullptr, false);
+    if (baseline.is_discarded() || !baseline.contains("benchmarks")) {
+        std::cerr << "Failed to read baseline " << path << std::endl;
+        return -1;
+    }
+
+    int regressions = 0;
+    std::cout << std::endl << "Against " << path << " (tolerance " << tolerance * 100.0 << "%):" << std::endl;
+    for (const Result& result : results) {
+        for (const auto& entry : baseline["benchmarks"]) {
+            if (entry.value("name", "") != result.name) {
+                continue;
+            }
+            const double before = entry.value("median_ms", 0.0);
+            const double ratio = before > 0.0 ? result.medianMs / before : 1.0;
+            const bool regressed = ratio > 1.0 + tolerance;
+            regressions += regressed ? 1 : 0;
+            std::cout << std::left << std::setw(20) << result.name << std::right << std::fixed
+                      << std::setw(10) << std::setprecision(3) << before << " ->"
+                      << std::setw(10) << result.medianMs << " ms"
+                      << std::setw(9) << std::setprecision(2) << ratio << "x"
+                      << (regressed ? "  REGRESSION" : "") << std::endl;
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SyntheticGltf::Desc desc;
+    Settings settings;
+    size_t nodeCount = 10000;
+    std::string generatePath;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        ++i;
+        if (arg == "--triangles") {
+            desc.triangles = std::strtoul(value, nullptr, 10);
+        } else if (arg == "--primitives") {
+            desc.primitives = std::strtoul(value, nullptr, 10);
+        } else if (arg == "--materials") {
+            desc.materials = std::strtoul(value, nullptr, 10);
+        } else if (arg == "--textures") {
+            desc.textures = std::strtoul(value, nullptr, 10);
+        } else if (arg == "--texture-size") {
+            desc.textureSize = std::atoi(value);
+        } else if (arg == "--nodes") {
+            nodeCount = std::strtoul(value, nullptr, 10);
+        } else if (arg == "--filter") {
+            settings.filter = value;
+        } else if (arg == "--min-time") {
+            settings.minMilliseconds = std::atof(value);
+        } else if (arg == "--json") {
+            jsonPath = value;
+        } else if (arg == "--baseline") {
+            baselinePath = value;
+        } else if (arg == "--tolerance") {
+            tolerance = std::atof(value);
+        } else if (arg == "--generate") {
+            generatePath = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (desc.triangles == 0 || desc.primitives == 0 || desc.textureSize <= 0 || nodeCount == 0) {
+        std::cerr << "Triangle, primitive, texture size and node counts must be positive" << std::endl;
+        return 1;
+    }
+
+    SyntheticGltf::Stats stats;
+    if (!generatePath.empty()) {
+        if (!SyntheticGltf::write(generatePath, desc, &stats)) {
+            return 1;
+        }
+        std::cout << "Wrote " << generatePath << ": " << stats.triangles << " triangles, " << stats.vertices
+                  << " vertices, " << MemoryStats::formatBytes(stats.bytes) << std::endl;
+        return 0;
+    }
+
+    // The same asset as .gltf (external .bin and PNGs, parsed by tinygltf) and as .glb (memory-mapped)
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "teo_bench_assets";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create " << directory.string() << ": " << error.message() << std::endl;
+        return 1;
+    }
+    const std::string gltfPath = (directory / "synthetic.gltf").string();
+    const std::string glbPath = (directory / "synthetic.glb").string();
+    if (!SyntheticGltf::write(gltfPath, desc, &stats) || !SyntheticGltf::write(glbPath, desc)) {
+        return 1;
+    }
+
+    std::cout << "Asset: " << stats.triangles << " triangles, " << stats.vertices << " vertices, "
+              << desc.primitives << " primitives, " << desc.materials << " materials, " << desc.textures
+              << " textures of " << desc.textureSize << "px" << std::endl;
+    std::cout << std::left << std::setw(20) << "benchmark" << std::right << std::setw(8) << "iters"
+              << std::setw(12) << "median ms" << std::setw(12) << "min ms" << std::setw(14) << "throughput"
+              << std::setw(12) << "" << std::setw(10) << "allocs" << std::endl;
+
+    std::vector<Result> results;
+    GLTFLoader loader;
+
+    // tinygltf decodes the .gltf's PNGs while parsing, the mapped .glb leaves them for upload
+    measure(settings, "parse_gltf", stats.triangles, "tris", results, [&] {
+        ParsedGltf parsed = loader.parse(gltfPath);
+    });
+    measure(settings, "parse_glb", stats.triangles, "tris", results, [&] {
+        ParsedGltf parsed = loader.parse(glbPath);
+    });
+
+    const ParsedGltf parsed = loader.parse(glbPath);
+    if (!parsed.isValid()) {
+        return 1;
+    }
+
+    std::vector<std::vector<Vertex>> vertices;
+    std::vector<std::vector<unsigned int>> indices;
+    measure(settings, "decode_vertices", stats.vertices, "verts", results, [&] {
+        GLTFLoader::readGeometry(parsed, &vertices, nullptr);
+    });
+    measure(settings, "widen_indices", stats.triangles * 3, "indices", results, [&] {
+        GLTFLoader::readGeometry(parsed, nullptr, &indices);
+    });
+
+    if (desc.textures > 0) {
+        const size_t pixels = desc.textures * size_t(desc.textureSize) * desc.textureSize;
+        measure(settings, "decode_images", pixels, "pixels", results, [&] {
+            GLTFLoader::decodeImages(parsed);
+        });
+    }
+
+    // Kernels below run on the decoded geometry
+    GLTFLoader::readGeometry(parsed, &vertices, &indices);
+
+    // Meshlet building reorders indices in place, every run starts from the loaded order
+    std::vector<std::vector<unsigned int>> clustered = indices;
+    std::vector<std::vector<Meshlet>> meshlets(vertices.size());
+    auto buildMeshlets = [&] {
+        for (size_t p = 0; p < vertices.size(); ++p) {
+            std::copy(indices[p].begin(), indices[p].end(), clustered[p].begin());
+            meshlets[p] = Meshlets::build(vertices[p].data(), vertices[p].size(), clustered[p].data(),
+                                          clustered[p].size());
+        }
+    };
+    if (!measure(settings, "build_meshlets", stats.triangles, "tris", results, buildMeshlets)) {
+        buildMeshlets();
+    }
+
+    size_t meshletCount = 0;
+    glm::vec3 boundsMin(1.0e30f);
+    glm::vec3 boundsMax(-1.0e30f);
+    for (size_t p = 0; p < vertices.size(); ++p) {
+        meshletCount += meshlets[p].size();
+        for (const Vertex& vertex : vertices[p]) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+    }
+
+    std::vector<glm::vec3> cameraPositions;
+    const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    const std::vector<glm::mat4> views = makeViews(center, glm::length(boundsMax - boundsMin) * 0.5f, cameraPositions);
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    measure(settings, "cull_meshlets", meshletCount * views.size(), "tests", results, [&] {
+        for (size_t v = 0; v < views.size(); ++v) {
+            const Meshlets::CullView view = Meshlets::makeCullView(views[v], cameraPositions[v], glm::mat4(1.0f));
+            for (const auto& primitiveMeshlets : meshlets) {
+                counts.clear();
+                offsets.clear();
+                Meshlets::cull(primitiveMeshlets, view, counts, offsets);
+            }
+        }
+    });
+    // Same views culled together, as Renderer does for several views of one frame
+    std::vector<Meshlets::CullView> cullViews;
+    for (size_t v = 0; v < views.size(); ++v) {
+        cullViews.push_back(Meshlets::makeCullView(views[v], cameraPositions[v], glm::mat4(1.0f)));
+    }
+    measure(settings, "cull_meshlets_union", meshletCount, "meshlets", results, [&] {
+        for (const auto& primitiveMeshlets : meshlets) {
+            counts.clear();
+            offsets.clear();
+            Meshlets::cull(primitiveMeshlets, cullViews.data(), cullViews.size(), counts, offsets);
+        }
+    });
+
+    // Node hierarchy four children wide, every local transform changes each frame
+    std::vector<Transform> locals(nodeCount);
+    std::vector<glm::mat4> worlds(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        locals[i].setPosition(glm::vec3(static_cast<float>(i % 7), 0.1f, 0.0f));
+    }
+    const glm::quat spin = glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+    measure(settings, "update_transforms", nodeCount, "nodes", results, [&] {
+        for (size_t i = 0; i < nodeCount; ++i) {
+            locals[i].rotate(spin);
+            const glm::mat4& local = locals[i].getMatrix();
+            worlds[i] = i == 0 ? local : worlds[(i - 1) / 4] * local;
+        }
+    });
+
+    if (!jsonPath.empty() && !writeResults(jsonPath, desc, stats, results)) {
+        return 1;
+    }
+    if (!baselinePath.empty()) {
+        const int regressions = compareBaseline(baselinePath, tolerance, results);
+        if (regressions != 0) {
+            return regressions < 0 ? 1 : 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,303 @@
+#include "SyntheticGltf.hpp"
+
+#include "json.hpp"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace SyntheticGltf {
+
+namespace {
+
+constexpr float kPi = 3.14159265f;
+constexpr float kPatchSize = 2.0f;
+
+constexpr int kArrayBuffer = 34962;
+constexpr int kElementArrayBuffer = 34963;
+constexpr int kUnsignedShort = 5123;
+constexpr int kUnsignedInt = 5125;
+constexpr int kFloat = 5126;
+
+// Appends at a 4-byte boundary, which every accessor here is aligned to, returns the offset
+size_t append(std::vector<unsigned char>& bin, const void* data, size_t bytes) {
+    bin.resize((bin.size() + 3) & ~size_t(3), 0);
+    const size_t offset = bin.size();
+    bin.resize(offset + bytes);
+    std::memcpy(bin.data() + offset, data, bytes);
+    return offset;
+}
+
+int addView(nlohmann::json& doc, size_t offset, size_t bytes, int target) {
+    nlohmann::json view = { { "buffer", 0 }, { "byteOffset", offset }, { "byteLength", bytes } };
+    if (target) {
+        view["target"] = target;
+    }
+    doc["bufferViews"].push_back(view);
+    return static_cast<int>(doc["bufferViews"].size() - 1);
+}
+
+int addAccessor(nlohmann::json& doc, int view, int componentType, size_t count, const char* type) {
+    doc["accessors"].push_back({ { "bufferView", view }, { "componentType", componentType },
+                                 { "count", count }, { "type", type } });
+    return static_cast<int>(doc["accessors"].size() - 1);
+}
+
+// Checkerboard in a per-texture tint with some noise, so PNG compression has real work to do
+std::vector<unsigned char> makeTexture(size_t index, int size) {
+    const float hue = static_cast<float>(index) * 2.4f;
+    const unsigned char tint[3] = {
+        static_cast<unsigned char>(128 + 100 * std::sin(hue)),
+        static_cast<unsigned char>(128 + 100 * std::sin(hue + 2.1f)),
+        static_cast<unsigned char>(128 + 100 * std::sin(hue + 4.2f)),
+    };
+
+    std::vector<unsigned char> pixels(size_t(size) * size * 4);
+    uint32_t seed = static_cast<uint32_t>(index) * 2654435761u + 1;
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = static_cast<int>(seed >> 28) - 8;
+            const bool dark = ((x * 8 / size) + (y * 8 / size)) % 2 != 0;
+            unsigned char* out = pixels.data() + (size_t(y) * size + x) * 4;
+            for (int c = 0; c < 3; ++c) {
+                const int value = (dark ? tint[c] / 3 : tint[c]) + noise;
+                out[c] = static_cast<unsigned char>(std::clamp(value, 0, 255));
+            }
+            out[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+std::vector<unsigned char> encodePng(const std::vector<unsigned char>& pixels, int size) {
+    std::vector<unsigned char> png;
+    stbi_write_png_to_func(
+        [](void* context, void* data, int bytes) {
+            auto* out = static_cast<std::vector<unsigned char>*>(context);
+            const auto* begin = static_cast<const unsigned char*>(data);
+            out->insert(out->end(), begin, begin + bytes);
+        },
+        &png, size, size, 4, pixels.data(), size * 4);
+    return png;
+}
+
+// One displaced grid patch of at least triangleCount triangles, turned by
+// angle around Y and pushed out to radius so its front faces away from the ring's center
+void addPrimitive(nlohmann::json& doc, std::vector<unsigned char>& bin, size_t triangleCount,
+                  float angle, float radius, int material, Stats& stats) {
+    const size_t quads = std::max<size_t>((triangleCount + 1) / 2, 1);
+    const size_t cols = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(quads))));
+    const size_t rows = (quads + cols - 1) / cols;
+    const size_t vertexCount = (cols + 1) * (rows + 1);
+
+    const float sinAngle = std::sin(angle);
+    const float cosAngle = std::cos(angle);
+    auto turn = [&](float x, float y, float z) {
+        return std::array<float, 3>{ x * cosAngle + z * sinAngle, y, -x * sinAngle + z * cosAngle };
+    };
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    positions.reserve(vertexCount * 3);
+    normals.reserve(vertexCount * 3);
+    texCoords.reserve(vertexCount * 2);
+    float minimum[3] = { 1.0e30f, 1.0e30f, 1.0e30f };
+    float maximum[3] = { -1.0e30f, -1.0e30f, -1.0e30f };
+
+    for (size_t row = 0; row <= rows; ++row) {
+        for (size_t col = 0; col <= cols; ++col) {
+            const float u = static_cast<float>(col) / cols;
+            const float v = static_cast<float>(row) / rows;
+
+            // Height field z = a sin(ku) cos(kv), normal from its slopes
+            const float amplitude = 0.1f;
+            const float k = 6.0f * kPi;
+            const float z = amplitude * std::sin(k * u) * std::cos(k * v);
+            const float dzdx = amplitude * k * std::cos(k * u) * std::cos(k * v) / kPatchSize;
+            const float dzdy = -amplitude * k * std::sin(k * u) * std::sin(k * v) / kPatchSize;
+            const float length = std::sqrt(dzdx * dzdx + dzdy * dzdy + 1.0f);
+
+            const auto position = turn((u - 0.5f) * kPatchSize, (v - 0.5f) * kPatchSize, z + radius);
+            const auto normal = turn(-dzdx / length, -dzdy / length, 1.0f / length);
+            for (int c = 0; c < 3; ++c) {
+                positions.push_back(position[c]);
+                normals.push_back(normal[c]);
+                minimum[c] = std::min(minimum[c], position[c]);
+                maximum[c] = std::max(maximum[c], position[c]);
+            }
+            texCoords.push_back(u);
+            texCoords.push_back(1.0f - v);
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(quads * 6);
+    for (size_t q = 0; q < quads; ++q) {
+        const uint32_t a = static_cast<uint32_t>((q / cols) * (cols + 1) + q % cols);
+        const uint32_t b = a + 1;
+        const uint32_t c = a + static_cast<uint32_t>(cols) + 2;
+        const uint32_t d = a + static_cast<uint32_t>(cols) + 1;
+        indices.insert(indices.end(), { a, b, c, a, c, d });
+    }
+
+    const int positionAccessor = addAccessor(
+        doc, addView(doc, append(bin, positions.data(), positions.size() * 4), positions.size() * 4, kArrayBuffer),
+        kFloat, vertexCount, "VEC3");
+    doc["accessors"][positionAccessor]["min"] = { minimum[0], minimum[1], minimum[2] };
+    doc["accessors"][positionAccessor]["max"] = { maximum[0], maximum[1], maximum[2] };
+    const int normalAccessor = addAccessor(
+        doc, addView(doc, append(bin, normals.data(), normals.size() * 4), normals.size() * 4, kArrayBuffer),
+        kFloat, vertexCount, "VEC3");
+    const int texCoordAccessor = addAccessor(
+        doc, addView(doc, append(bin, texCoords.data(), texCoords.size() * 4), texCoords.size() * 4, kArrayBuffer),
+        kFloat, vertexCount, "VEC2");
+
+    int indexAccessor;
+    if (vertexCount <= 0xFFFF) {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        const size_t bytes = narrow.size() * sizeof(uint16_t);
+        indexAccessor = addAccessor(doc, addView(doc, append(bin, narrow.data(), bytes), bytes, kElementArrayBuffer),
+                                    kUnsignedShort, narrow.size(), "SCALAR");
+    } else {
+        const size_t bytes = indices.size() * sizeof(uint32_t);
+        indexAccessor = addAccessor(doc, addView(doc, append(bin, indices.data(), bytes), bytes, kElementArrayBuffer),
+                                    kUnsignedInt, indices.size(), "SCALAR");
+    }
+
+    nlohmann::json primitive = {
+        { "attributes", { { "POSITION", positionAccessor }, { "NORMAL", normalAccessor },
+                          { "TEXCOORD_0", texCoordAccessor } } },
+        { "indices", indexAccessor },
+    };
+    if (material >= 0) {
+        primitive["material"] = material;
+    }
+    doc["meshes"].push_back({ { "primitives", nlohmann::json::array({ primitive }) } });
+
+    stats.triangles += quads * 2;
+    stats.vertices += vertexCount;
+}
+
+bool writeFile(const std::filesystem::path& path, const void* data, size_t bytes, Stats& stats) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    if (!file) {
+        std::cerr << "Failed to write " << path.string() << std::endl;
+        return false;
+    }
+    stats.bytes += bytes;
+    return true;
+}
+
+} // namespace
+
+bool write(const std::string& path, const Desc& desc, Stats* stats) {
+    const std::filesystem::path filePath(path);
+    const bool glb = filePath.extension() == ".glb";
+    const std::string stem = filePath.stem().string();
+    const size_t primitiveCount = std::max<size_t>(desc.primitives, 1);
+    const size_t textureSize = static_cast<size_t>(std::max(desc.textureSize, 1));
+
+    Stats written;
+    nlohmann::json doc = {
+        { "asset", { { "version", "2.0" }, { "generator", "teo_bench" } } },
+        { "scene", 0 },
+        { "bufferViews", nlohmann::json::array() },
+        { "accessors", nlohmann::json::array() },
+        { "meshes", nlohmann::json::array() },
+        { "nodes", nlohmann::json::array() },
+    };
+    std::vector<unsigned char> bin;
+
+    for (size_t t = 0; t < desc.textures; ++t) {
+        const std::vector<unsigned char> png = encodePng(makeTexture(t, static_cast<int>(textureSize)),
+                                                         static_cast<int>(textureSize));
+        if (glb) {
+            const int view = addView(doc, append(bin, png.data(), png.size()), png.size(), 0);
+            doc["images"].push_back({ { "bufferView", view }, { "mimeType", "image/png" } });
+        } else {
+            const std::string uri = stem + "_" + std::to_string(t) + ".png";
+            if (!writeFile(filePath.parent_path() / uri, png.data(), png.size(), written)) {
+                return false;
+            }
+            doc["images"].push_back({ { "uri", uri } });
+        }
+        doc["textures"].push_back({ { "source", t }, { "sampler", 0 } });
+    }
+    if (desc.textures > 0) {
+        doc["samplers"].push_back({ { "magFilter", 9729 }, { "minFilter", 9987 } });
+    }
+
+    for (size_t m = 0; m < desc.materials; ++m) {
+        const float shade = 0.5f + 0.5f * static_cast<float>(m) / desc.materials;
+        nlohmann::json pbr = { { "baseColorFactor", { shade, shade, shade, 1.0f } },
+                               { "metallicFactor", 0.0f }, { "roughnessFactor", 0.8f } };
+        if (desc.textures > 0) {
+            pbr["baseColorTexture"] = { { "index", m % desc.textures } };
+        }
+        doc["materials"].push_back({ { "pbrMetallicRoughness", pbr } });
+    }
+
+    // Patches side by side around the ring with a little room between them
+    const float radius = std::max(2.0f, 1.2f * kPatchSize * primitiveCount / (2.0f * kPi));
+    const size_t trianglesPerPrimitive = (desc.triangles + primitiveCount - 1) / primitiveCount;
+    nlohmann::json sceneNodes = nlohmann::json::array();
+    for (size_t p = 0; p < primitiveCount; ++p) {
+        const float angle = 2.0f * kPi * static_cast<float>(p) / primitiveCount;
+        const int material = desc.materials > 0 ? static_cast<int>(p % desc.materials) : -1;
+        addPrimitive(doc, bin, trianglesPerPrimitive, angle, radius, material, written);
+        doc["nodes"].push_back({ { "mesh", p } });
+        sceneNodes.push_back(p);
+    }
+    doc["scenes"] = nlohmann::json::array({ { { "nodes", sceneNodes } } });
+
+    bin.resize((bin.size() + 3) & ~size_t(3), 0);
+    nlohmann::json buffer = { { "byteLength", bin.size() } };
+    if (!glb) {
+        buffer["uri"] = stem + ".bin";
+    }
+    doc["buffers"] = nlohmann::json::array({ buffer });
+
+    std::string json = doc.dump();
+    if (glb) {
+        // Header, JSON chunk padded with spaces, BIN chunk
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+        const uint32_t header[5] = {
+            0x46546C67u, 2u, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()),
+            static_cast<uint32_t>(json.size()), 0x4E4F534Au,
+        };
+        const uint32_t binHeader[2] = { static_cast<uint32_t>(bin.size()), 0x004E4942u };
+
+        std::vector<unsigned char> file(sizeof(header) + json.size() + sizeof(binHeader) + bin.size());
+        unsigned char* out = file.data();
+        std::memcpy(out, header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, json.data(), json.size());
+        out += json.size();
+        std::memcpy(out, binHeader, sizeof(binHeader));
+        out += sizeof(binHeader);
+        std::memcpy(out, bin.data(), bin.size());
+        if (!writeFile(filePath, file.data(), file.size(), written)) {
+            return false;
+        }
+    } else if (!writeFile(filePath.parent_path() / (stem + ".bin"), bin.data(), bin.size(), written) ||
+               !writeFile(filePath, json.data(), json.size(), written)) {
+        return false;
+    }
+
+    if (stats) {
+        *stats = written;
+    }
+    return true;
+}
+
+} // namespace SyntheticGltf
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Generates glTF files of a chosen size for the benchmarks: displaced grid
+// patches arranged in a ring facing outwards, one mesh and node per
+// primitive, materials cycling over procedural PNG textures.
+namespace SyntheticGltf {
+
+struct Desc {
+    size_t triangles = 200000;  // spread evenly over the primitives, rounded up to whole quads
+    size_t primitives = 16;
+    size_t materials = 8;
+    size_t textures = 4;
+    int textureSize = 512;
+};
+
+// What was actually written
+struct Stats {
+    size_t triangles = 0;
+    size_t vertices = 0;
+    size_t bytes = 0;  // all files
+};
+
+// .glb writes one self-contained file, anything else a .gltf with its .bin
+// and PNGs next to it. Indices are 16-bit where a primitive allows it.
+bool write(const std::string& path, const Desc& desc, Stats* stats = nullptr);
+
+} // namespace SyntheticGltf
@@ -3,36 +3,234 @@
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+#if defined(CLUSTERED_LIGHTING) || defined(SHADOWS)
+in float ViewDepth;
+#endif
 
 out vec4 FragColor;
 
+// Factors of every material, three texels per entry, see MaterialTable
+uniform samplerBuffer materials;
+uniform int materialIndex;
+// Culling is off for double-sided materials, back faces are lit from behind
+uniform bool doubleSided;
+
+#ifdef HAS_BASE_COLOR_TEXTURE
 uniform sampler2D baseColorTexture;
-uniform vec4 baseColorFactor;
-uniform bool hasTexture;
+#endif
+#ifdef HAS_BASE_COLOR_ARRAY
+// Shared by every material whose texture is in the same size class, see TextureArray
+uniform sampler2DArray baseColorArray;
+uniform int baseColorLayer;
+#endif
+#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
+uniform sampler2D metallicRoughnessTexture;
+#endif
+#ifdef HAS_NORMAL_TEXTURE
+uniform sampler2D normalTexture;
+#endif
+#ifdef HAS_OCCLUSION_TEXTURE
+uniform sampler2D occlusionTexture;
+#endif
+#ifdef HAS_EMISSIVE_TEXTURE
+uniform sampler2D emissiveTexture;
+#endif
 
 uniform vec3 lightDir;
 uniform vec3 lightColor;
 uniform vec3 ambientColor;
 uniform vec3 viewPos;
 
+const float PI = 3.14159265;
+
+struct Surface {
+    vec3 diffuseColor;
+    vec3 f0;      // reflectance at normal incidence
+    float alpha;  // roughness squared
+};
+
+// glTF metallic-roughness BRDF (Lambert, GGX, Smith-Schlick, Schlick Fresnel)
+// times N.L, scaled by pi so a white Lambertian surface facing the light
+// reflects exactly the light color
+vec3 shade(Surface surface, vec3 norm, vec3 viewDir, vec3 L) {
+    float NdotL = max(dot(norm, L), 0.0);
+    if (NdotL <= 0.0) {
+        return vec3(0.0);
+    }
+    vec3 H = normalize(L + viewDir);
+    float NdotV = max(dot(norm, viewDir), 0.0001);
+    float NdotH = max(dot(norm, H), 0.0);
+    float VdotH = max(dot(viewDir, H), 0.0);
+
+    float a2 = surface.alpha * surface.alpha;
+    float d = NdotH * NdotH * (a2 - 1.0) + 1.0;
+    float distribution = a2 / (PI * d * d);
+    float k = surface.alpha * 0.5;
+    float visibility = 1.0 / (4.0 * (NdotL * (1.0 - k) + k) * (NdotV * (1.0 - k) + k));
+    vec3 fresnel = surface.f0 + (1.0 - surface.f0) * pow(1.0 - VdotH, 5.0);
+
+    vec3 diffuse = (1.0 - fresnel) * surface.diffuseColor;
+    return (diffuse + PI * distribution * visibility * fresnel) * NdotL;
+}
+
+#ifdef HAS_NORMAL_TEXTURE
+// Vertices carry no tangents, the frame comes from screen-space derivatives
+vec3 perturbNormal(vec3 norm, vec3 tangentNormal) {
+    vec3 dpdx = dFdx(FragPos);
+    vec3 dpdy = dFdy(FragPos);
+    vec2 dudx = dFdx(TexCoord);
+    vec2 dudy = dFdy(TexCoord);
+    float side = dudx.x * dudy.y - dudy.x * dudx.y < 0.0 ? -1.0 : 1.0;
+    // Direction of increasing u
+    vec3 t = (dudy.y * dpdx - dudx.y * dpdy) * side;
+    t -= norm * dot(norm, t);
+    if (dot(t, t) < 1e-12) {
+        return norm;  // degenerate UVs
+    }
+    t = normalize(t);
+    // glTF's bitangent points toward decreasing v, also on mirrored UVs
+    vec3 b = cross(norm, t) * -side;
+    return normalize(mat3(t, b, norm) * tangentNormal);
+}
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+// Point and spot lights binned into froxels, see ClusteredLighting.
+// Each light is three texels: position + range, color * intensity + cone
+// scale, direction + cone offset. Point lights have scale 0, offset 1.
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+uniform ivec3 clusterDims;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepthParams;  // slice = log(depth) * x + y
+
+vec3 clusteredLighting(Surface surface, vec3 norm, vec3 viewDir) {
+    ivec3 cell = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize),
+                       int(log(ViewDepth) * clusterDepthParams.x + clusterDepthParams.y));
+    cell = clamp(cell, ivec3(0), clusterDims - 1);
+    int cluster = (cell.z * clusterDims.y + cell.y) * clusterDims.x + cell.x;
+    uvec2 range = texelFetch(clusterGrid, cluster).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).x) * 3;
+        vec4 positionRange = texelFetch(clusterLights, light);
+        vec4 colorScale = texelFetch(clusterLights, light + 1);
+        vec4 directionOffset = texelFetch(clusterLights, light + 2);
+
+        vec3 toLight = positionRange.xyz - FragPos;
+        float dist2 = max(dot(toLight, toLight), 0.0001);
+        vec3 L = toLight * inversesqrt(dist2);
+
+        // Inverse square falloff windowed to reach zero at the range (glTF recommendation)
+        float ratio2 = dist2 / (positionRange.w * positionRange.w);
+        float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+        float cone = clamp(dot(directionOffset.xyz, -L) * colorScale.w + directionOffset.w, 0.0, 1.0);
+        float attenuation = window * window * cone * cone / dist2;
+
+        result += shade(surface, norm, viewDir, L) * attenuation * colorScale.rgb;
+    }
+    return result;
+}
+#endif
+
+#ifdef SHADOWS
+// Directional light cascades, see CascadedShadowMaps
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[4];
+uniform vec4 cascadeSplits;        // far view depth of each cascade
+uniform vec4 shadowNormalOffsets;  // world units, per cascade
+
+float shadowFactor(vec3 norm) {
+    int cascade = 0;
+    while (cascade < 3 && ViewDepth > cascadeSplits[cascade]) {
+        ++cascade;
+    }
+    if (ViewDepth > cascadeSplits[3]) {
+        return 1.0;
+    }
+
+    vec4 clip = shadowMatrices[cascade] * vec4(FragPos + norm * shadowNormalOffsets[cascade], 1.0);
+    vec3 coord = clip.xyz / clip.w * 0.5 + 0.5;
+
+    // 3x3 taps of hardware 2x2 PCF
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+        }
+    }
+    return lit / 9.0;
+}
+#endif
+
 void main() {
-    vec4 baseColor = baseColorFactor;
-    if (hasTexture) {
-        baseColor *= texture(baseColorTexture, TexCoord);
+    int material = materialIndex * 3;
+    vec4 baseColor = texelFetch(materials, material);
+    vec4 emissiveCutoff = texelFetch(materials, material + 1);
+    vec4 metallicRoughness = texelFetch(materials, material + 2);
+
+#ifdef HAS_BASE_COLOR_TEXTURE
+    baseColor *= texture(baseColorTexture, TexCoord);
+#endif
+#ifdef HAS_BASE_COLOR_ARRAY
+    baseColor *= texture(baseColorArray, vec3(TexCoord, float(baseColorLayer)));
+#endif
+#ifdef ALPHA_MASK
+    if (baseColor.a < emissiveCutoff.w) {
+        discard;
     }
+    baseColor.a = 1.0;
+#endif
 
-    vec3 norm = normalize(Normal);
-    vec3 lightDirection = normalize(-lightDir);
+    float metallic = metallicRoughness.x;
+    float roughness = metallicRoughness.y;
+#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
+    vec4 metallicRoughnessSample = texture(metallicRoughnessTexture, TexCoord);
+    roughness *= metallicRoughnessSample.g;
+    metallic *= metallicRoughnessSample.b;
+#endif
+    roughness = clamp(roughness, 0.05, 1.0);
+    metallic = clamp(metallic, 0.0, 1.0);
 
-    float diff = max(dot(norm, lightDirection), 0.0);
-    vec3 diffuse = diff * lightColor;
+    Surface surface;
+    surface.diffuseColor = baseColor.rgb * (1.0 - metallic);
+    surface.f0 = mix(vec3(0.04), baseColor.rgb, metallic);
+    surface.alpha = roughness * roughness;
 
+    vec3 geometricNormal = normalize(Normal);
+    vec3 norm = geometricNormal;
+#ifdef HAS_NORMAL_TEXTURE
+    vec3 tangentNormal = texture(normalTexture, TexCoord).xyz * 2.0 - 1.0;
+    tangentNormal.xy *= metallicRoughness.z;
+    norm = perturbNormal(norm, tangentNormal);
+#endif
+    if (doubleSided && !gl_FrontFacing) {
+        geometricNormal = -geometricNormal;
+        norm = -norm;
+    }
     vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDirection, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-    vec3 specular = spec * lightColor * 0.3;
+    vec3 lightDirection = normalize(-lightDir);
+
+    vec3 direct = shade(surface, norm, viewDir, lightDirection) * lightColor;
+#ifdef SHADOWS
+    direct *= shadowFactor(geometricNormal);
+#endif
+#ifdef CLUSTERED_LIGHTING
+    direct += clusteredLighting(surface, norm, viewDir);
+#endif
+
+    vec3 ambient = ambientColor * baseColor.rgb;
+#ifdef HAS_OCCLUSION_TEXTURE
+    ambient *= mix(1.0, texture(occlusionTexture, TexCoord).r, metallicRoughness.w);
+#endif
 
-    vec3 result = (ambientColor + diffuse + specular) * baseColor.rgb;
+    vec3 emissive = emissiveCutoff.rgb;
+#ifdef HAS_EMISSIVE_TEXTURE
+    emissive *= texture(emissiveTexture, TexCoord).rgb;
+#endif
 
-    FragColor = vec4(result, baseColor.a);
+    FragColor = vec4(ambient + direct + emissive, baseColor.a);
 }
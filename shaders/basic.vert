@@ -3,20 +3,63 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+#ifdef SKINNING
+layout (location = 3) in uvec4 aJoints;
+layout (location = 4) in vec4 aWeights;
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+#if defined(CLUSTERED_LIGHTING) || defined(SHADOWS)
+out float ViewDepth;
+#endif
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat3 normalMatrix;
 
+// Must match depth.vert bit for bit, the opaque pass tests GL_EQUAL against the pre-pass
+invariant gl_Position;
+
+#ifdef SKINNING
+// Three rows of an affine matrix per joint, see AnimationSystem
+uniform samplerBuffer jointPalette;
+uniform int jointOffset;
+
+mat4 jointMatrix(uint joint) {
+    int base = (jointOffset + int(joint)) * 3;
+    vec4 r0 = texelFetch(jointPalette, base);
+    vec4 r1 = texelFetch(jointPalette, base + 1);
+    vec4 r2 = texelFetch(jointPalette, base + 2);
+    return mat4(vec4(r0.x, r1.x, r2.x, 0.0),
+                vec4(r0.y, r1.y, r2.y, 0.0),
+                vec4(r0.z, r1.z, r2.z, 0.0),
+                vec4(r0.w, r1.w, r2.w, 1.0));
+}
+#endif
+
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = normalMatrix * aNormal;
+    vec4 localPos = vec4(aPos, 1.0);
+    vec3 localNormal = aNormal;
+
+#ifdef SKINNING
+    mat4 skin = aWeights.x * jointMatrix(aJoints.x)
+              + aWeights.y * jointMatrix(aJoints.y)
+              + aWeights.z * jointMatrix(aJoints.z)
+              + aWeights.w * jointMatrix(aJoints.w);
+    localPos = skin * localPos;
+    localNormal = mat3(skin) * localNormal;
+#endif
+
+    FragPos = vec3(model * localPos);
+    Normal = normalMatrix * localNormal;
     TexCoord = aTexCoord;
 
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    vec4 eyePos = view * vec4(FragPos, 1.0);
+#if defined(CLUSTERED_LIGHTING) || defined(SHADOWS)
+    ViewDepth = -eyePos.z;
+#endif
+    gl_Position = projection * eyePos;
 }
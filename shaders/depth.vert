@@ -0,0 +1,48 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+#ifdef SKINNING
+layout (location = 3) in uvec4 aJoints;
+layout (location = 4) in vec4 aWeights;
+#endif
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Depth pre-pass results are tested with GL_EQUAL against basic.vert, both
+// must compute gl_Position with the same expression
+invariant gl_Position;
+
+#ifdef SKINNING
+// Three rows of an affine matrix per joint, see AnimationSystem
+uniform samplerBuffer jointPalette;
+uniform int jointOffset;
+
+mat4 jointMatrix(uint joint) {
+    int base = (jointOffset + int(joint)) * 3;
+    vec4 r0 = texelFetch(jointPalette, base);
+    vec4 r1 = texelFetch(jointPalette, base + 1);
+    vec4 r2 = texelFetch(jointPalette, base + 2);
+    return mat4(vec4(r0.x, r1.x, r2.x, 0.0),
+                vec4(r0.y, r1.y, r2.y, 0.0),
+                vec4(r0.z, r1.z, r2.z, 0.0),
+                vec4(r0.w, r1.w, r2.w, 1.0));
+}
+#endif
+
+void main() {
+    vec4 localPos = vec4(aPos, 1.0);
+
+#ifdef SKINNING
+    mat4 skin = aWeights.x * jointMatrix(aJoints.x)
+              + aWeights.y * jointMatrix(aJoints.y)
+              + aWeights.z * jointMatrix(aJoints.z)
+              + aWeights.w * jointMatrix(aJoints.w);
+    localPos = skin * localPos;
+#endif
+
+    vec3 worldPos = vec3(model * localPos);
+    vec4 eyePos = view * vec4(worldPos, 1.0);
+    gl_Position = projection * eyePos;
+}
@@ -0,0 +1,33 @@
+#version 330 core
+
+// One level of the depth pyramid. Each texel keeps the farthest depth under
+// it, so a box in front of that depth is in front of everything it covers.
+
+out float depth;
+
+uniform sampler2D source;  // base level limited to the one read
+uniform bool downsample;   // false copies the depth buffer into level 0
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    if (!downsample) {
+        depth = texelFetch(source, texel, 0).r;
+        return;
+    }
+
+    ivec2 sourceSize = textureSize(source, 0);
+    ivec2 size = max(sourceSize / 2, ivec2(1));
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1, sourceSize - 1);
+    // An odd row or column left over at the edge folds into the last texel
+    if (texel.x == size.x - 1) last.x = sourceSize.x - 1;
+    if (texel.y == size.y - 1) last.y = sourceSize.y - 1;
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; ++y) {
+        for (int x = first.x; x <= last.x; ++x) {
+            farthest = max(farthest, texelFetch(source, ivec2(x, y), 0).r);
+        }
+    }
+    depth = farthest;
+}
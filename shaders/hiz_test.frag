@@ -0,0 +1,5 @@
+#version 330 core
+
+// Color and depth writes are off, the occlusion query only counts the sample
+void main() {
+}
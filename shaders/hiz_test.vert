@@ -0,0 +1,80 @@
+#version 330 core
+
+// One point per tested object, gl_VertexID picks its world bounds. The point
+// lands on a pixel only if the object may be visible, so an
+// ANY_SAMPLES_PASSED query around it can drive conditional rendering.
+
+uniform samplerBuffer bounds;  // min and max corner per object
+
+uniform mat4 viewProjection;
+uniform sampler2D pyramid;
+uniform bool hasPyramid;
+uniform mat4 previousViewProjection;
+uniform sampler2D previousPyramid;
+uniform bool hasPrevious;
+
+// false: may it have been visible last frame; true: was it hidden last
+// frame but may be visible now
+uniform bool revealed;
+uniform vec2 passPosition;  // center of a pixel inside the viewport, in NDC
+
+bool mayBeVisible(vec3 lo, vec3 hi, mat4 matrix, sampler2D depthPyramid) {
+    vec3 ndcMin = vec3(1.0e30);
+    vec3 ndcMax = vec3(-1.0e30);
+    int behind = 0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y, (i & 4) != 0 ? hi.z : lo.z);
+        vec4 clip = matrix * vec4(corner, 1.0);
+        if (clip.w <= 1.0e-5) {
+            ++behind;
+            continue;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+    // Wholly behind the eye it can't be seen, partly behind its footprint is unbounded
+    if (behind == 8) {
+        return false;
+    }
+    if (behind > 0) {
+        return true;
+    }
+    if (any(lessThan(ndcMax.xy, vec2(-1.0))) || any(greaterThan(ndcMin.xy, vec2(1.0))) || ndcMin.z > 1.0) {
+        return false;
+    }
+
+    // Finest level where the screen rectangle spans at most 2x2 texels
+    ivec2 size = textureSize(depthPyramid, 0);
+    ivec2 texelMin = ivec2(clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0) * vec2(size));
+    ivec2 texelMax = min(ivec2(clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0) * vec2(size)), size - 1);
+    int levels = 1 + int(log2(float(max(size.x, size.y))));
+    int level = 0;
+    while (level < levels - 1 && any(greaterThan((texelMax >> level) - (texelMin >> level), ivec2(1)))) {
+        ++level;
+    }
+
+    // Texels past a smaller level's edge were folded into its last one
+    ivec2 levelMax = textureSize(depthPyramid, level) - 1;
+    ivec2 a = min(texelMin >> level, levelMax);
+    ivec2 b = min(texelMax >> level, levelMax);
+    float farthest = max(max(texelFetch(depthPyramid, a, level).r, texelFetch(depthPyramid, ivec2(b.x, a.y), level).r),
+                         max(texelFetch(depthPyramid, ivec2(a.x, b.y), level).r, texelFetch(depthPyramid, b, level).r));
+
+    // Slack for depth buffer rounding, a surface flush with its box must not hide it
+    return ndcMin.z * 0.5 + 0.5 <= farthest + 1.0e-5;
+}
+
+void main() {
+    vec3 lo = texelFetch(bounds, gl_VertexID * 2).xyz;
+    vec3 hi = texelFetch(bounds, gl_VertexID * 2 + 1).xyz;
+
+    // Without a previous frame everything counts as visible last frame
+    bool before = !hasPrevious || mayBeVisible(lo, hi, previousViewProjection, previousPyramid);
+    // Without this frame's pyramid the second test can't reject anything
+    bool now = !hasPyramid || mayBeVisible(lo, hi, viewProjection, pyramid);
+    bool pass = revealed ? !before && now : before;
+
+    // Rejected points go past the far plane and are clipped
+    gl_Position = pass ? vec4(passPosition, 0.0, 1.0) : vec4(0.0, 0.0, 2.0, 1.0);
+}
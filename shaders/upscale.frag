@@ -0,0 +1,39 @@
+#version 330 core
+
+in vec2 vTexCoord;
+
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform vec2 uvScale;     // part of the target the scene was drawn into
+uniform vec2 texelSize;
+uniform float sharpness;  // 0 disables sharpening
+
+vec3 sampleScene(vec2 uv) {
+    // Clamped to the drawn part, the rest of the target holds stale pixels
+    return texture(scene, clamp(uv, texelSize * 0.5, uvScale - texelSize * 0.5)).rgb;
+}
+
+void main() {
+    vec2 uv = vTexCoord * uvScale;
+    vec3 center = sampleScene(uv);
+    if (sharpness <= 0.0) {
+        FragColor = vec4(center, 1.0);
+        return;
+    }
+
+    vec3 north = sampleScene(uv + vec2(0.0, texelSize.y));
+    vec3 south = sampleScene(uv - vec2(0.0, texelSize.y));
+    vec3 east = sampleScene(uv + vec2(texelSize.x, 0.0));
+    vec3 west = sampleScene(uv - vec2(texelSize.x, 0.0));
+
+    // Contrast-adaptive sharpening: the negative lobe shrinks where the
+    // neighbourhood already spans most of the range, so edges don't ring
+    vec3 lo = min(center, min(min(north, south), min(east, west)));
+    vec3 hi = max(center, max(max(north, south), max(east, west)));
+    vec3 amount = sqrt(clamp(min(lo, 1.0 - hi) / max(hi, vec3(1.0e-4)), 0.0, 1.0));
+    vec3 lobe = amount * (-1.0 / mix(8.0, 5.0, sharpness));
+
+    vec3 result = (center + (north + south + east + west) * lobe) / (1.0 + 4.0 * lobe);
+    FragColor = vec4(clamp(result, 0.0, 1.0), 1.0);
+}
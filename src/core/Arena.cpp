@@ -0,0 +1,92 @@
+#include "Arena.hpp"
+#include <algorithm>
+
+LinearArena::LinearArena(size_t blockBytes)
+    : m_blockBytes(std::max<size_t>(blockBytes, 64)) {
+}
+
+LinearArena& LinearArena::forThread() {
+    thread_local LinearArena arena;
+    return arena;
+}
+
+void* LinearArena::allocate(size_t bytes, size_t alignment) {
+    bytes = std::max<size_t>(bytes, 1);
+
+    // Current block first, then blocks kept from before the last rewind
+    while (m_block < m_blocks.size()) {
+        Block& block = m_blocks[m_block];
+        const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t aligned = (base + m_offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        const size_t end = static_cast<size_t>(aligned - base) + bytes;
+        if (end <= block.size) {
+            m_offset = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+        if (m_block + 1 == m_blocks.size()) {
+            break;
+        }
+        ++m_block;
+        m_offset = 0;
+    }
+
+    // Worst-case padding included, new[] only guarantees fundamental alignment
+    const size_t size = std::max(m_blockBytes, bytes + alignment);
+    m_blocks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[size]), size });
+    m_capacity += size;
+    m_memory.set(MemoryCategory::Arena, m_capacity);
+    m_block = m_blocks.size() - 1;
+    m_offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void LinearArena::rewind(Marker marker) {
+    m_block = marker.block;
+    m_offset = marker.offset;
+
+    // Oversized blocks served one big allocation, don't hold on to them
+    size_t kept = std::min(m_blocks.size(), m_block + 1);
+    for (size_t i = kept; i < m_blocks.size(); ++i) {
+        if (m_blocks[i].size > m_blockBytes) {
+            m_capacity -= m_blocks[i].size;
+        } else {
+            m_blocks[kept++] = std::move(m_blocks[i]);
+        }
+    }
+    if (kept < m_blocks.size()) {
+        m_blocks.resize(kept);
+        m_memory.set(MemoryCategory::Arena, m_capacity);
+    }
+}
+
+void LinearArena::release() {
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+    m_block = 0;
+    m_offset = 0;
+    m_capacity = 0;
+    m_memory.reset();
+}
+
+size_t LinearArena::getUsedBytes() const {
+    size_t used = m_offset;
+    for (size_t i = 0; i < m_block && i < m_blocks.size(); ++i) {
+        used += m_blocks[i].size;
+    }
+    return used;
+}
+
+FrameArena::FrameArena(size_t blockBytes)
+    : m_arenas{ LinearArena(blockBytes), LinearArena(blockBytes) } {
+}
+
+FrameArena& FrameArena::instance() {
+    static FrameArena arena;
+    return arena;
+}
+
+void FrameArena::beginFrame() {
+    m_current ^= 1;
+    m_arenas[m_current].reset();
+    ++m_frame;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "MemoryStats.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator over a chain of blocks. Allocations are never freed one by
+// one: rewind() drops everything allocated after a marker and reset() drops
+// everything, both keep the blocks for reuse, so a warmed-up arena allocates
+// nothing from the heap. Allocations larger than the block size get a block
+// of their own. Not thread-safe, give each thread its own (forThread()).
+class LinearArena {
+public:
+    static constexpr size_t kDefaultBlockBytes = 1 << 20;
+
+    explicit LinearArena(size_t blockBytes = kDefaultBlockBytes);
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    // Calling thread's scratch arena, for job and loader temporaries. Always
+    // use it through an ArenaScope, callers further up may hold allocations.
+    static LinearArena& forThread();
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for count Ts, T must be trivially destructible
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    struct Marker {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+    Marker getMarker() const { return { m_block, m_offset }; }
+    void rewind(Marker marker);
+    void reset() { rewind({}); }
+    // Frees the blocks too, e.g. after a load whose scratch won't be needed again
+    void release();
+
+    size_t getUsedBytes() const;
+    size_t getCapacityBytes() const { return m_capacity; }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> m_blocks;
+    size_t m_block = 0;   // block being filled
+    size_t m_offset = 0;  // into m_blocks[m_block]
+    size_t m_blockBytes;
+    size_t m_capacity = 0;
+    TrackedMemory m_memory;
+};
+
+// Rewinds an arena to where it was when the scope was entered
+class ArenaScope {
+public:
+    explicit ArenaScope(LinearArena& arena) : m_arena(arena), m_marker(arena.getMarker()) {}
+    ~ArenaScope() { m_arena.rewind(m_marker); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    LinearArena& arena() { return m_arena; }
+
+private:
+    LinearArena& m_arena;
+    LinearArena::Marker m_marker;
+};
+
+// Standard allocator drawing from an arena, deallocation is a no-op. Growing
+// a container leaves its old storage behind until the arena is rewound, so
+// reserve or size containers up front where the final size is known.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) : m_arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.getArena()) {}
+
+    T* allocate(size_t count) { return m_arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    LinearArena* getArena() const { return m_arena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.getArena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.getArena(); }
+
+private:
+    LinearArena* m_arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Two arenas used on alternate frames. Data allocated during a frame stays
+// valid through the next one, so results can be compared or consumed a
+// frame late (e.g. by jobs still running) without copies. Main thread only.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockBytes = LinearArena::kDefaultBlockBytes);
+
+    // Shared arena of the main loop, created on first use
+    static FrameArena& instance();
+
+    // Switches to the other arena and resets it, call once at the start of a frame
+    void beginFrame();
+
+    LinearArena& current() { return m_arenas[m_current]; }
+    LinearArena& previous() { return m_arenas[m_current ^ 1]; }
+
+    uint64_t getFrame() const { return m_frame; }
+
+private:
+    LinearArena m_arenas[2];
+    size_t m_current = 0;
+    uint64_t m_frame = 0;
+};
@@ -0,0 +1,209 @@
+#include "FileWatcher.hpp"
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Absolute, normalized, split into directory and file name
+bool splitPath(const std::string& path, std::string& directory, std::string& name) {
+    std::error_code error;
+    fs::path absolute = fs::absolute(path, error);
+    if (error) {
+        return false;
+    }
+    absolute = absolute.lexically_normal();
+    directory = absolute.parent_path().string();
+    name = absolute.filename().string();
+    return !name.empty();
+}
+
+} // namespace
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() {
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        std::cerr << "Failed to initialize inotify, file changes will not be seen" << std::endl;
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+FileWatcher::Directory* FileWatcher::addDirectory(const std::string& path) {
+    auto it = m_directories.find(path);
+    if (it != m_directories.end()) {
+        return &it->second;
+    }
+    if (m_fd < 0) {
+        return nullptr;
+    }
+    // Close-after-write covers in-place saves, moved-to covers write-then-rename
+    int watch = inotify_add_watch(m_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0) {
+        std::cerr << "Failed to watch directory: " << path << std::endl;
+        return nullptr;
+    }
+    m_watches[watch] = path;
+    return &m_directories[path];
+}
+
+void FileWatcher::collect() {
+    if (m_fd < 0) {
+        return;
+    }
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;  // EAGAIN, nothing more queued
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->len == 0) {
+                continue;
+            }
+            auto watch = m_watches.find(event->wd);
+            if (watch == m_watches.end()) {
+                continue;
+            }
+            const Directory& directory = m_directories[watch->second];
+            const std::string name = event->name;
+            if (directory.all || directory.names.count(name)) {
+                touch(watch->second + "/" + name);
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+FileWatcher::Directory* FileWatcher::addDirectory(const std::string& path) {
+    std::error_code error;
+    if (!fs::is_directory(path, error)) {
+        std::cerr << "Failed to watch directory: " << path << std::endl;
+        return nullptr;
+    }
+    return &m_directories[path];
+}
+
+void FileWatcher::collect() {
+    // Stat calls are not free, a few checks per second are plenty for edits
+    const Clock::time_point now = Clock::now();
+    if (now - m_lastScan < std::chrono::milliseconds(250)) {
+        return;
+    }
+    m_lastScan = now;
+
+    auto check = [this](const std::string& path) {
+        std::error_code error;
+        fs::file_time_type time = fs::last_write_time(path, error);
+        if (error) {
+            return;  // deleted or mid-rename, look again next time
+        }
+        auto [it, inserted] = m_times.try_emplace(path, time);
+        if (!inserted && it->second != time) {
+            it->second = time;
+            touch(path);
+        }
+    };
+
+    for (const auto& [path, directory] : m_directories) {
+        if (directory.all) {
+            std::error_code error;
+            for (const auto& entry : fs::directory_iterator(path, error)) {
+                if (entry.is_regular_file(error)) {
+                    check(entry.path().string());
+                }
+            }
+        } else {
+            for (const std::string& name : directory.names) {
+                check((fs::path(path) / name).string());
+            }
+        }
+    }
+}
+
+#endif
+
+bool FileWatcher::watch(const std::string& path) {
+    std::string directoryPath;
+    std::string name;
+    if (!splitPath(path, directoryPath, name)) {
+        std::cerr << "Failed to watch file: " << path << std::endl;
+        return false;
+    }
+    Directory* directory = addDirectory(directoryPath);
+    if (!directory) {
+        return false;
+    }
+    directory->names.insert(name);
+#ifndef __linux__
+    std::error_code error;
+    const std::string file = (fs::path(directoryPath) / name).string();
+    m_times.try_emplace(file, fs::last_write_time(file, error));
+#endif
+    return true;
+}
+
+bool FileWatcher::watchDirectory(const std::string& path) {
+    std::error_code error;
+    fs::path absolute = fs::absolute(path, error);
+    if (error) {
+        std::cerr << "Failed to watch directory: " << path << std::endl;
+        return false;
+    }
+    absolute = absolute.lexically_normal();
+    if (!absolute.has_filename()) {
+        absolute = absolute.parent_path();  // trailing separator
+    }
+    Directory* directory = addDirectory(absolute.string());
+    if (!directory) {
+        return false;
+    }
+    directory->all = true;
+#ifndef __linux__
+    for (const auto& entry : fs::directory_iterator(absolute, error)) {
+        if (entry.is_regular_file(error)) {
+            m_times.try_emplace(entry.path().string(), entry.last_write_time(error));
+        }
+    }
+#endif
+    return true;
+}
+
+void FileWatcher::touch(const std::string& path) {
+    // A later write restarts the settle delay
+    m_pending[path] = Clock::now();
+}
+
+void FileWatcher::poll(std::vector<std::string>& changed) {
+    collect();
+    if (m_pending.empty()) {
+        return;
+    }
+    const Clock::time_point now = Clock::now();
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (now - it->second >= m_settleDelay) {
+            changed.push_back(it->first);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Reports files that were written since the last poll. On Linux the parent
+// directories are watched with inotify, which also catches editors that save
+// through a temporary file and a rename; elsewhere modification times are
+// compared, at most every few hundred milliseconds. A change is only reported
+// once the file has been quiet for a short settle delay, so a file still
+// being written is read once it is complete.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watching the same file twice is harmless
+    bool watch(const std::string& path);
+    // Every regular file in a directory, including ones created later (inotify only)
+    bool watchDirectory(const std::string& path);
+
+    // Appends the files that changed and have settled since the last call
+    void poll(std::vector<std::string>& changed);
+    // Changes seen but not reported yet
+    bool hasPending() const { return !m_pending.empty(); }
+
+    void setSettleDelay(std::chrono::milliseconds delay) { m_settleDelay = delay; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Directory {
+        std::unordered_set<std::string> names;  // watched file names in it
+        bool all = false;                       // or every file
+    };
+
+    Directory* addDirectory(const std::string& path);
+    void collect();
+    void touch(const std::string& path);
+
+    std::unordered_map<std::string, Directory> m_directories;  // by absolute path
+    std::unordered_map<std::string, Clock::time_point> m_pending;  // file, last write seen
+    std::chrono::milliseconds m_settleDelay{200};
+
+#ifdef __linux__
+    int m_fd = -1;
+    std::unordered_map<int, std::string> m_watches;  // inotify watch descriptor to directory
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_times;  // file, last write time
+    Clock::time_point m_lastScan{};
+#endif
+};
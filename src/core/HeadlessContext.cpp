@@ -0,0 +1,133 @@
+#include "HeadlessContext.hpp"
+#include <glad/glad.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+bool hasEglExtension(EGLDisplay display, const char* name) {
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions) {
+        return false;
+    }
+    // Exact token match, some names are prefixes of others
+    const size_t length = std::strlen(name);
+    for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + length, name)) {
+        bool startsToken = p == extensions || p[-1] == ' ';
+        bool endsToken = p[length] == ' ' || p[length] == '\0';
+        if (startsToken && endsToken) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+HeadlessContext::~HeadlessContext() {
+    cleanup();
+}
+
+void HeadlessContext::cleanup() {
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+        m_surface = EGL_NO_SURFACE;
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    eglTerminate(m_display);
+    m_display = EGL_NO_DISPLAY;
+}
+
+bool HeadlessContext::init() {
+    cleanup();
+
+    // Surfaceless needs neither X11 nor a DRM device
+    auto getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay && hasEglExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (m_display == EGL_NO_DISPLAY) {
+        m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0, minor = 0;
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        m_display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL display does not support desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const bool surfaceless = hasEglExtension(m_display, "EGL_KHR_surfaceless_context");
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cerr << "No suitable EGL config" << std::endl;
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (m_context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create OpenGL 3.3 context (error 0x" << std::hex << eglGetError() << std::dec << ")"
+                  << std::endl;
+        return false;
+    }
+
+    // Without surfaceless support, bind a 1x1 pbuffer nobody draws to
+    if (!surfaceless) {
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttributes);
+        if (m_surface == EGL_NO_SURFACE) {
+            std::cerr << "Failed to create EGL pbuffer" << std::endl;
+            return false;
+        }
+    }
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        std::cerr << "Failed to make EGL context current" << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader((void*(*)(const char*))eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+
+    std::cout << "OpenGL Info (headless, EGL " << major << "." << minor << "):" << std::endl;
+    std::cout << "  Vendor: " << glGetString(GL_VENDOR) << std::endl;
+    std::cout << "  Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "  Version: " << glGetString(GL_VERSION) << std::endl;
+
+    // Same fixed state as Window::init
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+
+    return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+// OpenGL 3.3 core context without a window or display server, for batch
+// rendering on servers. Uses Mesa's surfaceless EGL platform when available
+// (runs on llvmpipe with no GPU), otherwise the default EGL display.
+//
+// There is no default framebuffer: render into an FBO.
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool init();
+
+private:
+    void cleanup();
+
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+};
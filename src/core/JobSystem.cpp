@@ -0,0 +1,285 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+
+namespace {
+
+// Which system's pool the current thread belongs to, and its deque there
+struct WorkerIdentity {
+    const JobSystem* system = nullptr;
+    size_t queue = 0;
+};
+
+thread_local WorkerIdentity t_worker;
+
+} // namespace
+
+JobSystem::JobSystem(unsigned threadCount)
+    : m_mainThread(std::this_thread::get_id()) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 1; i < threadCount; ++i) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, static_cast<size_t>(i));
+    }
+}
+
+JobSystem::~JobSystem() {
+    // Jobs still queued may hold counters someone waits on, let them finish
+    while (runOne(0)) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::instance() {
+    static JobSystem system;
+    return system;
+}
+
+size_t JobSystem::currentQueue() const {
+    return t_worker.system == this ? t_worker.queue : 0;
+}
+
+void JobSystem::run(Job job, JobCounter* counter) {
+    if (counter) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    push(currentQueue(), Task{ std::move(job), counter });
+}
+
+void JobSystem::runAfter(JobCounter& dependency, Job job, JobCounter* counter) {
+    if (counter) {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_mutex);
+        if (dependency.m_pending.load(std::memory_order_acquire) != 0) {
+            dependency.m_continuations.push_back({ std::move(job), counter });
+            return;
+        }
+    }
+    push(currentQueue(), Task{ std::move(job), counter });
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const size_t queue = currentQueue();
+    const bool mainThread = isMainThread();
+    // Outside the pool, an unrelated job could be a whole model parse and stall
+    // the frame. Workers take care of those, unless there are none.
+    const bool anyJob = t_worker.system == this || m_workers.empty();
+    while (!counter.isDone()) {
+        // A worker job may be waiting on GL work queued for this thread
+        if (mainThread && runMainThreadJobs() > 0) {
+            continue;
+        }
+        if (!(anyJob ? runOne(queue) : runOneFor(counter))) {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last complete() may still be unlocking, the counter can't go away before that
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (count + grain - 1) / grain;
+    if (m_workers.empty() || chunks <= 1) {
+        if (count > 0) {
+            fn(0, count);
+        }
+        return;
+    }
+
+    // Helpers pull chunks from a shared cursor, so a stolen helper that starts
+    // late simply finds less left to do
+    std::atomic<size_t> next{0};
+    auto loop = [&] {
+        for (;;) {
+            size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+            if (begin >= count) {
+                break;
+            }
+            fn(begin, std::min(begin + grain, count));
+        }
+    };
+
+    JobCounter counter;
+    const size_t helpers = std::min<size_t>(chunks, getThreadCount()) - 1;
+    // A single reference fits std::function's inline storage, queuing helpers doesn't allocate
+    for (size_t i = 0; i < helpers; ++i) {
+        run([&loop] { loop(); }, &counter);
+    }
+    loop();
+    wait(counter);
+}
+
+void JobSystem::runOnMainThread(Job job) {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_mainJobs.push_back(std::move(job));
+}
+
+size_t JobSystem::runMainThreadJobs() {
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        jobs.swap(m_mainJobs);
+    }
+    // Jobs queued while these run wait for the next call
+    for (auto& job : jobs) {
+        job();
+    }
+    return jobs.size();
+}
+
+void JobSystem::Queue::pushBack(Task task) {
+    if (count == ring.size()) {
+        std::vector<Task> grown(std::max<size_t>(ring.size() * 2, 16));
+        for (size_t i = 0; i < count; ++i) {
+            grown[i] = std::move(ring[(head + i) & (ring.size() - 1)]);
+        }
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count++) & (ring.size() - 1)] = std::move(task);
+}
+
+JobSystem::Task JobSystem::Queue::popBack() {
+    --count;
+    return std::move(ring[(head + count) & (ring.size() - 1)]);
+}
+
+JobSystem::Task JobSystem::Queue::popFront() {
+    Task task = std::move(ring[head]);
+    head = (head + 1) & (ring.size() - 1);
+    --count;
+    return task;
+}
+
+bool JobSystem::Queue::take(const JobCounter* counter, Task& task) {
+    for (size_t i = count; i-- > 0;) {
+        if (ring[(head + i) & (ring.size() - 1)].counter != counter) {
+            continue;
+        }
+        task = std::move(ring[(head + i) & (ring.size() - 1)]);
+        // Close the gap, the deques stay short
+        for (size_t j = i; j + 1 < count; ++j) {
+            ring[(head + j) & (ring.size() - 1)] = std::move(ring[(head + j + 1) & (ring.size() - 1)]);
+        }
+        --count;
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::push(size_t queue, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue]->mutex);
+        m_queues[queue]->pushBack(std::move(task));
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders this against a worker between its check and its wait
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_wake.notify_one();
+}
+
+bool JobSystem::pop(size_t queue, Task& task) {
+    Queue& own = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.count == 0) {
+        return false;
+    }
+    task = own.popBack();
+    return true;
+}
+
+bool JobSystem::steal(size_t thief, Task& task) {
+    // Oldest job of the next non-empty deque, the one its owner would get to last
+    const size_t queueCount = m_queues.size();
+    for (size_t i = 1; i < queueCount; ++i) {
+        Queue& victim = *m_queues[(thief + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.count > 0) {
+            task = victim.popFront();
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::runOne(size_t queue) {
+    Task task;
+    if (!pop(queue, task) && !steal(queue, task)) {
+        return false;
+    }
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+    task.job();
+    complete(task.counter);
+    return true;
+}
+
+bool JobSystem::runOneFor(const JobCounter& counter) {
+    Task task;
+    bool found = false;
+    for (auto& queue : m_queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->take(&counter, task)) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+    task.job();
+    complete(task.counter);
+    return true;
+}
+
+void JobSystem::complete(JobCounter* counter) {
+    if (!counter) {
+        return;
+    }
+
+    std::vector<JobCounter::Continuation> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready.swap(counter->m_continuations);
+        }
+    }
+    for (auto& continuation : ready) {
+        push(currentQueue(), Task{ std::move(continuation.job), continuation.counter });
+    }
+}
+
+void JobSystem::workerLoop(size_t queue) {
+    t_worker.system = this;
+    t_worker.queue = queue;
+
+    for (;;) {
+        if (runOne(queue)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+        if (m_stop) {
+            return;
+        }
+    }
+}
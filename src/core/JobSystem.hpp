@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of unfinished jobs tied to it. Jobs can be held back until a
+// counter drops to zero (JobSystem::runAfter), and any thread can help run
+// jobs until it does (JobSystem::wait). Only destroy a counter once wait()
+// has returned for it.
+class JobCounter {
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation {
+        std::function<void()> job;
+        JobCounter* counter;
+    };
+
+    std::atomic<size_t> m_pending{0};
+    // Guards the decrement to zero against runAfter() adding a continuation
+    std::mutex m_mutex;
+    std::vector<Continuation> m_continuations;
+};
+
+// One worker thread per core, each with its own deque of jobs. A thread pushes
+// and pops at the back of its own deque, so related jobs run hot in its cache,
+// and idle workers steal from the front of the others'. Threads outside the
+// pool (the main thread, or any other) share deque 0. While they wait they
+// only run jobs counted by the counter they wait on, so a frame's parallel
+// loop never picks up a long background job such as a model parse; workers
+// run anything, so nested parallel loops never deadlock.
+//
+// GL calls must stay on the thread that owns the context: jobs hand such work
+// back with runOnMainThread(), and the main loop drains it once per frame.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // threadCount counts the calling thread, 0 picks one per hardware thread.
+    // The constructing thread becomes the main thread.
+    explicit JobSystem(unsigned threadCount = 0);
+    // Finishes queued jobs first
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Shared system, created on first use. Call it from the main thread first.
+    static JobSystem& instance();
+
+    // Queues a job, counter (if any) counts it until it has run
+    void run(Job job, JobCounter* counter = nullptr);
+    // Queues a job once dependency reaches zero, counter counts it from now on
+    void runAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+    // Runs queued jobs (and main-thread jobs, on the main thread) until counter
+    // reaches zero. Outside the pool only jobs counted by counter are run.
+    void wait(JobCounter& counter);
+
+    // Calls fn(begin, end) over [0, count) in chunks of grain, returns when all
+    // are done. The caller takes part, so this can be used from inside a job.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    // Queues a job for the main thread, e.g. a GL upload prepared on a worker
+    void runOnMainThread(Job job);
+    // Runs the main-thread jobs queued so far, returns how many ran. Main thread only.
+    size_t runMainThreadJobs();
+    bool isMainThread() const { return std::this_thread::get_id() == m_mainThread; }
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+    // Jobs taken from another thread's deque, for tuning grain sizes
+    uint64_t getStolenCount() const { return m_stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter = nullptr;
+    };
+
+    // Own cache line each, workers hammer their own deque's lock. A ring
+    // that only grows, std::deque would allocate and free blocks as jobs
+    // come and go, every frame.
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::vector<Task> ring;  // size is zero or a power of two
+        size_t head = 0;         // oldest job
+        size_t count = 0;
+
+        void pushBack(Task task);
+        Task popBack();
+        Task popFront();
+        // Newest job counted by counter, false if there is none
+        bool take(const JobCounter* counter, Task& task);
+    };
+
+    size_t currentQueue() const;
+    void push(size_t queue, Task task);
+    bool pop(size_t queue, Task& task);
+    bool steal(size_t thief, Task& task);
+    // Runs one job from the thread's own deque or a stolen one, false if there was none
+    bool runOne(size_t queue);
+    // Runs one job counted by counter from any deque, false if none is queued
+    bool runOneFor(const JobCounter& counter);
+    void complete(JobCounter* counter);
+    void workerLoop(size_t queue);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;  // 0 is shared by threads outside the pool
+    std::vector<std::thread> m_workers;
+    std::thread::id m_mainThread;
+
+    std::atomic<size_t> m_queued{0};
+    std::atomic<uint64_t> m_stolen{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+
+    std::mutex m_mainMutex;
+    std::vector<Job> m_mainJobs;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first
+// access and can be handed back to the kernel once consumed, so reading a
+// multi-gigabyte file never needs more resident memory than the ranges in use.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    // Hints that [offset, offset + length) will be read soon
+    void prefetch(size_t offset, size_t length) const;
+
+    // Drops the resident pages fully inside [offset, offset + length).
+    // The range stays readable, it is paged in again from the file if touched.
+    void release(size_t offset, size_t length) const;
+
+private:
+    unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
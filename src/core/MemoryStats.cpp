@@ -0,0 +1,311 @@
+#include "MemoryStats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+constexpr size_t kCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+struct Counter {
+    size_t current = 0;
+    size_t peak = 0;
+    size_t allocations = 0;
+
+    void add(size_t bytes) {
+        current += bytes;
+        peak = std::max(peak, current);
+        ++allocations;
+    }
+
+    void remove(size_t bytes) {
+        current -= std::min(current, bytes);
+        if (allocations > 0) --allocations;
+    }
+};
+
+struct State {
+    std::mutex mutex;
+    Counter categories[kCategoryCount];
+    Counter gpu;
+    Counter cpu;
+    std::map<std::string, std::pair<Counter, Counter>> assets;  // gpu, cpu
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+thread_local std::string t_currentAsset;
+
+std::atomic<uint64_t> g_heapAllocations{0};
+thread_local uint64_t t_heapAllocations = 0;
+
+void* countedAllocate(size_t bytes, size_t alignment) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    ++t_heapAllocations;
+    bytes = std::max<size_t>(bytes, 1);
+    void* memory;
+    if (alignment > alignof(std::max_align_t)) {
+#ifdef _WIN32
+        memory = _aligned_malloc(bytes, alignment);
+#else
+        memory = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+#endif
+    } else {
+        memory = std::malloc(bytes);
+    }
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void alignedFree(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+MemoryStats::Totals toTotals(const Counter& counter) {
+    MemoryStats::Totals totals;
+    totals.current = counter.current;
+    totals.peak = counter.peak;
+    totals.allocations = counter.allocations;
+    return totals;
+}
+
+} // namespace
+
+std::string MemoryStats::formatBytes(size_t bytes) {
+    const char* units[] = { "B", "KiB", "MiB", "GiB" };
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 3) {
+        value /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << value << " " << units[unit];
+    return out.str();
+}
+
+void MemoryStats::allocate(MemoryCategory category, const std::string& asset, size_t bytes) {
+    if (category >= MemoryCategory::Count || bytes == 0) {
+        return;
+    }
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.categories[static_cast<size_t>(category)].add(bytes);
+    auto& assetCounters = s.assets[asset];
+    if (isGpu(category)) {
+        s.gpu.add(bytes);
+        assetCounters.first.add(bytes);
+    } else {
+        s.cpu.add(bytes);
+        assetCounters.second.add(bytes);
+    }
+}
+
+void MemoryStats::release(MemoryCategory category, const std::string& asset, size_t bytes) {
+    if (category >= MemoryCategory::Count || bytes == 0) {
+        return;
+    }
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.categories[static_cast<size_t>(category)].remove(bytes);
+    auto& assetCounters = s.assets[asset];
+    if (isGpu(category)) {
+        s.gpu.remove(bytes);
+        assetCounters.first.remove(bytes);
+    } else {
+        s.cpu.remove(bytes);
+        assetCounters.second.remove(bytes);
+    }
+}
+
+MemoryStats::Totals MemoryStats::getTotals(MemoryCategory category) {
+    if (category >= MemoryCategory::Count) {
+        return {};
+    }
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return toTotals(s.categories[static_cast<size_t>(category)]);
+}
+
+MemoryStats::Totals MemoryStats::getGpuTotals() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return toTotals(s.gpu);
+}
+
+MemoryStats::Totals MemoryStats::getCpuTotals() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return toTotals(s.cpu);
+}
+
+std::vector<MemoryStats::AssetUsage> MemoryStats::getAssetUsage() {
+    std::vector<AssetUsage> usage;
+    {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& [asset, counters] : s.assets) {
+            AssetUsage entry;
+            entry.asset = asset.empty() ? "(untagged)" : asset;
+            entry.gpuCurrent = counters.first.current;
+            entry.gpuPeak = counters.first.peak;
+            entry.cpuCurrent = counters.second.current;
+            entry.cpuPeak = counters.second.peak;
+            usage.push_back(std::move(entry));
+        }
+    }
+    std::sort(usage.begin(), usage.end(), [](const AssetUsage& a, const AssetUsage& b) {
+        return a.gpuPeak > b.gpuPeak;
+    });
+    return usage;
+}
+
+void MemoryStats::printReport(std::ostream& out) {
+    out << "\nMemory (current / peak / live allocations):" << std::endl;
+    for (size_t i = 0; i < kCategoryCount; ++i) {
+        MemoryCategory category = static_cast<MemoryCategory>(i);
+        Totals totals = getTotals(category);
+        if (totals.peak == 0) {
+            continue;
+        }
+        out << "  " << (isGpu(category) ? "GPU " : "CPU ") << std::left << std::setw(16) << categoryName(category)
+            << std::right << std::setw(12) << formatBytes(totals.current)
+            << std::setw(12) << formatBytes(totals.peak)
+            << std::setw(8) << totals.allocations << std::endl;
+    }
+
+    Totals gpu = getGpuTotals();
+    Totals cpu = getCpuTotals();
+    out << "  GPU total " << formatBytes(gpu.current) << " (peak " << formatBytes(gpu.peak) << ")" << std::endl;
+    out << "  CPU total " << formatBytes(cpu.current) << " (peak " << formatBytes(cpu.peak) << ")" << std::endl;
+
+    std::vector<AssetUsage> assets = getAssetUsage();
+    if (!assets.empty()) {
+        out << "Per asset (GPU current / peak, CPU peak):" << std::endl;
+        for (const auto& asset : assets) {
+            out << "  " << std::left << std::setw(28) << asset.asset << std::right
+                << std::setw(12) << formatBytes(asset.gpuCurrent)
+                << std::setw(12) << formatBytes(asset.gpuPeak)
+                << std::setw(12) << formatBytes(asset.cpuPeak) << std::endl;
+        }
+    }
+}
+
+const char* MemoryStats::categoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::VertexBuffer: return "vertex buffers";
+        case MemoryCategory::IndexBuffer: return "index buffers";
+        case MemoryCategory::Texture: return "textures";
+        case MemoryCategory::TextureBuffer: return "texture buffers";
+        case MemoryCategory::PixelBuffer: return "pixel buffers";
+        case MemoryCategory::UniformBuffer: return "uniform buffers";
+        case MemoryCategory::GltfDocument: return "glTF document";
+        case MemoryCategory::LoaderStaging: return "loader staging";
+        case MemoryCategory::DecodedImage: return "decoded images";
+        case MemoryCategory::Animation: return "animation";
+        case MemoryCategory::Arena: return "arenas";
+        case MemoryCategory::Count: break;
+    }
+    return "unknown";
+}
+
+uint64_t MemoryStats::getHeapAllocationCount() {
+    return g_heapAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryStats::getThreadHeapAllocationCount() {
+    return t_heapAllocations;
+}
+
+const std::string& MemoryStats::currentAsset() {
+    return t_currentAsset;
+}
+
+void MemoryStats::setCurrentAsset(const std::string& asset) {
+    t_currentAsset = asset;
+}
+
+MemoryAssetScope::MemoryAssetScope(const std::string& asset)
+    : m_previous(MemoryStats::currentAsset()) {
+    MemoryStats::setCurrentAsset(asset);
+}
+
+MemoryAssetScope::~MemoryAssetScope() {
+    MemoryStats::setCurrentAsset(m_previous);
+}
+
+TrackedMemory::TrackedMemory(TrackedMemory&& other) noexcept
+    : m_category(other.m_category), m_asset(std::move(other.m_asset)), m_bytes(other.m_bytes) {
+    other.m_bytes = 0;
+}
+
+TrackedMemory& TrackedMemory::operator=(TrackedMemory&& other) noexcept {
+    if (this != &other) {
+        reset();
+        m_category = other.m_category;
+        m_asset = std::move(other.m_asset);
+        m_bytes = other.m_bytes;
+        other.m_bytes = 0;
+    }
+    return *this;
+}
+
+void TrackedMemory::set(MemoryCategory category, size_t bytes) {
+    reset();
+    m_category = category;
+    m_asset = MemoryStats::currentAsset();
+    m_bytes = bytes;
+    MemoryStats::allocate(m_category, m_asset, m_bytes);
+}
+
+void TrackedMemory::reset() {
+    if (m_bytes > 0) {
+        MemoryStats::release(m_category, m_asset, m_bytes);
+        m_bytes = 0;
+    }
+}
+
+// Replacements of the global allocation functions, counted for
+// getHeapAllocationCount(). The array and nothrow forms forward to these.
+void* operator new(size_t bytes) {
+    return countedAllocate(bytes, alignof(std::max_align_t));
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return countedAllocate(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    alignedFree(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    alignedFree(memory);
+}
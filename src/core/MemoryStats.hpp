@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+enum class MemoryCategory : uint8_t {
+    // GPU
+    VertexBuffer,
+    IndexBuffer,
+    Texture,         // all mip levels
+    TextureBuffer,
+    PixelBuffer,
+    UniformBuffer,
+    // CPU
+    GltfDocument,    // tinygltf's copy of buffers and images
+    LoaderStaging,   // vertex/index vectors built before upload
+    DecodedImage,    // pixels between decode and upload
+    Animation,       // keyframes and the skinning palette
+    Arena,           // LinearArena blocks, see core/Arena
+
+    Count
+};
+
+// Process-wide accounting of GPU allocations and large CPU allocations,
+// tagged by category and asset name. Thread-safe.
+class MemoryStats {
+public:
+    struct Totals {
+        size_t current = 0;
+        size_t peak = 0;
+        size_t allocations = 0;  // live allocations
+    };
+
+    struct AssetUsage {
+        std::string asset;
+        size_t gpuCurrent = 0;
+        size_t gpuPeak = 0;
+        size_t cpuCurrent = 0;
+        size_t cpuPeak = 0;
+    };
+
+    static void allocate(MemoryCategory category, const std::string& asset, size_t bytes);
+    static void release(MemoryCategory category, const std::string& asset, size_t bytes);
+
+    static Totals getTotals(MemoryCategory category);
+    static Totals getGpuTotals();
+    static Totals getCpuTotals();
+    static std::vector<AssetUsage> getAssetUsage();  // sorted by GPU peak, largest first
+
+    static void printReport(std::ostream& out);
+
+    // Calls to the global operator new, process-wide and on the calling
+    // thread. Diff two readings to count the allocations in between.
+    static uint64_t getHeapAllocationCount();
+    static uint64_t getThreadHeapAllocationCount();
+
+    static const char* categoryName(MemoryCategory category);
+    static std::string formatBytes(size_t bytes);
+    static bool isGpu(MemoryCategory category) { return category < MemoryCategory::GltfDocument; }
+
+    // Asset name attached to allocations made on this thread, "" if none.
+    // Set through MemoryAssetScope.
+    static const std::string& currentAsset();
+
+private:
+    friend class MemoryAssetScope;
+    static void setCurrentAsset(const std::string& asset);
+};
+
+// Tags allocations made on this thread with an asset name while alive
+class MemoryAssetScope {
+public:
+    explicit MemoryAssetScope(const std::string& asset);
+    ~MemoryAssetScope();
+
+    MemoryAssetScope(const MemoryAssetScope&) = delete;
+    MemoryAssetScope& operator=(const MemoryAssetScope&) = delete;
+
+private:
+    std::string m_previous;
+};
+
+// One tracked allocation, released on destruction. Owners embed it next to
+// the GL name or container it describes and move it along with them.
+class TrackedMemory {
+public:
+    TrackedMemory() = default;
+    TrackedMemory(MemoryCategory category, size_t bytes) { set(category, bytes); }
+    ~TrackedMemory() { reset(); }
+
+    TrackedMemory(const TrackedMemory&) = delete;
+    TrackedMemory& operator=(const TrackedMemory&) = delete;
+
+    TrackedMemory(TrackedMemory&& other) noexcept;
+    TrackedMemory& operator=(TrackedMemory&& other) noexcept;
+
+    // Replaces the tracked size, tagged with the thread's current asset
+    void set(MemoryCategory category, size_t bytes);
+    void reset();
+
+    size_t getBytes() const { return m_bytes; }
+
+private:
+    MemoryCategory m_category = MemoryCategory::Count;
+    std::string m_asset;
+    size_t m_bytes = 0;
+};
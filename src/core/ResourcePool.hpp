@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Slot index into a ResourcePool plus the slot's generation when the handle
+// was handed out. Destroying a resource moves its slot to the next
+// generation, so stale handles resolve to nullptr instead of to whatever
+// reuses the slot. A default handle is null.
+template <typename T>
+struct Handle {
+    uint32_t index = 0;
+    uint32_t generation = 0;  // never 0 for a live resource
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Resources of one type kept contiguous and addressed by Handle. Slots map
+// handles to positions in the dense array; destroy() moves the last resource
+// into the hole, so iterating the pool never steps over gaps. Pointers from
+// get() and iterators stay valid only until the next create() or destroy().
+template <typename T>
+class ResourcePool {
+public:
+    ResourcePool() = default;
+
+    ResourcePool(const ResourcePool&) = delete;
+    ResourcePool& operator=(const ResourcePool&) = delete;
+
+    template <typename... Args>
+    Handle<T> create(Args&&... args) {
+        uint32_t index;
+        if (!m_freeSlots.empty()) {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({ kFree, 1 });
+        }
+
+        m_items.emplace_back(std::forward<Args>(args)...);
+        m_owners.push_back(index);
+        m_slots[index].dense = static_cast<uint32_t>(m_items.size() - 1);
+        return { index, m_slots[index].generation };
+    }
+
+    // Returns false if the handle was already stale
+    bool destroy(Handle<T> handle) {
+        if (!get(handle)) {
+            return false;
+        }
+        Slot& slot = m_slots[handle.index];
+        const uint32_t dense = slot.dense;
+        const uint32_t last = static_cast<uint32_t>(m_items.size() - 1);
+        if (dense != last) {
+            m_items[dense] = std::move(m_items[last]);
+            m_owners[dense] = m_owners[last];
+            m_slots[m_owners[dense]].dense = dense;
+        }
+        m_items.pop_back();
+        m_owners.pop_back();
+
+        slot.dense = kFree;
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        m_freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    T* get(Handle<T> handle) {
+        return const_cast<T*>(static_cast<const ResourcePool*>(this)->get(handle));
+    }
+
+    const T* get(Handle<T> handle) const {
+        if (handle.index >= m_slots.size()) {
+            return nullptr;
+        }
+        const Slot& slot = m_slots[handle.index];
+        if (slot.generation != handle.generation || slot.dense == kFree) {
+            return nullptr;
+        }
+        return &m_items[slot.dense];
+    }
+
+    size_t size() const { return m_items.size(); }
+    bool empty() const { return m_items.empty(); }
+
+    // Dense iteration, in no particular order
+    typename std::vector<T>::iterator begin() { return m_items.begin(); }
+    typename std::vector<T>::iterator end() { return m_items.end(); }
+    typename std::vector<T>::const_iterator begin() const { return m_items.begin(); }
+    typename std::vector<T>::const_iterator end() const { return m_items.end(); }
+
+private:
+    static constexpr uint32_t kFree = ~0u;
+
+    struct Slot {
+        uint32_t dense;       // position in m_items, kFree if the slot is unused
+        uint32_t generation;
+    };
+
+    std::vector<T> m_items;
+    std::vector<uint32_t> m_owners;  // slot of each item
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+};
@@ -85,6 +85,7 @@ void Window::swapBuffers() {
 void Window::pollEvents() {
     m_mouseDeltaX = 0;
     m_mouseDeltaY = 0;
+    m_changed = false;
 
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -92,6 +93,23 @@ void Window::pollEvents() {
     }
 }
 
+void Window::waitEvents(int timeoutMs) {
+    m_mouseDeltaX = 0;
+    m_mouseDeltaY = 0;
+    m_changed = false;
+
+    SDL_Event event;
+    if (SDL_WaitEventTimeout(&event, timeoutMs)) {
+        handleEvent(event);
+        while (SDL_PollEvent(&event)) {
+            handleEvent(event);
+        }
+    }
+
+    // The time spent asleep isn't frame time, or the first frame after would jump
+    m_lastTime = SDL_GetPerformanceCounter();
+}
+
 void Window::handleEvent(const SDL_Event& event) {
     switch (event.type) {
         case SDL_QUIT:
@@ -104,9 +122,16 @@ void Window::handleEvent(const SDL_Event& event) {
                 m_height = event.window.data2;
                 glViewport(0, 0, m_width, m_height);
             }
+            // Resizes, exposes, restores: the back buffer may need redrawing
+            m_changed = true;
+            break;
+
+        case SDL_KEYUP:
+            m_changed = true;
             break;
 
         case SDL_KEYDOWN:
+            m_changed = true;
             if (event.key.keysym.sym == SDLK_ESCAPE) {
                 if (m_mouseCaptured) {
                     setMouseCapture(false);
@@ -120,10 +145,12 @@ void Window::handleEvent(const SDL_Event& event) {
             if (m_mouseCaptured) {
                 m_mouseDeltaX = event.motion.xrel;
                 m_mouseDeltaY = event.motion.yrel;
+                m_changed = true;
             }
             break;
 
         case SDL_MOUSEBUTTONDOWN:
+            m_changed = true;
             if (!m_mouseCaptured && event.button.button == SDL_BUTTON_LEFT) {
                 setMouseCapture(true);
             }
@@ -145,3 +172,9 @@ void Window::setMouseCapture(bool capture) {
     m_mouseCaptured = capture;
     SDL_SetRelativeMouseMode(capture ? SDL_TRUE : SDL_FALSE);
 }
+
+void Window::setCaption(const std::string& caption) {
+    if (m_window) {
+        SDL_SetWindowTitle(m_window, caption.c_str());
+    }
+}
@@ -14,6 +14,11 @@ public:
     bool init();
     void swapBuffers();
     void pollEvents();
+    // Blocks until an event arrives or timeoutMs passes, then handles all pending events
+    void waitEvents(int timeoutMs);
+
+    // True if the last poll/wait handled input or window events that can change the picture
+    bool hasChanged() const { return m_changed; }
 
     bool shouldClose() const { return m_shouldClose; }
     int getWidth() const { return m_width; }
@@ -27,6 +32,10 @@ public:
     void getMouseDelta(int& dx, int& dy) const;
     void setMouseCapture(bool capture);
 
+    const std::string& getTitle() const { return m_title; }
+    // Changes the caption only, getTitle() keeps the original
+    void setCaption(const std::string& caption);
+
 private:
     void handleEvent(const SDL_Event& event);
 
@@ -34,6 +43,7 @@ private:
     int m_width;
     int m_height;
     bool m_shouldClose = false;
+    bool m_changed = true;
 
     SDL_Window* m_window = nullptr;
     SDL_GLContext m_glContext = nullptr;
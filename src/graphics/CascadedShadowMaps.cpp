@@ -0,0 +1,443 @@
+#include "CascadedShadowMaps.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include "GpuResources.hpp"
+#include "Mesh.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+// Blend between logarithmic (1) and uniform (0) split distances
+constexpr float kSplitLambda = 0.75f;
+
+// Cached cascades cover this much more than their slice needs
+constexpr float kCachedCascadeSlack = 1.25f;
+
+// Extra depth added on each side whenever the caster depth range grows
+constexpr float kDepthRangePadding = 0.1f;
+
+void transformBounds(const glm::mat4& matrix, const glm::vec3& min, const glm::vec3& max,
+                     glm::vec3& outMin, glm::vec3& outMax) {
+    outMin = glm::vec3(1.0e30f);
+    outMax = glm::vec3(-1.0e30f);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 p((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        glm::vec3 t = glm::vec3(matrix * glm::vec4(p, 1.0f));
+        outMin = glm::min(outMin, t);
+        outMax = glm::max(outMax, t);
+    }
+}
+
+} // namespace
+
+CascadedShadowMaps::CascadedShadowMaps(int resolution)
+    : m_resolution(resolution) {}
+
+CascadedShadowMaps::~CascadedShadowMaps() {
+    cleanup();
+}
+
+void CascadedShadowMaps::cleanup() {
+    if (m_staticFbos[0]) {
+        for (int i = 0; i < kCascadeCount; ++i) {
+            GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_staticFbos[i]);
+            GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_liveFbos[i]);
+        }
+        std::fill(m_staticFbos, m_staticFbos + kCascadeCount, 0u);
+        std::fill(m_liveFbos, m_liveFbos + kCascadeCount, 0u);
+    }
+    if (m_staticTexture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_staticTexture);
+        m_staticTexture = 0;
+    }
+    if (m_liveTexture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_liveTexture);
+        m_liveTexture = 0;
+    }
+    m_memory.reset();
+}
+
+bool CascadedShadowMaps::init() {
+    cleanup();
+
+    if (!m_depthShaders.loadFromFiles("shaders/depth.vert", "shaders/depth.frag")) {
+        std::cerr << "Failed to load shadow depth shaders" << std::endl;
+        return false;
+    }
+
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    m_staticTexture = textures[0];
+    m_liveTexture = textures[1];
+
+    for (GLuint texture : textures) {
+        GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, m_resolution, m_resolution, kCascadeCount,
+                     0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    // The live maps are sampled with hardware compare and bilinear PCF,
+    // anything outside a cascade counts as lit
+    const GLfloat border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, m_liveTexture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+
+    {
+        MemoryAssetScope scope("shadow maps");
+        m_memory.set(MemoryCategory::Texture, size_t(2) * m_resolution * m_resolution * kCascadeCount * 4);
+    }
+
+    GLint previousFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+
+    glGenFramebuffers(kCascadeCount, m_staticFbos);
+    glGenFramebuffers(kCascadeCount, m_liveFbos);
+    bool complete = true;
+    for (int i = 0; i < kCascadeCount; ++i) {
+        for (GLuint fbo : { m_staticFbos[i], m_liveFbos[i] }) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                      fbo == m_staticFbos[i] ? m_staticTexture : m_liveTexture, 0, i);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+
+    if (!complete) {
+        std::cerr << "Shadow map framebuffer incomplete" << std::endl;
+        cleanup();
+        return false;
+    }
+
+    for (auto& cascade : m_cascades) {
+        cascade = Cascade();
+    }
+    return true;
+}
+
+void CascadedShadowMaps::setLightDirection(const glm::vec3& lightDir) {
+    glm::vec3 dir = glm::normalize(lightDir);
+    if (glm::dot(dir, m_lightDir) > 0.99999f) {
+        return;
+    }
+    m_lightDir = dir;
+
+    // Rotation only, so light-space positions don't depend on the camera
+    glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    m_lightView = glm::lookAt(glm::vec3(0.0f), dir, up);
+
+    m_sceneRangeValid = false;
+    for (auto& cascade : m_cascades) {
+        cascade.fitted = false;
+        cascade.staticValid = false;
+    }
+}
+
+bool CascadedShadowMaps::reloadShaders() {
+    if (!m_depthShaders.reload()) {
+        return false;
+    }
+    // Only a handful of depth permutations, rebuild them now rather than over frames
+    m_depthShaders.compilePending(SIZE_MAX);
+    invalidate();
+    return true;
+}
+
+void CascadedShadowMaps::invalidate() {
+    m_staticMatrices.clear();
+    m_sceneRangeValid = false;
+    for (auto& cascade : m_cascades) {
+        cascade.fitted = false;
+        cascade.staticValid = false;
+    }
+}
+
+void CascadedShadowMaps::gatherCasters(const std::vector<std::unique_ptr<Model>>& models) {
+    const ResourcePool<Mesh>& meshes = GpuResources::meshes();
+    m_casters.clear();
+    m_hasDynamicCasters = false;
+
+    bool staticMoved = false;
+    size_t staticModels = 0;
+    float minZ = 1.0e30f;
+    float maxZ = -1.0e30f;
+
+    for (const auto& model : models) {
+        const glm::mat4& matrix = model->getTransform().getMatrix();
+        const bool dynamic = model->getJointPaletteOffset() >= 0;
+        m_hasDynamicCasters |= dynamic;
+
+        if (!dynamic) {
+            ++staticModels;
+            auto it = m_staticMatrices.find(model.get());
+            if (it == m_staticMatrices.end() || it->second != matrix) {
+                m_staticMatrices[model.get()] = matrix;
+                staticMoved = true;
+            }
+        }
+
+        const glm::mat4 toLight = m_lightView * matrix;
+        for (MeshHandle handle : model->getMeshHandles()) {
+            const Mesh* mesh = meshes.get(handle);
+            Caster caster{ model.get(), mesh, glm::vec3(0.0f), glm::vec3(0.0f), dynamic };
+            transformBounds(toLight, mesh->getBoundsMin(), mesh->getBoundsMax(), caster.lightMin, caster.lightMax);
+            minZ = std::min(minZ, caster.lightMin.z);
+            maxZ = std::max(maxZ, caster.lightMax.z);
+            m_casters.push_back(caster);
+        }
+    }
+
+    // Models were removed
+    if (m_staticMatrices.size() != staticModels) {
+        m_staticMatrices.clear();
+        for (const auto& model : models) {
+            if (model->getJointPaletteOffset() < 0) {
+                m_staticMatrices[model.get()] = model->getTransform().getMatrix();
+            }
+        }
+        staticMoved = true;
+    }
+
+    if (staticMoved) {
+        for (auto& cascade : m_cascades) {
+            cascade.staticValid = false;
+        }
+    }
+
+    // Growing the depth range changes every projection, so grow in steps
+    if (!m_casters.empty() && (!m_sceneRangeValid || minZ < m_sceneMinZ || maxZ > m_sceneMaxZ)) {
+        float padding = std::max(maxZ - minZ, 1.0f) * kDepthRangePadding;
+        m_sceneMinZ = m_sceneRangeValid ? std::min(m_sceneMinZ, minZ - padding) : minZ - padding;
+        m_sceneMaxZ = m_sceneRangeValid ? std::max(m_sceneMaxZ, maxZ + padding) : maxZ + padding;
+        m_sceneRangeValid = true;
+        for (auto& cascade : m_cascades) {
+            cascade.fitted = false;
+        }
+    }
+}
+
+bool CascadedShadowMaps::fitCascade(Cascade& cascade, int index, const Camera& camera, float splitNear, float splitFar) {
+    cascade.splitFar = splitFar;
+
+    // Bounding sphere of the frustum slice. Its radius only depends on the
+    // projection, so the cascade size doesn't change as the camera turns.
+    const float tanY = std::tan(glm::radians(camera.getFov()) * 0.5f);
+    const float tanX = tanY * camera.getAspect();
+    const glm::vec3 position = camera.getPosition();
+    const glm::vec3 forward = camera.getForward();
+    const glm::vec3 right = camera.getRight();
+    const glm::vec3 up = camera.getUp();
+
+    glm::vec3 corners[8];
+    glm::vec3 center(0.0f);
+    for (int i = 0; i < 8; ++i) {
+        float depth = (i & 4) ? splitFar : splitNear;
+        float x = ((i & 1) ? 1.0f : -1.0f) * tanX * depth;
+        float y = ((i & 2) ? 1.0f : -1.0f) * tanY * depth;
+        corners[i] = position + forward * depth + right * x + up * y;
+        center += corners[i];
+    }
+    center /= 8.0f;
+
+    float radius = 0.0f;
+    for (const auto& corner : corners) {
+        radius = std::max(radius, glm::length(corner - center));
+    }
+    radius = std::ceil(radius * 16.0f) / 16.0f;
+
+    const glm::vec2 lightCenter = glm::vec2(m_lightView * glm::vec4(center, 1.0f));
+    const bool cached = index >= kFirstCachedCascade;
+
+    // Cached cascades keep their fit while the slice stays inside it
+    if (cascade.fitted && cached &&
+        std::abs(lightCenter.x - cascade.center.x) + radius <= cascade.halfSize &&
+        std::abs(lightCenter.y - cascade.center.y) + radius <= cascade.halfSize) {
+        return false;
+    }
+
+    const float halfSize = cached ? radius * kCachedCascadeSlack : radius;
+    const float texel = 2.0f * halfSize / m_resolution;
+    const glm::vec2 snapped = glm::floor(lightCenter / texel) * texel;
+
+    if (cascade.fitted && snapped == cascade.center && halfSize == cascade.halfSize) {
+        return false;
+    }
+
+    cascade.center = snapped;
+    cascade.halfSize = halfSize;
+    cascade.texelSize = texel;
+    cascade.fitted = true;
+
+    // Light view looks down -Z, nearest casters have the largest z
+    cascade.projection = glm::ortho(snapped.x - halfSize, snapped.x + halfSize,
+                                    snapped.y - halfSize, snapped.y + halfSize,
+                                    -m_sceneMaxZ, -m_sceneMinZ);
+    cascade.viewProjection = cascade.projection * m_lightView;
+    return true;
+}
+
+void CascadedShadowMaps::update(const Camera& camera, const glm::vec3& lightDir,
+                                const std::vector<std::unique_ptr<Model>>& models, unsigned int jointPaletteUnit) {
+    if (!isReady()) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    m_stats = Stats{ 0, 0, 0, 0.0, m_timer.getMilliseconds() };
+
+    setLightDirection(lightDir);
+    gatherCasters(models);
+
+    // Practical split scheme
+    const float nearPlane = camera.getNear();
+    const float farPlane = std::min(camera.getFar(), m_shadowDistance);
+    float splits[kCascadeCount + 1];
+    splits[0] = nearPlane;
+    for (int i = 1; i <= kCascadeCount; ++i) {
+        float f = static_cast<float>(i) / kCascadeCount;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, f);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * f;
+        splits[i] = kSplitLambda * logSplit + (1.0f - kSplitLambda) * uniformSplit;
+    }
+
+    GLint previousFbo = 0;
+    GLint previousViewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFbo);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    m_timer.begin();
+    glViewport(0, 0, m_resolution, m_resolution);
+    GLState::setEnabled(GL_POLYGON_OFFSET_FILL, true);
+    glPolygonOffset(2.0f, 4.0f);
+
+    for (int i = 0; i < kCascadeCount; ++i) {
+        Cascade& cascade = m_cascades[i];
+        if (fitCascade(cascade, i, camera, splits[i], splits[i + 1])) {
+            cascade.staticValid = false;
+        }
+
+        bool staticRendered = false;
+        if (!cascade.staticValid) {
+            glBindFramebuffer(GL_FRAMEBUFFER, m_staticFbos[i]);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            renderCasters(cascade, false, jointPaletteUnit);
+            cascade.staticValid = true;
+            staticRendered = true;
+            ++m_stats.staticPasses;
+        }
+
+        // The live layer only needs touching if something in it changed
+        if (staticRendered || m_hasDynamicCasters || cascade.hadDynamic) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_staticFbos[i]);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_liveFbos[i]);
+            glBlitFramebuffer(0, 0, m_resolution, m_resolution, 0, 0, m_resolution, m_resolution,
+                              GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+            if (m_hasDynamicCasters) {
+                glBindFramebuffer(GL_FRAMEBUFFER, m_liveFbos[i]);
+                renderCasters(cascade, true, jointPaletteUnit);
+                ++m_stats.dynamicPasses;
+            }
+        }
+        cascade.hadDynamic = m_hasDynamicCasters;
+    }
+
+    GLState::setEnabled(GL_POLYGON_OFFSET_FILL, false);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFbo));
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    m_timer.end();
+
+    m_stats.cpuMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void CascadedShadowMaps::renderCasters(const Cascade& cascade, bool dynamic, unsigned int jointPaletteUnit) {
+    Shader* current = nullptr;
+    const Model* currentModel = nullptr;
+
+    for (const Caster& caster : m_casters) {
+        if (caster.dynamic != dynamic) {
+            continue;
+        }
+
+        // Skinned vertices can leave the bind-pose bounds, don't cull them.
+        // Depth is not tested, everything towards the light casts.
+        if (!caster.mesh->isSkinned() &&
+            (caster.lightMax.x < cascade.center.x - cascade.halfSize ||
+             caster.lightMin.x > cascade.center.x + cascade.halfSize ||
+             caster.lightMax.y < cascade.center.y - cascade.halfSize ||
+             caster.lightMin.y > cascade.center.y + cascade.halfSize)) {
+            continue;
+        }
+
+        ShaderFeatureMask features = 0;
+        if (caster.mesh->isSkinned() && caster.model->getJointPaletteOffset() >= 0) {
+            features |= SHADER_FEATURE_SKINNING;
+        }
+        Shader* shader = m_depthShaders.get(features);
+        if (!shader) {
+            continue;
+        }
+
+        if (shader != current) {
+            current = shader;
+            current->use();
+            current->setMat4("view", m_lightView);
+            current->setMat4("projection", cascade.projection);
+            if (features & SHADER_FEATURE_SKINNING) {
+                current->setInt("jointPalette", static_cast<int>(jointPaletteUnit));
+            }
+            currentModel = nullptr;
+        }
+
+        if (caster.model != currentModel) {
+            currentModel = caster.model;
+            current->setMat4("model", caster.model->getTransform().getMatrix());
+            if (features & SHADER_FEATURE_SKINNING) {
+                current->setInt("jointOffset", caster.model->getJointPaletteOffset());
+            }
+        }
+
+        if (features & SHADER_FEATURE_SKINNING) {
+            caster.mesh->draw();
+        } else {
+            caster.mesh->drawDepth();
+        }
+        ++m_stats.draws;
+    }
+}
+
+void CascadedShadowMaps::bind(unsigned int unit) const {
+    GLState::bindTexture(unit, GL_TEXTURE_2D_ARRAY, m_liveTexture);
+}
+
+void CascadedShadowMaps::setUniforms(Shader& shader, unsigned int unit) const {
+    shader.setInt("shadowMap", static_cast<int>(unit));
+
+    glm::mat4 matrices[kCascadeCount];
+    glm::vec4 splits(0.0f);
+    glm::vec4 normalOffsets(0.0f);
+    for (int i = 0; i < kCascadeCount; ++i) {
+        matrices[i] = m_cascades[i].viewProjection;
+        splits[i] = m_cascades[i].splitFar;
+        // Push lookups off the surface by about a texel to avoid acne
+        normalOffsets[i] = m_cascades[i].texelSize * 1.5f;
+    }
+    shader.setMat4Array("shadowMatrices", matrices, kCascadeCount);
+    shader.setVec4("cascadeSplits", splits);
+    shader.setVec4("shadowNormalOffsets", normalOffsets);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "GpuTimer.hpp"
+#include "ShaderPermutations.hpp"
+#include "core/MemoryStats.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Model.hpp"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Cascaded shadow maps for the directional light.
+//
+// The view frustum up to the shadow distance is split into kCascadeCount
+// slices, each covered by an orthographic light projection sized to the
+// slice's bounding sphere and snapped to whole texels, so moving the camera
+// doesn't make shadow edges crawl.
+//
+// Static casters are rendered into a cache per cascade that stays valid
+// until the cascade's projection, the light or a static caster changes.
+// Animated (skinned) models are drawn every frame on top of a copy of the
+// cache. Cascades from kFirstCachedCascade on are fitted with some slack
+// and keep their projection while the view stays inside it, so far
+// cascades rarely re-render at all.
+class CascadedShadowMaps {
+public:
+    static constexpr int kCascadeCount = 4;
+    static constexpr int kFirstCachedCascade = 2;
+
+    struct Stats {
+        int staticPasses = 0;   // cascades whose static cache was re-rendered
+        int dynamicPasses = 0;  // cascades that got animated casters drawn
+        size_t draws = 0;
+        double cpuMilliseconds = 0.0;
+        double gpuMilliseconds = 0.0;
+    };
+
+    explicit CascadedShadowMaps(int resolution = 2048);
+    ~CascadedShadowMaps();
+
+    CascadedShadowMaps(const CascadedShadowMaps&) = delete;
+    CascadedShadowMaps& operator=(const CascadedShadowMaps&) = delete;
+
+    bool init();
+    bool isReady() const { return m_liveTexture != 0; }
+    // Picks up edited depth shaders, see ShaderPermutations::reload
+    bool reloadShaders();
+
+    void setShadowDistance(float distance) { m_shadowDistance = distance; }
+
+    // Drops the static cache and caster depth range. Needed when the scene is
+    // replaced wholesale, since new models can reuse the old ones' addresses.
+    void invalidate();
+
+    // Brings the cascades up to date, rendering only what changed. Restores
+    // the framebuffer and viewport bound on entry. Skinned casters read the
+    // joint palette from jointPaletteUnit.
+    void update(const Camera& camera, const glm::vec3& lightDir,
+                const std::vector<std::unique_ptr<Model>>& models, unsigned int jointPaletteUnit);
+
+    void bind(unsigned int unit) const;
+    // Sets the sampler and cascade uniforms on a program compiled with SHADOWS
+    void setUniforms(Shader& shader, unsigned int unit) const;
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    struct Cascade {
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        glm::vec2 center = glm::vec2(0.0f);  // light space, snapped to texels
+        float halfSize = 0.0f;
+        float splitFar = 0.0f;               // view depth where the next cascade starts
+        float texelSize = 0.0f;              // world units
+        bool fitted = false;
+        bool staticValid = false;
+        bool hadDynamic = false;
+    };
+
+    struct Caster {
+        const Model* model;
+        const Mesh* mesh;
+        glm::vec3 lightMin;  // light-view-space bounds
+        glm::vec3 lightMax;
+        bool dynamic;
+    };
+
+    void cleanup();
+    void setLightDirection(const glm::vec3& lightDir);
+    void gatherCasters(const std::vector<std::unique_ptr<Model>>& models);
+    bool fitCascade(Cascade& cascade, int index, const Camera& camera, float splitNear, float splitFar);
+    void renderCasters(const Cascade& cascade, bool dynamic, unsigned int jointPaletteUnit);
+
+    int m_resolution;
+    float m_shadowDistance = 200.0f;
+
+    ShaderPermutations m_depthShaders;
+    GLuint m_staticTexture = 0;
+    GLuint m_liveTexture = 0;
+    GLuint m_staticFbos[kCascadeCount] = {};
+    GLuint m_liveFbos[kCascadeCount] = {};
+
+    Cascade m_cascades[kCascadeCount];
+    glm::vec3 m_lightDir = glm::vec3(0.0f);
+    glm::mat4 m_lightView = glm::mat4(1.0f);
+
+    // Light-space depth range covering every caster, only ever grows until the light changes
+    float m_sceneMinZ = 0.0f;
+    float m_sceneMaxZ = 0.0f;
+    bool m_sceneRangeValid = false;
+
+    std::vector<Caster> m_casters;
+    std::unordered_map<const Model*, glm::mat4> m_staticMatrices;
+    bool m_hasDynamicCasters = false;
+
+    GpuTimer m_timer;
+    Stats m_stats;
+    TrackedMemory m_memory;
+};
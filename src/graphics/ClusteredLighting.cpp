@@ -0,0 +1,297 @@
+#include "ClusteredLighting.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TEO_CLUSTER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// Padding spheres sit far behind the camera with zero radius
+constexpr float kPadDepth = -1.0e18f;
+
+// Bit i set if sphere first + i touches the box
+unsigned touchMask4(const ClusteredLighting::SphereSet& spheres, size_t first,
+                    const glm::vec3& boxMin, const glm::vec3& boxMax) {
+#ifdef TEO_CLUSTER_SSE
+    const __m128 zero = _mm_setzero_ps();
+    __m128 x = _mm_loadu_ps(spheres.x.data() + first);
+    __m128 y = _mm_loadu_ps(spheres.y.data() + first);
+    __m128 z = _mm_loadu_ps(spheres.z.data() + first);
+    __m128 r = _mm_loadu_ps(spheres.radius.data() + first);
+
+    // Distance from the center to the box along each axis, 0 inside
+    __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.x), x), _mm_sub_ps(x, _mm_set1_ps(boxMax.x))));
+    __m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.y), y), _mm_sub_ps(y, _mm_set1_ps(boxMax.y))));
+    __m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_set1_ps(boxMin.z), z), _mm_sub_ps(z, _mm_set1_ps(boxMax.z))));
+    __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(dist2, _mm_mul_ps(r, r))));
+#else
+    unsigned mask = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        float dx = std::max(0.0f, std::max(boxMin.x - spheres.x[first + i], spheres.x[first + i] - boxMax.x));
+        float dy = std::max(0.0f, std::max(boxMin.y - spheres.y[first + i], spheres.y[first + i] - boxMax.y));
+        float dz = std::max(0.0f, std::max(boxMin.z - spheres.z[first + i], spheres.z[first + i] - boxMax.z));
+        float r = spheres.radius[first + i];
+        if (dx * dx + dy * dy + dz * dz <= r * r) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Copies the spheres of `from` that touch the box into `to`, returns how
+// many did (to.size() includes padding)
+size_t filterSpheres(const ClusteredLighting::SphereSet& from, ClusteredLighting::SphereSet& to,
+                     const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    to.clear();
+    for (size_t i = 0; i < from.size(); i += 4) {
+        unsigned mask = touchMask4(from, i, boxMin, boxMax);
+        for (size_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+            if (mask & 1u) {
+                size_t s = i + lane;
+                to.push(from.x[s], from.y[s], from.z[s], from.radius[s], from.light[s]);
+            }
+        }
+    }
+    size_t count = to.size();
+    to.pad();
+    return count;
+}
+
+// Smallest sphere around a cone with apex `apex`, unit axis `axis`, length
+// `range` and half-angle `angle`: the circumsphere of the cap for wide cones,
+// the sphere through the apex and the cap rim for narrow ones
+void coneBounds(const glm::vec3& apex, const glm::vec3& axis, float range, float angle,
+                glm::vec3& center, float& radius) {
+    float cosAngle = std::cos(angle);
+    if (angle > 0.78539816f) {
+        center = apex + axis * (range * cosAngle);
+        radius = range * std::sin(angle);
+    } else {
+        float offset = range / (2.0f * cosAngle);
+        center = apex + axis * offset;
+        radius = offset;
+    }
+}
+
+} // namespace
+
+void ClusteredLighting::SphereSet::clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+    light.clear();
+}
+
+void ClusteredLighting::SphereSet::push(float cx, float cy, float cz, float r, uint16_t index) {
+    x.push_back(cx);
+    y.push_back(cy);
+    z.push_back(cz);
+    radius.push_back(r);
+    light.push_back(index);
+}
+
+void ClusteredLighting::SphereSet::pad() {
+    while (x.size() % 4 != 0) {
+        push(0.0f, 0.0f, kPadDepth, 0.0f, 0);
+    }
+}
+
+ClusteredLighting::ClusteredLighting(JobSystem& jobs)
+    : m_jobs(jobs),
+      m_lightBuffer(GL_RGBA32F, "clustered lights"),
+      m_gridBuffer(GL_RG32UI, "light clusters"),
+      m_indexBuffer(GL_R16UI, "light indices") {
+    m_sliceIndices.resize(kSlices);
+    m_grid.resize(kClusterCount * 2);
+}
+
+void ClusteredLighting::updateFroxels(const Camera& camera) {
+    if (camera.getFov() == m_fov && camera.getAspect() == m_aspect &&
+        camera.getNear() == m_near && camera.getFar() == m_far && !m_froxelMin.empty()) {
+        return;
+    }
+    m_fov = camera.getFov();
+    m_aspect = camera.getAspect();
+    m_near = camera.getNear();
+    m_far = camera.getFar();
+
+    const float logRatio = std::log(m_far / m_near);
+    m_depthScale = kSlices / logRatio;
+    m_depthBias = -static_cast<float>(kSlices) * std::log(m_near) / logRatio;
+
+    m_sliceNear.resize(kSlices + 1);
+    for (uint32_t z = 0; z <= kSlices; ++z) {
+        m_sliceNear[z] = m_near * std::pow(m_far / m_near, static_cast<float>(z) / kSlices);
+    }
+
+    const float tanY = std::tan(glm::radians(m_fov) * 0.5f);
+    const float tanX = tanY * m_aspect;
+
+    m_froxelMin.resize(kClusterCount);
+    m_froxelMax.resize(kClusterCount);
+    for (uint32_t z = 0; z < kSlices; ++z) {
+        const float zn = m_sliceNear[z];
+        const float zf = m_sliceNear[z + 1];
+        for (uint32_t y = 0; y < kTilesY; ++y) {
+            const float ny0 = -1.0f + 2.0f * y / kTilesY;
+            const float ny1 = -1.0f + 2.0f * (y + 1) / kTilesY;
+            for (uint32_t x = 0; x < kTilesX; ++x) {
+                const float nx0 = -1.0f + 2.0f * x / kTilesX;
+                const float nx1 = -1.0f + 2.0f * (x + 1) / kTilesX;
+
+                // The tile's edges spread out with depth, so the box spans
+                // the corners on both the near and the far face
+                const size_t index = (z * kTilesY + y) * kTilesX + x;
+                m_froxelMin[index] = glm::vec3(
+                    std::min(nx0 * tanX * zn, nx0 * tanX * zf),
+                    std::min(ny0 * tanY * zn, ny0 * tanY * zf),
+                    zn);
+                m_froxelMax[index] = glm::vec3(
+                    std::max(nx1 * tanX * zn, nx1 * tanX * zf),
+                    std::max(ny1 * tanY * zn, ny1 * tanY * zf),
+                    zf);
+            }
+        }
+    }
+}
+
+void ClusteredLighting::update(const Camera& camera, const std::vector<Light>& lights) {
+    auto start = std::chrono::steady_clock::now();
+
+    updateFroxels(camera);
+
+    const glm::mat4 view = camera.getViewMatrix();
+
+    m_lightTexels.clear();
+    m_spheres.clear();
+    for (const Light& light : lights) {
+        if (light.type == LightType::Directional) {
+            continue;
+        }
+        if (m_spheres.size() == kMaxLights) {
+            break;
+        }
+        const uint16_t index = static_cast<uint16_t>(m_spheres.size());
+
+        // Point lights get a cone term of 1: scale 0, offset 1
+        float coneScale = 0.0f;
+        float coneOffset = 1.0f;
+        glm::vec3 center = light.position;
+        float radius = light.range;
+        if (light.type == LightType::Spot) {
+            float cosInner = std::cos(light.innerConeAngle);
+            float cosOuter = std::cos(light.outerConeAngle);
+            coneScale = 1.0f / std::max(0.001f, cosInner - cosOuter);
+            coneOffset = -cosOuter * coneScale;
+            coneBounds(light.position, light.direction, light.range, light.outerConeAngle, center, radius);
+        }
+
+        m_lightTexels.push_back(glm::vec4(light.position, light.range));
+        m_lightTexels.push_back(glm::vec4(light.color * light.intensity, coneScale));
+        m_lightTexels.push_back(glm::vec4(light.direction, coneOffset));
+
+        glm::vec3 viewCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+        m_spheres.push(viewCenter.x, viewCenter.y, -viewCenter.z, radius, index);
+    }
+    m_lightCount = m_spheres.size();
+    m_spheres.pad();
+
+    std::fill(m_grid.begin(), m_grid.end(), 0u);
+    m_indices.clear();
+
+    if (m_lightCount > 0) {
+        std::function<void(size_t, size_t)> task = [this](size_t begin, size_t end) {
+            for (size_t z = begin; z < end; ++z) {
+                assignSlice(static_cast<uint32_t>(z));
+            }
+        };
+        m_jobs.parallelFor(kSlices, 1, task);
+
+        // Slices wrote offsets into their own lists, rebase them onto the merged one
+        for (uint32_t z = 0; z < kSlices; ++z) {
+            const uint32_t base = static_cast<uint32_t>(m_indices.size());
+            const size_t first = z * kTilesY * kTilesX;
+            for (size_t c = first; c < first + kTilesY * kTilesX; ++c) {
+                m_grid[c * 2] += base;
+            }
+            m_indices.insert(m_indices.end(), m_sliceIndices[z].begin(), m_sliceIndices[z].end());
+        }
+    }
+    m_indexCount = m_indices.size();
+
+    if (m_lightCount > 0) {
+        // Never leave the index buffer without storage, even if no light is in view
+        if (m_indices.empty()) {
+            m_indices.push_back(0);
+        }
+        m_lightBuffer.upload(m_lightTexels);
+        m_gridBuffer.upload(m_grid);
+        m_indexBuffer.upload(m_indices);
+    }
+
+    m_updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ClusteredLighting::assignSlice(uint32_t slice) {
+    // Scratch reused across frames by each pool thread
+    thread_local SphereSet sliceSpheres;
+    thread_local SphereSet rowSpheres;
+    thread_local SphereSet froxelSpheres;
+
+    std::vector<uint16_t>& out = m_sliceIndices[slice];
+    out.clear();
+
+    // Narrow down slice -> row -> froxel, each level testing only what survived the last
+    const size_t sliceFirst = slice * kTilesY * kTilesX;
+    const size_t sliceLast = sliceFirst + kTilesY * kTilesX - 1;
+    size_t sliceCount = filterSpheres(m_spheres, sliceSpheres,
+        glm::vec3(m_froxelMin[sliceFirst].x, m_froxelMin[sliceFirst].y, m_sliceNear[slice]),
+        glm::vec3(m_froxelMax[sliceLast].x, m_froxelMax[sliceLast].y, m_sliceNear[slice + 1]));
+    if (sliceCount == 0) {
+        return;
+    }
+
+    for (uint32_t y = 0; y < kTilesY; ++y) {
+        const size_t rowFirst = sliceFirst + y * kTilesX;
+        const size_t rowLast = rowFirst + kTilesX - 1;
+        size_t rowCount = filterSpheres(sliceSpheres, rowSpheres,
+            glm::vec3(m_froxelMin[rowFirst].x, m_froxelMin[rowFirst].y, m_sliceNear[slice]),
+            glm::vec3(m_froxelMax[rowLast].x, m_froxelMax[rowFirst].y, m_sliceNear[slice + 1]));
+        if (rowCount == 0) {
+            continue;
+        }
+
+        for (uint32_t x = 0; x < kTilesX; ++x) {
+            const size_t froxel = rowFirst + x;
+            size_t count = filterSpheres(rowSpheres, froxelSpheres, m_froxelMin[froxel], m_froxelMax[froxel]);
+
+            m_grid[froxel * 2] = static_cast<uint32_t>(out.size());
+            m_grid[froxel * 2 + 1] = static_cast<uint32_t>(count);
+            out.insert(out.end(), froxelSpheres.light.begin(), froxelSpheres.light.begin() + count);
+        }
+    }
+}
+
+void ClusteredLighting::bind(unsigned int firstUnit) const {
+    m_lightBuffer.bind(firstUnit);
+    m_gridBuffer.bind(firstUnit + 1);
+    m_indexBuffer.bind(firstUnit + 2);
+}
+
+void ClusteredLighting::setUniforms(Shader& shader, unsigned int firstUnit, int viewportWidth, int viewportHeight) const {
+    shader.setInt("clusterLights", static_cast<int>(firstUnit));
+    shader.setInt("clusterGrid", static_cast<int>(firstUnit + 1));
+    shader.setInt("clusterIndices", static_cast<int>(firstUnit + 2));
+    shader.setIVec3("clusterDims", glm::ivec3(kTilesX, kTilesY, kSlices));
+    shader.setVec2("clusterTileSize", glm::vec2(static_cast<float>(viewportWidth) / kTilesX,
+                                                static_cast<float>(viewportHeight) / kTilesY));
+    shader.setVec2("clusterDepthParams", glm::vec2(m_depthScale, m_depthBias));
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Shader.hpp"
+#include "TextureBuffer.hpp"
+#include "core/JobSystem.hpp"
+#include "scene/Camera.hpp"
+#include "scene/Light.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Clustered forward lighting. The view frustum is cut into froxels, screen
+// tiles times exponentially spaced depth slices, and every frame each froxel
+// gets the list of point and spot lights whose bounds touch it. Fragments
+// look up their froxel and only shade the lights listed there.
+//
+// Assignment runs on the CPU, one depth slice per task on the job system,
+// testing four light spheres against a froxel box at a time. Results go to
+// three buffer textures:
+//   lights   RGBA32F, kLightTexels texels per light (see shaders/basic.frag)
+//   grid     RG32UI, (first index, light count) per froxel
+//   indices  R16UI, light indices of all froxels back to back
+class ClusteredLighting {
+public:
+    static constexpr uint32_t kTilesX = 16;
+    static constexpr uint32_t kTilesY = 9;
+    static constexpr uint32_t kSlices = 24;
+    static constexpr uint32_t kClusterCount = kTilesX * kTilesY * kSlices;
+    static constexpr size_t kLightTexels = 3;
+    static constexpr size_t kMaxLights = 65535;  // indices are 16 bit
+
+    explicit ClusteredLighting(JobSystem& jobs = JobSystem::instance());
+
+    // Rebuilds the clusters for this frame. Lights are in world space,
+    // directional lights are ignored (they affect every fragment anyway).
+    void update(const Camera& camera, const std::vector<Light>& lights);
+
+    // Binds the three buffers to consecutive units starting at firstUnit
+    void bind(unsigned int firstUnit) const;
+    // Sets sampler units and grid parameters on a program compiled with CLUSTERED_LIGHTING
+    void setUniforms(Shader& shader, unsigned int firstUnit, int viewportWidth, int viewportHeight) const;
+
+    size_t getLightCount() const { return m_lightCount; }
+    size_t getIndexCount() const { return m_indexCount; }
+    double getUpdateMilliseconds() const { return m_updateMs; }
+
+    // Bounding spheres in view space with z as positive depth, SoA so four
+    // can be tested at once. Always padded to a multiple of 4 with spheres
+    // that touch nothing.
+    struct SphereSet {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+        std::vector<uint16_t> light;
+
+        void clear();
+        void push(float cx, float cy, float cz, float r, uint16_t index);
+        void pad();
+        size_t size() const { return x.size(); }
+    };
+
+private:
+    void updateFroxels(const Camera& camera);
+    void assignSlice(uint32_t slice);
+
+    JobSystem& m_jobs;
+
+    // Froxel boxes in view space with z as positive depth, rebuilt when the projection changes
+    float m_fov = 0.0f;
+    float m_aspect = 0.0f;
+    float m_near = 0.0f;
+    float m_far = 0.0f;
+    std::vector<glm::vec3> m_froxelMin;
+    std::vector<glm::vec3> m_froxelMax;
+    std::vector<float> m_sliceNear;  // kSlices + 1 depths
+    float m_depthScale = 0.0f;       // slice = log(depth) * scale + bias
+    float m_depthBias = 0.0f;
+
+    SphereSet m_spheres;
+
+    // Per slice results, merged after the parallel pass
+    std::vector<std::vector<uint16_t>> m_sliceIndices;
+    std::vector<uint32_t> m_grid;  // 2 per froxel
+    std::vector<glm::vec4> m_lightTexels;
+    std::vector<uint16_t> m_indices;
+
+    size_t m_lightCount = 0;
+    size_t m_indexCount = 0;
+    double m_updateMs = 0.0;
+
+    TextureBuffer m_lightBuffer;
+    TextureBuffer m_gridBuffer;
+    TextureBuffer m_indexBuffer;
+};
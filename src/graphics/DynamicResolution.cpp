@@ -0,0 +1,198 @@
+#include "DynamicResolution.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Largest step up per change. Steps down follow the measurement in one go,
+// a frame that's too slow matters more than one that could look sharper.
+constexpr float kMaxScaleIncrease = 1.1f;
+
+// Changes smaller than this aren't worth a visible resolution jump
+constexpr float kMinScaleStep = 0.01f;
+
+} // namespace
+
+DynamicResolution::~DynamicResolution() {
+    cleanup();
+    if (m_vao) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::VertexArray, m_vao);
+    }
+}
+
+void DynamicResolution::cleanup() {
+    if (m_fbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_fbo);
+        m_fbo = 0;
+    }
+    if (m_colorTexture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_colorTexture);
+        m_colorTexture = 0;
+    }
+    if (m_depthRbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Renderbuffer, m_depthRbo);
+        m_depthRbo = 0;
+    }
+    m_targetWidth = 0;
+    m_targetHeight = 0;
+    m_memory.reset();
+}
+
+bool DynamicResolution::init() {
+    if (!m_upscale.loadFromFiles("shaders/upscale.vert", "shaders/upscale.frag")) {
+        return false;
+    }
+    glGenVertexArrays(1, &m_vao);
+    setSettings(m_settings);
+    return true;
+}
+
+bool DynamicResolution::reloadShaders() {
+    Shader upscale;
+    if (!upscale.loadFromFiles("shaders/upscale.vert", "shaders/upscale.frag")) {
+        std::cerr << "Keeping previous upscale shader, reload failed" << std::endl;
+        return false;
+    }
+    m_upscale = std::move(upscale);
+    return true;
+}
+
+void DynamicResolution::setSettings(const Settings& settings) {
+    m_settings = settings;
+    m_settings.minScale = std::clamp(m_settings.minScale, 0.1f, 1.0f);
+    m_settings.maxScale = std::clamp(m_settings.maxScale, m_settings.minScale, 1.0f);
+    m_settings.hysteresis = std::max(m_settings.hysteresis, 0.0f);
+    m_settings.sharpness = std::clamp(m_settings.sharpness, 0.0f, 1.0f);
+    m_stats.scale = std::clamp(m_stats.scale, m_settings.minScale, m_settings.maxScale);
+
+    // A new maxScale changes the target size
+    cleanup();
+}
+
+bool DynamicResolution::allocate(int width, int height) {
+    cleanup();
+
+    glGenTextures(1, &m_colorTexture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
+
+    glGenRenderbuffers(1, &m_depthRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRbo);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Dynamic resolution framebuffer incomplete (0x" << std::hex << status << std::dec << ")"
+                  << std::endl;
+        cleanup();
+        return false;
+    }
+
+    m_targetWidth = width;
+    m_targetHeight = height;
+
+    // Color is 4 bytes, depth 24 bits padded to 4
+    MemoryAssetScope scope("dynamic resolution");
+    m_memory.set(MemoryCategory::Texture, static_cast<size_t>(width) * height * 4 * 2);
+    return true;
+}
+
+void DynamicResolution::begin(int windowWidth, int windowHeight) {
+    m_windowWidth = std::max(windowWidth, 1);
+    m_windowHeight = std::max(windowHeight, 1);
+
+    const int width = std::max(static_cast<int>(std::ceil(m_windowWidth * m_settings.maxScale)), 1);
+    const int height = std::max(static_cast<int>(std::ceil(m_windowHeight * m_settings.maxScale)), 1);
+    if ((width != m_targetWidth || height != m_targetHeight) && !allocate(width, height)) {
+        // Falls back to drawing straight into the window
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_windowWidth, m_windowHeight);
+        return;
+    }
+
+    m_stats.renderWidth = std::clamp(static_cast<int>(std::lround(m_windowWidth * m_stats.scale)), 1, m_targetWidth);
+    m_stats.renderHeight = std::clamp(static_cast<int>(std::lround(m_windowHeight * m_stats.scale)), 1, m_targetHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_stats.renderWidth, m_stats.renderHeight);
+    m_timer.begin();
+}
+
+void DynamicResolution::end() {
+    if (!m_fbo) {
+        return;
+    }
+    m_timer.end();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, m_windowWidth, m_windowHeight);
+    GLState::setEnabled(GL_DEPTH_TEST, false);
+
+    const glm::vec2 targetSize(static_cast<float>(m_targetWidth), static_cast<float>(m_targetHeight));
+    m_upscale.use();
+    m_upscale.setInt("scene", 0);
+    m_upscale.setVec2("uvScale", glm::vec2(static_cast<float>(m_stats.renderWidth),
+                                           static_cast<float>(m_stats.renderHeight)) / targetSize);
+    m_upscale.setVec2("texelSize", glm::vec2(1.0f) / targetSize);
+    // Nothing to restore at native resolution
+    const bool upscaled = m_stats.renderWidth < m_windowWidth || m_stats.renderHeight < m_windowHeight;
+    m_upscale.setFloat("sharpness", upscaled ? m_settings.sharpness : 0.0f);
+
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_colorTexture);
+    GLState::bindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+
+    adapt();
+}
+
+void DynamicResolution::adapt() {
+    // Only react to new measurements, the timer reports each one once
+    if (m_timer.getResultCount() == m_lastResult) {
+        return;
+    }
+    m_lastResult = m_timer.getResultCount();
+    m_stats.gpuMilliseconds = m_timer.getMilliseconds();
+
+    if (m_settle > 0) {
+        --m_settle;
+        return;
+    }
+
+    const double target = m_settings.targetMilliseconds;
+    const double measured = m_stats.gpuMilliseconds;
+    if (measured <= 0.0 || target <= 0.0) {
+        return;
+    }
+    if (measured <= target * (1.0 + m_settings.hysteresis) && measured >= target * (1.0 - m_settings.hysteresis)) {
+        return;
+    }
+
+    // Scene cost follows the pixel count, which goes with the scale squared
+    float scale = m_stats.scale * static_cast<float>(std::sqrt(target / measured));
+    scale = std::min(scale, m_stats.scale * kMaxScaleIncrease);
+    scale = std::clamp(scale, m_settings.minScale, m_settings.maxScale);
+    if (std::abs(scale - m_stats.scale) < kMinScaleStep) {
+        return;
+    }
+
+    m_stats.scale = scale;
+    ++m_stats.scaleChanges;
+    m_settle = m_settings.settleFrames;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "GpuTimer.hpp"
+#include "Shader.hpp"
+#include "core/MemoryStats.hpp"
+#include <glad/glad.h>
+
+// Renders the scene into an offscreen target at a fraction of the window
+// size and upscales it to the default framebuffer with contrast-adaptive
+// sharpening. The fraction adapts to hold a target GPU time for the scene:
+// timestamps come back a few frames late, so after each change the scale
+// holds still for a few measurements before it may move again.
+//
+// The target is allocated at maxScale times the window and the scene is
+// drawn into its lower-left corner, so scale changes never reallocate.
+class DynamicResolution {
+public:
+    struct Settings {
+        double targetMilliseconds = 16.0;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        // Scene time must leave target * (1 +- hysteresis) before the scale moves
+        float hysteresis = 0.1f;
+        // New measurements to wait after a change, covers the timer latency
+        int settleFrames = 8;
+        // 0 is plain bilinear upscaling, 1 the strongest sharpening
+        float sharpness = 0.5f;
+    };
+
+    struct Stats {
+        float scale = 1.0f;
+        int renderWidth = 0;
+        int renderHeight = 0;
+        double gpuMilliseconds = 0.0;  // scene only, without the upscale pass
+        unsigned scaleChanges = 0;
+    };
+
+    DynamicResolution() = default;
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    bool init();
+    // Keeps the current upscale program if the edited one fails to compile
+    bool reloadShaders();
+
+    void setSettings(const Settings& settings);
+    const Settings& getSettings() const { return m_settings; }
+
+    // Binds the scaled target for a window of this size, sets the viewport
+    // to the scaled size and starts timing the scene
+    void begin(int windowWidth, int windowHeight);
+    // Stops timing, upscales into the default framebuffer and picks the next frame's scale
+    void end();
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    void cleanup();
+    bool allocate(int width, int height);
+    void adapt();
+
+    Settings m_settings;
+    Stats m_stats;
+
+    Shader m_upscale;
+    GpuTimer m_timer;
+    unsigned m_lastResult = 0;
+    int m_settle = 0;
+
+    GLuint m_fbo = 0;
+    GLuint m_colorTexture = 0;
+    GLuint m_depthRbo = 0;
+    GLuint m_vao = 0;  // empty, the full-screen triangle comes from gl_VertexID
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+    int m_windowWidth = 0;
+    int m_windowHeight = 0;
+
+    TrackedMemory m_memory;
+};
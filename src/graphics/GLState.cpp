@@ -0,0 +1,202 @@
+#include "GLState.hpp"
+
+namespace {
+
+constexpr GLuint kUnknown = ~0u;
+constexpr int kUnknownFlag = -1;
+
+// Units and targets tracked, binds outside them are always issued
+constexpr unsigned int kTextureUnits = 16;
+constexpr GLenum kTextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER };
+constexpr size_t kTargetCount = sizeof(kTextureTargets) / sizeof(kTextureTargets[0]);
+
+constexpr GLenum kCapabilities[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_POLYGON_OFFSET_FILL };
+constexpr size_t kCapabilityCount = sizeof(kCapabilities) / sizeof(kCapabilities[0]);
+
+struct State {
+    GLuint program = kUnknown;
+    GLuint vertexArray = kUnknown;
+    GLuint activeUnit = kUnknown;
+    GLuint textures[kTextureUnits][kTargetCount];
+    int capabilities[kCapabilityCount];
+    GLenum depthFunc = kUnknown;
+    int depthMask = kUnknownFlag;
+    int colorMask = kUnknownFlag;
+    GLenum blendSource = kUnknown;
+    GLenum blendDestination = kUnknown;
+
+    GLState::Counters counters;
+
+    State() { reset(); }
+
+    void reset() {
+        program = kUnknown;
+        vertexArray = kUnknown;
+        activeUnit = kUnknown;
+        for (auto& unit : textures) {
+            for (GLuint& texture : unit) {
+                texture = kUnknown;
+            }
+        }
+        for (int& enabled : capabilities) {
+            enabled = kUnknownFlag;
+        }
+        depthFunc = kUnknown;
+        depthMask = kUnknownFlag;
+        colorMask = kUnknownFlag;
+        blendSource = kUnknown;
+        blendDestination = kUnknown;
+    }
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+size_t targetIndex(GLenum target) {
+    for (size_t i = 0; i < kTargetCount; ++i) {
+        if (kTextureTargets[i] == target) {
+            return i;
+        }
+    }
+    return kTargetCount;
+}
+
+size_t capabilityIndex(GLenum capability) {
+    for (size_t i = 0; i < kCapabilityCount; ++i) {
+        if (kCapabilities[i] == capability) {
+            return i;
+        }
+    }
+    return kCapabilityCount;
+}
+
+// Stores value into cached and returns true if the call has to be issued
+template <typename T>
+bool changes(T& cached, T value) {
+    State& s = state();
+    if (cached == value) {
+        ++s.counters.skipped;
+        return false;
+    }
+    cached = value;
+    ++s.counters.issued;
+    return true;
+}
+
+} // namespace
+
+void GLState::useProgram(GLuint program) {
+    if (changes(state().program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (changes(state().vertexArray, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+bool GLState::bindTexture(unsigned int unit, GLenum target, GLuint texture) {
+    State& s = state();
+    const size_t index = targetIndex(target);
+    if (unit < kTextureUnits && index < kTargetCount && s.textures[unit][index] == texture) {
+        ++s.counters.skipped;
+        return false;
+    }
+
+    if (changes(s.activeUnit, static_cast<GLuint>(unit))) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    glBindTexture(target, texture);
+    ++s.counters.issued;
+    if (unit < kTextureUnits && index < kTargetCount) {
+        s.textures[unit][index] = texture;
+    }
+    return true;
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    State& s = state();
+    const size_t index = capabilityIndex(capability);
+    if (index < kCapabilityCount && !changes(s.capabilities[index], enabled ? 1 : 0)) {
+        return;
+    }
+    if (index == kCapabilityCount) {
+        ++s.counters.issued;
+    }
+    if (enabled) {
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (changes(state().depthFunc, func)) {
+        glDepthFunc(func);
+    }
+}
+
+void GLState::depthMask(bool enabled) {
+    if (changes(state().depthMask, enabled ? 1 : 0)) {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GLState::colorMask(bool enabled) {
+    if (changes(state().colorMask, enabled ? 1 : 0)) {
+        const GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+    }
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    State& s = state();
+    if (s.blendSource == source && s.blendDestination == destination) {
+        ++s.counters.skipped;
+        return;
+    }
+    s.blendSource = source;
+    s.blendDestination = destination;
+    ++s.counters.issued;
+    glBlendFunc(source, destination);
+}
+
+void GLState::forgetProgram(GLuint program) {
+    State& s = state();
+    if (s.program == program) {
+        s.program = kUnknown;
+    }
+}
+
+void GLState::forgetVertexArray(GLuint vao) {
+    State& s = state();
+    if (s.vertexArray == vao) {
+        s.vertexArray = kUnknown;
+    }
+}
+
+void GLState::forgetTexture(GLuint texture) {
+    for (auto& unit : state().textures) {
+        for (GLuint& bound : unit) {
+            if (bound == texture) {
+                bound = kUnknown;
+            }
+        }
+    }
+}
+
+void GLState::invalidate() {
+    state().reset();
+}
+
+const GLState::Counters& GLState::getCounters() {
+    return state().counters;
+}
+
+void GLState::resetCounters() {
+    state().counters = Counters{};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// Shadow copy of the GL state that changes between draws: the program, the
+// vertex array, texture bindings per unit and target, and the depth, blend
+// and cull switches. Calls that would change nothing are dropped, and issued
+// and skipped calls are counted until resetCounters(), so driver overhead
+// shows up per frame.
+//
+// Everything that touches this state must go through here, or call
+// invalidate() afterwards. GL thread only, one context at a time.
+class GLState {
+public:
+    struct Counters {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vao);
+    // Returns true if the bind was issued, false if the texture was already there
+    static bool bindTexture(unsigned int unit, GLenum target, GLuint texture);
+
+    static void setEnabled(GLenum capability, bool enabled);
+    static void depthFunc(GLenum func);
+    static void depthMask(bool enabled);
+    static void colorMask(bool enabled);
+    static void blendFunc(GLenum source, GLenum destination);
+
+    // Deleted names get reused by the next object, so their bindings must be dropped
+    static void forgetProgram(GLuint program);
+    static void forgetVertexArray(GLuint vao);
+    static void forgetTexture(GLuint texture);
+
+    // Forgets everything, e.g. after making a new context current. The next
+    // call of each kind is always issued.
+    static void invalidate();
+
+    static const Counters& getCounters();
+    static void resetCounters();
+};
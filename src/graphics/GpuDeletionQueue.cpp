@@ -0,0 +1,136 @@
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace {
+
+// Time is checked every this many deletions, glDelete* calls are cheap on their own
+constexpr size_t kDeletionsPerClockCheck = 16;
+
+struct Entry {
+    GpuDeletionQueue::Kind kind;
+    GLuint name;
+};
+
+struct Batch {
+    GLsync fence = nullptr;
+    std::vector<Entry> entries;
+    size_t next = 0;
+};
+
+struct Queue {
+    std::vector<Entry> open;  // pushed since the last endFrame()
+    std::deque<Batch> fenced;
+    size_t pending = 0;
+};
+
+Queue& queue() {
+    static Queue q;
+    return q;
+}
+
+void destroy(const Entry& entry) {
+    GLuint name = entry.name;
+    switch (entry.kind) {
+        case GpuDeletionQueue::Kind::Buffer:
+            glDeleteBuffers(1, &name);
+            break;
+        case GpuDeletionQueue::Kind::Texture:
+            GLState::forgetTexture(name);
+            glDeleteTextures(1, &name);
+            break;
+        case GpuDeletionQueue::Kind::VertexArray:
+            GLState::forgetVertexArray(name);
+            glDeleteVertexArrays(1, &name);
+            break;
+        case GpuDeletionQueue::Kind::Program:
+            GLState::forgetProgram(name);
+            glDeleteProgram(name);
+            break;
+        case GpuDeletionQueue::Kind::Framebuffer:
+            glDeleteFramebuffers(1, &name);
+            break;
+        case GpuDeletionQueue::Kind::Renderbuffer:
+            glDeleteRenderbuffers(1, &name);
+            break;
+    }
+}
+
+} // namespace
+
+void GpuDeletionQueue::push(Kind kind, GLuint name) {
+    if (name == 0) {
+        return;
+    }
+    Queue& q = queue();
+    q.open.push_back({ kind, name });
+    ++q.pending;
+}
+
+void GpuDeletionQueue::endFrame() {
+    Queue& q = queue();
+    if (q.open.empty()) {
+        return;
+    }
+    Batch batch;
+    batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    batch.entries.swap(q.open);
+    q.fenced.push_back(std::move(batch));
+}
+
+size_t GpuDeletionQueue::collect(double budgetMilliseconds) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    Queue& q = queue();
+    size_t deleted = 0;
+
+    while (!q.fenced.empty()) {
+        Batch& batch = q.fenced.front();
+        if (batch.fence) {
+            // Batches are fenced in order, if this one is still in flight so are the rest
+            if (glClientWaitSync(batch.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                break;
+            }
+            glDeleteSync(batch.fence);
+            batch.fence = nullptr;
+        }
+
+        while (batch.next < batch.entries.size()) {
+            if (deleted > 0 && deleted % kDeletionsPerClockCheck == 0 &&
+                std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budgetMilliseconds) {
+                q.pending -= deleted;
+                return deleted;
+            }
+            destroy(batch.entries[batch.next++]);
+            ++deleted;
+        }
+        q.fenced.pop_front();
+    }
+
+    q.pending -= deleted;
+    return deleted;
+}
+
+void GpuDeletionQueue::flush() {
+    Queue& q = queue();
+    for (Batch& batch : q.fenced) {
+        if (batch.fence) {
+            glDeleteSync(batch.fence);
+        }
+        for (size_t i = batch.next; i < batch.entries.size(); ++i) {
+            destroy(batch.entries[i]);
+        }
+    }
+    for (const Entry& entry : q.open) {
+        destroy(entry);
+    }
+    q.fenced.clear();
+    q.open.clear();
+    q.pending = 0;
+}
+
+size_t GpuDeletionQueue::getPendingCount() {
+    return queue().pending;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+// GL objects whose owners are gone, deleted once the GPU has finished the
+// frames that may still use them. Owners push names from cleanup() instead
+// of calling glDelete*, endFrame() fences what was pushed during the frame,
+// and collect() deletes batches whose fence has passed within a time budget,
+// so unloading a large model is spread over frames instead of stalling one.
+//
+// GL thread only. Names still queued when the context is destroyed go with it.
+class GpuDeletionQueue {
+public:
+    enum class Kind : uint8_t {
+        Buffer,
+        Texture,
+        VertexArray,
+        Program,
+        Framebuffer,
+        Renderbuffer
+    };
+
+    // Name 0 is ignored
+    static void push(Kind kind, GLuint name);
+
+    // Fences the names pushed since the last call. Call once per frame after its draws.
+    static void endFrame();
+    // Deletes names the GPU is done with for up to budgetMilliseconds (at
+    // least one if any is ready), returns how many were deleted
+    static size_t collect(double budgetMilliseconds);
+    // Deletes everything queued right away, the driver keeps in-flight storage alive
+    static void flush();
+
+    static size_t getPendingCount();
+};
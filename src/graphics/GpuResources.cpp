@@ -0,0 +1,24 @@
+#include "GpuResources.hpp"
+
+// Never destroyed: by static destruction time the GL context is gone, and
+// whatever still lives in a pool is freed with it.
+
+ResourcePool<Mesh>& GpuResources::meshes() {
+    static auto* pool = new ResourcePool<Mesh>();
+    return *pool;
+}
+
+ResourcePool<Texture>& GpuResources::textures() {
+    static auto* pool = new ResourcePool<Texture>();
+    return *pool;
+}
+
+ResourcePool<TextureArray>& GpuResources::textureArrays() {
+    static auto* pool = new ResourcePool<TextureArray>();
+    return *pool;
+}
+
+MaterialTable& GpuResources::materials() {
+    static auto* table = new MaterialTable();
+    return *table;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "MaterialTable.hpp"
+#include "Texture.hpp"
+#include "TextureArray.hpp"
+#include "core/ResourcePool.hpp"
+
+// Pools holding every mesh and texture, so per-frame passes walk contiguous
+// storage instead of chasing one heap allocation per resource. Whoever
+// creates a resource destroys its handle (models own what the loader made
+// for them); the GL names are released through GpuDeletionQueue.
+//
+// GL thread only. Pointers from get() are only valid until the next create()
+// or destroy() on the same pool, so keep handles across frames, not pointers.
+class GpuResources {
+public:
+    static ResourcePool<Mesh>& meshes();
+    static ResourcePool<Texture>& textures();
+    static ResourcePool<TextureArray>& textureArrays();
+    // Shared by every model, see Mesh::setMaterial
+    static MaterialTable& materials();
+};
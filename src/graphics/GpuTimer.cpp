@@ -0,0 +1,59 @@
+#include "GpuTimer.hpp"
+
+GpuTimer::~GpuTimer() {
+    if (m_queries[0]) {
+        glDeleteQueries(kQueryCount * 2, m_queries);
+    }
+}
+
+void GpuTimer::begin() {
+    if (!m_queries[0]) {
+        glGenQueries(kQueryCount * 2, m_queries);
+    }
+
+    collect();
+
+    // All queries still in flight, skip this measurement rather than wait
+    if (m_pending[m_next]) {
+        return;
+    }
+
+    glQueryCounter(m_queries[m_next * 2], GL_TIMESTAMP);
+    m_running = true;
+}
+
+void GpuTimer::end() {
+    if (!m_running) {
+        return;
+    }
+
+    glQueryCounter(m_queries[m_next * 2 + 1], GL_TIMESTAMP);
+    m_pending[m_next] = true;
+    m_next = (m_next + 1) % kQueryCount;
+    m_running = false;
+}
+
+void GpuTimer::collect() {
+    // Oldest first, so the last one read is the newest result
+    for (int i = 0; i < kQueryCount; ++i) {
+        int index = (m_next + i) % kQueryCount;
+        if (!m_pending[index]) {
+            continue;
+        }
+
+        // The end timestamp lands last, once it's available both are
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[index * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(m_queries[index * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_queries[index * 2 + 1], GL_QUERY_RESULT, &end);
+        m_milliseconds = end > start ? static_cast<double>(end - start) / 1.0e6 : 0.0;
+        m_pending[index] = false;
+        ++m_resultCount;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Measures GPU time of a span of commands with a pair of GL_TIMESTAMP
+// queries. Results are read a few frames late from a small ring of query
+// pairs, so reading never stalls the pipeline. Unlike GL_TIME_ELAPSED,
+// timestamps let timers nest, e.g. the shadow pass inside a whole frame.
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // Most recent completed measurement, 0 until one is available
+    double getMilliseconds() const { return m_milliseconds; }
+    // Counts completed measurements, changes whenever getMilliseconds() does
+    unsigned getResultCount() const { return m_resultCount; }
+
+private:
+    static constexpr int kQueryCount = 4;
+
+    void collect();
+
+    // Start and end timestamp of each slot
+    GLuint m_queries[kQueryCount * 2] = {};
+    bool m_pending[kQueryCount] = {};
+    int m_next = 0;
+    bool m_running = false;
+    double m_milliseconds = 0.0;
+    unsigned m_resultCount = 0;
+};
@@ -0,0 +1,401 @@
+#include "HiZCulling.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// The depth format of a framebuffer's depth attachment, 0 if it has none
+GLenum depthFormatOf(GLint framebuffer) {
+    const GLenum attachment = framebuffer == 0 ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+    GLint objectType = GL_NONE;
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE,
+                                          &objectType);
+    if (objectType == GL_NONE) {
+        return 0;
+    }
+    GLint depthBits = 0;
+    GLint stencilBits = 0;
+    GLint componentType = 0;
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE,
+                                          &depthBits);
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE,
+                                          &stencilBits);
+    glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &componentType);
+    if (depthBits == 0) {
+        return 0;
+    }
+    if (componentType == GL_FLOAT) {
+        return stencilBits > 0 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+    }
+    if (depthBits <= 16 && stencilBits == 0) {
+        return GL_DEPTH_COMPONENT16;
+    }
+    return stencilBits > 0 ? GL_DEPTH24_STENCIL8 : GL_DEPTH_COMPONENT24;
+}
+
+// Pixel format and type glTexImage2D takes with a depth internal format
+void depthTransferFormat(GLenum internalFormat, GLenum& format, GLenum& type) {
+    switch (internalFormat) {
+        case GL_DEPTH24_STENCIL8:
+            format = GL_DEPTH_STENCIL;
+            type = GL_UNSIGNED_INT_24_8;
+            break;
+        case GL_DEPTH32F_STENCIL8:
+            format = GL_DEPTH_STENCIL;
+            type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+            break;
+        case GL_DEPTH_COMPONENT32F:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_FLOAT;
+            break;
+        case GL_DEPTH_COMPONENT16:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_UNSIGNED_SHORT;
+            break;
+        default:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_UNSIGNED_INT;
+            break;
+    }
+}
+
+int levelCount(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2) {
+        ++levels;
+    }
+    return levels;
+}
+
+} // namespace
+
+HiZCulling::HiZCulling()
+    : m_bounds(GL_RGBA32F, "occlusion bounds") {}
+
+HiZCulling::~HiZCulling() {
+    cleanup();
+    for (QuerySet& set : m_querySets) {
+        if (!set.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(set.queries.size()), set.queries.data());
+        }
+    }
+    if (m_copyFbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_copyFbo);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_reduceFbo);
+    }
+    if (m_vao) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::VertexArray, m_vao);
+    }
+}
+
+void HiZCulling::cleanup() {
+    for (Pyramid& pyramid : m_pyramids) {
+        if (pyramid.texture) {
+            GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, pyramid.texture);
+        }
+        pyramid = Pyramid{};
+    }
+    if (m_depthCopy) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_depthCopy);
+        m_depthCopy = 0;
+    }
+    m_depthCopyFormat = 0;
+    m_depthCopyWidth = 0;
+    m_depthCopyHeight = 0;
+    m_hasPrevious = false;
+    m_memory.reset();
+}
+
+bool HiZCulling::loadShaders(Shader& reduce, Shader& test) {
+    // The reduction shares the upscale pass's full-screen triangle
+    return reduce.loadFromFiles("shaders/upscale.vert", "shaders/hiz_reduce.frag") &&
+           test.loadFromFiles("shaders/hiz_test.vert", "shaders/hiz_test.frag");
+}
+
+bool HiZCulling::init() {
+    if (!loadShaders(m_reduce, m_test)) {
+        return false;
+    }
+    glGenVertexArrays(1, &m_vao);
+    glGenFramebuffers(1, &m_copyFbo);
+    glGenFramebuffers(1, &m_reduceFbo);
+    return true;
+}
+
+bool HiZCulling::reloadShaders() {
+    Shader reduce;
+    Shader test;
+    if (!loadShaders(reduce, test)) {
+        std::cerr << "Keeping previous occlusion culling shaders, reload failed" << std::endl;
+        return false;
+    }
+    m_reduce = std::move(reduce);
+    m_test = std::move(test);
+    return true;
+}
+
+void HiZCulling::allocatePyramid(Pyramid& pyramid, int width, int height) {
+    if (pyramid.texture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, pyramid.texture);
+    }
+    pyramid.width = width;
+    pyramid.height = height;
+    pyramid.levels = levelCount(width, height);
+
+    glGenTextures(1, &pyramid.texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, pyramid.texture);
+    for (int level = 0; level < pyramid.levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(width >> level, 1), std::max(height >> level, 1), 0,
+                     GL_RED, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pyramid.levels - 1);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
+    updateMemory();
+}
+
+void HiZCulling::updateMemory() {
+    // R32F mip chains take about 4/3 of their top level, the depth copy 4 bytes a pixel
+    size_t bytes = static_cast<size_t>(m_depthCopyWidth) * m_depthCopyHeight * 4;
+    for (const Pyramid& pyramid : m_pyramids) {
+        bytes += static_cast<size_t>(pyramid.width) * pyramid.height * 4 * 4 / 3;
+    }
+    MemoryAssetScope scope("occlusion pyramid");
+    m_memory.set(MemoryCategory::Texture, bytes);
+}
+
+bool HiZCulling::allocateDepthCopy(GLint framebuffer, int width, int height) {
+    const GLenum format = depthFormatOf(framebuffer);
+    if (format == 0) {
+        return false;
+    }
+    if (m_depthCopy && format == m_depthCopyFormat && width == m_depthCopyWidth && height == m_depthCopyHeight) {
+        return true;
+    }
+    if (m_depthCopy) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_depthCopy);
+    }
+
+    GLenum transferFormat = 0;
+    GLenum transferType = 0;
+    depthTransferFormat(format, transferFormat, transferType);
+    glGenTextures(1, &m_depthCopy);
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_depthCopy);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, transferFormat, transferType,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
+
+    // Drops a depth-stencil attachment left from a format change too
+    glBindFramebuffer(GL_FRAMEBUFFER, m_copyFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    const GLenum attachment = transferFormat == GL_DEPTH_STENCIL ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+    glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, m_depthCopy, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Occlusion depth copy framebuffer incomplete (0x" << std::hex << status << std::dec << ")"
+                  << std::endl;
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_depthCopy);
+        m_depthCopy = 0;
+        return false;
+    }
+
+    m_depthCopyFormat = format;
+    m_depthCopyWidth = width;
+    m_depthCopyHeight = height;
+    updateMemory();
+    return true;
+}
+
+void HiZCulling::beginFrame(const glm::mat4& viewProjection, const std::vector<glm::vec4>& bounds,
+                            unsigned int firstUnit) {
+    collect();
+
+    m_viewProjection = viewProjection;
+    m_objectCount = bounds.size() / 2;
+    m_firstUnit = firstUnit;
+    m_bounds.upload(bounds);
+
+    // A set whose results never arrived is reused anyway, only its counts are lost
+    m_querySet = (m_querySet + 1) % kQuerySetCount;
+    QuerySet& set = m_querySets[m_querySet];
+    set.pending = false;
+    set.objectCount = m_objectCount;
+    const size_t queryCount = m_objectCount * 2;
+    if (set.queries.size() < queryCount) {
+        const size_t first = set.queries.size();
+        set.queries.resize(queryCount);
+        glGenQueries(static_cast<GLsizei>(queryCount - first), set.queries.data() + first);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    m_passPosition = glm::vec2(-1.0f + 1.0f / static_cast<float>(std::max(viewport[2], 1)),
+                               -1.0f + 1.0f / static_cast<float>(std::max(viewport[3], 1)));
+
+    runTest(Phase::Previous);
+}
+
+void HiZCulling::buildAndTest() {
+    GLint framebuffer = 0;
+    GLint readFramebuffer = 0;
+    GLint viewport[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const int width = std::max(viewport[2], 1);
+    const int height = std::max(viewport[3], 1);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    const bool copied = allocateDepthCopy(framebuffer, width, height);
+    Pyramid& pyramid = m_pyramids[m_current];
+    if (copied && (pyramid.width != width || pyramid.height != height)) {
+        allocatePyramid(pyramid, width, height);
+    }
+
+    if (copied) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_copyFbo);
+        glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + width, viewport[1] + height, 0, 0, width, height,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+        GLState::setEnabled(GL_DEPTH_TEST, false);
+        GLState::depthMask(false);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_reduceFbo);
+        m_reduce.use();
+        m_reduce.setInt("source", 0);
+        GLState::bindVertexArray(m_vao);
+
+        // Level 0 copies the depth, every level after it reduces the one above.
+        // Limiting the pyramid to the level read keeps it from also being the target.
+        for (int level = 0; level < pyramid.levels; ++level) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramid.texture, level);
+            glViewport(0, 0, std::max(width >> level, 1), std::max(height >> level, 1));
+            if (level == 0) {
+                GLState::bindTexture(0, GL_TEXTURE_2D, m_depthCopy);
+            } else {
+                GLState::bindTexture(0, GL_TEXTURE_2D, pyramid.texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+            }
+            m_reduce.setInt("downsample", level > 0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        GLState::bindTexture(0, GL_TEXTURE_2D, pyramid.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pyramid.levels - 1);
+        GLState::bindTexture(0, GL_TEXTURE_2D, 0);
+
+        GLState::depthMask(true);
+        GLState::setEnabled(GL_DEPTH_TEST, true);
+    }
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(readFramebuffer));
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    // Without a copy (no depth buffer) the test still runs, every draw needs its query
+    if (!copied) {
+        pyramid.width = 0;
+    }
+    runTest(Phase::Revealed);
+}
+
+void HiZCulling::runTest(Phase phase) {
+    if (m_objectCount == 0) {
+        return;
+    }
+    const Pyramid& pyramid = m_pyramids[m_current];
+    const Pyramid& previous = m_pyramids[1 - m_current];
+
+    m_test.use();
+    m_test.setInt("bounds", static_cast<int>(m_firstUnit));
+    m_test.setInt("pyramid", static_cast<int>(m_firstUnit + 1));
+    m_test.setInt("previousPyramid", static_cast<int>(m_firstUnit + 2));
+    m_test.setMat4("viewProjection", m_viewProjection);
+    m_test.setMat4("previousViewProjection", m_previousViewProjection);
+    m_test.setInt("hasPyramid", phase == Phase::Revealed && pyramid.width > 0);
+    m_test.setInt("hasPrevious", m_hasPrevious && previous.width > 0);
+    m_test.setInt("revealed", phase == Phase::Revealed);
+    m_test.setVec2("passPosition", m_passPosition);
+
+    m_bounds.bind(m_firstUnit);
+    GLState::bindTexture(m_firstUnit + 1, GL_TEXTURE_2D, pyramid.texture);
+    GLState::bindTexture(m_firstUnit + 2, GL_TEXTURE_2D, previous.texture);
+    GLState::bindVertexArray(m_vao);
+
+    // Only the query counts the passing sample, nothing is written
+    GLState::colorMask(false);
+    GLState::depthMask(false);
+    GLState::setEnabled(GL_DEPTH_TEST, false);
+
+    const QuerySet& set = m_querySets[m_querySet];
+    const size_t offset = phase == Phase::Revealed ? 1 : 0;
+    for (size_t i = 0; i < m_objectCount; ++i) {
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, set.queries[i * 2 + offset]);
+        glDrawArrays(GL_POINTS, static_cast<GLint>(i), 1);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+
+    GLState::setEnabled(GL_DEPTH_TEST, true);
+    GLState::depthMask(true);
+    GLState::colorMask(true);
+}
+
+void HiZCulling::endFrame() {
+    m_querySets[m_querySet].pending = m_objectCount > 0;
+    if (m_pyramids[m_current].width > 0) {
+        m_previousViewProjection = m_viewProjection;
+        m_hasPrevious = true;
+        m_current = 1 - m_current;
+    }
+}
+
+void HiZCulling::beginConditional(uint32_t object, Phase phase) const {
+    const size_t offset = phase == Phase::Revealed ? 1 : 0;
+    // The GPU waits for the test, the CPU never does
+    glBeginConditionalRender(m_querySets[m_querySet].queries[object * 2 + offset], GL_QUERY_WAIT);
+}
+
+void HiZCulling::endConditional() {
+    glEndConditionalRender();
+}
+
+void HiZCulling::collect() {
+    // Oldest first, so the last set read is the newest result
+    for (int i = 1; i <= kQuerySetCount; ++i) {
+        QuerySet& set = m_querySets[(m_querySet + i) % kQuerySetCount];
+        if (!set.pending) {
+            continue;
+        }
+
+        // Queries complete in order, once the last is available all are
+        GLint available = 0;
+        glGetQueryObjectiv(set.queries[set.objectCount * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+
+        Stats stats;
+        stats.tested = set.objectCount;
+        size_t visible = 0;
+        for (size_t object = 0; object < set.objectCount; ++object) {
+            GLuint previous = 0;
+            GLuint revealed = 0;
+            glGetQueryObjectuiv(set.queries[object * 2], GL_QUERY_RESULT, &previous);
+            glGetQueryObjectuiv(set.queries[object * 2 + 1], GL_QUERY_RESULT, &revealed);
+            visible += previous != 0 || revealed != 0;
+            stats.revealed += revealed != 0;
+        }
+        stats.culled = stats.tested - visible;
+        m_stats = stats;
+        set.pending = false;
+    }
+}
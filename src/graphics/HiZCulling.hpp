@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Shader.hpp"
+#include "TextureBuffer.hpp"
+#include "core/MemoryStats.hpp"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// GPU occlusion culling against a hierarchical depth pyramid, without
+// reading anything back on the CPU.
+//
+// Each frame tests the world bounds of the draws twice, each test a single
+// point drawn inside an ANY_SAMPLES_PASSED query that the draw then uses
+// for conditional rendering:
+//  - Previous: was the object visible against last frame's pyramid, seen
+//    from last frame's camera. These draws lay down this frame's occluders.
+//  - Revealed: after the pyramid is rebuilt from that depth, was the object
+//    hidden last frame but may be visible now. Objects coming into view
+//    draw in the same frame instead of popping in a frame late.
+// An object passes at most one of the two, so drawing it under each query
+// in turn draws it at most once.
+//
+// The pyramid is an R32F mip chain holding the farthest depth per texel,
+// reduced from a copy of the bound framebuffer's depth. Culled counts come
+// back a few frames late, from a small ring of query sets.
+class HiZCulling {
+public:
+    enum class Phase { Previous, Revealed };
+
+    // Counted over the last frame whose queries have completed
+    struct Stats {
+        size_t tested = 0;
+        size_t revealed = 0;  // passed only the second test
+        size_t culled = 0;    // passed neither
+    };
+
+    HiZCulling();
+    ~HiZCulling();
+
+    HiZCulling(const HiZCulling&) = delete;
+    HiZCulling& operator=(const HiZCulling&) = delete;
+
+    bool init();
+    bool isReady() const { return m_vao != 0; }
+    // Keeps the current programs if the edited ones fail to compile
+    bool reloadShaders();
+
+    // Starts a frame, bounds holds a min and a max corner per object in
+    // world space. Runs the Previous test; the textures use firstUnit and
+    // the two units after it.
+    void beginFrame(const glm::mat4& viewProjection, const std::vector<glm::vec4>& bounds, unsigned int firstUnit);
+    // Builds this frame's pyramid from the depth drawn so far in the bound
+    // framebuffer's viewport, then runs the Revealed test. Restores the
+    // framebuffer and viewport.
+    void buildAndTest();
+    // This frame's pyramid and camera become the previous ones
+    void endFrame();
+
+    // Draws until endConditional() only if the object passed that test
+    void beginConditional(uint32_t object, Phase phase) const;
+    static void endConditional();
+
+    size_t getObjectCount() const { return m_objectCount; }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    static constexpr int kQuerySetCount = 3;
+
+    struct Pyramid {
+        GLuint texture = 0;
+        int width = 0;
+        int height = 0;
+        int levels = 0;
+    };
+
+    // Two queries per object, Previous then Revealed
+    struct QuerySet {
+        std::vector<GLuint> queries;
+        size_t objectCount = 0;
+        bool pending = false;
+    };
+
+    bool loadShaders(Shader& reduce, Shader& test);
+    void cleanup();
+    void allocatePyramid(Pyramid& pyramid, int width, int height);
+    // Matches the bound framebuffer's depth format, false if it has no depth
+    bool allocateDepthCopy(GLint framebuffer, int width, int height);
+    void updateMemory();
+    void runTest(Phase phase);
+    void collect();
+
+    Shader m_reduce;
+    Shader m_test;
+    GLuint m_vao = 0;  // empty, points and the full-screen triangle come from gl_VertexID
+
+    Pyramid m_pyramids[2];
+    int m_current = 0;  // built this frame, the other one is last frame's
+    bool m_hasPrevious = false;
+    glm::mat4 m_viewProjection = glm::mat4(1.0f);
+    glm::mat4 m_previousViewProjection = glm::mat4(1.0f);
+
+    // Same format as the framebuffer's depth, blits need that
+    GLuint m_depthCopy = 0;
+    GLenum m_depthCopyFormat = 0;
+    int m_depthCopyWidth = 0;
+    int m_depthCopyHeight = 0;
+    GLuint m_copyFbo = 0;
+    GLuint m_reduceFbo = 0;
+
+    TextureBuffer m_bounds;
+    size_t m_objectCount = 0;
+    unsigned int m_firstUnit = 0;
+    glm::vec2 m_passPosition = glm::vec2(0.0f);
+
+    QuerySet m_querySets[kQuerySetCount];
+    int m_querySet = 0;
+    Stats m_stats;
+
+    TrackedMemory m_memory;
+};
@@ -0,0 +1,74 @@
+#include "MaterialTable.hpp"
+#include <cstring>
+
+MaterialTable::MaterialTable()
+    : m_buffer(GL_RGBA32F, "material table") {}
+
+MaterialTable::Entry MaterialTable::pack(const Material& material) {
+    Entry entry;
+    entry.texels[0] = material.baseColorFactor;
+    // The cutoff only matters to masked materials, don't let it split the others
+    const float cutoff = material.alphaMode == AlphaMode::Mask ? material.alphaCutoff : 0.0f;
+    entry.texels[1] = glm::vec4(material.emissiveFactor, cutoff);
+    entry.texels[2] = glm::vec4(material.metallicFactor, material.roughnessFactor,
+                                material.normalScale, material.occlusionStrength);
+    return entry;
+}
+
+size_t MaterialTable::EntryHash::operator()(const Entry& entry) const {
+    // FNV-1a over the float bits, equal entries compare bitwise too
+    uint32_t words[kTexelsPerEntry * 4];
+    std::memcpy(words, entry.texels, sizeof(words));
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : words) {
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool MaterialTable::EntryEqual::operator()(const Entry& a, const Entry& b) const {
+    return std::memcmp(a.texels, b.texels, sizeof(a.texels)) == 0;
+}
+
+uint32_t MaterialTable::acquire(const Material& material) {
+    const Entry entry = pack(material);
+    auto found = m_lookup.find(entry);
+    if (found != m_lookup.end()) {
+        ++m_references[found->second];
+        return found->second;
+    }
+
+    uint32_t index;
+    if (!m_freeEntries.empty()) {
+        index = m_freeEntries.back();
+        m_freeEntries.pop_back();
+        m_entries[index] = entry;
+        m_references[index] = 1;
+    } else {
+        index = static_cast<uint32_t>(m_entries.size());
+        m_entries.push_back(entry);
+        m_references.push_back(1);
+    }
+    m_lookup.emplace(entry, index);
+    m_dirty = true;
+    return index;
+}
+
+void MaterialTable::release(uint32_t entry) {
+    if (entry >= m_references.size() || m_references[entry] == 0) {
+        return;
+    }
+    if (--m_references[entry] == 0) {
+        // The stale texels stay in the uploaded table until the slot is reused
+        m_lookup.erase(m_entries[entry]);
+        m_freeEntries.push_back(entry);
+    }
+}
+
+void MaterialTable::bind(unsigned int unit) {
+    if (m_dirty) {
+        m_buffer.upload(m_entries);
+        m_dirty = false;
+    }
+    m_buffer.bind(unit);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "TextureBuffer.hpp"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Factors of every material in use, packed into one buffer texture that
+// shaders index by materialIndex. Materials with the same factors share an
+// entry whichever model they came from; textures are not part of an entry,
+// draws bind them. Entries are reference counted, released slots are reused.
+//
+// Entry layout, kTexelsPerEntry RGBA32F texels:
+//   base color factor
+//   emissive factor, alpha cutoff
+//   metallic, roughness, normal scale, occlusion strength
+class MaterialTable {
+public:
+    static constexpr int kTexelsPerEntry = 3;
+
+    MaterialTable();
+
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    // Returns the entry holding these factors, adding it if needed
+    uint32_t acquire(const Material& material);
+    void release(uint32_t entry);
+
+    // Uploads the table if entries were added since the last call, then binds it
+    void bind(unsigned int unit);
+
+    // Live entries, at most one per distinct set of factors
+    size_t getEntryCount() const { return m_lookup.size(); }
+
+private:
+    struct Entry {
+        glm::vec4 texels[kTexelsPerEntry];
+    };
+    struct EntryHash {
+        size_t operator()(const Entry& entry) const;
+    };
+    struct EntryEqual {
+        bool operator()(const Entry& a, const Entry& b) const;
+    };
+
+    static Entry pack(const Material& material);
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_references;
+    std::vector<uint32_t> m_freeEntries;
+    std::unordered_map<Entry, uint32_t, EntryHash, EntryEqual> m_lookup;
+    bool m_dirty = false;
+    TextureBuffer m_buffer;
+};
@@ -1,65 +1,213 @@
 #include "Mesh.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GpuResources.hpp"
+#include "GLState.hpp"
+#include "core/Arena.hpp"
+#include <utility>
 
 Mesh::~Mesh() {
     cleanup();
+    releaseMaterial();
 }
 
 Mesh::Mesh(Mesh&& other) noexcept
-    : m_vao(other.m_vao), m_vbo(other.m_vbo), m_ebo(other.m_ebo),
-      m_indexCount(other.m_indexCount), m_material(std::move(other.m_material)) {
+    : m_vao(other.m_vao), m_vbo(other.m_vbo), m_ebo(other.m_ebo), m_skinVbo(other.m_skinVbo),
+      m_depthVao(other.m_depthVao), m_positionVbo(other.m_positionVbo),
+      m_indexCount(other.m_indexCount), m_material(std::move(other.m_material)),
+      m_loadState(other.m_loadState), m_subMeshes(std::move(other.m_subMeshes)), m_meshlets(std::move(other.m_meshlets)),
+      m_boundsMin(other.m_boundsMin), m_boundsMax(other.m_boundsMax),
+      m_vertexMemory(std::move(other.m_vertexMemory)), m_indexMemory(std::move(other.m_indexMemory)),
+      m_skinMemory(std::move(other.m_skinMemory)), m_positionMemory(std::move(other.m_positionMemory)) {
     other.m_vao = 0;
     other.m_vbo = 0;
     other.m_ebo = 0;
+    other.m_skinVbo = 0;
+    other.m_depthVao = 0;
+    other.m_positionVbo = 0;
     other.m_indexCount = 0;
+    other.m_material.tableIndex = UINT32_MAX;
 }
 
 Mesh& Mesh::operator=(Mesh&& other) noexcept {
     if (this != &other) {
         cleanup();
+        releaseMaterial();
         m_vao = other.m_vao;
         m_vbo = other.m_vbo;
         m_ebo = other.m_ebo;
+        m_skinVbo = other.m_skinVbo;
+        m_depthVao = other.m_depthVao;
+        m_positionVbo = other.m_positionVbo;
         m_indexCount = other.m_indexCount;
         m_material = std::move(other.m_material);
+        m_loadState = other.m_loadState;
+        m_subMeshes = std::move(other.m_subMeshes);
+        m_meshlets = std::move(other.m_meshlets);
+        m_boundsMin = other.m_boundsMin;
+        m_boundsMax = other.m_boundsMax;
+        m_vertexMemory = std::move(other.m_vertexMemory);
+        m_indexMemory = std::move(other.m_indexMemory);
+        m_skinMemory = std::move(other.m_skinMemory);
+        m_positionMemory = std::move(other.m_positionMemory);
         other.m_vao = 0;
         other.m_vbo = 0;
         other.m_ebo = 0;
+        other.m_skinVbo = 0;
+        other.m_depthVao = 0;
+        other.m_positionVbo = 0;
         other.m_indexCount = 0;
+        other.m_material.tableIndex = UINT32_MAX;
     }
     return *this;
 }
 
+void Mesh::setMaterial(const Material& material) {
+    // Acquire first, re-setting the same factors must not free the entry in between
+    const uint32_t entry = GpuResources::materials().acquire(material);
+    releaseMaterial();
+    m_material = material;
+    m_material.tableIndex = entry;
+}
+
+void Mesh::releaseMaterial() {
+    if (m_material.tableIndex != UINT32_MAX) {
+        GpuResources::materials().release(m_material.tableIndex);
+        m_material.tableIndex = UINT32_MAX;
+    }
+}
+
 void Mesh::cleanup() {
     if (m_vao) {
-        glDeleteVertexArrays(1, &m_vao);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::VertexArray, m_vao);
         m_vao = 0;
     }
     if (m_vbo) {
-        glDeleteBuffers(1, &m_vbo);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, m_vbo);
         m_vbo = 0;
     }
     if (m_ebo) {
-        glDeleteBuffers(1, &m_ebo);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, m_ebo);
         m_ebo = 0;
     }
+    if (m_skinVbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, m_skinVbo);
+        m_skinVbo = 0;
+    }
+    if (m_depthVao) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::VertexArray, m_depthVao);
+        m_depthVao = 0;
+    }
+    if (m_positionVbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, m_positionVbo);
+        m_positionVbo = 0;
+    }
+    m_vertexMemory.reset();
+    m_indexMemory.reset();
+    m_skinMemory.reset();
+    m_positionMemory.reset();
 }
 
-void Mesh::setup(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+void Mesh::setup(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount) {
+    glm::vec3 boundsMin = vertexCount == 0 ? glm::vec3(0.0f) : vertices[0].position;
+    glm::vec3 boundsMax = boundsMin;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        boundsMin = glm::min(boundsMin, vertices[i].position);
+        boundsMax = glm::max(boundsMax, vertices[i].position);
+    }
+
+    // Tightly packed positions for depth-only passes, a third of the fetch bandwidth
+    // of the interleaved stream. Shares the index buffer with the main VAO.
+    ArenaScope scratch(LinearArena::forThread());
+    glm::vec3* positions = scratch.arena().allocateArray<glm::vec3>(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        positions[i] = vertices[i].position;
+    }
+
+    // Setting up a live mesh again with the same counts (a reload) refills
+    // its buffers in place, draws and VAOs keep referring to the same objects
+    if (m_vao && indexCount == static_cast<size_t>(m_indexCount) &&
+        vertexCount * sizeof(Vertex) == m_vertexMemory.getBytes()) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, vertexCount * sizeof(Vertex), vertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_positionVbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, vertexCount * sizeof(glm::vec3), positions);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, indexCount * sizeof(unsigned int), indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    } else {
+        createBuffers(vertexCount, indexCount, vertices, positions, indices);
+    }
+    m_boundsMin = boundsMin;
+    m_boundsMax = boundsMax;
+}
+
+bool Mesh::mapForWrite(size_t vertexCount, size_t indexCount, MappedGeometry& geometry) {
+    createBuffers(vertexCount, indexCount, nullptr, nullptr, nullptr);
+
+    // Fresh storage nothing has used yet, so no sync and no need to keep old contents
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    auto map = [access](GLuint buffer, size_t bytes) -> void* {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        return bytes > 0 ? glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(bytes), access) : nullptr;
+    };
+    geometry.vertices = static_cast<Vertex*>(map(m_vbo, vertexCount * sizeof(Vertex)));
+    geometry.positions = static_cast<glm::vec3*>(map(m_positionVbo, vertexCount * sizeof(glm::vec3)));
+    geometry.indices = static_cast<unsigned int*>(map(m_ebo, indexCount * sizeof(unsigned int)));
+
+    if (!geometry.vertices || !geometry.positions || !geometry.indices) {
+        const std::pair<GLuint, void*> buffers[] = {
+            { m_vbo, geometry.vertices }, { m_positionVbo, geometry.positions }, { m_ebo, geometry.indices }
+        };
+        for (const auto& [buffer, pointer] : buffers) {
+            if (pointer) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            }
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        cleanup();
+        geometry = MappedGeometry{};
+        return false;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return true;
+}
+
+bool Mesh::unmapWrite(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    bool intact = true;
+    for (GLuint buffer : { m_vbo, m_positionVbo, m_ebo }) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        // GL_FALSE means the driver lost the contents while mapped (e.g. a mode switch)
+        if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_FALSE) {
+            intact = false;
+        }
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_boundsMin = boundsMin;
+    m_boundsMax = boundsMax;
+    return intact;
+}
+
+void Mesh::createBuffers(size_t vertexCount, size_t indexCount, const Vertex* vertices,
+                         const glm::vec3* positions, const unsigned int* indices) {
     cleanup();
 
-    m_indexCount = static_cast<GLsizei>(indices.size());
+    m_indexCount = static_cast<GLsizei>(indexCount);
 
     glGenVertexArrays(1, &m_vao);
     glGenBuffers(1, &m_vbo);
     glGenBuffers(1, &m_ebo);
 
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
+    m_vertexMemory.set(MemoryCategory::VertexBuffer, vertexCount * sizeof(Vertex));
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    m_indexMemory.set(MemoryCategory::IndexBuffer, indexCount * sizeof(unsigned int));
 
     // Position attribute
     glEnableVertexAttribArray(0);
@@ -73,11 +221,77 @@ void Mesh::setup(const std::vector<Vertex>& vertices, const std::vector<unsigned
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
 
-    glBindVertexArray(0);
+    glGenVertexArrays(1, &m_depthVao);
+    glGenBuffers(1, &m_positionVbo);
+
+    GLState::bindVertexArray(m_depthVao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_positionVbo);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), positions, GL_STATIC_DRAW);
+    m_positionMemory.set(MemoryCategory::VertexBuffer, vertexCount * sizeof(glm::vec3));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+    GLState::bindVertexArray(0);
+}
+
+void Mesh::setupSkin(const SkinVertex* skinVertices, size_t count) {
+    if (!m_vao) {
+        return;
+    }
+
+    if (!m_skinVbo) {
+        glGenBuffers(1, &m_skinVbo);
+    }
+
+    if (count * sizeof(SkinVertex) == m_skinMemory.getBytes()) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_skinVbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, count * sizeof(SkinVertex), skinVertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+
+    GLState::bindVertexArray(m_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_skinVbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(SkinVertex), skinVertices, GL_STATIC_DRAW);
+    m_skinMemory.set(MemoryCategory::VertexBuffer, count * sizeof(SkinVertex));
+
+    // Joint indices attribute (integer, not normalized)
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 4, GL_UNSIGNED_SHORT, sizeof(SkinVertex), (void*)offsetof(SkinVertex, joints));
+
+    // Joint weights attribute
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(SkinVertex), (void*)offsetof(SkinVertex, weights));
+
+    GLState::bindVertexArray(0);
+}
+
+size_t Mesh::getGpuBytes() const {
+    return m_vertexMemory.getBytes() + m_indexMemory.getBytes() + m_skinMemory.getBytes() +
+           m_positionMemory.getBytes();
 }
 
 void Mesh::draw() const {
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
     glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+}
+
+void Mesh::drawDepth() const {
+    GLState::bindVertexArray(m_depthVao);
+    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
+}
+
+void Mesh::drawRanges(const GLsizei* counts, const void* const* offsets, GLsizei rangeCount) const {
+    GLState::bindVertexArray(m_vao);
+    glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets, rangeCount);
+}
+
+void Mesh::drawDepthRanges(const GLsizei* counts, const void* const* offsets, GLsizei rangeCount) const {
+    GLState::bindVertexArray(m_depthVao);
+    glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets, rangeCount);
 }
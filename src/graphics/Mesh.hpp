@@ -1,7 +1,12 @@
 #pragma once
 
+#include "ShaderPermutations.hpp"
+#include "Meshlets.hpp"
+#include "core/MemoryStats.hpp"
+#include "core/ResourcePool.hpp"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -11,11 +16,79 @@ struct Vertex {
     glm::vec2 texCoord;
 };
 
+// Skinning influences, kept in their own stream so static meshes don't pay for them
+struct SkinVertex {
+    uint16_t joints[4];
+    glm::vec4 weights;
+};
+
 class Texture;
+class TextureArray;
+using TextureHandle = Handle<Texture>;
+using TextureArrayHandle = Handle<TextureArray>;
+
+// glTF alphaMode, decides which render bucket a mesh goes to
+enum class AlphaMode : uint8_t {
+    Opaque,
+    Mask,
+    Blend
+};
+
+// How much of a streamed mesh or model is on the GPU, see GLTFLoader::beginUpload
+enum class LoadState : uint8_t {
+    Proxy,     // bounding box stand-in
+    Geometry,  // full geometry, textures still pending
+    Full
+};
 
+// glTF metallic-roughness material. The factors are packed into
+// GpuResources::materials() by Mesh::setMaterial, the textures are bound per draw.
 struct Material {
     glm::vec4 baseColorFactor = glm::vec4(1.0f);
-    std::shared_ptr<Texture> baseColorTexture;
+    TextureHandle baseColorTexture;       // in GpuResources::textures()
+    // Packed alternative to baseColorTexture, sampled at baseColorLayer
+    TextureArrayHandle baseColorArray;    // in GpuResources::textureArrays()
+    int baseColorLayer = 0;
+
+    float metallicFactor = 1.0f;
+    float roughnessFactor = 1.0f;
+    TextureHandle metallicRoughnessTexture;  // roughness in green, metalness in blue
+    TextureHandle normalTexture;             // tangent space, derived from screen-space derivatives
+    float normalScale = 1.0f;
+    TextureHandle occlusionTexture;          // red channel
+    float occlusionStrength = 1.0f;
+    glm::vec3 emissiveFactor = glm::vec3(0.0f);
+    TextureHandle emissiveTexture;
+
+    AlphaMode alphaMode = AlphaMode::Opaque;
+    float alphaCutoff = 0.5f;
+    bool doubleSided = false;
+
+    // Program permutation for this material, refresh after changing the fields above
+    ShaderFeatureMask shaderFeatures = 0;
+    // Entry in the material table, owned by the mesh holding this material
+    uint32_t tableIndex = UINT32_MAX;
+
+    void updateShaderFeatures() {
+        shaderFeatures = 0;
+        if (baseColorTexture) shaderFeatures |= SHADER_FEATURE_BASE_COLOR_TEXTURE;
+        if (baseColorArray) shaderFeatures |= SHADER_FEATURE_BASE_COLOR_ARRAY;
+        if (alphaMode == AlphaMode::Mask) shaderFeatures |= SHADER_FEATURE_ALPHA_MASK;
+        if (metallicRoughnessTexture) shaderFeatures |= SHADER_FEATURE_METALLIC_ROUGHNESS_TEXTURE;
+        if (normalTexture) shaderFeatures |= SHADER_FEATURE_NORMAL_TEXTURE;
+        if (occlusionTexture) shaderFeatures |= SHADER_FEATURE_OCCLUSION_TEXTURE;
+        if (emissiveTexture) shaderFeatures |= SHADER_FEATURE_EMISSIVE_TEXTURE;
+    }
+};
+
+// One source primitive inside a merged mesh, see GLTFLoader::setStaticBatching
+struct SubMesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    glm::vec3 boundsMin = glm::vec3(0.0f);  // mesh space
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    int node = -1;       // glTF node and primitive it came from, for picking
+    int primitive = -1;
 };
 
 class Mesh {
@@ -29,18 +102,86 @@ public:
     Mesh(Mesh&& other) noexcept;
     Mesh& operator=(Mesh&& other) noexcept;
 
-    void setup(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    // Calling it again with the same counts refills the existing buffers
+    void setup(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+    // Takes std::vector or ArenaVector
+    template <typename VertexVector, typename IndexVector>
+    void setup(const VertexVector& vertices, const IndexVector& indices) {
+        setup(vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+
+    // Alternative to setup() without a CPU copy: mapForWrite() allocates the
+    // buffers and maps them write-only, the caller fills every element in
+    // order, then unmapWrite() hands them to GL. Mapped memory may be
+    // uncached, never read it back. unmapWrite() returns false if the
+    // contents were lost and the mesh must be set up again.
+    struct MappedGeometry {
+        Vertex* vertices = nullptr;
+        glm::vec3* positions = nullptr;  // depth-only stream, same order as vertices
+        unsigned int* indices = nullptr;
+    };
+    bool mapForWrite(size_t vertexCount, size_t indexCount, MappedGeometry& geometry);
+    bool unmapWrite(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+    // Adds joint/weight attributes, call after setup() with one entry per vertex
+    void setupSkin(const SkinVertex* skinVertices, size_t count);
+    template <typename SkinVector>
+    void setupSkin(const SkinVector& skinVertices) { setupSkin(skinVertices.data(), skinVertices.size()); }
+    // Draws leave the vertex array bound, GLState skips rebinding it for the same mesh
     void draw() const;
+    // Same triangles from a position-only stream, for depth-only passes of unskinned meshes
+    void drawDepth() const;
+    // Several index ranges in one multi-draw call, as produced by Meshlets::cull
+    void drawRanges(const GLsizei* counts, const void* const* offsets, GLsizei rangeCount) const;
+    void drawDepthRanges(const GLsizei* counts, const void* const* offsets, GLsizei rangeCount) const;
+
+    bool isSkinned() const { return m_skinVbo != 0; }
+    GLsizei getIndexCount() const { return m_indexCount; }
+    size_t getGpuBytes() const;
+
+    // Object-space bounding box of the positions passed to setup()
+    const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+    const glm::vec3& getBoundsMax() const { return m_boundsMax; }
 
-    void setMaterial(const Material& material) { m_material = material; }
+    // Empty unless this mesh merges several primitives, the renderer culls them one by one
+    void setSubMeshes(std::vector<SubMesh> subMeshes) { m_subMeshes = std::move(subMeshes); }
+    const std::vector<SubMesh>& getSubMeshes() const { return m_subMeshes; }
+
+    // Empty unless the index buffer was clustered with Meshlets::build
+    void setMeshlets(std::vector<Meshlet> meshlets) { m_meshlets = std::move(meshlets); }
+    const std::vector<Meshlet>& getMeshlets() const { return m_meshlets; }
+
+    // Finds or adds the material's entry in GpuResources::materials()
+    void setMaterial(const Material& material);
     const Material& getMaterial() const { return m_material; }
 
+    void setLoadState(LoadState state) { m_loadState = state; }
+    LoadState getLoadState() const { return m_loadState; }
+
 private:
     void cleanup();
+    void releaseMaterial();
+    // Null data leaves the storage uninitialized
+    void createBuffers(size_t vertexCount, size_t indexCount, const Vertex* vertices,
+                       const glm::vec3* positions, const unsigned int* indices);
 
     GLuint m_vao = 0;
     GLuint m_vbo = 0;
     GLuint m_ebo = 0;
+    GLuint m_skinVbo = 0;
+    GLuint m_depthVao = 0;
+    GLuint m_positionVbo = 0;
     GLsizei m_indexCount = 0;
     Material m_material;
+    LoadState m_loadState = LoadState::Full;
+    std::vector<SubMesh> m_subMeshes;
+    std::vector<Meshlet> m_meshlets;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+
+    TrackedMemory m_vertexMemory;
+    TrackedMemory m_indexMemory;
+    TrackedMemory m_skinMemory;
+    TrackedMemory m_positionMemory;
 };
+
+using MeshHandle = Handle<Mesh>;
@@ -0,0 +1,277 @@
+#include "Meshlets.hpp"
+#include "Mesh.hpp"
+#include "core/Arena.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Meshlets {
+
+namespace {
+
+glm::vec3 triangleNormal(const Vertex* vertices, const unsigned int* tri) {
+    const glm::vec3& a = vertices[tri[0]].position;
+    glm::vec3 n = glm::cross(vertices[tri[1]].position - a, vertices[tri[2]].position - a);
+    float length = glm::length(n);
+    return length > 0.0f ? n / length : glm::vec3(0.0f);
+}
+
+void computeBounds(const Vertex* vertices, const unsigned int* tris, size_t triangleCount,
+                   Meshlet& meshlet) {
+    // Sphere around the box center, cheaper than a minimal sphere and close enough for clusters
+    glm::vec3 min(1.0e30f), max(-1.0e30f);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        min = glm::min(min, vertices[tris[i]].position);
+        max = glm::max(max, vertices[tris[i]].position);
+    }
+    meshlet.center = (min + max) * 0.5f;
+    float radius2 = 0.0f;
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        glm::vec3 d = vertices[tris[i]].position - meshlet.center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    glm::vec3 axis(0.0f);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        axis += triangleNormal(vertices, tris + t * 3);
+    }
+    float axisLength = glm::length(axis);
+    if (axisLength <= 0.0f) {
+        return;
+    }
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        glm::vec3 n = triangleNormal(vertices, tris + t * 3);
+        // Degenerate triangles never rasterize, they don't widen the cone
+        if (n != glm::vec3(0.0f)) {
+            minDot = std::min(minDot, glm::dot(n, axis));
+        }
+    }
+
+    meshlet.coneAxis = axis;
+    // Cones of 90 degrees or more can't be back-facing as a whole
+    meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+}
+
+} // namespace
+
+std::vector<Meshlet> build(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount,
+                           size_t maxTriangles) {
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || maxTriangles == 0) {
+        return meshlets;
+    }
+    // Indices address the adjacency and vertex arrays directly, one bad index would write past them
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        if (indices[i] >= vertexCount) {
+            return meshlets;
+        }
+    }
+
+    ArenaScope scratch(LinearArena::forThread());
+    LinearArena& arena = scratch.arena();
+    const ArenaAllocator<uint32_t> allocator(arena);
+
+    // Vertex -> triangles adjacency, CSR
+    ArenaVector<uint32_t> adjacencyStart(vertexCount + 1, 0, allocator);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++adjacencyStart[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    }
+    ArenaVector<uint32_t> adjacency(triangleCount * 3, allocator);
+    ArenaVector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1, allocator);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            adjacency[fill[indices[t * 3 + c]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    ArenaVector<uint8_t> emitted(triangleCount, 0, ArenaAllocator<uint8_t>(arena));
+    ArenaVector<uint32_t> vertexStamp(vertexCount, UINT32_MAX, allocator);
+    ArenaVector<uint32_t> candidateStamp(triangleCount, UINT32_MAX, allocator);
+    // Both stay small, reserved so they rarely regrow and strand storage in the arena
+    ArenaVector<uint32_t> candidates(allocator);
+    candidates.reserve(8 * maxTriangles);
+    ArenaVector<uint32_t> clusterTriangles(allocator);
+    clusterTriangles.reserve(maxTriangles);
+
+    unsigned int* reordered = arena.allocateArray<unsigned int>(triangleCount * 3);
+    size_t reorderedCount = 0;
+
+    size_t seed = 0;
+    while (true) {
+        while (seed < triangleCount && emitted[seed]) {
+            ++seed;
+        }
+        if (seed == triangleCount) {
+            break;
+        }
+
+        const auto id = static_cast<uint32_t>(meshlets.size());
+        clusterTriangles.clear();
+        candidates.clear();
+        glm::vec3 centroidSum(0.0f);
+
+        auto addTriangle = [&](uint32_t t) {
+            emitted[t] = true;
+            clusterTriangles.push_back(t);
+            for (int c = 0; c < 3; ++c) {
+                unsigned int v = indices[t * 3 + c];
+                centroidSum += vertices[v].position;
+                if (vertexStamp[v] == id) {
+                    continue;
+                }
+                vertexStamp[v] = id;
+                for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; ++a) {
+                    uint32_t neighbour = adjacency[a];
+                    if (!emitted[neighbour] && candidateStamp[neighbour] != id) {
+                        candidateStamp[neighbour] = id;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+        };
+
+        addTriangle(static_cast<uint32_t>(seed));
+
+        while (clusterTriangles.size() < maxTriangles) {
+            // Prefer triangles whose vertices are already in the cluster, then the closest to its centroid
+            const glm::vec3 centroid = centroidSum / static_cast<float>(clusterTriangles.size() * 3);
+            int bestShared = -1;
+            float bestDistance = 0.0f;
+            size_t best = 0;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                uint32_t t = candidates[i];
+                if (emitted[t]) {
+                    continue;
+                }
+                int shared = 0;
+                glm::vec3 sum(0.0f);
+                for (int c = 0; c < 3; ++c) {
+                    unsigned int v = indices[t * 3 + c];
+                    shared += vertexStamp[v] == id;
+                    sum += vertices[v].position;
+                }
+                glm::vec3 d = sum / 3.0f - centroid;
+                float distance = glm::dot(d, d);
+                if (shared > bestShared || (shared == bestShared && distance < bestDistance)) {
+                    bestShared = shared;
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            if (bestShared < 0) {
+                break;
+            }
+
+            uint32_t t = candidates[best];
+            candidates[best] = candidates.back();
+            candidates.pop_back();
+            addTriangle(t);
+
+            // Drop stale entries now and then so the scan stays short
+            if (candidates.size() > 4 * maxTriangles) {
+                candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                                [&](uint32_t c) { return emitted[c]; }),
+                                 candidates.end());
+            }
+        }
+
+        Meshlet meshlet;
+        meshlet.firstIndex = static_cast<uint32_t>(reorderedCount);
+        meshlet.indexCount = static_cast<uint32_t>(clusterTriangles.size() * 3);
+        for (uint32_t t : clusterTriangles) {
+            std::copy(indices + t * 3, indices + t * 3 + 3, reordered + reorderedCount);
+            reorderedCount += 3;
+        }
+        computeBounds(vertices, reordered + meshlet.firstIndex, clusterTriangles.size(), meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    // Trailing indices of an incomplete triangle stay where they were
+    std::copy(reordered, reordered + reorderedCount, indices);
+    return meshlets;
+}
+
+CullView makeCullView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::mat4& model) {
+    CullView view;
+
+    // Planes of the mesh-space frustum straight from (viewProjection * model)
+    const glm::mat4 m = viewProjection * model;
+    auto row = [&m](int r) { return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]); };
+    const glm::vec4 planes[6] = {
+        row(3) + row(0), row(3) - row(0),
+        row(3) + row(1), row(3) - row(1),
+        row(3) + row(2), row(3) - row(2),
+    };
+    for (int i = 0; i < 6; ++i) {
+        float length = glm::length(glm::vec3(planes[i]));
+        view.planes[i] = length > 0.0f ? planes[i] / length : planes[i];
+    }
+
+    view.cameraPosition = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+
+    // Mirroring flips which side is the front face
+    view.coneCulling = glm::determinant(glm::mat3(model)) > 0.0f;
+    return view;
+}
+
+size_t cull(const std::vector<Meshlet>& meshlets, const CullView& view,
+            std::vector<GLsizei>& counts, std::vector<const void*>& offsets) {
+    return cull(meshlets, &view, 1, counts, offsets);
+}
+
+size_t cull(const std::vector<Meshlet>& meshlets, const CullView* views, size_t viewCount,
+            std::vector<GLsizei>& counts, std::vector<const void*>& offsets) {
+    size_t visible = 0;
+    uint32_t rangeStart = 0;
+    uint32_t rangeEnd = 0;  // empty range when equal to rangeStart
+
+    auto flush = [&]() {
+        if (rangeEnd > rangeStart) {
+            counts.push_back(static_cast<GLsizei>(rangeEnd - rangeStart));
+            offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(rangeStart) * sizeof(unsigned int)));
+        }
+    };
+
+    auto culledIn = [](const Meshlet& meshlet, const CullView& view) {
+        for (const glm::vec4& plane : view.planes) {
+            if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) {
+                return true;
+            }
+        }
+
+        // Back-facing if the camera sees the whole sphere from behind the normal cone
+        if (view.coneCulling && meshlet.coneCutoff < 1.0f) {
+            glm::vec3 toCenter = meshlet.center - view.cameraPosition;
+            return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+        }
+        return false;
+    };
+
+    for (const Meshlet& meshlet : meshlets) {
+        bool culled = true;
+        for (size_t v = 0; v < viewCount && culled; ++v) {
+            culled = culledIn(meshlet, views[v]);
+        }
+        if (culled) {
+            continue;
+        }
+        ++visible;
+
+        if (meshlet.firstIndex != rangeEnd) {
+            flush();
+            rangeStart = meshlet.firstIndex;
+        }
+        rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+    }
+    flush();
+    return visible;
+}
+
+} // namespace Meshlets
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+
+// A small cluster of triangles occupying a contiguous range of its mesh's
+// index buffer, with bounds tight enough to cull it on its own.
+struct Meshlet {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    glm::vec3 center = glm::vec3(0.0f);  // bounding sphere, mesh space
+    float radius = 0.0f;
+    // Every triangle normal lies within acos(sqrt(1 - cutoff^2)) of the axis.
+    // A cutoff of 1 means the normals spread too far to ever cull on facing.
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float coneCutoff = 1.0f;
+};
+
+namespace Meshlets {
+
+constexpr size_t kMaxTriangles = 124;
+
+// Reorders indices in place so triangles are grouped into spatially compact
+// meshlets of up to maxTriangles and returns them. Clusters grow across
+// shared vertices, so each is a connected, mostly flat patch. Scratch comes
+// from the calling thread's arena. Returns none, leaving the indices as they
+// are, if any index is out of range.
+std::vector<Meshlet> build(const Vertex* vertices, size_t vertexCount, unsigned int* indices, size_t indexCount,
+                           size_t maxTriangles = kMaxTriangles);
+
+// View data in mesh space: transform the world planes/camera by the model matrix first
+struct CullView {
+    glm::vec4 planes[6];          // normalized, inside is positive
+    glm::vec3 cameraPosition;
+    bool coneCulling = true;      // off for double-sided or mirrored meshes
+};
+
+// Mesh-space view of a world-space frustum, planes from a view-projection matrix
+CullView makeCullView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::mat4& model);
+
+// Appends GL index ranges (count, byte offset) of meshlets that may be visible.
+// Neighbouring visible meshlets are merged into one range. Returns the number
+// of meshlets that survived.
+size_t cull(const std::vector<Meshlet>& meshlets, const CullView& view,
+            std::vector<GLsizei>& counts, std::vector<const void*>& offsets);
+
+// Same for several views in one pass: keeps the meshlets that may be visible
+// in any of them, so views sharing a draw list cull it once
+size_t cull(const std::vector<Meshlet>& meshlets, const CullView* views, size_t viewCount,
+            std::vector<GLsizei>& counts, std::vector<const void*>& offsets);
+
+} // namespace Meshlets
@@ -0,0 +1,219 @@
+#include "OffscreenCapture.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "stb_image_write.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+OffscreenCapture::OffscreenCapture(int width, int height, unsigned writerThreads)
+    : m_width(std::max(width, 1)), m_height(std::max(height, 1)) {
+    if (writerThreads == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        writerThreads = hardware > 1 ? hardware - 1 : 1;
+    }
+    m_writerThreadCount = writerThreads;
+}
+
+OffscreenCapture::~OffscreenCapture() {
+    if (m_fbo) {
+        finish();
+    }
+    cleanup();
+}
+
+void OffscreenCapture::cleanup() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& writer : m_writers) {
+        writer.join();
+    }
+    m_writers.clear();
+    m_stop = false;
+
+    for (auto& readback : m_readbacks) {
+        if (readback.fence) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+    }
+    if (m_pixelBuffers[0]) {
+        for (GLuint buffer : m_pixelBuffers) {
+            GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, buffer);
+        }
+        std::fill(m_pixelBuffers, m_pixelBuffers + kPixelBufferCount, 0u);
+    }
+    if (m_fbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Framebuffer, m_fbo);
+        m_fbo = 0;
+    }
+    if (m_colorRbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Renderbuffer, m_colorRbo);
+        m_colorRbo = 0;
+    }
+    if (m_depthRbo) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Renderbuffer, m_depthRbo);
+        m_depthRbo = 0;
+    }
+    m_targetMemory.reset();
+    m_pixelBufferMemory.reset();
+}
+
+bool OffscreenCapture::init() {
+    cleanup();
+
+    glGenRenderbuffers(1, &m_colorRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenRenderbuffers(1, &m_depthRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRbo);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer incomplete (0x" << std::hex << status << std::dec << ")" << std::endl;
+        cleanup();
+        return false;
+    }
+
+    // Color is 4 bytes, depth 24 bits padded to 4
+    const size_t imageBytes = static_cast<size_t>(m_width) * m_height * 4;
+    m_targetMemory.set(MemoryCategory::Texture, imageBytes * 2);
+
+    glGenBuffers(kPixelBufferCount, m_pixelBuffers);
+    for (GLuint buffer : m_pixelBuffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(imageBytes), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_pixelBufferMemory.set(MemoryCategory::PixelBuffer, imageBytes * kPixelBufferCount);
+
+    for (unsigned i = 0; i < m_writerThreadCount; ++i) {
+        m_writers.emplace_back(&OffscreenCapture::writerLoop, this);
+    }
+    m_nextSlot = 0;
+    return true;
+}
+
+void OffscreenCapture::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glViewport(0, 0, m_width, m_height);
+}
+
+void OffscreenCapture::capture(const std::string& path) {
+    const int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % kPixelBufferCount;
+
+    // Oldest readback, issued kPixelBufferCount - 1 captures ago
+    collect(slot);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[slot]);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_readbacks[slot].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_readbacks[slot].path = path;
+}
+
+void OffscreenCapture::collect(int slot) {
+    Readback& readback = m_readbacks[slot];
+    if (!readback.fence) {
+        return;
+    }
+
+    GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (result == GL_WAIT_FAILED) {
+        std::cerr << "Readback failed: " << readback.path << std::endl;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_failed;
+        return;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(m_width) * 4;
+    Image image;
+    image.path = std::move(readback.path);
+    image.pixels.resize(rowBytes * m_height);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[slot]);
+    const auto* mapped = static_cast<const unsigned char*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(image.pixels.size()), GL_MAP_READ_BIT));
+    if (mapped) {
+        // GL rows run bottom-up, PNG rows top-down
+        for (int y = 0; y < m_height; ++y) {
+            std::memcpy(image.pixels.data() + y * rowBytes, mapped + (m_height - 1 - y) * rowBytes, rowBytes);
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!mapped) {
+        std::cerr << "Failed to map readback buffer: " << image.path << std::endl;
+        ++m_failed;
+        return;
+    }
+    m_queue.push_back(std::move(image));
+    m_wake.notify_one();
+}
+
+void OffscreenCapture::finish() {
+    // Oldest first, so images are handed to the writers in capture order
+    for (int i = 0; i < kPixelBufferCount; ++i) {
+        collect((m_nextSlot + i) % kPixelBufferCount);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_queue.empty() && m_busyWriters == 0; });
+}
+
+void OffscreenCapture::writerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return;
+        }
+
+        Image image = std::move(m_queue.front());
+        m_queue.pop_front();
+        ++m_busyWriters;
+        lock.unlock();
+
+        bool ok = stbi_write_png(image.path.c_str(), m_width, m_height, 4, image.pixels.data(), m_width * 4) != 0;
+        if (!ok) {
+            std::cerr << "Failed to write " << image.path << std::endl;
+        }
+
+        lock.lock();
+        --m_busyWriters;
+        ++(ok ? m_written : m_failed);
+        if (m_queue.empty() && m_busyWriters == 0) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+size_t OffscreenCapture::getWrittenCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+size_t OffscreenCapture::getFailedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "core/MemoryStats.hpp"
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Renders into an RGBA8 + depth framebuffer and writes each frame to a PNG.
+//
+// Readback is asynchronous: capture() starts a glReadPixels into one of a
+// ring of pixel pack buffers and returns; the buffer is mapped only once its
+// fence has passed, kPixelBufferCount - 1 captures later. PNG encoding runs
+// on writer threads so the GL thread goes straight on to the next frame.
+class OffscreenCapture {
+public:
+    // writerThreads 0 picks one per hardware thread, minus the GL thread
+    OffscreenCapture(int width, int height, unsigned writerThreads = 0);
+    ~OffscreenCapture();
+
+    OffscreenCapture(const OffscreenCapture&) = delete;
+    OffscreenCapture& operator=(const OffscreenCapture&) = delete;
+
+    bool init();
+
+    // Binds the framebuffer and sets the viewport to cover it
+    void bind() const;
+
+    // Queues the current framebuffer contents to be written to path
+    void capture(const std::string& path);
+
+    // Waits for every queued capture to be read back and written
+    void finish();
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    size_t getWrittenCount() const;
+    size_t getFailedCount() const;
+
+private:
+    static constexpr int kPixelBufferCount = 3;
+
+    struct Readback {
+        GLsync fence = nullptr;
+        std::string path;
+    };
+
+    struct Image {
+        std::vector<unsigned char> pixels;
+        std::string path;
+    };
+
+    void cleanup();
+    void collect(int slot);
+    void writerLoop();
+
+    int m_width;
+    int m_height;
+    unsigned m_writerThreadCount;
+
+    GLuint m_fbo = 0;
+    GLuint m_colorRbo = 0;
+    GLuint m_depthRbo = 0;
+    GLuint m_pixelBuffers[kPixelBufferCount] = {};
+    Readback m_readbacks[kPixelBufferCount];
+    int m_nextSlot = 0;
+
+    TrackedMemory m_targetMemory;
+    TrackedMemory m_pixelBufferMemory;
+
+    // Images waiting for a writer, filled by the GL thread
+    std::vector<std::thread> m_writers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Image> m_queue;
+    size_t m_busyWriters = 0;
+    size_t m_written = 0;
+    size_t m_failed = 0;
+    bool m_stop = false;
+};
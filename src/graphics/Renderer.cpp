@@ -1,49 +1,733 @@
 #include "Renderer.hpp"
+#include "GLState.hpp"
+#include "GpuResources.hpp"
 #include "Texture.hpp"
+#include "TextureArray.hpp"
 #include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
 
-Renderer::Renderer() {}
+namespace {
+
+// Texture units: 0 holds base color, then the joint palette, the three
+// clustered lighting buffers, the shadow cascades, the occlusion tests'
+// bounds and two depth pyramids, the material table and the material's
+// other textures
+constexpr unsigned int kJointPaletteUnit = 1;
+constexpr unsigned int kClusterFirstUnit = 2;
+constexpr unsigned int kShadowMapUnit = 5;
+constexpr unsigned int kOcclusionFirstUnit = 6;
+constexpr unsigned int kMaterialTableUnit = 9;
+
+struct MaterialTexture {
+    ShaderFeature feature;
+    const char* sampler;
+    unsigned int unit;
+    TextureHandle Material::*texture;
+};
+
+const MaterialTexture kMaterialTextures[] = {
+    { SHADER_FEATURE_METALLIC_ROUGHNESS_TEXTURE, "metallicRoughnessTexture", 10, &Material::metallicRoughnessTexture },
+    { SHADER_FEATURE_NORMAL_TEXTURE, "normalTexture", 11, &Material::normalTexture },
+    { SHADER_FEATURE_OCCLUSION_TEXTURE, "occlusionTexture", 12, &Material::occlusionTexture },
+    { SHADER_FEATURE_EMISSIVE_TEXTURE, "emissiveTexture", 13, &Material::emissiveTexture },
+};
+
+// Below this many triangles a mesh costs about as much as its occlusion test
+constexpr GLsizei kMinOcclusionTestedTriangles = 256;
+
+int popCount(uint8_t bits) {
+    int count = 0;
+    for (; bits != 0; bits &= static_cast<uint8_t>(bits - 1)) {
+        ++count;
+    }
+    return count;
+}
+
+// World-space box against world-space frustum planes, true if wholly outside one of them
+bool outsideFrustum(const Meshlets::CullView& frustum, const glm::vec3& min, const glm::vec3& max) {
+    for (const glm::vec4& plane : frustum.planes) {
+        // Corner farthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                         plane.z >= 0.0f ? max.z : min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void transformBounds(const glm::mat4& matrix, const glm::vec3& min, const glm::vec3& max,
+                     glm::vec3& outMin, glm::vec3& outMax) {
+    outMin = glm::vec3(1.0e30f);
+    outMax = glm::vec3(-1.0e30f);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 p((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        glm::vec3 t = glm::vec3(matrix * glm::vec4(p, 1.0f));
+        outMin = glm::min(outMin, t);
+        outMax = glm::max(outMax, t);
+    }
+}
+
+} // namespace
+
+Renderer::Renderer(JobSystem& jobs, FrameArena& frameArena)
+    : m_jobs(jobs)
+    , m_frameArena(frameArena)
+    , m_jointPalette(GL_RGBA32F, "joint palette")
+    , m_clusteredLighting(jobs) {}
 
 bool Renderer::init() {
-    if (!m_shader.loadFromFiles("shaders/basic.vert", "shaders/basic.frag")) {
+    if (!m_shaders.loadFromFiles("shaders/basic.vert", "shaders/basic.frag")) {
         return false;
     }
+    if (!m_depthShaders.loadFromFiles("shaders/depth.vert", "shaders/depth.frag")) {
+        std::cerr << "Depth pre-pass disabled" << std::endl;
+    }
+    if (!m_shadows.init()) {
+        std::cerr << "Shadows disabled" << std::endl;
+    }
+    if (!m_occlusion.init()) {
+        std::cerr << "Occlusion culling disabled" << std::endl;
+    }
+    if (m_defaultMaterial == UINT32_MAX) {
+        m_defaultMaterial = GpuResources::materials().acquire(Material());
+    }
     return true;
 }
 
+bool Renderer::reloadShaders() {
+    bool reloaded = m_shaders.reload();
+    if (m_depthShaders.reload()) {
+        m_depthShaders.compilePending(SIZE_MAX);
+    } else {
+        reloaded = false;
+    }
+    if (m_shadows.isReady() && !m_shadows.reloadShaders()) {
+        reloaded = false;
+    }
+    if (m_occlusion.isReady() && !m_occlusion.reloadShaders()) {
+        reloaded = false;
+    }
+    return reloaded;
+}
+
+void Renderer::prewarmShaders(const std::vector<std::unique_ptr<Model>>& models) {
+    const ResourcePool<Mesh>& meshes = GpuResources::meshes();
+    bool clustered = false;
+    for (const auto& model : models) {
+        for (const auto& light : model->getLights()) {
+            clustered |= light.type != LightType::Directional;
+        }
+    }
+
+    ShaderFeatureMask frameFeatures = 0;
+    if (clustered) {
+        frameFeatures |= SHADER_FEATURE_CLUSTERED_LIGHTS;
+    }
+    if (m_shadowsEnabled && m_shadows.isReady()) {
+        frameFeatures |= SHADER_FEATURE_SHADOWS;
+    }
+
+    size_t meshCount = 0;
+    for (const auto& model : models) {
+        meshCount += model->getMeshCount();
+    }
+    ArenaScope scratch(m_frameArena.current());
+    ShaderFeatureMask* masks = scratch.arena().allocateArray<ShaderFeatureMask>(meshCount);
+    size_t maskCount = 0;
+    for (const auto& model : models) {
+        for (MeshHandle handle : model->getMeshHandles()) {
+            const Mesh* mesh = meshes.get(handle);
+            masks[maskCount++] = meshFeatures(*model, *mesh) | frameFeatures;
+        }
+    }
+    m_shaders.prewarm(masks, maskCount);
+}
+
+void Renderer::uploadJointPalette(const std::vector<glm::vec4>& rows) {
+    m_jointPalette.upload(rows);
+}
+
+ShaderFeatureMask Renderer::meshFeatures(const Model& model, const Mesh& mesh) {
+    ShaderFeatureMask features = mesh.getMaterial().shaderFeatures;
+    if (mesh.isSkinned() && model.getJointPaletteOffset() >= 0) {
+        features |= SHADER_FEATURE_SKINNING;
+    }
+    return features;
+}
+
 void Renderer::render(const Camera& camera, const std::vector<std::unique_ptr<Model>>& models) {
-    glClearColor(m_clearColor.r, m_clearColor.g, m_clearColor.b, m_clearColor.a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const View view{ &camera, glm::ivec4(viewport[0], viewport[1], viewport[2], viewport[3]) };
+    renderViews(&view, 1, models);
+}
 
-    m_shader.use();
+void Renderer::render(const std::vector<View>& views, const std::vector<std::unique_ptr<Model>>& models) {
+    if (views.size() > kMaxViews) {
+        std::cerr << "Renderer: drawing the first " << kMaxViews << " of " << views.size() << " views" << std::endl;
+    }
+    renderViews(views.data(), std::min(views.size(), kMaxViews), models);
+}
+
+void Renderer::renderViews(const View* views, size_t viewCount, const std::vector<std::unique_ptr<Model>>& models) {
+    if (viewCount == 0) {
+        return;
+    }
+
+    // Spread prewarm compiles across frames, anything still missing compiles lazily below
+    m_shaders.compilePending(1);
+
+    if (!m_jointPalette.isEmpty()) {
+        m_jointPalette.bind(kJointPaletteUnit);
+    }
+    // Only uploads when materials were added since the last frame
+    GpuResources::materials().bind(kMaterialTableUnit);
+
+    GLint previousViewport[4];
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    gatherLights(models);
+
+    const Camera& primary = *views[0].camera;
+    bool shadows = false;
+    if (m_shadowsEnabled && m_shadows.isReady()) {
+        m_shadows.update(primary, m_frameHasDirectional ? m_frameLightDir : m_lightDir, models, kJointPaletteUnit);
+        m_shadows.bind(kShadowMapUnit);
+        shadows = true;
+    }
+
+    m_frameStats = FrameStats{};
+    buildQueues(views, viewCount, models);
 
-    m_shader.setMat4("view", camera.getViewMatrix());
-    m_shader.setMat4("projection", camera.getProjectionMatrix());
-    m_shader.setVec3("viewPos", camera.getPosition());
+    for (size_t v = 0; v < viewCount; ++v) {
+        const View& view = views[v];
+        glViewport(view.viewport.x, view.viewport.y, view.viewport.z, view.viewport.w);
+        m_viewportWidth = std::max(view.viewport.z, 1);
+        m_viewportHeight = std::max(view.viewport.w, 1);
 
-    m_shader.setVec3("lightDir", m_lightDir);
-    m_shader.setVec3("lightColor", m_lightColor);
-    m_shader.setVec3("ambientColor", m_ambientColor);
+        // A single view clears everything, as it always did; several only clear their own rectangle
+        glClearColor(m_clearColor.r, m_clearColor.g, m_clearColor.b, m_clearColor.a);
+        if (viewCount > 1) {
+            GLState::setEnabled(GL_SCISSOR_TEST, true);
+            glScissor(view.viewport.x, view.viewport.y, view.viewport.z, view.viewport.w);
+        }
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (viewCount > 1) {
+            GLState::setEnabled(GL_SCISSOR_TEST, false);
+        }
+
+        m_pass.camera = view.camera;
+        m_pass.bit = static_cast<uint8_t>(1u << v);
+        m_pass.features = 0;
+        m_pass.occlusion = v == 0 && !m_occlusionBounds.empty();
+
+        // Froxels are cut from each view's frustum, the gathered lights are shared
+        m_clusteredLighting.update(*view.camera, m_frameLights);
+        if (m_clusteredLighting.getLightCount() > 0) {
+            m_clusteredLighting.bind(kClusterFirstUnit);
+            m_pass.features |= SHADER_FEATURE_CLUSTERED_LIGHTS;
+        }
+        // Cascades are fitted to the first view, fitting them per view would re-render them every view
+        if (shadows && v == 0) {
+            m_pass.features |= SHADER_FEATURE_SHADOWS;
+        }
+
+        renderView();
+    }
+
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+    // Double-sided draws leave culling off, the shadow pass and others expect it on
+    GLState::setEnabled(GL_CULL_FACE, true);
+}
 
+void Renderer::renderView() {
+    const Camera& camera = *m_pass.camera;
+
+    // Pre-passed items sort first, so the opaque queue splits into an EQUAL part and a LESS part
+    size_t prepassedCount = 0;
+    while (prepassedCount < m_opaqueQueue.size() && m_opaqueQueue[prepassedCount].prepassed) {
+        ++prepassedCount;
+    }
+
+    // Tested items lay down depth if they were visible last frame, the rest
+    // are tested again against a pyramid built from it (see HiZCulling)
+    if (m_pass.occlusion) {
+        m_occlusion.beginFrame(camera.getProjectionMatrix() * camera.getViewMatrix(), m_occlusionBounds,
+                               kOcclusionFirstUnit);
+    }
+    if (prepassedCount > 0) {
+        renderDepthPrepass(HiZCulling::Phase::Previous);
+    }
+    if (m_pass.occlusion) {
+        m_occlusion.buildAndTest();
+        renderDepthPrepass(HiZCulling::Phase::Revealed);
+    }
+
+    if (prepassedCount > 0) {
+        GLState::depthFunc(GL_EQUAL);
+        GLState::depthMask(false);
+        m_frameStats.opaqueDraws += drawItems(m_opaqueQueue, 0, prepassedCount);
+        GLState::depthMask(true);
+        GLState::depthFunc(GL_LESS);
+    }
+    m_frameStats.opaqueDraws += drawItems(m_opaqueQueue, prepassedCount, m_opaqueQueue.size());
+
+    m_frameStats.maskDraws += drawItems(m_maskQueue, 0, m_maskQueue.size());
+
+    // Blended surfaces test against the opaque depth but don't write it
+    if (!m_blendQueue.empty()) {
+        sortBlendQueue();
+        GLState::setEnabled(GL_BLEND, true);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        GLState::depthMask(false);
+        m_frameStats.blendDraws += drawItems(m_blendQueue, 0, m_blendQueue.size());
+        GLState::depthMask(true);
+        GLState::setEnabled(GL_BLEND, false);
+    }
+
+    if (m_pass.occlusion) {
+        m_occlusion.endFrame();
+    }
+}
+
+void Renderer::buildQueues(const View* views, size_t viewCount, const std::vector<std::unique_ptr<Model>>& models) {
+    const ResourcePool<Mesh>& meshes = GpuResources::meshes();
+    m_opaqueQueue.clear();
+    m_maskQueue.clear();
+    m_blendQueue.clear();
+    m_rangeCounts.clear();
+    m_rangeOffsets.clear();
+    m_occlusionBounds.clear();
+
+    const bool prepass = m_depthPrepass && m_depthShaders.get(0) != nullptr;
+    // The pyramid is built from pre-pass depth, without it nothing would occlude
+    const bool occlusion = m_occlusionCulling && prepass && m_occlusion.isReady();
+
+    // World-space frustum of each view, for whole meshes
+    glm::mat4 viewProjections[kMaxViews];
+    Meshlets::CullView frustums[kMaxViews];
+    for (size_t v = 0; v < viewCount; ++v) {
+        const Camera& camera = *views[v].camera;
+        viewProjections[v] = camera.getProjectionMatrix() * camera.getViewMatrix();
+        frustums[v] = Meshlets::makeCullView(viewProjections[v], camera.getPosition(), glm::mat4(1.0f));
+    }
+    const uint8_t allViews = static_cast<uint8_t>((1u << viewCount) - 1);
+
+    // Cull every clustered mesh first, one task per mesh, then append the
+    // ranges below in scene order so the result does not depend on scheduling
+    size_t taskCount = 0;
     for (const auto& model : models) {
-        const auto& transform = model->getTransform();
-        m_shader.setMat4("model", transform.getMatrix());
-        m_shader.setMat3("normalMatrix", transform.getNormalMatrix());
+        Meshlets::CullView cullViews[kMaxViews];
+        bool cullViewsReady = false;
+        for (MeshHandle handle : model->getMeshHandles()) {
+            const Mesh* mesh = meshes.get(handle);
+            if (mesh->getMeshlets().empty()) {
+                continue;
+            }
+            if (!cullViewsReady) {
+                for (size_t v = 0; v < viewCount; ++v) {
+                    cullViews[v] = Meshlets::makeCullView(viewProjections[v], views[v].camera->getPosition(),
+                                                          model->getTransform().getMatrix());
+                }
+                cullViewsReady = true;
+            }
+            if (taskCount == m_cullTasks.size()) {
+                m_cullTasks.emplace_back();
+            }
+            CullTask& task = m_cullTasks[taskCount++];
+            task.meshlets = &mesh->getMeshlets();
+            task.viewCount = viewCount;
+            for (size_t v = 0; v < viewCount; ++v) {
+                task.views[v] = cullViews[v];
+                task.views[v].coneCulling &= !mesh->getMaterial().doubleSided;
+            }
+        }
+    }
+
+    m_jobs.parallelFor(taskCount, 1, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            CullTask& task = m_cullTasks[i];
+            task.counts.clear();
+            task.offsets.clear();
+            task.visible = Meshlets::cull(*task.meshlets, task.views, task.viewCount, task.counts, task.offsets);
+        }
+    });
+
+    size_t nextTask = 0;
+    for (const auto& model : models) {
+        const glm::mat4 matrix = model->getTransform().getMatrix();
 
-        for (const auto& mesh : model->getMeshes()) {
+        for (MeshHandle handle : model->getMeshHandles()) {
+            const Mesh* mesh = meshes.get(handle);
             const auto& material = mesh->getMaterial();
+            // The permutation samples whichever base color source is still live,
+            // a released array falls back to the standalone texture
+            ShaderFeatureMask features = meshFeatures(*model, *mesh) &
+                ~(SHADER_FEATURE_BASE_COLOR_TEXTURE | SHADER_FEATURE_BASE_COLOR_ARRAY);
+            GLuint texture = 0;
+            if (const TextureArray* array = GpuResources::textureArrays().get(material.baseColorArray)) {
+                texture = array->getId();
+                features |= SHADER_FEATURE_BASE_COLOR_ARRAY;
+            } else if (const Texture* image = GpuResources::textures().get(material.baseColorTexture)) {
+                texture = image->getId();
+                features |= SHADER_FEATURE_BASE_COLOR_TEXTURE;
+            }
+            const uint32_t entry = material.tableIndex != UINT32_MAX ? material.tableIndex : m_defaultMaterial;
+            DrawItem item{ model.get(), mesh, features, 0.0f, false, texture, entry, 0, 0, 0 };
 
-            m_shader.setVec4("baseColorFactor", material.baseColorFactor);
+            // Clustered meshes only draw the meshlets that can be visible, skip them if none are
+            const auto& meshlets = mesh->getMeshlets();
+            if (!meshlets.empty()) {
+                const CullTask& task = m_cullTasks[nextTask++];
+                item.firstRange = static_cast<uint32_t>(m_rangeCounts.size());
+                m_rangeCounts.insert(m_rangeCounts.end(), task.counts.begin(), task.counts.end());
+                m_rangeOffsets.insert(m_rangeOffsets.end(), task.offsets.begin(), task.offsets.end());
+                m_frameStats.meshletsTotal += meshlets.size();
+                m_frameStats.meshletsVisible += task.visible;
+                item.rangeCount = static_cast<uint32_t>(task.counts.size());
+                if (item.rangeCount == 0) {
+                    continue;
+                }
+            }
 
-            if (material.baseColorTexture) {
-                material.baseColorTexture->bind(0);
-                m_shader.setInt("baseColorTexture", 0);
-                m_shader.setInt("hasTexture", 1);
+            // Skinned vertices can leave the bind pose bounds, they go to every view
+            const bool skinned = item.features & SHADER_FEATURE_SKINNING;
+            glm::vec3 worldMin;
+            glm::vec3 worldMax;
+            const auto& subMeshes = mesh->getSubMeshes();
+            if (meshlets.empty() && !subMeshes.empty()) {
+                // Merged meshes only draw the sub-meshes some view can see, runs of
+                // neighbouring ones as one range. Bounds cover just those.
+                cullSubMeshes(subMeshes, matrix, frustums, viewCount, item, worldMin, worldMax);
+                if (item.rangeCount == 0) {
+                    m_frameStats.frustumCulled += viewCount;
+                    continue;
+                }
             } else {
-                m_shader.setInt("hasTexture", 0);
+                transformBounds(matrix, mesh->getBoundsMin(), mesh->getBoundsMax(), worldMin, worldMax);
+                item.viewMask = skinned ? allViews : 0;
+                for (size_t v = 0; v < viewCount && !skinned; ++v) {
+                    if (!outsideFrustum(frustums[v], worldMin, worldMax)) {
+                        item.viewMask |= static_cast<uint8_t>(1u << v);
+                    }
+                }
+            }
+            m_frameStats.frustumCulled += viewCount - static_cast<size_t>(popCount(item.viewMask));
+            if (item.viewMask == 0) {
+                continue;
+            }
+
+            // Blended ones are drawn anyway
+            if (occlusion && material.alphaMode != AlphaMode::Blend && !skinned &&
+                mesh->getIndexCount() >= kMinOcclusionTestedTriangles * 3) {
+                item.occlusionTest = static_cast<uint32_t>(m_occlusionBounds.size() / 2);
+                m_occlusionBounds.emplace_back(worldMin, 1.0f);
+                m_occlusionBounds.emplace_back(worldMax, 1.0f);
             }
 
-            mesh->draw();
+            switch (material.alphaMode) {
+                case AlphaMode::Opaque:
+                    // Skinned meshes would need the palette in the pre-pass too, they just draw with LESS
+                    item.prepassed = prepass && !skinned;
+                    m_opaqueQueue.push_back(item);
+                    break;
+                case AlphaMode::Mask:
+                    m_maskQueue.push_back(item);
+                    break;
+                case AlphaMode::Blend:
+                    item.order = static_cast<uint32_t>(m_blendQueue.size());
+                    m_blendQueue.push_back(item);
+                    break;
+            }
+        }
+    }
+
+    // Opaque and masked: group by program, then by texture so materials sharing
+    // an array layer set draw back to back, then by model and material to keep
+    // uniform updates down. Views only add frame-wide feature bits, so the order
+    // holds for all of them.
+    auto byState = [](const DrawItem& a, const DrawItem& b) {
+        if (a.prepassed != b.prepassed) return a.prepassed;
+        if (a.features != b.features) return a.features < b.features;
+        if (a.texture != b.texture) return a.texture < b.texture;
+        if (a.model != b.model) return a.model < b.model;
+        return a.material < b.material;
+    };
+    std::sort(m_opaqueQueue.begin(), m_opaqueQueue.end(), byState);
+    std::sort(m_maskQueue.begin(), m_maskQueue.end(), byState);
+}
+
+void Renderer::cullSubMeshes(const std::vector<SubMesh>& subMeshes, const glm::mat4& matrix,
+                             const Meshlets::CullView* frustums, size_t viewCount, DrawItem& item,
+                             glm::vec3& worldMin, glm::vec3& worldMax) {
+    item.firstRange = static_cast<uint32_t>(m_rangeCounts.size());
+    item.viewMask = 0;
+    worldMin = glm::vec3(1.0e30f);
+    worldMax = glm::vec3(-1.0e30f);
+    uint32_t rangeEnd = UINT32_MAX;
+    for (const SubMesh& subMesh : subMeshes) {
+        glm::vec3 subMin;
+        glm::vec3 subMax;
+        transformBounds(matrix, subMesh.boundsMin, subMesh.boundsMax, subMin, subMax);
+        uint8_t mask = 0;
+        for (size_t v = 0; v < viewCount; ++v) {
+            if (!outsideFrustum(frustums[v], subMin, subMax)) {
+                mask |= static_cast<uint8_t>(1u << v);
+            }
+        }
+        ++m_frameStats.subMeshesTotal;
+        if (mask == 0 || subMesh.indexCount == 0) {
+            continue;
+        }
+        ++m_frameStats.subMeshesVisible;
+        item.viewMask |= mask;
+        worldMin = glm::min(worldMin, subMin);
+        worldMax = glm::max(worldMax, subMax);
+
+        if (subMesh.firstIndex == rangeEnd) {
+            m_rangeCounts.back() += static_cast<GLsizei>(subMesh.indexCount);
+        } else {
+            m_rangeCounts.push_back(static_cast<GLsizei>(subMesh.indexCount));
+            m_rangeOffsets.push_back(
+                reinterpret_cast<const void*>(static_cast<uintptr_t>(subMesh.firstIndex) * sizeof(unsigned int)));
+        }
+        rangeEnd = subMesh.firstIndex + subMesh.indexCount;
+    }
+    item.rangeCount = static_cast<uint32_t>(m_rangeCounts.size()) - item.firstRange;
+}
+
+void Renderer::sortBlendQueue() {
+    const glm::mat4 view = m_pass.camera->getViewMatrix();
+    for (DrawItem& item : m_blendQueue) {
+        const Mesh& mesh = *item.mesh;
+        glm::vec3 center = (mesh.getBoundsMin() + mesh.getBoundsMax()) * 0.5f;
+        glm::vec4 eye = view * (item.model->getTransform().getMatrix() * glm::vec4(center, 1.0f));
+        item.viewDepth = -eye.z;
+    }
+
+    // Back to front, equal depths keep scene order. Not std::stable_sort,
+    // which allocates its merge buffer every call.
+    std::sort(m_blendQueue.begin(), m_blendQueue.end(), [](const DrawItem& a, const DrawItem& b) {
+        if (a.viewDepth != b.viewDepth) return a.viewDepth > b.viewDepth;
+        return a.order < b.order;
+    });
+}
+
+void Renderer::renderDepthPrepass(HiZCulling::Phase phase) {
+    const Camera& camera = *m_pass.camera;
+    Shader* shader = m_depthShaders.get(0);
+    shader->use();
+    shader->setMat4("view", camera.getViewMatrix());
+    shader->setMat4("projection", camera.getProjectionMatrix());
+
+    GLState::colorMask(false);
+
+    const Model* currentModel = nullptr;
+    for (const DrawItem& item : m_opaqueQueue) {
+        if (!item.prepassed) {
+            break;
+        }
+        const bool tested = m_pass.occlusion && item.occlusionTest != kNotTested;
+        if (!(item.viewMask & m_pass.bit) || (!tested && phase != HiZCulling::Phase::Previous)) {
+            continue;
+        }
+        if (item.model != currentModel) {
+            currentModel = item.model;
+            shader->setMat4("model", item.model->getTransform().getMatrix());
+        }
+
+        // Double-sided items switch culling off until the next single-sided one
+        GLState::setEnabled(GL_CULL_FACE, !item.mesh->getMaterial().doubleSided);
+        if (!tested) {
+            drawGeometry(item, true, m_rangeCounts, m_rangeOffsets);
+        } else {
+            m_occlusion.beginConditional(item.occlusionTest, phase);
+            drawGeometry(item, true, m_rangeCounts, m_rangeOffsets);
+            HiZCulling::endConditional();
+        }
+        ++m_frameStats.prepassDraws;
+    }
+
+    GLState::colorMask(true);
+}
+
+void Renderer::drawGeometry(const DrawItem& item, bool depthOnly, const std::vector<GLsizei>& counts,
+                            const std::vector<const void*>& offsets) {
+    if (item.rangeCount == 0) {
+        if (depthOnly) {
+            item.mesh->drawDepth();
+        } else {
+            item.mesh->draw();
+        }
+        return;
+    }
+
+    const GLsizei* rangeCounts = counts.data() + item.firstRange;
+    const void* const* rangeOffsets = offsets.data() + item.firstRange;
+    const auto rangeCount = static_cast<GLsizei>(item.rangeCount);
+    if (depthOnly) {
+        item.mesh->drawDepthRanges(rangeCounts, rangeOffsets, rangeCount);
+    } else {
+        item.mesh->drawRanges(rangeCounts, rangeOffsets, rangeCount);
+    }
+}
+
+void Renderer::drawTested(const DrawItem& item) {
+    for (HiZCulling::Phase phase : { HiZCulling::Phase::Previous, HiZCulling::Phase::Revealed }) {
+        m_occlusion.beginConditional(item.occlusionTest, phase);
+        drawGeometry(item, false, m_rangeCounts, m_rangeOffsets);
+        HiZCulling::endConditional();
+    }
+}
+
+size_t Renderer::drawItems(const std::vector<DrawItem>& items, size_t begin, size_t end) {
+    const Camera& camera = *m_pass.camera;
+    size_t drawn = 0;
+    Shader* current = nullptr;
+    ShaderFeatureMask currentFeatures = 0;
+    const Model* currentModel = nullptr;
+    uint32_t currentMaterial = UINT32_MAX;
+    int currentLayer = -1;
+    int currentDoubleSided = -1;
+
+    for (size_t i = begin; i < end; ++i) {
+        const DrawItem& item = items[i];
+        if (!(item.viewMask & m_pass.bit)) {
+            continue;
+        }
+        const auto& material = item.mesh->getMaterial();
+        const ShaderFeatureMask features = item.features | m_pass.features;
+
+        Shader* shader = m_shaders.get(features);
+        if (!shader) {
+            continue;
+        }
+
+        if (shader != current) {
+            current = shader;
+            currentFeatures = features;
+            current->use();
+            setFrameUniforms(*current, camera);
+            if (currentFeatures & SHADER_FEATURE_BASE_COLOR_TEXTURE) {
+                current->setInt("baseColorTexture", 0);
+            }
+            if (currentFeatures & SHADER_FEATURE_BASE_COLOR_ARRAY) {
+                current->setInt("baseColorArray", 0);
+            }
+            current->setInt("materials", kMaterialTableUnit);
+            for (const MaterialTexture& texture : kMaterialTextures) {
+                if (currentFeatures & texture.feature) {
+                    current->setInt(texture.sampler, texture.unit);
+                }
+            }
+            if (currentFeatures & SHADER_FEATURE_SKINNING) {
+                current->setInt("jointPalette", kJointPaletteUnit);
+            }
+            if (currentFeatures & SHADER_FEATURE_CLUSTERED_LIGHTS) {
+                m_clusteredLighting.setUniforms(*current, kClusterFirstUnit, m_viewportWidth, m_viewportHeight);
+            }
+            if (currentFeatures & SHADER_FEATURE_SHADOWS) {
+                m_shadows.setUniforms(*current, kShadowMapUnit);
+            }
+            currentModel = nullptr;
+            currentMaterial = UINT32_MAX;
+            currentLayer = -1;
+            currentDoubleSided = -1;
+        }
+
+        if (item.model != currentModel) {
+            currentModel = item.model;
+            const auto& transform = item.model->getTransform();
+            current->setMat4("model", transform.getMatrix());
+            current->setMat3("normalMatrix", transform.getNormalMatrix());
+            if (currentFeatures & SHADER_FEATURE_SKINNING) {
+                current->setInt("jointOffset", item.model->getJointPaletteOffset());
+            }
+        }
+
+        // Factors live in the material table, a switch is one index
+        if (item.material != currentMaterial) {
+            currentMaterial = item.material;
+            current->setInt("materialIndex", static_cast<int>(item.material));
+            ++m_frameStats.materialSwitches;
+        }
+
+        if (item.texture != 0) {
+            const bool array = item.features & SHADER_FEATURE_BASE_COLOR_ARRAY;
+            const GLenum target = array ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+            if (GLState::bindTexture(0, target, item.texture)) {
+                ++m_frameStats.textureBinds;
+            }
+        }
+        if ((currentFeatures & SHADER_FEATURE_BASE_COLOR_ARRAY) && material.baseColorLayer != currentLayer) {
+            currentLayer = material.baseColorLayer;
+            current->setInt("baseColorLayer", currentLayer);
+        }
+        for (const MaterialTexture& texture : kMaterialTextures) {
+            if (!(currentFeatures & texture.feature)) {
+                continue;
+            }
+            if (const Texture* image = GpuResources::textures().get(material.*texture.texture)) {
+                if (GLState::bindTexture(texture.unit, GL_TEXTURE_2D, image->getId())) {
+                    ++m_frameStats.textureBinds;
+                }
+            }
+        }
+
+        GLState::setEnabled(GL_CULL_FACE, !material.doubleSided);
+        if (int(material.doubleSided) != currentDoubleSided) {
+            currentDoubleSided = material.doubleSided;
+            current->setInt("doubleSided", currentDoubleSided);
+        }
+        if (!m_pass.occlusion || item.occlusionTest == kNotTested) {
+            drawGeometry(item, false, m_rangeCounts, m_rangeOffsets);
+        } else {
+            drawTested(item);
+        }
+        ++drawn;
+    }
+    return drawn;
+}
+
+void Renderer::setFrameUniforms(Shader& shader, const Camera& camera) {
+    shader.setMat4("view", camera.getViewMatrix());
+    shader.setMat4("projection", camera.getProjectionMatrix());
+    shader.setVec3("viewPos", camera.getPosition());
+
+    // A directional light in the scene replaces the default one
+    shader.setVec3("lightDir", m_frameHasDirectional ? m_frameLightDir : m_lightDir);
+    shader.setVec3("lightColor", m_frameHasDirectional ? m_frameLightColor : m_lightColor);
+    shader.setVec3("ambientColor", m_ambientColor);
+}
+
+void Renderer::gatherLights(const std::vector<std::unique_ptr<Model>>& models) {
+    m_frameLights.clear();
+    m_frameHasDirectional = false;
+
+    for (const auto& model : models) {
+        if (model->getLights().empty()) {
+            continue;
+        }
+        const glm::mat4 matrix = model->getTransform().getMatrix();
+        const glm::mat3 rotation = glm::mat3(matrix);
+
+        for (Light light : model->getLights()) {
+            light.position = glm::vec3(matrix * glm::vec4(light.position, 1.0f));
+            light.direction = glm::normalize(rotation * light.direction);
+
+            if (light.type == LightType::Directional) {
+                if (!m_frameHasDirectional) {
+                    m_frameHasDirectional = true;
+                    m_frameLightDir = light.direction;
+                    m_frameLightColor = light.color * light.intensity;
+                }
+                continue;
+            }
+            m_frameLights.push_back(light);
         }
     }
 }
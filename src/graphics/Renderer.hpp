@@ -1,6 +1,13 @@
 #pragma once
 
-#include "Shader.hpp"
+#include "ShaderPermutations.hpp"
+#include "TextureBuffer.hpp"
+#include "ClusteredLighting.hpp"
+#include "CascadedShadowMaps.hpp"
+#include "HiZCulling.hpp"
+#include "Meshlets.hpp"
+#include "core/Arena.hpp"
+#include "core/JobSystem.hpp"
 #include "scene/Camera.hpp"
 #include "scene/Model.hpp"
 #include <glm/glm.hpp>
@@ -9,18 +16,175 @@
 
 class Renderer {
 public:
-    Renderer();
+    static constexpr size_t kMaxViews = 8;
+
+    // One camera drawn into a rectangle of the bound framebuffer
+    struct View {
+        const Camera* camera = nullptr;
+        glm::ivec4 viewport = glm::ivec4(0);  // x, y, width, height
+    };
+
+    // Draws issued last frame per bucket, summed over views
+    struct FrameStats {
+        size_t prepassDraws = 0;
+        size_t opaqueDraws = 0;
+        size_t maskDraws = 0;
+        size_t blendDraws = 0;
+        size_t frustumCulled = 0;    // mesh draws skipped in views that can't see them
+        size_t meshletsTotal = 0;    // in meshes clustered by the loader
+        size_t meshletsVisible = 0;  // after frustum and normal cone culling
+        size_t subMeshesTotal = 0;   // in meshes merged by static batching
+        size_t subMeshesVisible = 0; // inside some view's frustum
+        size_t textureBinds = 0;     // material texture binds actually issued
+        size_t materialSwitches = 0; // material table index changes
+    };
+
+    explicit Renderer(JobSystem& jobs = JobSystem::instance(), FrameArena& frameArena = FrameArena::instance());
 
     bool init();
+    // Draws into the whole current viewport
     void render(const Camera& camera, const std::vector<std::unique_ptr<Model>>& models);
+    // Draws several views of the same models, e.g. split screen or a minimap.
+    // Queues are built and sorted once for all of them: each mesh carries a
+    // mask of the views whose frustum it touches, clustered meshes keep the
+    // meshlets visible in any view. Lights, the joint palette and the material
+    // table are uploaded once; clustered lights are binned per view. Shadow
+    // cascades and occlusion culling follow the first view, the other views
+    // draw without them. At most kMaxViews views, each clears its own rectangle.
+    void render(const std::vector<View>& views, const std::vector<std::unique_ptr<Model>>& models);
+
+    // Queues the shader permutations used by these models so they compile
+    // a few per frame instead of on first draw
+    void prewarmShaders(const std::vector<std::unique_ptr<Model>>& models);
+    // Reads the shader files again, the running programs stay if they fail to compile
+    bool reloadShaders();
+    // True while queued work still needs frames to finish, e.g. prewarmed shaders
+    bool hasPendingWork() const { return m_shaders.hasPending(); }
+
+    // Uploads this frame's skinning matrices (see AnimationSystem::getPalette)
+    void uploadJointPalette(const std::vector<glm::vec4>& rows);
 
     void setClearColor(const glm::vec4& color);
     void setLightDirection(const glm::vec3& dir);
     void setLightColor(const glm::vec3& color);
     void setAmbientColor(const glm::vec3& color);
 
+    const ClusteredLighting& getClusteredLighting() const { return m_clusteredLighting; }
+
+    void setShadowsEnabled(bool enabled) { m_shadowsEnabled = enabled; }
+    // Shadow pass cost is reported apart from the rest of the frame
+    const CascadedShadowMaps::Stats& getShadowStats() const { return m_shadows.getStats(); }
+    // Call after swapping in a different set of models
+    void invalidateShadowCache() { m_shadows.invalidate(); }
+
+    // Lays down depth for unskinned opaque meshes first so the opaque pass
+    // only shades visible fragments
+    void setDepthPrepass(bool enabled) { m_depthPrepass = enabled; }
+    bool isDepthPrepassEnabled() const { return m_depthPrepass; }
+
+    // Skips opaque and masked meshes hidden behind the depth of earlier
+    // draws, tested on the GPU (see HiZCulling). Needs the depth pre-pass.
+    void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+    bool isOcclusionCullingEnabled() const { return m_occlusionCulling; }
+    // A few frames late, results are never waited for
+    const HiZCulling::Stats& getOcclusionStats() const { return m_occlusion.getStats(); }
+
+    const FrameStats& getFrameStats() const { return m_frameStats; }
+
 private:
-    Shader m_shader;
+    static constexpr uint32_t kNotTested = UINT32_MAX;
+
+    struct DrawItem {
+        const Model* model;
+        const Mesh* mesh;
+        ShaderFeatureMask features;  // the mesh's, views add the frame-wide ones
+        float viewDepth;  // of the world bounds center in the view being drawn, only used for blended items
+        bool prepassed;
+        GLuint texture;   // base color texture or array, 0 if untextured
+        uint32_t material;  // entry in GpuResources::materials()
+        // Visible meshlet ranges in m_rangeCounts/m_rangeOffsets, whole mesh if rangeCount is 0
+        uint32_t firstRange;
+        uint32_t rangeCount;
+        uint32_t order;   // blended only: scene order, breaks depth ties
+        uint32_t occlusionTest = kNotTested;  // object index in the HiZCulling tests
+        uint8_t viewMask = 0;  // bit per view whose frustum the mesh touches
+    };
+
+    // What differs between the views drawing the same queues
+    struct ViewPass {
+        const Camera* camera = nullptr;
+        uint8_t bit = 0;
+        ShaderFeatureMask features = 0;  // clustered lights, shadows
+        bool occlusion = false;          // draws follow the HiZCulling tests
+    };
+
+    // One clustered mesh's meshlet culling, run in parallel ahead of queue building
+    struct CullTask {
+        const std::vector<Meshlet>* meshlets;
+        Meshlets::CullView views[kMaxViews];
+        size_t viewCount;
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        size_t visible;
+    };
+
+    void setFrameUniforms(Shader& shader, const Camera& camera);
+    void gatherLights(const std::vector<std::unique_ptr<Model>>& models);
+    void renderViews(const View* views, size_t viewCount, const std::vector<std::unique_ptr<Model>>& models);
+    void buildQueues(const View* views, size_t viewCount, const std::vector<std::unique_ptr<Model>>& models);
+    // Appends the ranges of the sub-meshes inside any view to item, sets its
+    // view mask and the world bounds of those sub-meshes
+    void cullSubMeshes(const std::vector<SubMesh>& subMeshes, const glm::mat4& matrix,
+                       const Meshlets::CullView* frustums, size_t viewCount, DrawItem& item,
+                       glm::vec3& worldMin, glm::vec3& worldMax);
+    // Draws m_pass's view of the queues into the current viewport
+    void renderView();
+    // Back to front for m_pass's camera
+    void sortBlendQueue();
+    // Occlusion-tested items draw in the phase of the test they passed, the rest in Previous
+    void renderDepthPrepass(HiZCulling::Phase phase);
+    static void drawGeometry(const DrawItem& item, bool depthOnly, const std::vector<GLsizei>& counts,
+                             const std::vector<const void*>& offsets);
+    // Tested items draw under both tests, passing at most one of them
+    void drawTested(const DrawItem& item);
+    // Draws the items in m_pass's view in order, switching programs and model
+    // uniforms only when they change. Returns how many were drawn.
+    size_t drawItems(const std::vector<DrawItem>& items, size_t begin, size_t end);
+
+    static ShaderFeatureMask meshFeatures(const Model& model, const Mesh& mesh);
+
+    JobSystem& m_jobs;
+    FrameArena& m_frameArena;
+    ShaderPermutations m_shaders;
+    ShaderPermutations m_depthShaders;
+    TextureBuffer m_jointPalette;
+    ClusteredLighting m_clusteredLighting;
+    CascadedShadowMaps m_shadows;
+    HiZCulling m_occlusion;
+    bool m_shadowsEnabled = true;
+    bool m_depthPrepass = true;
+    bool m_occlusionCulling = false;
+    // Entry for meshes that never had a material set
+    uint32_t m_defaultMaterial = UINT32_MAX;
+
+    // Rebuilt every frame, kept as members to reuse their storage
+    std::vector<DrawItem> m_opaqueQueue;
+    std::vector<DrawItem> m_maskQueue;
+    std::vector<DrawItem> m_blendQueue;
+    std::vector<GLsizei> m_rangeCounts;
+    std::vector<const void*> m_rangeOffsets;
+    std::vector<CullTask> m_cullTasks;  // only grows, tasks keep their range storage
+    std::vector<glm::vec4> m_occlusionBounds;  // world min and max per tested item
+    ViewPass m_pass;
+    FrameStats m_frameStats;
+
+    // This frame's model lights in world space
+    std::vector<Light> m_frameLights;
+    bool m_frameHasDirectional = false;
+    glm::vec3 m_frameLightDir = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_frameLightColor = glm::vec3(1.0f);
+    int m_viewportWidth = 1;
+    int m_viewportHeight = 1;
 
     glm::vec4 m_clearColor = glm::vec4(0.1f, 0.1f, 0.15f, 1.0f);
     glm::vec3 m_lightDir = glm::normalize(glm::vec3(-0.5f, -1.0f, -0.3f));
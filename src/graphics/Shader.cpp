@@ -1,4 +1,6 @@
 #include "Shader.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include <fstream>
 #include <sstream>
@@ -6,28 +8,32 @@
 
 Shader::~Shader() {
     if (m_program) {
-        glDeleteProgram(m_program);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Program, m_program);
     }
 }
 
 Shader::Shader(Shader&& other) noexcept
-    : m_program(other.m_program), m_uniformCache(std::move(other.m_uniformCache)) {
+    : m_program(other.m_program),
+      m_uniformNames(std::move(other.m_uniformNames)),
+      m_uniformCache(std::move(other.m_uniformCache)) {
     other.m_program = 0;
 }
 
 Shader& Shader::operator=(Shader&& other) noexcept {
     if (this != &other) {
         if (m_program) {
-            glDeleteProgram(m_program);
+            GpuDeletionQueue::push(GpuDeletionQueue::Kind::Program, m_program);
         }
         m_program = other.m_program;
+        m_uniformNames = std::move(other.m_uniformNames);
         m_uniformCache = std::move(other.m_uniformCache);
         other.m_program = 0;
     }
     return *this;
 }
 
-bool Shader::loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath) {
+bool Shader::loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath,
+                           const std::vector<std::string>& defines) {
     std::string vertexSource = readFile(vertexPath);
     std::string fragmentSource = readFile(fragmentPath);
 
@@ -35,14 +41,15 @@ bool Shader::loadFromFiles(const std::string& vertexPath, const std::string& fra
         return false;
     }
 
-    return loadFromSource(vertexSource, fragmentSource);
+    return loadFromSource(vertexSource, fragmentSource, defines);
 }
 
-bool Shader::loadFromSource(const std::string& vertexSource, const std::string& fragmentSource) {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+bool Shader::loadFromSource(const std::string& vertexSource, const std::string& fragmentSource,
+                            const std::vector<std::string>& defines) {
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, injectDefines(vertexSource, defines));
     if (!vertexShader) return false;
 
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, injectDefines(fragmentSource, defines));
     if (!fragmentShader) {
         glDeleteShader(vertexShader);
         return false;
@@ -90,6 +97,33 @@ GLuint Shader::compileShader(GLenum type, const std::string& source) {
     return shader;
 }
 
+std::string Shader::injectDefines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    std::string block;
+    for (const auto& define : defines) {
+        block += "#define " + define + "\n";
+    }
+
+    // GLSL requires #version to be the first directive, so defines go right after it
+    size_t insertAt = 0;
+    size_t versionPos = source.find("#version");
+    if (versionPos != std::string::npos) {
+        size_t lineEnd = source.find('\n', versionPos);
+        insertAt = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+    }
+
+    std::string result = source;
+    if (insertAt == result.size() && !result.empty() && result.back() != '\n') {
+        result += '\n';
+        insertAt = result.size();
+    }
+    result.insert(insertAt, block);
+    return result;
+}
+
 std::string Shader::readFile(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -103,44 +137,53 @@ std::string Shader::readFile(const std::string& path) {
 }
 
 void Shader::use() const {
-    glUseProgram(m_program);
+    GLState::useProgram(m_program);
 }
 
-GLint Shader::getUniformLocation(const std::string& name) {
+GLint Shader::getUniformLocation(const char* name) {
     auto it = m_uniformCache.find(name);
     if (it != m_uniformCache.end()) {
         return it->second;
     }
 
-    GLint location = glGetUniformLocation(m_program, name.c_str());
-    m_uniformCache[name] = location;
+    GLint location = glGetUniformLocation(m_program, name);
+    m_uniformNames.emplace_back(name);
+    m_uniformCache.emplace(m_uniformNames.back(), location);
     return location;
 }
 
-void Shader::setInt(const std::string& name, int value) {
+void Shader::setInt(const char* name, int value) {
     glUniform1i(getUniformLocation(name), value);
 }
 
-void Shader::setFloat(const std::string& name, float value) {
+void Shader::setFloat(const char* name, float value) {
     glUniform1f(getUniformLocation(name), value);
 }
 
-void Shader::setVec2(const std::string& name, const glm::vec2& value) {
+void Shader::setIVec3(const char* name, const glm::ivec3& value) {
+    glUniform3i(getUniformLocation(name), value.x, value.y, value.z);
+}
+
+void Shader::setVec2(const char* name, const glm::vec2& value) {
     glUniform2f(getUniformLocation(name), value.x, value.y);
 }
 
-void Shader::setVec3(const std::string& name, const glm::vec3& value) {
+void Shader::setVec3(const char* name, const glm::vec3& value) {
     glUniform3f(getUniformLocation(name), value.x, value.y, value.z);
 }
 
-void Shader::setVec4(const std::string& name, const glm::vec4& value) {
+void Shader::setVec4(const char* name, const glm::vec4& value) {
     glUniform4f(getUniformLocation(name), value.x, value.y, value.z, value.w);
 }
 
-void Shader::setMat3(const std::string& name, const glm::mat3& value) {
+void Shader::setMat3(const char* name, const glm::mat3& value) {
     glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void Shader::setMat4(const std::string& name, const glm::mat4& value) {
+void Shader::setMat4(const char* name, const glm::mat4& value) {
     glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 }
+
+void Shader::setMat4Array(const char* name, const glm::mat4* values, int count) {
+    glUniformMatrix4fv(getUniformLocation(name), count, GL_FALSE, glm::value_ptr(values[0]));
+}
@@ -2,8 +2,11 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 class Shader {
 public:
@@ -16,25 +19,36 @@ public:
     Shader(Shader&& other) noexcept;
     Shader& operator=(Shader&& other) noexcept;
 
-    bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
-    bool loadFromSource(const std::string& vertexSource, const std::string& fragmentSource);
+    bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath,
+                       const std::vector<std::string>& defines = {});
+    bool loadFromSource(const std::string& vertexSource, const std::string& fragmentSource,
+                        const std::vector<std::string>& defines = {});
+
+    // Inserts one "#define NAME" line per entry right after the #version directive
+    static std::string injectDefines(const std::string& source, const std::vector<std::string>& defines);
+    static std::string readFile(const std::string& path);
 
     void use() const;
     GLuint getProgram() const { return m_program; }
 
-    void setInt(const std::string& name, int value);
-    void setFloat(const std::string& name, float value);
-    void setVec2(const std::string& name, const glm::vec2& value);
-    void setVec3(const std::string& name, const glm::vec3& value);
-    void setVec4(const std::string& name, const glm::vec4& value);
-    void setMat3(const std::string& name, const glm::mat3& value);
-    void setMat4(const std::string& name, const glm::mat4& value);
+    void setInt(const char* name, int value);
+    void setFloat(const char* name, float value);
+    void setIVec3(const char* name, const glm::ivec3& value);
+    void setVec2(const char* name, const glm::vec2& value);
+    void setVec3(const char* name, const glm::vec3& value);
+    void setVec4(const char* name, const glm::vec4& value);
+    void setMat3(const char* name, const glm::mat3& value);
+    void setMat4(const char* name, const glm::mat4& value);
+    // Whole uniform array in one call, name without the subscript
+    void setMat4Array(const char* name, const glm::mat4* values, int count);
 
 private:
     GLuint compileShader(GLenum type, const std::string& source);
-    GLint getUniformLocation(const std::string& name);
-    std::string readFile(const std::string& path);
+    GLint getUniformLocation(const char* name);
 
     GLuint m_program = 0;
-    std::unordered_map<std::string, GLint> m_uniformCache;
+    // Keys view the strings in m_uniformNames, whose elements never move, so
+    // per-draw lookups hash the caller's name without building a std::string
+    std::deque<std::string> m_uniformNames;
+    std::unordered_map<std::string_view, GLint> m_uniformCache;
 };
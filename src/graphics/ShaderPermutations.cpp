@@ -0,0 +1,155 @@
+#include "ShaderPermutations.hpp"
+#include <iostream>
+
+namespace {
+
+struct FeatureDefine {
+    ShaderFeature bit;
+    const char* define;
+};
+
+const FeatureDefine kFeatureDefines[] = {
+    { SHADER_FEATURE_BASE_COLOR_TEXTURE, "HAS_BASE_COLOR_TEXTURE" },
+    { SHADER_FEATURE_SKINNING, "SKINNING" },
+    { SHADER_FEATURE_CLUSTERED_LIGHTS, "CLUSTERED_LIGHTING" },
+    { SHADER_FEATURE_SHADOWS, "SHADOWS" },
+    { SHADER_FEATURE_ALPHA_MASK, "ALPHA_MASK" },
+    { SHADER_FEATURE_BASE_COLOR_ARRAY, "HAS_BASE_COLOR_ARRAY" },
+    { SHADER_FEATURE_METALLIC_ROUGHNESS_TEXTURE, "HAS_METALLIC_ROUGHNESS_TEXTURE" },
+    { SHADER_FEATURE_NORMAL_TEXTURE, "HAS_NORMAL_TEXTURE" },
+    { SHADER_FEATURE_OCCLUSION_TEXTURE, "HAS_OCCLUSION_TEXTURE" },
+    { SHADER_FEATURE_EMISSIVE_TEXTURE, "HAS_EMISSIVE_TEXTURE" },
+};
+
+constexpr size_t kPermutationCount = size_t(1) << SHADER_FEATURE_COUNT;
+
+} // namespace
+
+bool ShaderPermutations::loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath) {
+    m_vertexPath = vertexPath;
+    m_fragmentPath = fragmentPath;
+    m_vertexSource = Shader::readFile(vertexPath);
+    m_fragmentSource = Shader::readFile(fragmentPath);
+
+    if (m_vertexSource.empty() || m_fragmentSource.empty()) {
+        return false;
+    }
+
+    m_programs.clear();
+    m_programs.resize(kPermutationCount);
+    m_states.assign(kPermutationCount, State::NotCompiled);
+    m_pending.clear();
+
+    // The feature-less program doubles as a sanity check of the sources
+    return compile(0) != nullptr;
+}
+
+bool ShaderPermutations::reload() {
+    std::string vertexSource = Shader::readFile(m_vertexPath);
+    std::string fragmentSource = Shader::readFile(m_fragmentPath);
+    if (vertexSource.empty() || fragmentSource.empty() || m_states.empty()) {
+        return false;
+    }
+
+    // Try the new sources before touching anything, a typo mid-edit must not
+    // take the running programs down
+    Shader shader;
+    if (!shader.loadFromSource(vertexSource, fragmentSource, definesFor(0))) {
+        std::cerr << "Keeping previous shaders, reload failed: " << m_vertexPath << ", " << m_fragmentPath << std::endl;
+        return false;
+    }
+
+    m_vertexSource = std::move(vertexSource);
+    m_fragmentSource = std::move(fragmentSource);
+    m_programs[0] = std::move(shader);
+    m_states[0] = State::Ready;
+
+    // The old programs stay in use until their permutation is compiled again,
+    // queue the ones in use so it happens over the next frames
+    for (ShaderFeatureMask mask = 1; mask < m_states.size(); ++mask) {
+        if (m_states[mask] == State::Ready) {
+            m_states[mask] = State::Stale;
+            m_pending.push_back(mask);
+        } else if (m_states[mask] == State::Failed) {
+            m_states[mask] = State::NotCompiled;
+        }
+    }
+    return true;
+}
+
+Shader* ShaderPermutations::get(ShaderFeatureMask mask) {
+    if (mask >= m_states.size()) {
+        return nullptr;
+    }
+
+    switch (m_states[mask]) {
+        case State::Ready:
+        case State::Stale:
+            return &m_programs[mask];
+        case State::Failed:
+            return nullptr;
+        case State::NotCompiled:
+            break;
+    }
+
+    return compile(mask);
+}
+
+void ShaderPermutations::prewarm(const ShaderFeatureMask* masks, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const ShaderFeatureMask mask = masks[i];
+        if (mask < m_states.size() && m_states[mask] == State::NotCompiled) {
+            m_pending.push_back(mask);
+        }
+    }
+}
+
+size_t ShaderPermutations::compilePending(size_t maxPrograms) {
+    size_t compiled = 0;
+    while (!m_pending.empty() && compiled < maxPrograms) {
+        ShaderFeatureMask mask = m_pending.back();
+        m_pending.pop_back();
+
+        // Already compiled lazily or queued twice
+        if (m_states[mask] != State::NotCompiled && m_states[mask] != State::Stale) {
+            continue;
+        }
+
+        compile(mask);
+        ++compiled;
+    }
+    return compiled;
+}
+
+size_t ShaderPermutations::getCompiledCount() const {
+    size_t count = 0;
+    for (State state : m_states) {
+        if (state == State::Ready || state == State::Stale) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<std::string> ShaderPermutations::definesFor(ShaderFeatureMask mask) {
+    std::vector<std::string> defines;
+    for (const auto& feature : kFeatureDefines) {
+        if (mask & feature.bit) {
+            defines.push_back(feature.define);
+        }
+    }
+    return defines;
+}
+
+Shader* ShaderPermutations::compile(ShaderFeatureMask mask) {
+    Shader shader;
+    if (!shader.loadFromSource(m_vertexSource, m_fragmentSource, definesFor(mask))) {
+        std::cerr << "Failed to compile shader permutation 0x" << std::hex << mask << std::dec << std::endl;
+        m_states[mask] = State::Failed;
+        return nullptr;
+    }
+
+    m_programs[mask] = std::move(shader);
+    m_states[mask] = State::Ready;
+    return &m_programs[mask];
+}
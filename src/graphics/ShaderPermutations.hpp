@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Shader.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Feature bits selecting a specialized program. Each bit maps to one #define
+// injected into both shader stages, so unused paths are compiled out instead
+// of branched over at runtime.
+enum ShaderFeature : uint32_t {
+    SHADER_FEATURE_BASE_COLOR_TEXTURE = 1u << 0,
+    SHADER_FEATURE_SKINNING = 1u << 1,
+    SHADER_FEATURE_CLUSTERED_LIGHTS = 1u << 2,
+    SHADER_FEATURE_SHADOWS = 1u << 3,
+    SHADER_FEATURE_ALPHA_MASK = 1u << 4,
+    SHADER_FEATURE_BASE_COLOR_ARRAY = 1u << 5,
+    SHADER_FEATURE_METALLIC_ROUGHNESS_TEXTURE = 1u << 6,
+    SHADER_FEATURE_NORMAL_TEXTURE = 1u << 7,
+    SHADER_FEATURE_OCCLUSION_TEXTURE = 1u << 8,
+    SHADER_FEATURE_EMISSIVE_TEXTURE = 1u << 9,
+
+    SHADER_FEATURE_COUNT = 10
+};
+
+using ShaderFeatureMask = uint32_t;
+
+class ShaderPermutations {
+public:
+    ShaderPermutations() = default;
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath);
+    // Reads the files again. Keeps the current programs if the new sources
+    // fail to compile; otherwise the permutations in use are recompiled by
+    // compilePending() and keep drawing with the old program until then.
+    bool reload();
+
+    // Returns the program for a feature mask, compiling it on first use.
+    // Returns nullptr if that permutation failed to compile.
+    Shader* get(ShaderFeatureMask mask);
+
+    // Queues permutations to be compiled ahead of their first use
+    void prewarm(const ShaderFeatureMask* masks, size_t count);
+
+    // Compiles at most maxPrograms queued permutations, returns how many were compiled.
+    // Call once per frame to spread compile cost instead of stalling on first draw.
+    size_t compilePending(size_t maxPrograms = 1);
+
+    bool hasPending() const { return !m_pending.empty(); }
+    size_t getCompiledCount() const;
+
+    static std::vector<std::string> definesFor(ShaderFeatureMask mask);
+
+private:
+    // Stale programs were built from the sources before reload() and are queued
+    enum class State : uint8_t { NotCompiled, Ready, Stale, Failed };
+
+    Shader* compile(ShaderFeatureMask mask);
+
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::string m_vertexSource;
+    std::string m_fragmentSource;
+
+    // Indexed directly by mask, all masks fit in 1 << SHADER_FEATURE_COUNT slots.
+    // Stored inline and sized once per load, so pointers from get() stay valid.
+    std::vector<Shader> m_programs;
+    std::vector<State> m_states;
+    std::vector<ShaderFeatureMask> m_pending;
+};
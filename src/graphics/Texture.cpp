@@ -1,6 +1,11 @@
 #include "Texture.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <algorithm>
 #include <iostream>
 
+// stb's vertical flip setting is process-wide and tinygltf decodes with it on
+// parse threads, so it is never changed: every image is read top row first
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -9,55 +14,85 @@ Texture::~Texture() {
 }
 
 Texture::Texture(Texture&& other) noexcept
-    : m_texture(other.m_texture), m_width(other.m_width), m_height(other.m_height) {
+    : m_colorSpace(other.m_colorSpace), m_sampler(other.m_sampler), m_texture(other.m_texture),
+      m_width(other.m_width), m_height(other.m_height), m_channels(other.m_channels),
+      m_memory(std::move(other.m_memory)) {
     other.m_texture = 0;
     other.m_width = 0;
     other.m_height = 0;
+    other.m_channels = 0;
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept {
     if (this != &other) {
         cleanup();
+        m_colorSpace = other.m_colorSpace;
+        m_sampler = other.m_sampler;
         m_texture = other.m_texture;
         m_width = other.m_width;
         m_height = other.m_height;
+        m_channels = other.m_channels;
+        m_memory = std::move(other.m_memory);
         other.m_texture = 0;
         other.m_width = 0;
         other.m_height = 0;
+        other.m_channels = 0;
     }
     return *this;
 }
 
 void Texture::cleanup() {
     if (m_texture) {
-        glDeleteTextures(1, &m_texture);
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_texture);
         m_texture = 0;
     }
+    m_memory.reset();
 }
 
 bool Texture::loadFromFile(const std::string& path) {
-    stbi_set_flip_vertically_on_load(true);
-
-    int channels;
-    unsigned char* data = stbi_load(path.c_str(), &m_width, &m_height, &channels, 0);
+    // Top row first, the same as loadFromEncoded(), which glTF texcoords expect
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
 
     if (!data) {
         std::cerr << "Failed to load texture: " << path << std::endl;
         return false;
     }
+    TrackedMemory decoded(MemoryCategory::DecodedImage, size_t(width) * height * channels);
+
+    bool result = loadFromMemory(data, width, height, channels);
+    stbi_image_free(data);
+
+    return result;
+}
+
+bool Texture::loadFromEncoded(const unsigned char* bytes, size_t size) {
+    // glTF images are stored top row first, which is what the texcoords expect
+    int width, height, channels;
+    unsigned char* data = stbi_load_from_memory(bytes, static_cast<int>(size), &width, &height, &channels, 0);
+
+    if (!data) {
+        std::cerr << "Failed to decode texture: " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+    TrackedMemory decoded(MemoryCategory::DecodedImage, size_t(width) * height * channels);
 
-    bool result = loadFromMemory(data, m_width, m_height, channels);
+    bool result = loadFromMemory(data, width, height, channels);
     stbi_image_free(data);
 
     return result;
 }
 
 bool Texture::loadFromMemory(const unsigned char* data, int width, int height, int channels) {
-    cleanup();
+    // Loading into a live texture keeps its GL object, and its storage too
+    // when the size and format match, so a reload is a plain upload
+    const bool sameStorage = m_texture && width == m_width && height == m_height && channels == m_channels;
 
     m_width = width;
     m_height = height;
+    m_channels = channels;
 
+    const bool srgb = m_colorSpace == ColorSpace::Srgb;
     GLenum format = GL_RGB;
     GLenum internalFormat = GL_RGB8;
 
@@ -66,33 +101,47 @@ bool Texture::loadFromMemory(const unsigned char* data, int width, int height, i
         internalFormat = GL_RED;
     } else if (channels == 3) {
         format = GL_RGB;
-        internalFormat = GL_SRGB8;
+        internalFormat = srgb ? GL_SRGB8 : GL_RGB8;
     } else if (channels == 4) {
         format = GL_RGBA;
-        internalFormat = GL_SRGB8_ALPHA8;
+        internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
     }
 
-    glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    if (!m_texture) {
+        glGenTextures(1, &m_texture);
+    }
+    GLState::bindTexture(0, GL_TEXTURE_2D, m_texture);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    if (sameStorage) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    }
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Drivers pad 3-channel formats to 4 bytes per texel
+    size_t texelSize = channels == 1 ? 1 : 4;
+    size_t bytes = 0;
+    for (int w = width, h = height; ; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        bytes += size_t(w) * h * texelSize;
+        if (w == 1 && h == 1) break;
+    }
+    m_memory.set(MemoryCategory::Texture, bytes);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_sampler.wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_sampler.wrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_sampler.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_sampler.magFilter);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
 
     return true;
 }
 
 void Texture::bind(unsigned int unit) const {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    GLState::bindTexture(unit, GL_TEXTURE_2D, m_texture);
 }
 
 void Texture::unbind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0, GL_TEXTURE_2D, 0);
 }
@@ -1,11 +1,33 @@
 #pragma once
 
+#include "core/MemoryStats.hpp"
 #include <glad/glad.h>
+#include <cstddef>
 #include <string>
 
+// Wrap and filter modes, glTF samplers use the same GL enums
+struct TextureSampler {
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+
+    bool operator<(const TextureSampler& other) const {
+        if (wrapS != other.wrapS) return wrapS < other.wrapS;
+        if (wrapT != other.wrapT) return wrapT < other.wrapT;
+        if (minFilter != other.minFilter) return minFilter < other.minFilter;
+        return magFilter < other.magFilter;
+    }
+};
+
 class Texture {
 public:
-    Texture() = default;
+    // Colors are decoded from sRGB when sampled, data maps (normals,
+    // metallic-roughness, occlusion) are sampled as stored
+    enum class ColorSpace { Srgb, Linear };
+
+    explicit Texture(ColorSpace colorSpace = ColorSpace::Srgb, const TextureSampler& sampler = TextureSampler())
+        : m_colorSpace(colorSpace), m_sampler(sampler) {}
     ~Texture();
 
     Texture(const Texture&) = delete;
@@ -14,8 +36,11 @@ public:
     Texture(Texture&& other) noexcept;
     Texture& operator=(Texture&& other) noexcept;
 
+    // Loading into a texture that already has an image replaces it in place
     bool loadFromFile(const std::string& path);
     bool loadFromMemory(const unsigned char* data, int width, int height, int channels);
+    // Decodes a PNG/JPEG file image held in memory (e.g. a glTF bufferView)
+    bool loadFromEncoded(const unsigned char* bytes, size_t size);
 
     void bind(unsigned int unit = 0) const;
     void unbind() const;
@@ -23,11 +48,16 @@ public:
     GLuint getId() const { return m_texture; }
     int getWidth() const { return m_width; }
     int getHeight() const { return m_height; }
+    size_t getGpuBytes() const { return m_memory.getBytes(); }
 
 private:
     void cleanup();
 
+    ColorSpace m_colorSpace = ColorSpace::Srgb;
+    TextureSampler m_sampler;
     GLuint m_texture = 0;
     int m_width = 0;
     int m_height = 0;
+    int m_channels = 0;
+    TrackedMemory m_memory;
 };
@@ -0,0 +1,179 @@
+#include "TextureArray.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Resamples lineCount lines of RGBA floats along one axis. Lines start
+// *LineStride floats apart, pixels along the axis are *Step floats apart.
+void resampleAxis(const float* src, int srcLength, float* dst, int dstLength,
+                  int lineCount, int srcLineStride, int dstLineStride, int srcStep, int dstStep) {
+    const float scale = static_cast<float>(srcLength) / dstLength;
+    const float radius = std::max(scale, 1.0f);
+    std::vector<float> w;
+
+    for (int x = 0; x < dstLength; ++x) {
+        const float center = (x + 0.5f) * scale - 0.5f;
+        const int first = std::max(static_cast<int>(std::floor(center - radius)) + 1, 0);
+        const int last = std::min(static_cast<int>(std::ceil(center + radius)) - 1, srcLength - 1);
+        const int taps = std::max(last - first + 1, 1);
+        w.assign(taps, 0.0f);
+
+        float total = 0.0f;
+        for (int i = 0; i < taps; ++i) {
+            float d = std::abs(first + i - center) / radius;
+            w[i] = std::max(1.0f - d, 0.0f);
+            total += w[i];
+        }
+        // Can only happen right at the edges when enlarging
+        if (total <= 0.0f) {
+            w[0] = 1.0f;
+            total = 1.0f;
+        }
+
+        for (int line = 0; line < lineCount; ++line) {
+            const float* in = src + line * srcLineStride;
+            float* out = dst + line * dstLineStride + x * dstStep;
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < taps; ++i) {
+                const float* p = in + std::min(first + i, srcLength - 1) * srcStep;
+                for (int c = 0; c < 4; ++c) {
+                    sum[c] += p[c] * w[i];
+                }
+            }
+            for (int c = 0; c < 4; ++c) {
+                out[c] = sum[c] / total;
+            }
+        }
+    }
+}
+
+} // namespace
+
+TextureArray::~TextureArray() {
+    cleanup();
+}
+
+TextureArray::TextureArray(TextureArray&& other) noexcept
+    : m_texture(other.m_texture), m_width(other.m_width), m_height(other.m_height),
+      m_layerCount(other.m_layerCount), m_memory(std::move(other.m_memory)) {
+    other.m_texture = 0;
+    other.m_width = 0;
+    other.m_height = 0;
+    other.m_layerCount = 0;
+}
+
+TextureArray& TextureArray::operator=(TextureArray&& other) noexcept {
+    if (this != &other) {
+        cleanup();
+        m_texture = other.m_texture;
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_layerCount = other.m_layerCount;
+        m_memory = std::move(other.m_memory);
+        other.m_texture = 0;
+        other.m_width = 0;
+        other.m_height = 0;
+        other.m_layerCount = 0;
+    }
+    return *this;
+}
+
+void TextureArray::cleanup() {
+    if (m_texture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_texture);
+        m_texture = 0;
+    }
+    m_memory.reset();
+}
+
+bool TextureArray::create(int width, int height, int layerCount, const TextureSampler& sampler) {
+    cleanup();
+
+    if (width <= 0 || height <= 0 || layerCount <= 0 || layerCount > maxLayers()) {
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    m_layerCount = layerCount;
+
+    glGenTextures(1, &m_texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB8_ALPHA8, width, height, layerCount, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, sampler.wrapS);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, sampler.wrapT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+
+    size_t bytes = 0;
+    for (int w = width, h = height; ; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        bytes += size_t(w) * h * 4 * layerCount;
+        if (w == 1 && h == 1) break;
+    }
+    m_memory.set(MemoryCategory::Texture, bytes);
+    return true;
+}
+
+void TextureArray::uploadLayer(int layer, const unsigned char* rgba) {
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_width, m_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::generateMipmaps() {
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    GLState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(unsigned int unit) const {
+    GLState::bindTexture(unit, GL_TEXTURE_2D_ARRAY, m_texture);
+}
+
+int TextureArray::maxLayers() {
+    static const int layers = [] {
+        GLint value = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &value);
+        return std::max(value, 256);
+    }();
+    return layers;
+}
+
+int TextureArray::sizeClass(int size) {
+    int power = 4;
+    while (power < kMaxSize && power * 2 <= size) {
+        power *= 2;
+    }
+    // Round to nearest: go up if size is closer to the next power
+    if (power < kMaxSize && size - power > power * 2 - size) {
+        power *= 2;
+    }
+    return power;
+}
+
+void TextureArray::resize(const unsigned char* src, int srcWidth, int srcHeight,
+                          unsigned char* dst, int dstWidth, int dstHeight) {
+    std::vector<float> in(size_t(srcWidth) * srcHeight * 4);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = src[i];
+    }
+
+    // Horizontal pass: srcHeight rows, then vertical pass: dstWidth columns
+    std::vector<float> rows(size_t(dstWidth) * srcHeight * 4);
+    resampleAxis(in.data(), srcWidth, rows.data(), dstWidth, srcHeight, srcWidth * 4, dstWidth * 4, 4, 4);
+
+    std::vector<float> out(size_t(dstWidth) * dstHeight * 4);
+    resampleAxis(rows.data(), srcHeight, out.data(), dstHeight, dstWidth, 4, 4, dstWidth * 4, dstWidth * 4);
+
+    for (size_t i = 0; i < out.size(); ++i) {
+        dst[i] = static_cast<unsigned char>(std::clamp(out[i] + 0.5f, 0.0f, 255.0f));
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Texture.hpp"
+#include "core/MemoryStats.hpp"
+#include <glad/glad.h>
+#include <cstddef>
+
+// Mipmapped GL_TEXTURE_2D_ARRAY of same-sized sRGB RGBA8 layers. Textures
+// of one size class and sampler share an array, so draws using any of them
+// keep the same binding and only change the layer they sample. Classes with
+// more textures than maxLayers() are split over several arrays.
+class TextureArray {
+public:
+    // Largest size class, bigger images are scaled down to it
+    static constexpr int kMaxSize = 2048;
+
+    TextureArray() = default;
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    TextureArray(TextureArray&& other) noexcept;
+    TextureArray& operator=(TextureArray&& other) noexcept;
+
+    bool create(int width, int height, int layerCount, const TextureSampler& sampler = TextureSampler());
+    // Tightly packed RGBA8, width x height of this array
+    void uploadLayer(int layer, const unsigned char* rgba);
+    // Call once every layer has been uploaded
+    void generateMipmaps();
+
+    void bind(unsigned int unit = 0) const;
+
+    GLuint getId() const { return m_texture; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getLayerCount() const { return m_layerCount; }
+    size_t getGpuBytes() const { return m_memory.getBytes(); }
+
+    // GL_MAX_ARRAY_TEXTURE_LAYERS, at least 256. Current context only.
+    static int maxLayers();
+
+    // Nearest power of two in [4, kMaxSize]. Powers of two keep REPEAT
+    // wrapping and mip chains intact, unlike padding.
+    static int sizeClass(int size);
+
+    // Resamples RGBA8 with a separable tent filter widened when shrinking
+    static void resize(const unsigned char* src, int srcWidth, int srcHeight,
+                       unsigned char* dst, int dstWidth, int dstHeight);
+
+private:
+    void cleanup();
+
+    GLuint m_texture = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_layerCount = 0;
+    TrackedMemory m_memory;
+};
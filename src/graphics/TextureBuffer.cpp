@@ -0,0 +1,62 @@
+#include "TextureBuffer.hpp"
+#include "GpuDeletionQueue.hpp"
+#include "GLState.hpp"
+#include <utility>
+
+TextureBuffer::TextureBuffer(GLenum format, std::string name)
+    : m_format(format), m_name(std::move(name)) {
+}
+
+TextureBuffer::~TextureBuffer() {
+    cleanup();
+}
+
+void TextureBuffer::cleanup() {
+    if (m_texture) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Texture, m_texture);
+        m_texture = 0;
+    }
+    if (m_buffer) {
+        GpuDeletionQueue::push(GpuDeletionQueue::Kind::Buffer, m_buffer);
+        m_buffer = 0;
+    }
+    m_capacity = 0;
+    m_size = 0;
+    m_memory.reset();
+}
+
+void TextureBuffer::upload(const void* data, size_t bytes) {
+    m_size = static_cast<GLsizeiptr>(bytes);
+    if (m_size == 0) {
+        return;
+    }
+
+    bool created = false;
+    if (!m_buffer) {
+        glGenBuffers(1, &m_buffer);
+        glGenTextures(1, &m_texture);
+        created = true;
+    }
+
+    // Reallocating every frame orphans last frame's storage, so the driver
+    // doesn't have to wait for draws that are still reading it
+    if (m_size > m_capacity) {
+        m_capacity = m_size;
+        MemoryAssetScope scope(m_name);
+        m_memory.set(MemoryCategory::TextureBuffer, static_cast<size_t>(m_capacity));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, m_size, data);
+
+    if (created) {
+        GLState::bindTexture(0, GL_TEXTURE_BUFFER, m_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, m_format, m_buffer);
+        GLState::bindTexture(0, GL_TEXTURE_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::bind(unsigned int unit) const {
+    GLState::bindTexture(unit, GL_TEXTURE_BUFFER, m_texture);
+}
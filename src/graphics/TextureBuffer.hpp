@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/MemoryStats.hpp"
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// Buffer texture re-uploaded every frame (joint palette, light lists).
+// Shaders read it with texelFetch in the format given at construction.
+class TextureBuffer {
+public:
+    // name tags the allocation in MemoryStats
+    TextureBuffer(GLenum format, std::string name);
+    ~TextureBuffer();
+
+    TextureBuffer(const TextureBuffer&) = delete;
+    TextureBuffer& operator=(const TextureBuffer&) = delete;
+
+    void upload(const void* data, size_t bytes);
+
+    template <typename T>
+    void upload(const std::vector<T>& items) {
+        upload(items.data(), items.size() * sizeof(T));
+    }
+
+    void bind(unsigned int unit) const;
+
+    bool isEmpty() const { return m_size == 0; }
+
+private:
+    void cleanup();
+
+    GLenum m_format;
+    std::string m_name;
+    GLuint m_buffer = 0;
+    GLuint m_texture = 0;
+    GLsizeiptr m_capacity = 0;
+    GLsizeiptr m_size = 0;
+    TrackedMemory m_memory;
+};
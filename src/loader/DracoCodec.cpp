@@ -0,0 +1,97 @@
+#include "DracoCodec.hpp"
+
+#ifdef TEO_WITH_DRACO
+#include "tiny_gltf.h"
+#include <draco/compression/decode.h>
+#include <cstring>
+#endif
+
+namespace DracoCodec {
+
+#ifdef TEO_WITH_DRACO
+
+namespace {
+
+template <typename T>
+bool readAttribute(const draco::Mesh& mesh, const draco::PointAttribute& attribute, Attribute& out) {
+    out.data.resize(static_cast<size_t>(mesh.num_points()) * out.components * sizeof(T));
+    T values[4] = {};
+    unsigned char* dst = out.data.data();
+    for (draco::PointIndex i(0); i < mesh.num_points(); ++i) {
+        if (!attribute.ConvertValue<T>(attribute.mapped_index(i), static_cast<int8_t>(out.components), values)) {
+            return false;
+        }
+        std::memcpy(dst, values, sizeof(T) * out.components);
+        dst += sizeof(T) * out.components;
+    }
+    return true;
+}
+
+bool readAttribute(const draco::Mesh& mesh, const draco::PointAttribute& attribute, Attribute& out) {
+    switch (out.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+            return readAttribute<int8_t>(mesh, attribute, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return readAttribute<uint8_t>(mesh, attribute, out);
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+            return readAttribute<int16_t>(mesh, attribute, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            return readAttribute<uint16_t>(mesh, attribute, out);
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return readAttribute<uint32_t>(mesh, attribute, out);
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return readAttribute<float>(mesh, attribute, out);
+    }
+    return false;
+}
+
+} // namespace
+
+bool isAvailable() {
+    return true;
+}
+
+bool decodeMesh(const unsigned char* data, size_t size, std::vector<uint32_t>& indices,
+                std::vector<Attribute>& attributes, size_t& pointCount) {
+    draco::DecoderBuffer buffer;
+    buffer.Init(reinterpret_cast<const char*>(data), size);
+
+    draco::Decoder decoder;
+    auto result = decoder.DecodeMeshFromBuffer(&buffer);
+    if (!result.ok()) {
+        return false;
+    }
+    const draco::Mesh& mesh = *result.value();
+
+    pointCount = mesh.num_points();
+    indices.resize(static_cast<size_t>(mesh.num_faces()) * 3);
+    for (draco::FaceIndex f(0); f < mesh.num_faces(); ++f) {
+        const auto& face = mesh.face(f);
+        for (int corner = 0; corner < 3; ++corner) {
+            indices[f.value() * 3 + corner] = face[corner].value();
+        }
+    }
+
+    for (auto& attribute : attributes) {
+        const draco::PointAttribute* source = mesh.GetAttributeByUniqueId(attribute.uniqueId);
+        if (!source || attribute.components < 1 || attribute.components > 4 ||
+            !readAttribute(mesh, *source, attribute)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#else
+
+bool isAvailable() {
+    return false;
+}
+
+bool decodeMesh(const unsigned char*, size_t, std::vector<uint32_t>&, std::vector<Attribute>&, size_t&) {
+    return false;
+}
+
+#endif
+
+} // namespace DracoCodec
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// KHR_draco_mesh_compression decoding through the draco library. Only
+// compiled in when CMake finds draco (TEO_WITH_DRACO), otherwise
+// isAvailable() is false and decodeMesh always fails.
+namespace DracoCodec {
+
+// One attribute to extract: the draco unique id from the extension's
+// attributes map and the accessor layout it must be written in
+struct Attribute {
+    int uniqueId = -1;
+    int componentType = 0;
+    int components = 0;
+    std::vector<unsigned char> data;  // filled tightly packed, pointCount elements
+};
+
+bool isAvailable();
+
+// Decodes a draco mesh into 32-bit triangle list indices and the requested attributes
+bool decodeMesh(const unsigned char* data, size_t size, std::vector<uint32_t>& indices,
+                std::vector<Attribute>& attributes, size_t& pointCount);
+
+} // namespace DracoCodec
@@ -1,29 +1,2054 @@
 #include "GLTFLoader.hpp"
+#include "DracoCodec.hpp"
+#include "MeshoptCodec.hpp"
+#include "core/MappedFile.hpp"
+#include "core/Arena.hpp"
+#include "core/JobSystem.hpp"
+#include "graphics/GpuResources.hpp"
 #include "graphics/Mesh.hpp"
 #include "graphics/Texture.hpp"
+#include "graphics/TextureArray.hpp"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "tiny_gltf.h"
+#include "stb_image.h"
 
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <map>
+#include <tuple>
+
+// Parsed glTF plus where each buffer's bytes live: tinygltf's own copy, or
+// the BIN chunk of a memory-mapped GLB that tinygltf never copied
+struct GltfSource {
+    tinygltf::Model model;
+
+    std::vector<const unsigned char*> buffers;
+
+    // Mapped GLB only
+    MappedFile file;
+    size_t binOffset = 0;
+    std::vector<bool> bufferMapped;
+    std::vector<int> imageBufferViews;  // per image, -1 if tinygltf decoded it
+
+    // Real byte length of each buffer, placeholders in the document hold only one byte
+    std::vector<size_t> bufferSizes;
+
+    // Per buffer view, the decompressed bytes of EXT_meshopt_compression views
+    // and of the views added for KHR_draco_mesh_compression primitives.
+    // Empty for views read straight from their buffer.
+    std::vector<std::vector<unsigned char>> decodedViews;
+
+    TrackedMemory memory;  // tinygltf's buffer and image copies, plus decoded views
+
+    bool isMapped() const { return file.isOpen(); }
+
+    bool isDecoded(int bufferViewIndex) const {
+        return static_cast<size_t>(bufferViewIndex) < decodedViews.size() && !decodedViews[bufferViewIndex].empty();
+    }
+
+    const unsigned char* viewData(int bufferViewIndex) const {
+        if (isDecoded(bufferViewIndex)) {
+            return decodedViews[bufferViewIndex].data();
+        }
+        const auto& bufferView = model.bufferViews[bufferViewIndex];
+        return buffers[bufferView.buffer] + bufferView.byteOffset;
+    }
+
+    // Starts read-ahead of an accessor's pages / drops them once uploaded.
+    // No-ops unless the accessor lives in a mapped BIN chunk.
+    void prefetchAccessor(int accessorIndex) const { adviseAccessor(accessorIndex, false); }
+    void releaseAccessor(int accessorIndex) const { adviseAccessor(accessorIndex, true); }
+
+    void adviseAccessor(int accessorIndex, bool release) const {
+        if (!isMapped() || accessorIndex < 0) {
+            return;
+        }
+        const auto& accessor = model.accessors[accessorIndex];
+        if (accessor.bufferView < 0 || accessor.count == 0 || isDecoded(accessor.bufferView)) {
+            return;
+        }
+        const auto& bufferView = model.bufferViews[accessor.bufferView];
+        if (!bufferMapped[bufferView.buffer]) {
+            return;
+        }
+
+        int stride = accessor.ByteStride(bufferView);
+        if (stride <= 0) {
+            return;
+        }
+        size_t elementSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(accessor.componentType)) *
+                             tinygltf::GetNumComponentsInType(accessor.type);
+        size_t offset = binOffset + bufferView.byteOffset + accessor.byteOffset;
+        size_t length = (accessor.count - 1) * stride + elementSize;
+
+        if (release) {
+            file.release(offset, length);
+        } else {
+            file.prefetch(offset, length);
+        }
+    }
+};
+
+// A parsed document as far as GLTFLoader::reload compares it: the tinygltf
+// model without buffer or pixel bytes, and content hashes standing in for them
+struct GltfFingerprint {
+    tinygltf::Model model;
+    std::vector<uint64_t> bufferViews;  // bytes as read, after decompression
+    std::vector<uint64_t> images;       // encoded or decoded bytes, or the uri of a file left unread
+};
+
+namespace {
+
+constexpr uint32_t kGlbMagic = 0x46546C67;      // "glTF"
+constexpr uint32_t kGlbChunkJson = 0x4E4F534A;  // "JSON"
+constexpr uint32_t kGlbChunkBin = 0x004E4942;   // "BIN\0"
+
+// Stand-in for buffers and images whose bytes stay in the mapped BIN chunk.
+// tinygltf rejects empty data URIs, so these carry one byte / a 1x1 PNG.
+const char* kPlaceholderBufferUri = "data:application/octet-stream;base64,AA==";
+const char* kPlaceholderImageUri =
+    "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAAEAAAABCAYAAAAfFcSJAAAADUlEQVR42mNk+M9QDwADhgGAWjR9awAAAABJRU5ErkJggg==";
+
+// Primitives with at least this many triangles are split into meshlets for per-cluster culling
+constexpr size_t kMeshletMinTriangles = 4096;
+
+// Irradiance below which an unbounded light is considered to contribute nothing
+constexpr float kLightCutoff = 0.01f;
+
+// Adds the heap allocations made on this thread while alive to a running total
+class HeapAllocationTally {
+public:
+    explicit HeapAllocationTally(uint64_t& total)
+        : m_total(total), m_start(MemoryStats::getThreadHeapAllocationCount()) {}
+    ~HeapAllocationTally() { m_total += MemoryStats::getThreadHeapAllocationCount() - m_start; }
+
+    HeapAllocationTally(const HeapAllocationTally&) = delete;
+    HeapAllocationTally& operator=(const HeapAllocationTally&) = delete;
+
+    // Total including this scope so far
+    uint64_t get() const { return m_total + MemoryStats::getThreadHeapAllocationCount() - m_start; }
+
+private:
+    uint64_t& m_total;
+    uint64_t m_start;
+};
+
+uint32_t readU32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+bool hasExtension(const std::string& path, const char* extension) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == extension;
+}
+
+size_t numberValue(const tinygltf::Value& object, const char* key, size_t fallback) {
+    const tinygltf::Value& value = object.Get(key);
+    return value.IsNumber() ? static_cast<size_t>(value.GetNumberAsDouble()) : fallback;
+}
+
+std::string stringValue(const tinygltf::Value& object, const char* key) {
+    const tinygltf::Value& value = object.Get(key);
+    return value.IsString() ? value.Get<std::string>() : std::string();
+}
+
+// Marks fallback buffers of EXT_meshopt_compression as placeholders. Their
+// views are all compressed, so their bytes are never needed and are often
+// not even present. Returns one flag per buffer.
+std::vector<bool> stubFallbackBuffers(nlohmann::json& doc) {
+    std::vector<bool> fallback;
+    if (!doc.contains("buffers") || !doc["buffers"].is_array()) {
+        return fallback;
+    }
+    for (auto& buffer : doc["buffers"]) {
+        bool stub = false;
+        if (buffer.is_object() && buffer.contains("extensions")) {
+            const auto& extensions = buffer["extensions"];
+            stub = extensions.is_object() && extensions.contains("EXT_meshopt_compression") &&
+                   extensions["EXT_meshopt_compression"].value("fallback", false);
+        }
+        if (stub) {
+            buffer["uri"] = kPlaceholderBufferUri;
+            buffer["byteLength"] = 1;
+        }
+        fallback.push_back(stub);
+    }
+    return fallback;
+}
+
+// One compressed buffer view (meshopt) or compressed primitive (draco), decoded
+// independently of the others
+struct DecodeJob {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool decoded = false;
+
+    // EXT_meshopt_compression
+    int bufferView = -1;
+    MeshoptCodec::Mode mode = MeshoptCodec::Mode::Attributes;
+    MeshoptCodec::Filter filter = MeshoptCodec::Filter::None;
+    size_t count = 0;
+    size_t stride = 0;
+    std::vector<unsigned char> output;
+
+    // KHR_draco_mesh_compression, decoded once for every primitive sharing the view
+    struct DracoPrimitive {
+        int mesh = -1;
+        int primitive = -1;
+        std::vector<int> attributeAccessors;  // per entry in attributes, -1 if this primitive doesn't use it
+    };
+    std::vector<DracoPrimitive> primitives;
+    std::vector<uint32_t> indices;
+    std::vector<DracoCodec::Attribute> attributes;
+    size_t pointCount = 0;
+};
+
+bool collectMeshoptJob(const GltfSource& source, int viewIndex, const tinygltf::Value& extension, DecodeJob& job) {
+    const size_t buffer = numberValue(extension, "buffer", source.buffers.size());
+    const size_t byteOffset = numberValue(extension, "byteOffset", 0);
+    const size_t byteLength = numberValue(extension, "byteLength", 0);
+    if (buffer >= source.buffers.size() || byteOffset + byteLength > source.bufferSizes[buffer]) {
+        return false;
+    }
+
+    const std::string mode = stringValue(extension, "mode");
+    const std::string filter = stringValue(extension, "filter");
+    if (mode == "ATTRIBUTES") {
+        job.mode = MeshoptCodec::Mode::Attributes;
+    } else if (mode == "TRIANGLES") {
+        job.mode = MeshoptCodec::Mode::Triangles;
+    } else if (mode == "INDICES") {
+        job.mode = MeshoptCodec::Mode::Indices;
+    } else {
+        return false;
+    }
+    if (filter.empty() || filter == "NONE") {
+        job.filter = MeshoptCodec::Filter::None;
+    } else if (filter == "OCTAHEDRAL") {
+        job.filter = MeshoptCodec::Filter::Octahedral;
+    } else if (filter == "QUATERNION") {
+        job.filter = MeshoptCodec::Filter::Quaternion;
+    } else if (filter == "EXPONENTIAL") {
+        job.filter = MeshoptCodec::Filter::Exponential;
+    } else {
+        return false;
+    }
+
+    job.bufferView = viewIndex;
+    job.data = source.buffers[buffer] + byteOffset;
+    job.size = byteLength;
+    job.count = numberValue(extension, "count", 0);
+    job.stride = numberValue(extension, "byteStride", 0);
+    return job.count > 0 && job.stride > 0;
+}
+
+// Adds a primitive to the job decoding its compressed view. Attributes are
+// decoded as the first primitive asking for them declares them.
+bool collectDracoJob(const GltfSource& source, int meshIndex, int primitiveIndex, const tinygltf::Value& extension,
+                     DecodeJob& job) {
+    const auto& primitive = source.model.meshes[meshIndex].primitives[primitiveIndex];
+    const size_t viewIndex = numberValue(extension, "bufferView", source.model.bufferViews.size());
+    const tinygltf::Value& attributes = extension.Get("attributes");
+    if (viewIndex >= source.model.bufferViews.size() || !attributes.IsObject()) {
+        return false;
+    }
+
+    DecodeJob::DracoPrimitive user;
+    user.mesh = meshIndex;
+    user.primitive = primitiveIndex;
+    user.attributeAccessors.assign(job.attributes.size(), -1);
+    for (const auto& [name, accessor] : primitive.attributes) {
+        const tinygltf::Value& uniqueId = attributes.Get(name);
+        if (!uniqueId.IsNumber()) {
+            continue;
+        }
+        const int id = uniqueId.GetNumberAsInt();
+        size_t a = 0;
+        while (a < job.attributes.size() && job.attributes[a].uniqueId != id) {
+            ++a;
+        }
+        if (a == job.attributes.size()) {
+            const auto& gltfAccessor = source.model.accessors[accessor];
+            DracoCodec::Attribute attribute;
+            attribute.uniqueId = id;
+            attribute.componentType = gltfAccessor.componentType;
+            attribute.components = tinygltf::GetNumComponentsInType(gltfAccessor.type);
+            job.attributes.push_back(std::move(attribute));
+            user.attributeAccessors.push_back(-1);
+        }
+        user.attributeAccessors[a] = accessor;
+    }
+
+    job.primitives.push_back(std::move(user));
+    job.data = source.viewData(static_cast<int>(viewIndex));
+    job.size = source.model.bufferViews[viewIndex].byteLength;
+    return true;
+}
+
+void runDecodeJob(DecodeJob& job) {
+    if (job.bufferView >= 0) {
+        job.output.resize(job.count * job.stride);
+        job.decoded = MeshoptCodec::decode(job.mode, job.filter, job.output.data(), job.count, job.stride,
+                                           job.data, job.size);
+    } else {
+        job.decoded = DracoCodec::decodeMesh(job.data, job.size, job.indices, job.attributes, job.pointCount);
+    }
+}
+
+// Appends a buffer view holding decoded bytes and points an accessor at it
+void attachDecodedView(GltfSource& source, int accessorIndex, int componentType, size_t count,
+                       std::vector<unsigned char> bytes) {
+    tinygltf::BufferView bufferView;
+    bufferView.buffer = -1;
+    bufferView.byteLength = bytes.size();
+    source.model.bufferViews.push_back(bufferView);
+    source.decodedViews.push_back(std::move(bytes));
+
+    auto& accessor = source.model.accessors[accessorIndex];
+    accessor.bufferView = static_cast<int>(source.model.bufferViews.size()) - 1;
+    accessor.byteOffset = 0;
+    accessor.componentType = componentType;
+    accessor.count = count;
+}
+
+// Decompresses every EXT_meshopt_compression buffer view and
+// KHR_draco_mesh_compression primitive on the job system, one view or
+// primitive per task, so the upload steps only ever see plain buffer views.
+// Returns false if a required view couldn't be decoded.
+bool decodeCompressedViews(GltfSource& source) {
+    tinygltf::Model& model = source.model;
+    std::vector<DecodeJob> jobs;
+
+    for (size_t i = 0; i < model.bufferViews.size(); ++i) {
+        auto extension = model.bufferViews[i].extensions.find("EXT_meshopt_compression");
+        if (extension == model.bufferViews[i].extensions.end()) {
+            continue;
+        }
+        DecodeJob job;
+        if (!collectMeshoptJob(source, static_cast<int>(i), extension->second, job)) {
+            std::cerr << "glTF error: malformed EXT_meshopt_compression on buffer view " << i << std::endl;
+            return false;
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    // Primitives sharing a compressed view decode it once
+    std::map<size_t, size_t> dracoViews;
+    for (size_t m = 0; m < model.meshes.size(); ++m) {
+        auto& primitives = model.meshes[m].primitives;
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            auto extension = primitives[p].extensions.find("KHR_draco_mesh_compression");
+            if (extension == primitives[p].extensions.end()) {
+                continue;
+            }
+            const size_t viewIndex = numberValue(extension->second, "bufferView", model.bufferViews.size());
+            auto shared = dracoViews.find(viewIndex);
+            DecodeJob job;
+            DecodeJob& target = shared != dracoViews.end() ? jobs[shared->second] : job;
+            if (!DracoCodec::isAvailable() ||
+                !collectDracoJob(source, static_cast<int>(m), static_cast<int>(p), extension->second, target)) {
+                std::cerr << "glTF warning: skipping KHR_draco_mesh_compression primitive " << p << " of mesh " << m
+                          << (DracoCodec::isAvailable() ? ", extension is malformed" : ", built without draco")
+                          << std::endl;
+                primitives[p].attributes.clear();
+                continue;
+            }
+            if (shared == dracoViews.end()) {
+                dracoViews[viewIndex] = jobs.size();
+                jobs.push_back(std::move(job));
+            }
+        }
+    }
+
+    if (jobs.empty()) {
+        return true;
+    }
+
+    // Largest first, so one big view doesn't start last and leave the other workers idle
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobs[a].size > jobs[b].size; });
+
+    JobSystem& jobSystem = JobSystem::instance();
+    const auto start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(order.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            runDecodeJob(jobs[order[i]]);
+        }
+    });
+    const double milliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    source.decodedViews.resize(model.bufferViews.size());
+    size_t compressedBytes = 0;
+    size_t decodedBytes = 0;
+    for (auto& job : jobs) {
+        compressedBytes += job.size;
+        if (job.bufferView >= 0) {
+            if (!job.decoded) {
+                std::cerr << "glTF error: failed to decode meshopt buffer view " << job.bufferView << std::endl;
+                return false;
+            }
+            decodedBytes += job.output.size();
+            source.decodedViews[job.bufferView] = std::move(job.output);
+            continue;
+        }
+
+        if (!job.decoded) {
+            for (const auto& user : job.primitives) {
+                std::cerr << "glTF warning: failed to decode draco primitive " << user.primitive << " of mesh "
+                          << user.mesh << std::endl;
+                model.meshes[user.mesh].primitives[user.primitive].attributes.clear();
+            }
+            continue;
+        }
+
+        // Accessors shared between the primitives are pointed at the decoded data once
+        std::vector<int> attached;
+        auto attach = [&](int accessor, int componentType, size_t count, const unsigned char* data, size_t size) {
+            if (accessor < 0 || std::find(attached.begin(), attached.end(), accessor) != attached.end()) {
+                return;
+            }
+            attached.push_back(accessor);
+            decodedBytes += size;
+            attachDecodedView(source, accessor, componentType, count, std::vector<unsigned char>(data, data + size));
+        };
+        for (const auto& user : job.primitives) {
+            auto& primitive = model.meshes[user.mesh].primitives[user.primitive];
+            attach(primitive.indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, job.indices.size(),
+                   reinterpret_cast<const unsigned char*>(job.indices.data()), job.indices.size() * sizeof(uint32_t));
+            // Shorter than attributes if later primitives asked for more of them
+            for (size_t a = 0; a < user.attributeAccessors.size(); ++a) {
+                attach(user.attributeAccessors[a], job.attributes[a].componentType, job.pointCount,
+                       job.attributes[a].data.data(), job.attributes[a].data.size());
+            }
+            // Draco faces are always a triangle list, even for strip primitives
+            primitive.mode = TINYGLTF_MODE_TRIANGLES;
+        }
+    }
+
+    const double megabytes = decodedBytes / (1024.0 * 1024.0);
+    std::cout << "Decompressed " << jobs.size() << " buffer views: " << compressedBytes / (1024.0 * 1024.0)
+              << " MB -> " << megabytes << " MB in " << milliseconds << " ms ("
+              << (milliseconds > 0.0 ? megabytes / (milliseconds / 1000.0) : 0.0) << " MB/s, "
+              << std::min<size_t>(jobs.size(), jobSystem.getThreadCount()) << " threads)" << std::endl;
+    return true;
+}
+
+// Reads component c of element i of an accessor as float, applying
+// normalization for integer types as the glTF spec requires
+float readComponent(const unsigned char* element, int componentType, bool normalized, int c) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            return reinterpret_cast<const float*>(element)[c];
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+            float v = reinterpret_cast<const uint8_t*>(element)[c];
+            return normalized ? v / 255.0f : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            float v = reinterpret_cast<const int8_t*>(element)[c];
+            return normalized ? std::max(v / 127.0f, -1.0f) : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            float v = reinterpret_cast<const uint16_t*>(element)[c];
+            return normalized ? v / 65535.0f : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            float v = reinterpret_cast<const int16_t*>(element)[c];
+            return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            return static_cast<float>(reinterpret_cast<const uint32_t*>(element)[c]);
+    }
+    return 0.0f;
+}
+
+glm::vec3 readVec3(const unsigned char* element, int componentType, bool normalized) {
+    return glm::vec3(readComponent(element, componentType, normalized, 0),
+                     readComponent(element, componentType, normalized, 1),
+                     readComponent(element, componentType, normalized, 2));
+}
+
+// Calls fn(i, element) for every element of a (non-sparse) accessor, honouring byteStride
+template <typename Fn>
+bool forEachElement(const GltfSource& source, int accessorIndex, Fn fn) {
+    if (accessorIndex < 0) {
+        return false;
+    }
+    const auto& accessor = source.model.accessors[accessorIndex];
+    if (accessor.bufferView < 0) {
+        return false;
+    }
+    const auto& bufferView = source.model.bufferViews[accessor.bufferView];
+
+    int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0) {
+        return false;
+    }
+
+    const unsigned char* base = source.viewData(accessor.bufferView) + accessor.byteOffset;
+    for (size_t i = 0; i < accessor.count; ++i) {
+        fn(i, base + i * stride);
+    }
+    return true;
+}
+
+// Reads any float/normalized accessor into vec4s, missing components are zero.
+// Takes std::vector or ArenaVector.
+template <typename Vec4Vector>
+void readVec4s(const GltfSource& source, int accessorIndex, Vec4Vector& result) {
+    result.clear();
+    if (accessorIndex < 0) {
+        return;
+    }
+    const auto& accessor = source.model.accessors[accessorIndex];
+    int components = std::min(4, tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type)));
+
+    result.resize(accessor.count, glm::vec4(0.0f));
+    forEachElement(source, accessorIndex, [&](size_t i, const unsigned char* element) {
+        for (int c = 0; c < components; ++c) {
+            result[i][c] = readComponent(element, accessor.componentType, accessor.normalized, c);
+        }
+    });
+}
+
+std::vector<glm::vec4> readVec4s(const GltfSource& source, int accessorIndex) {
+    std::vector<glm::vec4> result;
+    readVec4s(source, accessorIndex, result);
+    return result;
+}
+
+std::vector<float> readFloats(const GltfSource& source, int accessorIndex) {
+    std::vector<float> result;
+    if (accessorIndex < 0) {
+        return result;
+    }
+    const auto& accessor = source.model.accessors[accessorIndex];
+    result.resize(accessor.count, 0.0f);
+    forEachElement(source, accessorIndex, [&](size_t i, const unsigned char* element) {
+        result[i] = readComponent(element, accessor.componentType, accessor.normalized, 0);
+    });
+    return result;
+}
+
+// Reads a triangle primitive's vertices, normals and texcoords default when missing
+template <typename VertexVector>
+void readVertices(const GltfSource& source, const tinygltf::Primitive& primitive, VertexVector& vertices) {
+    const int positionAccessor = primitive.attributes.at("POSITION");
+    const int normalAccessor = primitive.attributes.count("NORMAL") ? primitive.attributes.at("NORMAL") : -1;
+    const int texCoordAccessor = primitive.attributes.count("TEXCOORD_0") ? primitive.attributes.at("TEXCOORD_0") : -1;
+    const size_t vertexCount = source.model.accessors[positionAccessor].count;
+
+    Vertex defaultVertex;
+    defaultVertex.position = glm::vec3(0.0f);
+    defaultVertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    defaultVertex.texCoord = glm::vec2(0.0f);
+    vertices.assign(vertexCount, defaultVertex);
+
+    // Positions and normals may be quantized (KHR_mesh_quantization) or come
+    // from a meshopt filter as normalized 8/16-bit components
+    const auto& positions = source.model.accessors[positionAccessor];
+    forEachElement(source, positionAccessor, [&](size_t i, const unsigned char* element) {
+        vertices[i].position = readVec3(element, positions.componentType, positions.normalized);
+    });
+
+    if (normalAccessor >= 0) {
+        const auto& normals = source.model.accessors[normalAccessor];
+        forEachElement(source, normalAccessor, [&](size_t i, const unsigned char* element) {
+            vertices[i].normal = readVec3(element, normals.componentType, normals.normalized);
+        });
+    }
+
+    if (texCoordAccessor >= 0) {
+        const auto& accessor = source.model.accessors[texCoordAccessor];
+        forEachElement(source, texCoordAccessor, [&](size_t i, const unsigned char* element) {
+            vertices[i].texCoord = glm::vec2(
+                readComponent(element, accessor.componentType, accessor.normalized, 0),
+                readComponent(element, accessor.componentType, accessor.normalized, 1));
+        });
+    }
+}
+
+// Widens a primitive's indices to 32 bits, generating sequential ones if it has none
+template <typename IndexVector>
+void readIndices(const GltfSource& source, const tinygltf::Primitive& primitive, IndexVector& indices) {
+    indices.clear();
+    if (primitive.indices >= 0) {
+        const auto& accessor = source.model.accessors[primitive.indices];
+        indices.resize(accessor.count);
+
+        switch (accessor.componentType) {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+                forEachElement(source, primitive.indices, [&](size_t i, const unsigned char* element) {
+                    uint16_t index;
+                    std::memcpy(&index, element, sizeof(index));
+                    indices[i] = index;
+                });
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+                forEachElement(source, primitive.indices, [&](size_t i, const unsigned char* element) {
+                    uint32_t index;
+                    std::memcpy(&index, element, sizeof(index));
+                    indices[i] = index;
+                });
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                forEachElement(source, primitive.indices, [&](size_t i, const unsigned char* element) {
+                    indices[i] = *element;
+                });
+                break;
+        }
+    } else {
+        const size_t vertexCount = source.model.accessors[primitive.attributes.at("POSITION")].count;
+        indices.reserve(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            indices.push_back(static_cast<unsigned int>(i));
+        }
+    }
+}
+
+// Reads a triangle primitive's vertices and indices. Starts read-ahead of
+// every accessor it touches.
+template <typename VertexVector, typename IndexVector>
+void readPrimitive(const GltfSource& source, const tinygltf::Primitive& primitive,
+                   VertexVector& vertices, IndexVector& indices) {
+    const int normalAccessor = primitive.attributes.count("NORMAL") ? primitive.attributes.at("NORMAL") : -1;
+    const int texCoordAccessor = primitive.attributes.count("TEXCOORD_0") ? primitive.attributes.at("TEXCOORD_0") : -1;
+
+    source.prefetchAccessor(primitive.attributes.at("POSITION"));
+    source.prefetchAccessor(normalAccessor);
+    source.prefetchAccessor(texCoordAccessor);
+    source.prefetchAccessor(primitive.indices);
+
+    readVertices(source, primitive, vertices);
+    readIndices(source, primitive, indices);
+}
+
+// Strided element access into one accessor, for loops that walk several accessors at once
+struct AccessorView {
+    const unsigned char* data = nullptr;
+    size_t stride = 0;
+    size_t count = 0;
+    int componentType = 0;
+    bool normalized = false;
+
+    bool valid() const { return data != nullptr; }
+    const unsigned char* element(size_t i) const { return data + i * stride; }
+};
+
+AccessorView viewAccessor(const GltfSource& source, int accessorIndex) {
+    AccessorView view;
+    if (accessorIndex < 0) {
+        return view;
+    }
+    const auto& accessor = source.model.accessors[accessorIndex];
+    if (accessor.bufferView < 0) {
+        return view;
+    }
+    const int stride = accessor.ByteStride(source.model.bufferViews[accessor.bufferView]);
+    if (stride <= 0) {
+        return view;
+    }
+    view.data = source.viewData(accessor.bufferView) + accessor.byteOffset;
+    view.stride = static_cast<size_t>(stride);
+    view.count = accessor.count;
+    view.componentType = accessor.componentType;
+    view.normalized = accessor.normalized;
+    return view;
+}
+
+// Same result as readPrimitive() followed by Mesh::setup(), but decodes straight
+// into the mesh's mapped buffers instead of staging vectors. Every element is
+// written once, in order, as a whole struct, which suits write-combined memory.
+// Returns false if mapping failed or the contents were lost, the mesh is then
+// left for the caller to set up the staged way.
+bool writePrimitive(const GltfSource& source, const tinygltf::Primitive& primitive, Mesh& mesh) {
+    const int positionAccessor = primitive.attributes.at("POSITION");
+    const int normalAccessor = primitive.attributes.count("NORMAL") ? primitive.attributes.at("NORMAL") : -1;
+    const int texCoordAccessor = primitive.attributes.count("TEXCOORD_0") ? primitive.attributes.at("TEXCOORD_0") : -1;
+
+    source.prefetchAccessor(positionAccessor);
+    source.prefetchAccessor(normalAccessor);
+    source.prefetchAccessor(texCoordAccessor);
+    source.prefetchAccessor(primitive.indices);
+
+    const AccessorView positions = viewAccessor(source, positionAccessor);
+    const AccessorView normals = viewAccessor(source, normalAccessor);
+    const AccessorView texCoords = viewAccessor(source, texCoordAccessor);
+    const AccessorView indices = viewAccessor(source, primitive.indices);
+    const size_t vertexCount = source.model.accessors[positionAccessor].count;
+    const size_t indexCount = primitive.indices >= 0 ? source.model.accessors[primitive.indices].count : vertexCount;
+    if (!positions.valid() || (primitive.indices >= 0 && !indices.valid()) || vertexCount == 0 || indexCount == 0) {
+        return false;
+    }
+
+    Mesh::MappedGeometry geometry;
+    if (!mesh.mapForWrite(vertexCount, indexCount, geometry)) {
+        return false;
+    }
+
+    glm::vec3 boundsMin(1.0e30f);
+    glm::vec3 boundsMax(-1.0e30f);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        Vertex vertex;
+        vertex.position = readVec3(positions.element(i), positions.componentType, positions.normalized);
+        vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        if (i < normals.count) {
+            vertex.normal = readVec3(normals.element(i), normals.componentType, normals.normalized);
+        }
+        vertex.texCoord = glm::vec2(0.0f);
+        if (i < texCoords.count) {
+            const unsigned char* element = texCoords.element(i);
+            vertex.texCoord = glm::vec2(readComponent(element, texCoords.componentType, texCoords.normalized, 0),
+                                        readComponent(element, texCoords.componentType, texCoords.normalized, 1));
+        }
+
+        geometry.vertices[i] = vertex;
+        geometry.positions[i] = vertex.position;
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+
+    if (primitive.indices < 0) {
+        for (size_t i = 0; i < indexCount; ++i) {
+            geometry.indices[i] = static_cast<unsigned int>(i);
+        }
+    } else {
+        for (size_t i = 0; i < indexCount; ++i) {
+            const unsigned char* element = indices.element(i);
+            uint32_t index = 0;
+            if (indices.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+                uint16_t value;
+                std::memcpy(&value, element, sizeof(value));
+                index = value;
+            } else if (indices.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+                std::memcpy(&index, element, sizeof(index));
+            } else if (indices.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+                index = *element;
+            }
+            geometry.indices[i] = index;
+        }
+    }
+
+    return mesh.unmapWrite(boundsMin, boundsMax);
+}
+
+// Drops the mapped pages behind a primitive's geometry, call once it is uploaded
+void releasePrimitive(const GltfSource& source, const tinygltf::Primitive& primitive) {
+    for (const char* attribute : { "POSITION", "NORMAL", "TEXCOORD_0" }) {
+        auto it = primitive.attributes.find(attribute);
+        if (it != primitive.attributes.end()) {
+            source.releaseAccessor(it->second);
+        }
+    }
+    source.releaseAccessor(primitive.indices);
+}
+
+// Object-space box of a primitive from its POSITION accessor's min/max, which glTF requires
+void positionBounds(const GltfSource& source, const tinygltf::Primitive& primitive, glm::vec3& min, glm::vec3& max) {
+    const auto& accessor = source.model.accessors[primitive.attributes.at("POSITION")];
+    min = max = glm::vec3(0.0f);
+    if (accessor.minValues.size() >= 3 && accessor.maxValues.size() >= 3) {
+        min = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
+        max = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
+    }
+}
+
+void transformBounds(const glm::mat4& matrix, glm::vec3& min, glm::vec3& max) {
+    const glm::vec3 lo = min, hi = max;
+    min = glm::vec3(1.0e30f);
+    max = glm::vec3(-1.0e30f);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec3 p((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+        glm::vec3 world = glm::vec3(matrix * glm::vec4(p, 1.0f));
+        min = glm::min(min, world);
+        max = glm::max(max, world);
+    }
+}
+
+// Flat-shaded box standing in for a primitive until its geometry is uploaded
+Mesh makeProxy(const glm::vec3& min, const glm::vec3& max, const Material& material) {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    vertices.reserve(24);
+    indices.reserve(36);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = 0; side < 2; ++side) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = side ? 1.0f : -1.0f;
+            // Two in-plane axes ordered so the face winds counter-clockwise seen from outside
+            const int u = side ? (axis + 1) % 3 : (axis + 2) % 3;
+            const int v = side ? (axis + 2) % 3 : (axis + 1) % 3;
+
+            const auto base = static_cast<unsigned int>(vertices.size());
+            for (int corner = 0; corner < 4; ++corner) {
+                const bool du = corner == 1 || corner == 2;
+                const bool dv = corner >= 2;
+                Vertex vertex;
+                vertex.position[axis] = side ? max[axis] : min[axis];
+                vertex.position[u] = du ? max[u] : min[u];
+                vertex.position[v] = dv ? max[v] : min[v];
+                vertex.normal = normal;
+                vertex.texCoord = glm::vec2(du ? 1.0f : 0.0f, dv ? 1.0f : 0.0f);
+                vertices.push_back(vertex);
+            }
+            for (unsigned int i : { 0u, 1u, 2u, 0u, 2u, 3u }) {
+                indices.push_back(base + i);
+            }
+        }
+    }
+
+    Mesh mesh;
+    mesh.setup(vertices, indices);
+    mesh.setMaterial(material);
+    mesh.setLoadState(LoadState::Proxy);
+    return mesh;
+}
+
+// Size of an image without decoding it, 0x0 if unknown
+void imageSize(const GltfSource& source, int imageIndex, const std::string& basePath, int& width, int& height) {
+    const auto& image = source.model.images[imageIndex];
+    const int mappedView = imageIndex < static_cast<int>(source.imageBufferViews.size())
+        ? source.imageBufferViews[imageIndex] : -1;
+    int channels = 0;
+    width = height = 0;
+
+    if (mappedView >= 0) {
+        const auto& bufferView = source.model.bufferViews[mappedView];
+        stbi_info_from_memory(source.viewData(mappedView), static_cast<int>(bufferView.byteLength),
+                              &width, &height, &channels);
+    } else if (!image.image.empty()) {
+        width = image.width;
+        height = image.height;
+    } else if (!image.uri.empty()) {
+        stbi_info((basePath + image.uri).c_str(), &width, &height, &channels);
+    }
+}
+
+// Decodes an external image file to tightly packed RGBA8, top row first. Initial
+// loads and hot reloads both go through here, so a reload can't come out different.
+// Free the result with stbi_image_free().
+unsigned char* decodeImageFile(const std::string& path, int& width, int& height) {
+    int channels = 0;
+    return stbi_load(path.c_str(), &width, &height, &channels, 4);
+}
+
+// Decodes an image to tightly packed RGBA8, top row first as glTF texcoords expect
+bool decodeImage(const GltfSource& source, int imageIndex, const std::string& basePath,
+                 std::vector<unsigned char>& rgba, int& width, int& height) {
+    const auto& image = source.model.images[imageIndex];
+    const int mappedView = imageIndex < static_cast<int>(source.imageBufferViews.size())
+        ? source.imageBufferViews[imageIndex] : -1;
+
+    if (mappedView < 0 && !image.image.empty()) {
+        // Already decoded by tinygltf, only 8-bit images are packed
+        if (image.bits != 8 || image.component < 1 || image.component > 4) {
+            return false;
+        }
+        width = image.width;
+        height = image.height;
+        rgba.resize(size_t(width) * height * 4);
+        for (size_t i = 0; i < size_t(width) * height; ++i) {
+            const unsigned char* in = image.image.data() + i * image.component;
+            unsigned char* out = rgba.data() + i * 4;
+            out[0] = in[0];
+            out[1] = image.component >= 3 ? in[1] : in[0];
+            out[2] = image.component >= 3 ? in[2] : in[0];
+            out[3] = image.component == 4 ? in[3] : (image.component == 2 ? in[1] : 255);
+        }
+        return true;
+    }
+
+    unsigned char* decoded = nullptr;
+    if (mappedView >= 0) {
+        const auto& bufferView = source.model.bufferViews[mappedView];
+        int channels = 0;
+        decoded = stbi_load_from_memory(source.viewData(mappedView), static_cast<int>(bufferView.byteLength),
+                                        &width, &height, &channels, 4);
+        if (source.bufferMapped[bufferView.buffer]) {
+            source.file.release(source.binOffset + bufferView.byteOffset, bufferView.byteLength);
+        }
+    } else if (!image.uri.empty()) {
+        decoded = decodeImageFile(basePath + image.uri, width, height);
+    }
+
+    if (!decoded) {
+        return false;
+    }
+    rgba.assign(decoded, decoded + size_t(width) * height * 4);
+    stbi_image_free(decoded);
+    return true;
+}
+
+// A texture's glTF sampler as GL parameters. Unset or invalid modes keep the defaults.
+TextureSampler textureSampler(const tinygltf::Model& model, int textureIndex) {
+    TextureSampler sampler;
+    const int index = model.textures[textureIndex].sampler;
+    if (index < 0 || index >= static_cast<int>(model.samplers.size())) {
+        return sampler;
+    }
+    const auto& gltfSampler = model.samplers[index];
+    auto isWrap = [](int mode) { return mode == GL_REPEAT || mode == GL_CLAMP_TO_EDGE || mode == GL_MIRRORED_REPEAT; };
+    if (isWrap(gltfSampler.wrapS)) {
+        sampler.wrapS = gltfSampler.wrapS;
+    }
+    if (isWrap(gltfSampler.wrapT)) {
+        sampler.wrapT = gltfSampler.wrapT;
+    }
+    switch (gltfSampler.minFilter) {
+        case GL_NEAREST:
+        case GL_LINEAR:
+        case GL_NEAREST_MIPMAP_NEAREST:
+        case GL_LINEAR_MIPMAP_NEAREST:
+        case GL_NEAREST_MIPMAP_LINEAR:
+        case GL_LINEAR_MIPMAP_LINEAR:
+            sampler.minFilter = gltfSampler.minFilter;
+            break;
+    }
+    if (gltfSampler.magFilter == GL_NEAREST || gltfSampler.magFilter == GL_LINEAR) {
+        sampler.magFilter = gltfSampler.magFilter;
+    }
+    return sampler;
+}
+
+// Resamples RGBA8 pixels to an array's size and uploads them to one layer
+void fillLayer(TextureArray& array, int layer, const unsigned char* rgba, int width, int height) {
+    TrackedMemory decoded(MemoryCategory::DecodedImage, size_t(width) * height * 4);
+    if (width == array.getWidth() && height == array.getHeight()) {
+        array.uploadLayer(layer, rgba);
+        return;
+    }
+    std::vector<unsigned char> resized(size_t(array.getWidth()) * array.getHeight() * 4);
+    TrackedMemory resampled(MemoryCategory::DecodedImage, resized.size());
+    TextureArray::resize(rgba, width, height, resized.data(), array.getWidth(), array.getHeight());
+    array.uploadLayer(layer, resized.data());
+}
+
+// Hashes and compares vertices by their bits, for welding exact duplicates
+struct VertexBitsHash {
+    size_t operator()(const Vertex& vertex) const {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+        size_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(Vertex); ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+struct VertexBitsEqual {
+    bool operator()(const Vertex& a, const Vertex& b) const {
+        return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+
+glm::mat4 nodeLocalMatrix(const tinygltf::Node& node) {
+    if (node.matrix.size() == 16) {
+        glm::mat4 m;
+        for (int i = 0; i < 16; ++i) {
+            m[i / 4][i % 4] = static_cast<float>(node.matrix[i]);
+        }
+        return m;
+    }
+
+    glm::mat4 m(1.0f);
+    if (node.translation.size() == 3) {
+        m = glm::translate(m, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+    }
+    if (node.rotation.size() == 4) {
+        m *= glm::mat4_cast(glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]),
+                                      static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2])));
+    }
+    if (node.scale.size() == 3) {
+        m = glm::scale(m, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+    }
+    return m;
+}
+
+void nodeRestPose(const tinygltf::Node& node, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) {
+    translation = glm::vec3(0.0f);
+    rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    scale = glm::vec3(1.0f);
+
+    if (node.matrix.size() == 16) {
+        // Matrix nodes are never animated, but joints still need their rest
+        // pose as TRS so untouched paths can be filled in
+        glm::mat4 m = nodeLocalMatrix(node);
+        translation = glm::vec3(m[3]);
+        scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+        glm::mat3 rotationMatrix(glm::vec3(m[0]) / scale.x, glm::vec3(m[1]) / scale.y, glm::vec3(m[2]) / scale.z);
+        rotation = glm::quat_cast(rotationMatrix);
+        return;
+    }
+
+    if (node.translation.size() == 3) {
+        translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+    }
+    if (node.rotation.size() == 4) {
+        rotation = glm::quat(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]),
+                             static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
+    }
+    if (node.scale.size() == 3) {
+        scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+    }
+}
+
+// Builds a Skeleton with joints sorted parents-first. skinToJoint maps the
+// skin's joint order (what JOINTS_0 refers to) to the sorted order,
+// nodeToJoint maps node indices to sorted joints or -1.
+std::shared_ptr<Skeleton> loadSkeleton(const GltfSource& source, const tinygltf::Skin& skin,
+                                       const std::vector<int>& nodeParents,
+                                       std::vector<int>& nodeToJoint, std::vector<uint16_t>& skinToJoint) {
+    const tinygltf::Model& gltfModel = source.model;
+    const size_t jointCount = skin.joints.size();
+
+    std::vector<int> nodeToSkinJoint(gltfModel.nodes.size(), -1);
+    for (size_t j = 0; j < jointCount; ++j) {
+        nodeToSkinJoint[skin.joints[j]] = static_cast<int>(j);
+    }
+
+    // Nearest ancestor that is also a joint, intermediate nodes are folded away
+    std::vector<int> skinParents(jointCount, -1);
+    std::vector<int> depths(jointCount, 0);
+    for (size_t j = 0; j < jointCount; ++j) {
+        int node = nodeParents[skin.joints[j]];
+        while (node >= 0 && nodeToSkinJoint[node] < 0) {
+            node = nodeParents[node];
+        }
+        if (node >= 0) {
+            skinParents[j] = nodeToSkinJoint[node];
+        }
+
+        for (int n = nodeParents[skin.joints[j]]; n >= 0; n = nodeParents[n]) {
+            ++depths[j];
+        }
+    }
+
+    std::vector<uint16_t> order(jointCount);
+    for (size_t j = 0; j < jointCount; ++j) {
+        order[j] = static_cast<uint16_t>(j);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint16_t a, uint16_t b) { return depths[a] < depths[b]; });
+
+    skinToJoint.assign(jointCount, 0);
+    for (size_t sorted = 0; sorted < jointCount; ++sorted) {
+        skinToJoint[order[sorted]] = static_cast<uint16_t>(sorted);
+    }
+
+    std::vector<glm::vec4> inverseBind;
+    if (skin.inverseBindMatrices >= 0) {
+        // Read as 4 columns of 4 floats each
+        const auto& accessor = gltfModel.accessors[skin.inverseBindMatrices];
+        inverseBind.resize(accessor.count * 4);
+        forEachElement(source, skin.inverseBindMatrices, [&](size_t i, const unsigned char* element) {
+            const float* m = reinterpret_cast<const float*>(element);
+            for (int c = 0; c < 4; ++c) {
+                inverseBind[i * 4 + c] = glm::vec4(m[c * 4], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]);
+            }
+        });
+    }
+
+    auto skeleton = std::make_shared<Skeleton>();
+    skeleton->parents.resize(jointCount);
+    skeleton->inverseBindMatrices.resize(jointCount, glm::mat4(1.0f));
+    skeleton->restTranslations.resize(jointCount);
+    skeleton->restRotations.resize(jointCount);
+    skeleton->restScales.resize(jointCount);
+    skeleton->rootParentTransforms.resize(jointCount, glm::mat4(1.0f));
+    skeleton->names.resize(jointCount);
+
+    nodeToJoint.assign(gltfModel.nodes.size(), -1);
+    for (size_t sorted = 0; sorted < jointCount; ++sorted) {
+        const uint16_t j = order[sorted];
+        const int nodeIndex = skin.joints[j];
+        const auto& node = gltfModel.nodes[nodeIndex];
+        nodeToJoint[nodeIndex] = static_cast<int>(sorted);
+
+        skeleton->parents[sorted] = skinParents[j] >= 0 ? skinToJoint[skinParents[j]] : -1;
+        skeleton->names[sorted] = node.name;
+        nodeRestPose(node, skeleton->restTranslations[sorted], skeleton->restRotations[sorted],
+                     skeleton->restScales[sorted]);
+
+        if (size_t(j) * 4 + 3 < inverseBind.size()) {
+            skeleton->inverseBindMatrices[sorted] = glm::mat4(inverseBind[j * 4], inverseBind[j * 4 + 1],
+                                                              inverseBind[j * 4 + 2], inverseBind[j * 4 + 3]);
+        }
+
+        // Roots inherit whatever non-joint nodes sit above them (e.g. an armature node)
+        if (skeleton->parents[sorted] < 0) {
+            glm::mat4 parentTransform(1.0f);
+            for (int n = nodeParents[nodeIndex]; n >= 0; n = nodeParents[n]) {
+                parentTransform = nodeLocalMatrix(gltfModel.nodes[n]) * parentTransform;
+            }
+            skeleton->rootParentTransforms[sorted] = parentTransform;
+        }
+    }
+
+    return skeleton;
+}
+
+std::shared_ptr<AnimationClip> loadAnimation(const GltfSource& source, const tinygltf::Animation& animation,
+                                             const std::vector<int>& nodeToJoint) {
+    auto clip = std::make_shared<AnimationClip>();
+    clip->name = animation.name;
+
+    for (const auto& gltfChannel : animation.channels) {
+        if (gltfChannel.target_node < 0 || gltfChannel.sampler < 0) {
+            continue;
+        }
+        int joint = nodeToJoint[gltfChannel.target_node];
+        if (joint < 0) {
+            continue;
+        }
+
+        AnimationChannel channel;
+        channel.joint = static_cast<uint32_t>(joint);
+        if (gltfChannel.target_path == "translation") {
+            channel.path = AnimationPath::Translation;
+        } else if (gltfChannel.target_path == "rotation") {
+            channel.path = AnimationPath::Rotation;
+        } else if (gltfChannel.target_path == "scale") {
+            channel.path = AnimationPath::Scale;
+        } else {
+            // Morph target weights are not supported
+            continue;
+        }
+
+        const auto& sampler = animation.samplers[gltfChannel.sampler];
+        if (sampler.interpolation == "STEP") {
+            channel.interpolation = AnimationInterpolation::Step;
+        } else if (sampler.interpolation == "CUBICSPLINE") {
+            channel.interpolation = AnimationInterpolation::CubicSpline;
+        } else {
+            channel.interpolation = AnimationInterpolation::Linear;
+        }
+
+        std::vector<float> times = readFloats(source, sampler.input);
+        std::vector<glm::vec4> values = readVec4s(source, sampler.output);
+        const size_t valuesPerKey = channel.interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+        if (times.empty() || values.size() < times.size() * valuesPerKey) {
+            continue;
+        }
+
+        channel.firstKey = static_cast<uint32_t>(clip->times.size());
+        channel.keyCount = static_cast<uint32_t>(times.size());
+        channel.firstValue = static_cast<uint32_t>(clip->values.size());
+
+        clip->times.insert(clip->times.end(), times.begin(), times.end());
+        clip->values.insert(clip->values.end(), values.begin(), values.begin() + times.size() * valuesPerKey);
+        clip->duration = std::max(clip->duration, times.back());
+        clip->channels.push_back(channel);
+    }
+
+    clip->memory.set(MemoryCategory::Animation, clip->times.size() * sizeof(float) +
+                                                clip->values.size() * sizeof(glm::vec4) +
+                                                clip->channels.size() * sizeof(AnimationChannel));
+    return clip;
+}
+
+Light loadLight(const tinygltf::Light& gltfLight, const glm::mat4& world) {
+    Light light;
+    if (gltfLight.type == "directional") {
+        light.type = LightType::Directional;
+    } else if (gltfLight.type == "spot") {
+        light.type = LightType::Spot;
+    }
+
+    // Lights shine down their node's -Z
+    light.position = glm::vec3(world[3]);
+    light.direction = glm::normalize(glm::mat3(world) * glm::vec3(0.0f, 0.0f, -1.0f));
+    if (gltfLight.color.size() >= 3) {
+        light.color = glm::vec3(gltfLight.color[0], gltfLight.color[1], gltfLight.color[2]);
+    }
+    light.intensity = static_cast<float>(gltfLight.intensity);
+    light.innerConeAngle = static_cast<float>(gltfLight.spot.innerConeAngle);
+    light.outerConeAngle = static_cast<float>(gltfLight.spot.outerConeAngle);
+
+    light.range = static_cast<float>(gltfLight.range);
+    if (light.range <= 0.0f) {
+        // Unbounded in glTF, cut it where inverse-square falloff drops below kLightCutoff
+        float peak = light.intensity * std::max(light.color.r, std::max(light.color.g, light.color.b));
+        light.range = std::sqrt(std::max(peak, 0.0f) / kLightCutoff);
+    }
+    return light;
+}
+
+// Directory of a document with a trailing separator, "" for the working directory
+std::string basePathOf(const std::string& path) {
+    std::string basePath = std::filesystem::path(path).parent_path().string();
+    if (!basePath.empty()) {
+        basePath += "/";
+    }
+    return basePath;
+}
+
+// Absolute and normalized, the form FileWatcher reports changes in
+std::string absolutePath(const std::string& path) {
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return error ? path : absolute.lexically_normal().string();
+}
+
+bool isDataUri(const std::string& uri) {
+    return uri.compare(0, 5, "data:") == 0;
+}
+
+// Content hash for change detection, 8 bytes per step. A collision only
+// means one missed reload, so it need not be cryptographic.
+uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t seed = 0) {
+    constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = seed ^ (size * kMultiplier);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ (word * kMultiplier));
+        hash = ((hash << 31) | (hash >> 33)) * 0xBF58476D1CE4E5B9ull;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, data + i, size - i);
+    hash ^= tail * kMultiplier;
+    hash ^= hash >> 32;
+    hash *= kMultiplier;
+    return hash ^ (hash >> 29);
+}
+
+std::unique_ptr<GltfFingerprint> makeFingerprint(GltfSource& source) {
+    auto fingerprint = std::make_unique<GltfFingerprint>();
+    tinygltf::Model& model = source.model;
+
+    // Everything but the buffers, and the images without their pixels
+    tinygltf::Model& copy = fingerprint->model;
+    copy.accessors = model.accessors;
+    copy.animations = model.animations;
+    copy.bufferViews = model.bufferViews;
+    copy.materials = model.materials;
+    copy.meshes = model.meshes;
+    copy.nodes = model.nodes;
+    copy.textures = model.textures;
+    copy.skins = model.skins;
+    copy.samplers = model.samplers;
+    copy.scenes = model.scenes;
+    copy.lights = model.lights;
+    copy.defaultScene = model.defaultScene;
+    copy.extensionsUsed = model.extensionsUsed;
+    copy.images.reserve(model.images.size());
+    for (auto& image : model.images) {
+        std::vector<unsigned char> pixels = std::move(image.image);
+        copy.images.push_back(image);
+        image.image = std::move(pixels);
+    }
+
+    fingerprint->bufferViews.resize(model.bufferViews.size());
+    for (size_t v = 0; v < model.bufferViews.size(); ++v) {
+        const int view = static_cast<int>(v);
+        const size_t length = source.isDecoded(view) ? source.decodedViews[v].size() : model.bufferViews[v].byteLength;
+        fingerprint->bufferViews[v] = hashBytes(source.viewData(view), length);
+    }
+
+    fingerprint->images.resize(model.images.size());
+    for (size_t i = 0; i < model.images.size(); ++i) {
+        const auto& image = model.images[i];
+        const int mappedView = i < source.imageBufferViews.size() ? source.imageBufferViews[i] : -1;
+        uint64_t& hash = fingerprint->images[i];
+        if (mappedView >= 0) {
+            hash = fingerprint->bufferViews[mappedView];
+        } else if (!image.image.empty()) {
+            const uint64_t shape = (uint64_t(image.width) << 32) ^ (uint64_t(image.height) << 8) ^ uint64_t(image.component);
+            hash = hashBytes(image.image.data(), image.image.size(), shape);
+        } else {
+            hash = hashBytes(reinterpret_cast<const unsigned char*>(image.uri.data()), image.uri.size());
+        }
+    }
+    return fingerprint;
+}
+
+bool accessorChanged(const GltfFingerprint& before, const GltfFingerprint& after, int accessorIndex) {
+    if (accessorIndex < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(accessorIndex) >= before.model.accessors.size() ||
+        static_cast<size_t>(accessorIndex) >= after.model.accessors.size()) {
+        return true;
+    }
+    const auto& old = before.model.accessors[accessorIndex];
+    const auto& current = after.model.accessors[accessorIndex];
+    if (!(old == current)) {
+        return true;
+    }
+    if (current.bufferView < 0) {
+        return false;
+    }
+    const size_t view = static_cast<size_t>(current.bufferView);
+    return view >= before.bufferViews.size() || view >= after.bufferViews.size() ||
+           before.bufferViews[view] != after.bufferViews[view];
+}
+
+bool primitiveChanged(const GltfFingerprint& before, const GltfFingerprint& after, const tinygltf::Primitive& primitive) {
+    for (const auto& [name, accessor] : primitive.attributes) {
+        if (accessorChanged(before, after, accessor)) {
+            return true;
+        }
+    }
+    return accessorChanged(before, after, primitive.indices);
+}
+
+// Whether reload() can patch the model: same nodes, skins, animations,
+// lights and texture bindings, and the same primitives reading the same
+// accessors. Accessor contents, images and materials are free to change.
+bool sameStructure(const GltfFingerprint& before, const GltfFingerprint& after) {
+    const tinygltf::Model& a = before.model;
+    const tinygltf::Model& b = after.model;
+    if (!(a.nodes == b.nodes) || !(a.skins == b.skins) || !(a.animations == b.animations) ||
+        !(a.lights == b.lights) || !(a.scenes == b.scenes) || !(a.textures == b.textures) ||
+        a.extensionsUsed != b.extensionsUsed || a.images.size() != b.images.size() ||
+        a.materials.size() != b.materials.size() || a.meshes.size() != b.meshes.size()) {
+        return false;
+    }
+    for (size_t m = 0; m < a.meshes.size(); ++m) {
+        const auto& primitivesA = a.meshes[m].primitives;
+        const auto& primitivesB = b.meshes[m].primitives;
+        if (primitivesA.size() != primitivesB.size()) {
+            return false;
+        }
+        for (size_t p = 0; p < primitivesA.size(); ++p) {
+            // The material may change, reload() reassigns it
+            if (primitivesA[p].attributes != primitivesB[p].attributes ||
+                primitivesA[p].indices != primitivesB[p].indices || primitivesA[p].mode != primitivesB[p].mode) {
+                return false;
+            }
+        }
+    }
+
+    // Skeletons and clips are built once per model, changed data means a new upload
+    for (const auto& skin : b.skins) {
+        if (accessorChanged(before, after, skin.inverseBindMatrices)) {
+            return false;
+        }
+    }
+    for (const auto& animation : b.animations) {
+        for (const auto& sampler : animation.samplers) {
+            if (accessorChanged(before, after, sampler.input) || accessorChanged(before, after, sampler.output)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+ParsedGltf::ParsedGltf() = default;
+ParsedGltf::~ParsedGltf() = default;
+ParsedGltf::ParsedGltf(ParsedGltf&& other) noexcept = default;
+ParsedGltf& ParsedGltf::operator=(ParsedGltf&& other) noexcept = default;
 
 std::unique_ptr<Model> GLTFLoader::load(const std::string& path) {
-    tinygltf::Model gltfModel;
-    tinygltf::TinyGLTF loader;
-    std::string err, warn;
+    return upload(parse(path));
+}
+
+ParsedGltf GLTFLoader::parse(const std::string& path) const {
+    const uint64_t heapStart = MemoryStats::getThreadHeapAllocationCount();
+    ParsedGltf parsed;
+    parsed.m_path = path;
+
+    auto source = std::make_unique<GltfSource>();
+    if (!parseSource(path, *source) || !decodeCompressedViews(*source)) {
+        std::cerr << "Failed to load glTF: " << path << std::endl;
+        return parsed;
+    }
+    if (m_options.hotReload) {
+        parsed.m_fingerprint = makeFingerprint(*source);
+    }
+    parsed.m_source = std::move(source);
+    parsed.m_heapAllocations = MemoryStats::getThreadHeapAllocationCount() - heapStart;
+    return parsed;
+}
+
+// An upload in progress, advanced by uploadStep()
+struct GLTFLoader::UploadState {
+    ParsedGltf parsed;
+    std::string name;
+    bool progressive = false;
+
+    std::vector<int> nodeParents;
+    std::vector<bool> meshSkinned;
+    std::vector<uint16_t> skinToJoint;
+
+    // Static batches replace the first staticProxies meshes in one step
+    bool batchPending = false;
+    size_t staticProxies = 0;
+
+    // Primitives uploaded one per step, the first lands at mesh firstPrimitiveMesh
+    struct PrimitiveRef {
+        int mesh;
+        int primitive;
+    };
+    std::vector<PrimitiveRef> primitives;
+    size_t nextPrimitive = 0;
+    size_t firstPrimitiveMesh = 0;
+
+    // Texture array layers left to decode, see collectTextureArrays
+    struct PendingLayer {
+        int texture;
+        int image;
+        TextureArrayHandle array;
+        int layer;
+    };
+    std::vector<PendingLayer> layers;
+    std::vector<TextureArrayHandle> arrays;
+    size_t nextLayer = 0;
+
+    // Progressive only: glTF material of each model mesh, textured in the last steps
+    std::vector<int> meshMaterials;
+    size_t nextMaterial = 0;
+
+    // glTF material of each static batch, for the load record
+    std::vector<int> batchMaterials;
+};
+
+GLTFLoader::LoadRecord::LoadRecord() = default;
+GLTFLoader::LoadRecord::~LoadRecord() = default;
+
+GLTFLoader::GLTFLoader() = default;
+GLTFLoader::~GLTFLoader() = default;
+
+std::unique_ptr<Model> GLTFLoader::upload(ParsedGltf parsed) {
+    auto model = beginUpload(std::move(parsed), false);
+    while (model && uploadStep(*model)) {
+    }
+    return model;
+}
+
+void GLTFLoader::readGeometry(const ParsedGltf& parsed, std::vector<std::vector<Vertex>>* vertices,
+                              std::vector<std::vector<unsigned int>>* indices) {
+    if (vertices) {
+        vertices->clear();
+    }
+    if (indices) {
+        indices->clear();
+    }
+    if (!parsed.isValid()) {
+        return;
+    }
+
+    const GltfSource& source = *parsed.m_source;
+    for (const auto& mesh : source.model.meshes) {
+        for (const auto& primitive : mesh.primitives) {
+            if (primitive.mode != TINYGLTF_MODE_TRIANGLES || !primitive.attributes.count("POSITION")) {
+                continue;
+            }
+            if (vertices) {
+                vertices->emplace_back();
+                readVertices(source, primitive, vertices->back());
+            }
+            if (indices) {
+                indices->emplace_back();
+                readIndices(source, primitive, indices->back());
+            }
+        }
+    }
+}
+
+size_t GLTFLoader::decodeImages(const ParsedGltf& parsed) {
+    if (!parsed.isValid()) {
+        return 0;
+    }
+
+    const std::string basePath = basePathOf(parsed.m_path);
+
+    size_t pixels = 0;
+    std::vector<unsigned char> rgba;
+    for (size_t i = 0; i < parsed.m_source->model.images.size(); ++i) {
+        int width = 0;
+        int height = 0;
+        if (decodeImage(*parsed.m_source, static_cast<int>(i), basePath, rgba, width, height)) {
+            pixels += size_t(width) * height;
+        }
+    }
+    return pixels;
+}
+
+std::unique_ptr<Model> GLTFLoader::beginUpload(ParsedGltf parsed, bool progressive) {
+    m_upload.reset();
+    if (!parsed.isValid()) {
+        return nullptr;
+    }
+
+    // Counted from here, plus what parse() counted on its thread
+    m_uploadHeapAllocations = parsed.m_heapAllocations;
+    HeapAllocationTally heapAllocations(m_uploadHeapAllocations);
+
+    auto state = std::make_unique<UploadState>();
+    state->parsed = std::move(parsed);
+    state->progressive = progressive;
+    const std::string& path = state->parsed.m_path;
+    GltfSource& source = *state->parsed.m_source;
+
+    m_basePath = basePathOf(path);
+    m_record.reset();
+
+    // Everything allocated below and in the steps is accounted to this model
+    state->name = std::filesystem::path(path).stem().string();
+    MemoryAssetScope memoryScope(state->name);
+
+    const tinygltf::Model& gltfModel = source.model;
+
+    size_t documentBytes = 0;
+    for (const auto& buffer : gltfModel.buffers) {
+        documentBytes += buffer.data.size();
+    }
+    for (const auto& image : gltfModel.images) {
+        documentBytes += image.image.size();
+    }
+    for (const auto& view : source.decodedViews) {
+        documentBytes += view.size();
+    }
+    source.memory.set(MemoryCategory::GltfDocument, documentBytes);
+
+    auto model = std::make_unique<Model>();
+    model->setName(state->name);
+
+    m_textureCache.clear();
+    m_arrayLayers.clear();
+    if (m_options.textureArrays) {
+        collectTextureArrays(source, *model, *state);
+        // Materials pick up their layers as they load, so without proxies the arrays go first
+        while (!progressive && state->nextLayer < state->layers.size()) {
+            uploadArrayLayer(source, *state);
+        }
+    }
+
+    // Skinning: one skeleton per model, taken from the first skinned mesh node
+    state->nodeParents.assign(gltfModel.nodes.size(), -1);
+    for (size_t n = 0; n < gltfModel.nodes.size(); ++n) {
+        for (int child : gltfModel.nodes[n].children) {
+            state->nodeParents[child] = static_cast<int>(n);
+        }
+    }
+
+    int skinIndex = -1;
+    state->meshSkinned.assign(gltfModel.meshes.size(), false);
+    for (const auto& node : gltfModel.nodes) {
+        if (node.mesh < 0 || node.skin < 0) {
+            continue;
+        }
+        if (skinIndex < 0) {
+            skinIndex = node.skin;
+        }
+        if (node.skin == skinIndex) {
+            state->meshSkinned[node.mesh] = true;
+        }
+    }
+
+    if (skinIndex >= 0) {
+        std::vector<int> nodeToJoint;
+        auto skeleton = loadSkeleton(source, gltfModel.skins[skinIndex], state->nodeParents, nodeToJoint,
+                                     state->skinToJoint);
+
+        for (const auto& animation : gltfModel.animations) {
+            auto clip = loadAnimation(source, animation, nodeToJoint);
+            if (!clip->channels.empty()) {
+                model->addAnimation(std::move(clip));
+            }
+        }
+
+        model->setSkeleton(std::move(skeleton));
+    }
+
+    state->batchPending = m_options.staticBatching;
+    for (size_t meshIndex = 0; meshIndex < gltfModel.meshes.size(); ++meshIndex) {
+        // Batched, only skinned meshes upload primitive by primitive
+        if (m_options.staticBatching && !state->meshSkinned[meshIndex]) {
+            continue;
+        }
+        const auto& primitives = gltfModel.meshes[meshIndex].primitives;
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            if (primitives[p].mode == TINYGLTF_MODE_TRIANGLES && primitives[p].attributes.count("POSITION")) {
+                state->primitives.push_back({ static_cast<int>(meshIndex), static_cast<int>(p) });
+            }
+        }
+    }
+
+    // KHR_lights_punctual, placed by their node's world transform
+    for (size_t n = 0; n < gltfModel.nodes.size(); ++n) {
+        int lightIndex = gltfModel.nodes[n].light;
+        if (lightIndex < 0 || lightIndex >= static_cast<int>(gltfModel.lights.size())) {
+            continue;
+        }
+
+        glm::mat4 world(1.0f);
+        for (int node = static_cast<int>(n); node >= 0; node = state->nodeParents[node]) {
+            world = nodeLocalMatrix(gltfModel.nodes[node]) * world;
+        }
+        model->addLight(loadLight(gltfModel.lights[lightIndex], world));
+    }
+
+    if (progressive) {
+        addProxies(source, *state, *model);
+        model->setLoadState(LoadState::Proxy);
+    }
+
+    m_upload = std::move(state);
+    return model;
+}
+
+bool GLTFLoader::uploadStep(Model& model) {
+    if (!m_upload) {
+        return false;
+    }
+    UploadState& state = *m_upload;
+    GltfSource& source = *state.parsed.m_source;
+    MemoryAssetScope memoryScope(state.name);
+    HeapAllocationTally heapAllocations(m_uploadHeapAllocations);
+    // Step temporaries live in the arena until the step returns
+    ArenaScope scratch(m_arena);
+
+    if (state.batchPending) {
+        std::vector<Mesh> meshes;
+        std::vector<int> materials;
+        loadStaticBatches(source, model, state.meshSkinned, state.nodeParents, !state.progressive, meshes, materials);
+        if (state.progressive) {
+            for (auto& mesh : meshes) {
+                mesh.setLoadState(LoadState::Geometry);
+            }
+            state.meshMaterials.erase(state.meshMaterials.begin(), state.meshMaterials.begin() + state.staticProxies);
+            state.meshMaterials.insert(state.meshMaterials.begin(), materials.begin(), materials.end());
+        }
+        state.firstPrimitiveMesh = meshes.size();
+        state.batchMaterials = std::move(materials);
+        model.replaceMeshes(0, state.staticProxies, std::move(meshes));
+        state.batchPending = false;
+        return true;
+    }
+
+    if (state.nextPrimitive < state.primitives.size()) {
+        uploadPrimitive(source, state, model);
+        if (state.nextPrimitive == state.primitives.size() && state.progressive) {
+            model.setLoadState(LoadState::Geometry);
+        }
+        return true;
+    }
+
+    if (state.nextLayer < state.layers.size()) {
+        uploadArrayLayer(source, state);
+        return true;
+    }
+
+    if (state.progressive && state.nextMaterial < model.getMeshCount()) {
+        Material material = loadMaterial(source, model, state.meshMaterials[state.nextMaterial], true);
+        Mesh& mesh = model.getMesh(state.nextMaterial);
+        mesh.setMaterial(material);
+        mesh.setLoadState(LoadState::Full);
+        ++state.nextMaterial;
+        return true;
+    }
+
+    model.setLoadState(LoadState::Full);
+    std::cout << "Loaded glTF: " << state.parsed.m_path << " (" << model.getMeshCount() << " meshes, "
+              << heapAllocations.get() << " heap allocations";
+    if (model.getSkeleton()) {
+        std::cout << ", " << model.getSkeleton()->getJointCount() << " joints, "
+                  << model.getAnimations().size() << " animations";
+    }
+    if (!model.getLights().empty()) {
+        std::cout << ", " << model.getLights().size() << " lights";
+    }
+    std::cout << ")" << std::endl;
+
+    if (state.parsed.m_fingerprint) {
+        m_record = makeLoadRecord(state);
+    }
+    m_upload.reset();
+    // Scratch of one file says little about the next, give it back
+    m_arena.release();
+    return false;
+}
+
+std::unique_ptr<GLTFLoader::LoadRecord> GLTFLoader::makeLoadRecord(UploadState& state) {
+    auto record = std::make_unique<LoadRecord>();
+    record->m_path = state.parsed.m_path;
+    record->m_name = state.name;
+    record->m_options = m_options;
+    record->m_fingerprint = std::move(state.parsed.m_fingerprint);
+    record->m_batchMaterials = state.batchMaterials;
+    for (const auto& ref : state.primitives) {
+        record->m_primitives.emplace_back(ref.mesh, ref.primitive);
+    }
+    record->m_meshSkinned = state.meshSkinned;
+    record->m_skinToJoint = state.skinToJoint;
+    record->m_textures = m_textureCache;
+    record->m_arrayLayers = m_arrayLayers;
+    recordFiles(*state.parsed.m_source, *record);
+    return record;
+}
+
+void GLTFLoader::recordFiles(const GltfSource& source, LoadRecord& record) {
+    const std::string basePath = basePathOf(record.m_path);
+    record.m_documentFiles.assign(1, absolutePath(record.m_path));
+    for (const auto& buffer : source.model.buffers) {
+        if (!buffer.uri.empty() && !isDataUri(buffer.uri)) {
+            record.m_documentFiles.push_back(absolutePath(basePath + buffer.uri));
+        }
+    }
+    record.m_imageFiles.clear();
+    for (const auto& image : source.model.images) {
+        if (!image.uri.empty() && !isDataUri(image.uri)) {
+            record.m_imageFiles.push_back(absolutePath(basePath + image.uri));
+        }
+    }
+}
+
+GLTFLoader::ReloadResult GLTFLoader::reload(ParsedGltf& parsed, Model& model, LoadRecord& record) {
+    if (!parsed.isValid() || !parsed.m_fingerprint || !record.m_fingerprint) {
+        return ReloadResult::Failed;
+    }
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+
+    const GltfSource& source = *parsed.m_source;
+    const tinygltf::Model& gltfModel = source.model;
+    const GltfFingerprint& before = *record.m_fingerprint;
+    const GltfFingerprint& after = *parsed.m_fingerprint;
+
+    if (!sameStructure(before, after)) {
+        return ReloadResult::Restructured;
+    }
+    // Static batches weld and merge their primitives, there is no patching one in place
+    if (record.m_options.staticBatching) {
+        for (size_t m = 0; m < gltfModel.meshes.size(); ++m) {
+            if (record.m_meshSkinned[m]) {
+                continue;
+            }
+            const auto& primitives = gltfModel.meshes[m].primitives;
+            for (size_t p = 0; p < primitives.size(); ++p) {
+                if (primitiveChanged(before, after, primitives[p]) ||
+                    primitives[p].material != before.model.meshes[m].primitives[p].material) {
+                    return ReloadResult::Restructured;
+                }
+            }
+        }
+    }
+
+    // Per-model state comes from the record, the loader keeps its own options
+    m_basePath = basePathOf(record.m_path);
+    m_textureCache = record.m_textures;
+    m_arrayLayers = record.m_arrayLayers;
+    MemoryAssetScope memoryScope(record.m_name);
+    ArenaScope scratch(m_arena);
+
+    // New pixels go into the textures and layers already bound by materials
+    size_t texturesUpdated = 0;
+    std::vector<TextureArrayHandle> arrays;
+    std::vector<unsigned char> rgba;
+    for (size_t i = 0; i < after.images.size(); ++i) {
+        if (before.images[i] == after.images[i]) {
+            continue;
+        }
+        const int image = static_cast<int>(i);
+        for (const auto& [key, handle] : m_textureCache) {
+            Texture* texture = GpuResources::textures().get(handle);
+            if (texture && gltfModel.textures[key.first].source == image &&
+                loadTextureImage(source, image, *texture)) {
+                ++texturesUpdated;
+            }
+        }
+        for (const auto& [textureIndex, layer] : m_arrayLayers) {
+            TextureArray* array = GpuResources::textureArrays().get(layer.array);
+            int width, height;
+            if (!array || gltfModel.textures[textureIndex].source != image ||
+                !decodeImage(source, image, m_basePath, rgba, width, height)) {
+                continue;
+            }
+            fillLayer(*array, layer.layer, rgba.data(), width, height);
+            if (std::find(arrays.begin(), arrays.end(), layer.array) == arrays.end()) {
+                arrays.push_back(layer.array);
+            }
+            ++texturesUpdated;
+        }
+    }
+    for (TextureArrayHandle handle : arrays) {
+        if (TextureArray* array = GpuResources::textureArrays().get(handle)) {
+            array->generateMipmaps();
+        }
+    }
+
+    std::vector<bool> materialChanged(gltfModel.materials.size());
+    size_t materialsUpdated = 0;
+    for (size_t m = 0; m < gltfModel.materials.size(); ++m) {
+        materialChanged[m] = !(before.model.materials[m] == gltfModel.materials[m]);
+        materialsUpdated += materialChanged[m];
+    }
+    auto usesChangedMaterial = [&materialChanged](int material) {
+        return material >= 0 && materialChanged[material];
+    };
+
+    const size_t batchCount = record.m_batchMaterials.size();
+    for (size_t b = 0; b < batchCount && b < model.getMeshCount(); ++b) {
+        const int material = record.m_batchMaterials[b];
+        if (usesChangedMaterial(material)) {
+            model.getMesh(b).setMaterial(loadMaterial(source, model, material, true));
+        }
+    }
+
+    size_t meshesUpdated = 0;
+    for (size_t k = 0; k < record.m_primitives.size() && batchCount + k < model.getMeshCount(); ++k) {
+        const auto [meshIndex, primitiveIndex] = record.m_primitives[k];
+        const auto& primitive = gltfModel.meshes[meshIndex].primitives[primitiveIndex];
+        const size_t slot = batchCount + k;
+        if (primitiveChanged(before, after, primitive)) {
+            fillPrimitive(source, meshIndex, primitiveIndex, record.m_meshSkinned[meshIndex], record.m_skinToJoint,
+                          model.getMesh(slot));
+            ++meshesUpdated;
+        }
+        const int previousMaterial = before.model.meshes[meshIndex].primitives[primitiveIndex].material;
+        if (primitive.material != previousMaterial || usesChangedMaterial(primitive.material)) {
+            model.getMesh(slot).setMaterial(loadMaterial(source, model, primitive.material, true));
+        }
+    }
+
+    // Materials may have loaded textures not used before
+    record.m_textures = m_textureCache;
+    record.m_fingerprint = std::move(parsed.m_fingerprint);
+    recordFiles(source, record);
+    m_arena.release();
+
+    if (meshesUpdated == 0 && texturesUpdated == 0 && materialsUpdated == 0) {
+        return ReloadResult::Unchanged;
+    }
+    const double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "Reloaded glTF: " << record.m_path << " (" << meshesUpdated << " meshes, " << texturesUpdated
+              << " textures, " << materialsUpdated << " materials in " << milliseconds << " ms)" << std::endl;
+    return ReloadResult::Updated;
+}
+
+size_t GLTFLoader::reloadImageFile(const std::string& path, LoadRecord& record) {
+    if (!record.m_fingerprint) {
+        return 0;
+    }
+    const tinygltf::Model& gltfModel = record.m_fingerprint->model;
+    const std::string basePath = basePathOf(record.m_path);
+    MemoryAssetScope memoryScope(record.m_name);
+
+    size_t updated = 0;
+    std::vector<TextureArrayHandle> arrays;
+    for (size_t i = 0; i < gltfModel.images.size(); ++i) {
+        const std::string& uri = gltfModel.images[i].uri;
+        if (uri.empty() || isDataUri(uri) || absolutePath(basePath + uri) != path) {
+            continue;
+        }
+
+        // RGBA so layers can take it too
+        int width, height;
+        unsigned char* pixels = decodeImageFile(path, width, height);
+        if (!pixels) {
+            std::cerr << "Failed to reload image: " << path << std::endl;
+            return updated;
+        }
+
+        const int image = static_cast<int>(i);
+        for (const auto& [key, handle] : record.m_textures) {
+            Texture* texture = GpuResources::textures().get(handle);
+            if (texture && gltfModel.textures[key.first].source == image &&
+                texture->loadFromMemory(pixels, width, height, 4)) {
+                ++updated;
+            }
+        }
+        for (const auto& [textureIndex, layer] : record.m_arrayLayers) {
+            TextureArray* array = GpuResources::textureArrays().get(layer.array);
+            if (!array || gltfModel.textures[textureIndex].source != image) {
+                continue;
+            }
+            fillLayer(*array, layer.layer, pixels, width, height);
+            if (std::find(arrays.begin(), arrays.end(), layer.array) == arrays.end()) {
+                arrays.push_back(layer.array);
+            }
+            ++updated;
+        }
+        stbi_image_free(pixels);
+    }
+    for (TextureArrayHandle handle : arrays) {
+        if (TextureArray* array = GpuResources::textureArrays().get(handle)) {
+            array->generateMipmaps();
+        }
+    }
+
+    if (updated > 0) {
+        std::cout << "Reloaded image: " << path << " (" << updated << " textures)" << std::endl;
+    }
+    return updated;
+}
+
+void GLTFLoader::addProxies(const GltfSource& source, UploadState& state, Model& model) {
+    const tinygltf::Model& gltfModel = source.model;
+    glm::vec3 min, max;
+
+    // Static batches are pre-transformed, so their proxies are boxes around each node instance
+    if (m_options.staticBatching) {
+        for (size_t n = 0; n < gltfModel.nodes.size(); ++n) {
+            const int meshIndex = gltfModel.nodes[n].mesh;
+            if (meshIndex < 0 || state.meshSkinned[meshIndex]) {
+                continue;
+            }
+
+            glm::mat4 world(1.0f);
+            for (int node = static_cast<int>(n); node >= 0; node = state.nodeParents[node]) {
+                world = nodeLocalMatrix(gltfModel.nodes[node]) * world;
+            }
+
+            for (const auto& primitive : gltfModel.meshes[meshIndex].primitives) {
+                if (primitive.mode != TINYGLTF_MODE_TRIANGLES || !primitive.attributes.count("POSITION")) {
+                    continue;
+                }
+                positionBounds(source, primitive, min, max);
+                transformBounds(world, min, max);
+                model.addMesh(makeProxy(min, max, loadMaterial(source, model, primitive.material, false)));
+                state.meshMaterials.push_back(primitive.material);
+                ++state.staticProxies;
+            }
+        }
+    }
 
-    m_basePath = std::filesystem::path(path).parent_path().string();
-    if (!m_basePath.empty()) {
-        m_basePath += "/";
+    for (const auto& ref : state.primitives) {
+        const auto& primitive = gltfModel.meshes[ref.mesh].primitives[ref.primitive];
+        positionBounds(source, primitive, min, max);
+        model.addMesh(makeProxy(min, max, loadMaterial(source, model, primitive.material, false)));
+        state.meshMaterials.push_back(primitive.material);
     }
+}
+
+void GLTFLoader::uploadPrimitive(const GltfSource& source, UploadState& state, Model& model) {
+    const size_t slot = state.firstPrimitiveMesh + state.nextPrimitive;
+    const UploadState::PrimitiveRef ref = state.primitives[state.nextPrimitive++];
+    const auto& primitive = source.model.meshes[ref.mesh].primitives[ref.primitive];
+
+    Mesh mesh;
+    fillPrimitive(source, ref.mesh, ref.primitive, state.meshSkinned[ref.mesh], state.skinToJoint, mesh);
+
+    mesh.setMaterial(loadMaterial(source, model, primitive.material, !state.progressive));
+    if (state.progressive) {
+        mesh.setLoadState(LoadState::Geometry);
+        model.setMesh(slot, std::move(mesh));
+    } else {
+        model.addMesh(std::move(mesh));
+    }
+}
+
+void GLTFLoader::fillPrimitive(const GltfSource& source, int meshIndex, int primitiveIndex, bool skinned,
+                               const std::vector<uint16_t>& skinToJoint, Mesh& mesh) {
+    const auto& primitive = source.model.meshes[meshIndex].primitives[primitiveIndex];
+    const size_t vertexCount = source.model.accessors[primitive.attributes.at("POSITION")].count;
+    const size_t indexCount = primitive.indices >= 0 ? source.model.accessors[primitive.indices].count : vertexCount;
+
+    // Big static primitives are clustered, skinned ones move away from their bind-pose bounds
+    const bool clustered = !skinned && indexCount / 3 >= kMeshletMinTriangles;
+
+    // Only clustering needs the geometry on the CPU, everything else decodes
+    // straight into mapped GPU buffers. A live mesh goes through setup(),
+    // which refills its buffers instead of replacing them.
+    const bool fresh = mesh.getGpuBytes() == 0;
+    if (clustered || !fresh || !writePrimitive(source, primitive, mesh)) {
+        ArenaVector<Vertex> vertices{ ArenaAllocator<Vertex>(m_arena) };
+        ArenaVector<unsigned int> indices{ ArenaAllocator<unsigned int>(m_arena) };
+        readPrimitive(source, primitive, vertices, indices);
+
+        TrackedMemory staging(MemoryCategory::LoaderStaging,
+                              vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
+
+        std::vector<Meshlet> meshlets;
+        if (clustered) {
+            meshlets = Meshlets::build(vertices.data(), vertices.size(), indices.data(), indices.size());
+            if (meshlets.empty()) {
+                std::cerr << "glTF warning: primitive " << primitiveIndex << " of mesh " << meshIndex
+                          << " has out of range indices, drawing it unclustered" << std::endl;
+            }
+        }
+        mesh.setup(vertices, indices);
+        mesh.setMeshlets(std::move(meshlets));
+    }
+
+    // Geometry is on the GPU now, mapped pages behind it can go
+    releasePrimitive(source, primitive);
+
+    // Joints and weights
+    if (skinned && primitive.attributes.count("JOINTS_0") && primitive.attributes.count("WEIGHTS_0")) {
+        ArenaVector<glm::vec4> joints{ ArenaAllocator<glm::vec4>(m_arena) };
+        ArenaVector<glm::vec4> weights{ ArenaAllocator<glm::vec4>(m_arena) };
+        readVec4s(source, primitive.attributes.at("JOINTS_0"), joints);
+        readVec4s(source, primitive.attributes.at("WEIGHTS_0"), weights);
+        source.releaseAccessor(primitive.attributes.at("JOINTS_0"));
+        source.releaseAccessor(primitive.attributes.at("WEIGHTS_0"));
+
+        if (joints.size() == vertexCount && weights.size() == vertexCount) {
+            ArenaVector<SkinVertex> skinVertices(vertexCount, SkinVertex(), ArenaAllocator<SkinVertex>(m_arena));
+            TrackedMemory skinStaging(MemoryCategory::LoaderStaging,
+                                      vertexCount * (2 * sizeof(glm::vec4) + sizeof(SkinVertex)));
+            for (size_t i = 0; i < vertexCount; ++i) {
+                SkinVertex& sv = skinVertices[i];
+                float weightSum = weights[i].x + weights[i].y + weights[i].z + weights[i].w;
+                sv.weights = weightSum > 0.0f ? weights[i] / weightSum : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+
+                for (int c = 0; c < 4; ++c) {
+                    size_t skinJoint = static_cast<size_t>(joints[i][c]);
+                    sv.joints[c] = skinJoint < skinToJoint.size() ? skinToJoint[skinJoint] : 0;
+                }
+            }
+            mesh.setupSkin(skinVertices);
+        }
+    }
+}
+
+bool GLTFLoader::parseSource(const std::string& path, GltfSource& source) const {
+    const bool binary = hasExtension(path, ".glb");
+    if (binary && m_options.mapGlb) {
+        return parseMappedGlb(path, source);
+    }
+
+    tinygltf::TinyGLTF loader;
+    std::string err, warn;
 
     bool success = false;
-    if (path.ends_with(".glb")) {
-        success = loader.LoadBinaryFromFile(&gltfModel, &err, &warn, path);
+    std::vector<bool> fallback;
+    if (binary) {
+        success = loader.LoadBinaryFromFile(&source.model, &err, &warn, path);
     } else {
-        success = loader.LoadASCIIFromFile(&gltfModel, &err, &warn, path);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "glTF error: failed to open " << path << std::endl;
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        // Meshopt fallback buffers are usually absent, tinygltf would fail to load them
+        if (text.find("EXT_meshopt_compression") != std::string::npos) {
+            nlohmann::json doc = nlohmann::json::parse(text, nullptr, false);
+            if (doc.is_object()) {
+                fallback = stubFallbackBuffers(doc);
+                text = doc.dump();
+            }
+        }
+
+        std::string basePath = std::filesystem::path(path).parent_path().string();
+        if (!basePath.empty()) {
+            basePath += "/";
+        }
+        success = loader.LoadASCIIFromString(&source.model, &err, &warn, text.c_str(),
+                                             static_cast<unsigned int>(text.size()), basePath);
     }
 
     if (!warn.empty()) {
@@ -35,182 +2060,471 @@ std::unique_ptr<Model> GLTFLoader::load(const std::string& path) {
     }
 
     if (!success) {
-        std::cerr << "Failed to load glTF: " << path << std::endl;
-        return nullptr;
+        return false;
     }
 
-    auto model = std::make_unique<Model>();
-    model->setName(std::filesystem::path(path).stem().string());
+    for (size_t i = 0; i < source.model.buffers.size(); ++i) {
+        const auto& buffer = source.model.buffers[i];
+        source.buffers.push_back(buffer.data.data());
+        source.bufferSizes.push_back(i < fallback.size() && fallback[i] ? 0 : buffer.data.size());
+    }
+    return true;
+}
 
-    m_textureCache.clear();
+bool GLTFLoader::parseMappedGlb(const std::string& path, GltfSource& source) const {
+    if (!source.file.open(path)) {
+        return false;
+    }
 
-    for (const auto& gltfMesh : gltfModel.meshes) {
-        for (const auto& primitive : gltfMesh.primitives) {
-            if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
-                continue;
+    const unsigned char* data = source.file.data();
+    const size_t size = source.file.size();
+
+    // 12-byte header followed by the JSON chunk header
+    if (size < 20 || readU32(data) != kGlbMagic || readU32(data + 4) != 2) {
+        std::cerr << "glTF error: not a glTF 2.0 binary file" << std::endl;
+        return false;
+    }
+
+    const size_t length = std::min<size_t>(readU32(data + 8), size);
+    const size_t jsonLength = readU32(data + 12);
+    if (readU32(data + 16) != kGlbChunkJson || 20 + jsonLength > length) {
+        std::cerr << "glTF error: GLB is missing its JSON chunk" << std::endl;
+        return false;
+    }
+    const char* jsonChunk = reinterpret_cast<const char*>(data + 20);
+
+    size_t binSize = 0;
+    size_t binHeader = 20 + jsonLength;
+    if (binHeader + 8 <= length && readU32(data + binHeader + 4) == kGlbChunkBin) {
+        source.binOffset = binHeader + 8;
+        binSize = std::min<size_t>(readU32(data + binHeader), length - source.binOffset);
+    }
+
+    // Only the JSON chunk is parsed. Buffers and images backed by the BIN
+    // chunk are swapped for placeholders so tinygltf doesn't copy them, and
+    // are read straight from the mapping instead.
+    nlohmann::json doc = nlohmann::json::parse(jsonChunk, jsonChunk + jsonLength, nullptr, false);
+    if (doc.is_discarded() || !doc.is_object()) {
+        std::cerr << "glTF error: GLB JSON chunk is malformed" << std::endl;
+        return false;
+    }
+
+    const std::vector<bool> fallback = stubFallbackBuffers(doc);
+    std::vector<size_t> mappedSizes;
+    if (doc.contains("buffers") && doc["buffers"].is_array()) {
+        for (auto& buffer : doc["buffers"]) {
+            bool mapped = buffer.is_object() && !buffer.contains("uri");
+            size_t byteLength = 0;
+            if (mapped) {
+                byteLength = buffer.value("byteLength", size_t(0));
+                if (byteLength > binSize) {
+                    std::cerr << "glTF error: buffer is larger than the GLB BIN chunk" << std::endl;
+                    return false;
+                }
+                buffer["uri"] = kPlaceholderBufferUri;
+                buffer["byteLength"] = 1;
+            }
+            source.bufferMapped.push_back(mapped);
+            mappedSizes.push_back(byteLength);
+        }
+    }
+
+    if (doc.contains("images") && doc["images"].is_array()) {
+        for (auto& image : doc["images"]) {
+            int bufferView = -1;
+            if (image.is_object() && image.contains("bufferView")) {
+                bufferView = image["bufferView"].get<int>();
+                image.erase("bufferView");
+                image.erase("mimeType");
+                image["uri"] = kPlaceholderImageUri;
+            }
+            source.imageBufferViews.push_back(bufferView);
+        }
+    }
+
+    const std::string rewritten = doc.dump();
+
+    // Runs off the GL thread, so the base path can't come from m_basePath
+    std::string basePath = std::filesystem::path(path).parent_path().string();
+    if (!basePath.empty()) {
+        basePath += "/";
+    }
+
+    tinygltf::TinyGLTF loader;
+    std::string err, warn;
+    bool success = loader.LoadASCIIFromString(&source.model, &err, &warn, rewritten.c_str(),
+                                              static_cast<unsigned int>(rewritten.size()), basePath);
+
+    if (!warn.empty()) {
+        std::cerr << "glTF warning: " << warn << std::endl;
+    }
+
+    if (!err.empty()) {
+        std::cerr << "glTF error: " << err << std::endl;
+    }
+
+    if (!success) {
+        return false;
+    }
+
+    for (size_t i = 0; i < source.model.buffers.size(); ++i) {
+        bool mapped = i < source.bufferMapped.size() && source.bufferMapped[i];
+        bool stub = i < fallback.size() && fallback[i];
+        source.buffers.push_back(mapped ? data + source.binOffset : source.model.buffers[i].data.data());
+        source.bufferSizes.push_back(mapped ? mappedSizes[i] : stub ? 0 : source.model.buffers[i].data.size());
+    }
+    source.bufferMapped.resize(source.model.buffers.size(), false);
+    return true;
+}
+
+Material GLTFLoader::loadMaterial(const GltfSource& source, Model& model, int materialIndex, bool withTextures) {
+    Material material;
+    if (materialIndex >= 0) {
+        const auto& gltfMat = source.model.materials[materialIndex];
+        const auto& pbr = gltfMat.pbrMetallicRoughness;
+
+        material.baseColorFactor = glm::vec4(
+            pbr.baseColorFactor[0],
+            pbr.baseColorFactor[1],
+            pbr.baseColorFactor[2],
+            pbr.baseColorFactor[3]
+        );
+
+        // Load base color texture, from its array layer if it was packed
+        if (withTextures && pbr.baseColorTexture.index >= 0) {
+            auto layer = m_arrayLayers.find(pbr.baseColorTexture.index);
+            if (layer != m_arrayLayers.end()) {
+                material.baseColorArray = layer->second.array;
+                material.baseColorLayer = layer->second.layer;
+            } else {
+                material.baseColorTexture = loadTexture(source, model, pbr.baseColorTexture.index);
+            }
+        }
+
+        material.metallicFactor = static_cast<float>(pbr.metallicFactor);
+        material.roughnessFactor = static_cast<float>(pbr.roughnessFactor);
+        material.normalScale = static_cast<float>(gltfMat.normalTexture.scale);
+        material.occlusionStrength = static_cast<float>(gltfMat.occlusionTexture.strength);
+        if (gltfMat.emissiveFactor.size() == 3) {
+            material.emissiveFactor = glm::vec3(
+                gltfMat.emissiveFactor[0],
+                gltfMat.emissiveFactor[1],
+                gltfMat.emissiveFactor[2]
+            );
+        }
+
+        // The other maps stay individual textures, only base colors are packed into arrays
+        if (withTextures) {
+            if (pbr.metallicRoughnessTexture.index >= 0) {
+                material.metallicRoughnessTexture = loadTexture(source, model, pbr.metallicRoughnessTexture.index,
+                                                                Texture::ColorSpace::Linear);
+            }
+            if (gltfMat.normalTexture.index >= 0) {
+                material.normalTexture = loadTexture(source, model, gltfMat.normalTexture.index,
+                                                     Texture::ColorSpace::Linear);
+            }
+            if (gltfMat.occlusionTexture.index >= 0) {
+                material.occlusionTexture = loadTexture(source, model, gltfMat.occlusionTexture.index,
+                                                        Texture::ColorSpace::Linear);
             }
+            if (gltfMat.emissiveTexture.index >= 0) {
+                material.emissiveTexture = loadTexture(source, model, gltfMat.emissiveTexture.index);
+            }
+        }
+
+        if (gltfMat.alphaMode == "MASK") {
+            material.alphaMode = AlphaMode::Mask;
+        } else if (gltfMat.alphaMode == "BLEND") {
+            material.alphaMode = AlphaMode::Blend;
+        }
+        material.alphaCutoff = static_cast<float>(gltfMat.alphaCutoff);
+        material.doubleSided = gltfMat.doubleSided;
+    }
+
+    material.updateShaderFeatures();
+    return material;
+}
+
+void GLTFLoader::collectTextureArrays(const GltfSource& source, Model& model, UploadState& state) {
+    const tinygltf::Model& gltfModel = source.model;
 
-            std::vector<Vertex> vertices;
-            std::vector<unsigned int> indices;
+    // Base color textures in first-use order, grouped by size class and sampler
+    std::map<std::tuple<int, int, TextureSampler>, std::vector<UploadState::PendingLayer>> classes;
+    std::vector<bool> seen(gltfModel.textures.size(), false);
 
-            // Get accessors
-            const float* positions = nullptr;
-            const float* normals = nullptr;
-            const float* texCoords = nullptr;
-            size_t vertexCount = 0;
+    for (const auto& material : gltfModel.materials) {
+        const int texture = material.pbrMetallicRoughness.baseColorTexture.index;
+        if (texture < 0 || texture >= static_cast<int>(seen.size()) || seen[texture]) {
+            continue;
+        }
+        seen[texture] = true;
+
+        const int image = gltfModel.textures[texture].source;
+        if (image < 0 || image >= static_cast<int>(gltfModel.images.size())) {
+            continue;
+        }
+        int width, height;
+        imageSize(source, image, m_basePath, width, height);
+        if (width <= 0 || height <= 0) {
+            continue;  // left to loadTexture, which reports the failure
+        }
 
-            // Position
-            if (primitive.attributes.count("POSITION")) {
-                const auto& accessor = gltfModel.accessors[primitive.attributes.at("POSITION")];
-                const auto& bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const auto& buffer = gltfModel.buffers[bufferView.buffer];
+        auto& layers = classes[{ TextureArray::sizeClass(width), TextureArray::sizeClass(height),
+                                 textureSampler(gltfModel, texture) }];
+        layers.push_back({ texture, image, TextureArrayHandle(), 0 });
+    }
 
-                positions = reinterpret_cast<const float*>(
-                    buffer.data.data() + bufferView.byteOffset + accessor.byteOffset
-                );
-                vertexCount = accessor.count;
+    // Classes with more textures than an array can hold fill several
+    const size_t pageSize = static_cast<size_t>(TextureArray::maxLayers());
+    ResourcePool<TextureArray>& arrays = GpuResources::textureArrays();
+    for (auto& [key, layers] : classes) {
+        const auto& [width, height, sampler] = key;
+        for (size_t first = 0; first < layers.size(); first += pageSize) {
+            const size_t count = std::min(pageSize, layers.size() - first);
+            TextureArrayHandle array = arrays.create();
+            if (!arrays.get(array)->create(width, height, static_cast<int>(count), sampler)) {
+                arrays.destroy(array);
+                continue;
             }
+            model.addTextureArray(array);
+            for (size_t i = 0; i < count; ++i) {
+                UploadState::PendingLayer& layer = layers[first + i];
+                layer.array = array;
+                layer.layer = static_cast<int>(i);
+                state.layers.push_back(layer);
+            }
+            state.arrays.push_back(array);
+        }
+    }
+
+    if (!state.layers.empty()) {
+        std::cout << "Texture arrays: " << state.layers.size() << " base color textures in "
+                  << state.arrays.size() << " arrays" << std::endl;
+    }
+}
 
-            // Normal
-            if (primitive.attributes.count("NORMAL")) {
-                const auto& accessor = gltfModel.accessors[primitive.attributes.at("NORMAL")];
-                const auto& bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const auto& buffer = gltfModel.buffers[bufferView.buffer];
+void GLTFLoader::uploadArrayLayer(const GltfSource& source, UploadState& state) {
+    const UploadState::PendingLayer& pending = state.layers[state.nextLayer++];
+    ResourcePool<TextureArray>& arrays = GpuResources::textureArrays();
+    TextureArray* target = arrays.get(pending.array);
+    if (!target) {
+        return;  // went with an abandoned model
+    }
+    TextureArray& array = *target;
+
+    // One image in memory at a time: decode, resample to the class, upload
+    std::vector<unsigned char> rgba;
+    int width, height;
+    if (decodeImage(source, pending.image, m_basePath, rgba, width, height)) {
+        fillLayer(array, pending.layer, rgba.data(), width, height);
+        m_arrayLayers[pending.texture] = { pending.array, pending.layer };
+    } else {
+        std::cerr << "Failed to decode texture " << pending.texture << ", layer left blank" << std::endl;
+    }
 
-                normals = reinterpret_cast<const float*>(
-                    buffer.data.data() + bufferView.byteOffset + accessor.byteOffset
-                );
+    // Mips once every layer is in
+    if (state.nextLayer == state.layers.size()) {
+        for (TextureArrayHandle filled : state.arrays) {
+            if (TextureArray* filledArray = arrays.get(filled)) {
+                filledArray->generateMipmaps();
             }
+        }
+    }
+}
+
+void GLTFLoader::loadStaticBatches(const GltfSource& source, Model& model, const std::vector<bool>& meshSkinned,
+                                   const std::vector<int>& nodeParents, bool withTextures,
+                                   std::vector<Mesh>& meshes, std::vector<int>& materials) {
+    const tinygltf::Model& gltfModel = source.model;
 
-            // Texture coordinates
-            if (primitive.attributes.count("TEXCOORD_0")) {
-                const auto& accessor = gltfModel.accessors[primitive.attributes.at("TEXCOORD_0")];
-                const auto& bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const auto& buffer = gltfModel.buffers[bufferView.buffer];
+    struct Batch {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<SubMesh> subMeshes;
+    };
+    // Keyed by material index, -1 for the default material
+    std::map<int, Batch> batches;
 
-                texCoords = reinterpret_cast<const float*>(
-                    buffer.data.data() + bufferView.byteOffset + accessor.byteOffset
-                );
+    size_t sourcePrimitives = 0;
+    size_t sourceVertices = 0;
+
+    // Every node instance of a static mesh, placed by its world transform
+    for (size_t n = 0; n < gltfModel.nodes.size(); ++n) {
+        const int meshIndex = gltfModel.nodes[n].mesh;
+        if (meshIndex < 0 || meshSkinned[meshIndex]) {
+            continue;
+        }
+
+        glm::mat4 world(1.0f);
+        for (int node = static_cast<int>(n); node >= 0; node = nodeParents[node]) {
+            world = nodeLocalMatrix(gltfModel.nodes[node]) * world;
+        }
+        const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
+        // Mirroring transforms turn triangles inside out
+        const bool flipWinding = glm::determinant(glm::mat3(world)) < 0.0f;
+
+        const auto& primitives = gltfModel.meshes[meshIndex].primitives;
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            const auto& primitive = primitives[p];
+            if (primitive.mode != TINYGLTF_MODE_TRIANGLES || !primitive.attributes.count("POSITION")) {
+                continue;
             }
 
-            // Build vertices
-            vertices.reserve(vertexCount);
-            for (size_t i = 0; i < vertexCount; ++i) {
-                Vertex v;
-                v.position = glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+            // Batches grow on the heap, so the primitive's scratch can be rewound after each one
+            ArenaScope scratch(m_arena);
+            ArenaVector<Vertex> vertices{ ArenaAllocator<Vertex>(m_arena) };
+            ArenaVector<unsigned int> indices{ ArenaAllocator<unsigned int>(m_arena) };
+            readPrimitive(source, primitive, vertices, indices);
+            ++sourcePrimitives;
+            sourceVertices += vertices.size();
 
-                if (normals) {
-                    v.normal = glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
-                } else {
-                    v.normal = glm::vec3(0.0f, 1.0f, 0.0f);
-                }
+            Batch& batch = batches[primitive.material];
+            const auto base = static_cast<unsigned int>(batch.vertices.size());
 
-                if (texCoords) {
-                    v.texCoord = glm::vec2(texCoords[i * 2], texCoords[i * 2 + 1]);
-                } else {
-                    v.texCoord = glm::vec2(0.0f);
-                }
+            SubMesh subMesh;
+            subMesh.firstIndex = static_cast<uint32_t>(batch.indices.size());
+            subMesh.boundsMin = glm::vec3(1.0e30f);
+            subMesh.boundsMax = glm::vec3(-1.0e30f);
+            subMesh.node = static_cast<int>(n);
+            subMesh.primitive = static_cast<int>(p);
 
-                vertices.push_back(v);
-            }
-
-            // Indices
-            if (primitive.indices >= 0) {
-                const auto& accessor = gltfModel.accessors[primitive.indices];
-                const auto& bufferView = gltfModel.bufferViews[accessor.bufferView];
-                const auto& buffer = gltfModel.buffers[bufferView.buffer];
-
-                indices.reserve(accessor.count);
-
-                const void* dataPtr = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
-
-                switch (accessor.componentType) {
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-                        const uint16_t* data = static_cast<const uint16_t*>(dataPtr);
-                        for (size_t i = 0; i < accessor.count; ++i) {
-                            indices.push_back(data[i]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
-                        const uint32_t* data = static_cast<const uint32_t*>(dataPtr);
-                        for (size_t i = 0; i < accessor.count; ++i) {
-                            indices.push_back(data[i]);
-                        }
-                        break;
-                    }
-                    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-                        const uint8_t* data = static_cast<const uint8_t*>(dataPtr);
-                        for (size_t i = 0; i < accessor.count; ++i) {
-                            indices.push_back(data[i]);
-                        }
-                        break;
-                    }
-                }
-            } else {
-                // No indices, generate sequential
-                indices.reserve(vertexCount);
-                for (size_t i = 0; i < vertexCount; ++i) {
-                    indices.push_back(static_cast<unsigned int>(i));
-                }
+            for (Vertex vertex : vertices) {
+                vertex.position = glm::vec3(world * glm::vec4(vertex.position, 1.0f));
+                vertex.normal = glm::normalize(normalMatrix * vertex.normal);
+                subMesh.boundsMin = glm::min(subMesh.boundsMin, vertex.position);
+                subMesh.boundsMax = glm::max(subMesh.boundsMax, vertex.position);
+                batch.vertices.push_back(vertex);
             }
 
-            // Create mesh
-            auto mesh = std::make_unique<Mesh>();
-            mesh->setup(vertices, indices);
-
-            // Material
-            Material material;
-            if (primitive.material >= 0) {
-                const auto& gltfMat = gltfModel.materials[primitive.material];
-                const auto& pbr = gltfMat.pbrMetallicRoughness;
-
-                material.baseColorFactor = glm::vec4(
-                    pbr.baseColorFactor[0],
-                    pbr.baseColorFactor[1],
-                    pbr.baseColorFactor[2],
-                    pbr.baseColorFactor[3]
-                );
-
-                // Load base color texture
-                if (pbr.baseColorTexture.index >= 0) {
-                    int texIndex = pbr.baseColorTexture.index;
-
-                    if (m_textureCache.count(texIndex)) {
-                        material.baseColorTexture = m_textureCache[texIndex];
-                    } else {
-                        const auto& gltfTex = gltfModel.textures[texIndex];
-                        if (gltfTex.source >= 0) {
-                            const auto& image = gltfModel.images[gltfTex.source];
-
-                            auto texture = std::make_shared<Texture>();
-
-                            if (!image.image.empty()) {
-                                // Embedded image data
-                                texture->loadFromMemory(
-                                    image.image.data(),
-                                    image.width,
-                                    image.height,
-                                    image.component
-                                );
-                            } else if (!image.uri.empty()) {
-                                // External file
-                                texture->loadFromFile(m_basePath + image.uri);
-                            }
-
-                            m_textureCache[texIndex] = texture;
-                            material.baseColorTexture = texture;
-                        }
-                    }
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (a >= vertices.size() || b >= vertices.size() || c >= vertices.size()) {
+                    continue;
                 }
+                if (flipWinding) {
+                    std::swap(b, c);
+                }
+                batch.indices.push_back(base + a);
+                batch.indices.push_back(base + b);
+                batch.indices.push_back(base + c);
             }
 
-            mesh->setMaterial(material);
-            model->addMesh(std::move(mesh));
+            subMesh.indexCount = static_cast<uint32_t>(batch.indices.size()) - subMesh.firstIndex;
+            batch.subMeshes.push_back(subMesh);
+            releasePrimitive(source, primitive);
         }
     }
 
-    std::cout << "Loaded glTF: " << path << " (" << model->getMeshes().size() << " meshes)" << std::endl;
+    size_t weldedVertices = 0;
+    for (auto& [materialIndex, batch] : batches) {
+        if (batch.indices.empty()) {
+            continue;
+        }
+
+        TrackedMemory staging(MemoryCategory::LoaderStaging,
+                              batch.vertices.size() * (sizeof(Vertex) + sizeof(unsigned int)) +
+                              batch.indices.size() * sizeof(unsigned int));
 
-    return model;
+        // Weld bit-identical vertices, primitives often duplicate them along shared edges.
+        // Index positions don't move, so the sub-ranges stay valid. The map's
+        // nodes come from the arena too, one rewind frees them all.
+        ArenaScope scratch(m_arena);
+        ArenaVector<Vertex> welded{ ArenaAllocator<Vertex>(m_arena) };
+        ArenaVector<unsigned int> remap(batch.vertices.size(), 0, ArenaAllocator<unsigned int>(m_arena));
+        std::unordered_map<Vertex, unsigned int, VertexBitsHash, VertexBitsEqual,
+                           ArenaAllocator<std::pair<const Vertex, unsigned int>>>
+            unique(batch.vertices.size(), VertexBitsHash(), VertexBitsEqual(),
+                   ArenaAllocator<std::pair<const Vertex, unsigned int>>(m_arena));
+        welded.reserve(batch.vertices.size());
+        for (size_t i = 0; i < batch.vertices.size(); ++i) {
+            auto inserted = unique.emplace(batch.vertices[i], static_cast<unsigned int>(welded.size()));
+            if (inserted.second) {
+                welded.push_back(batch.vertices[i]);
+            }
+            remap[i] = inserted.first->second;
+        }
+        for (unsigned int& index : batch.indices) {
+            index = remap[index];
+        }
+        weldedVertices += welded.size();
+
+        Mesh mesh;
+        mesh.setup(welded, batch.indices);
+        mesh.setSubMeshes(std::move(batch.subMeshes));
+        mesh.setMaterial(loadMaterial(source, model, materialIndex, withTextures));
+        meshes.push_back(std::move(mesh));
+        materials.push_back(materialIndex);
+    }
+
+    std::cout << "Static batching: " << sourcePrimitives << " draws -> " << meshes.size()
+              << " draws, " << sourceVertices << " -> " << weldedVertices << " vertices" << std::endl;
+}
+
+TextureHandle GLTFLoader::loadTexture(const GltfSource& source, Model& model, int textureIndex,
+                                      Texture::ColorSpace colorSpace) {
+    const TextureKey key(textureIndex, colorSpace);
+    auto cached = m_textureCache.find(key);
+    if (cached != m_textureCache.end()) {
+        return cached->second;
+    }
+
+    const tinygltf::Model& gltfModel = source.model;
+    const auto& gltfTex = gltfModel.textures[textureIndex];
+    if (gltfTex.source < 0 || gltfTex.source >= static_cast<int>(gltfModel.images.size())) {
+        return {};
+    }
+
+    ResourcePool<Texture>& textures = GpuResources::textures();
+    TextureHandle handle = textures.create(colorSpace, textureSampler(gltfModel, textureIndex));
+    const bool loaded = loadTextureImage(source, gltfTex.source, *textures.get(handle));
+
+    if (loaded) {
+        model.addTexture(handle);
+    } else {
+        textures.destroy(handle);
+        handle = {};
+    }
+
+    m_textureCache[key] = handle;
+    return handle;
+}
+
+bool GLTFLoader::loadTextureImage(const GltfSource& source, int imageIndex, Texture& texture) {
+    const tinygltf::Model& gltfModel = source.model;
+    const auto& image = gltfModel.images[imageIndex];
+    int mappedView = imageIndex < static_cast<int>(source.imageBufferViews.size())
+        ? source.imageBufferViews[imageIndex] : -1;
+
+    if (mappedView >= 0) {
+        // Encoded image inside the mapped BIN chunk, decode in place
+        const auto& bufferView = gltfModel.bufferViews[mappedView];
+        const bool loaded = texture.loadFromEncoded(source.viewData(mappedView), bufferView.byteLength);
+        if (source.bufferMapped[bufferView.buffer]) {
+            source.file.release(source.binOffset + bufferView.byteOffset, bufferView.byteLength);
+        }
+        return loaded;
+    }
+    if (!image.image.empty()) {
+        // Embedded image data
+        return texture.loadFromMemory(
+            image.image.data(),
+            image.width,
+            image.height,
+            image.component
+        );
+    }
+    if (!image.uri.empty()) {
+        // External file, decoded as a hot reload of it will be
+        int width, height;
+        unsigned char* pixels = decodeImageFile(m_basePath + image.uri, width, height);
+        if (!pixels) {
+            std::cerr << "Failed to load texture: " << m_basePath + image.uri << std::endl;
+            return false;
+        }
+        TrackedMemory decoded(MemoryCategory::DecodedImage, size_t(width) * height * 4);
+        const bool loaded = texture.loadFromMemory(pixels, width, height, 4);
+        stbi_image_free(pixels);
+        return loaded;
+    }
+    return false;
 }
@@ -1,20 +1,198 @@
 #pragma once
 
+#include "core/Arena.hpp"
+#include "graphics/Texture.hpp"
 #include "scene/Model.hpp"
+#include <map>
 #include <string>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
 class Texture;
+class TextureArray;
+struct GltfSource;
+struct GltfFingerprint;
+
+// A document read and parsed by GLTFLoader::parse, waiting for its GPU upload
+class ParsedGltf {
+public:
+    ParsedGltf();
+    ~ParsedGltf();
+
+    ParsedGltf(ParsedGltf&& other) noexcept;
+    ParsedGltf& operator=(ParsedGltf&& other) noexcept;
+
+    bool isValid() const { return m_source != nullptr; }
+    const std::string& getPath() const { return m_path; }
+
+private:
+    friend class GLTFLoader;
+
+    std::string m_path;
+    std::unique_ptr<GltfSource> m_source;
+    std::unique_ptr<GltfFingerprint> m_fingerprint;  // Options::hotReload only
+    uint64_t m_heapAllocations = 0;  // made on the parsing thread
+};
 
 class GLTFLoader {
 public:
-    GLTFLoader() = default;
+    struct Options {
+        bool mapGlb = true;
+        bool staticBatching = false;
+        bool textureArrays = true;
+        // Keep what reload() needs to patch the model later, costs a hash of
+        // every buffer view and image at parse time
+        bool hotReload = false;
+    };
 
+    // What an upload with Options::hotReload leaves behind, see takeLoadRecord()
+    class LoadRecord;
+
+    enum class ReloadResult {
+        Unchanged,
+        Updated,       // changed meshes, textures and materials patched in place
+        Restructured,  // nodes, skins, animations or batched geometry changed, upload it anew
+        Failed
+    };
+
+    GLTFLoader();
+    ~GLTFLoader();
+
+    GLTFLoader(const GLTFLoader&) = delete;
+    GLTFLoader& operator=(const GLTFLoader&) = delete;
+
+    // parse() followed by upload()
     std::unique_ptr<Model> load(const std::string& path);
 
+    // Reads and parses a file without touching GL, safe to call from a worker
+    // thread so the next file loads while the current one renders
+    ParsedGltf parse(const std::string& path) const;
+    // Creates meshes and textures from a parsed document, needs the GL context
+    std::unique_ptr<Model> upload(ParsedGltf parsed);
+
+    // Incremental upload, one primitive or texture per uploadStep() call, so a
+    // render loop can keep running while a model streams in. With progressive
+    // set, the returned model starts as one bounding-box proxy mesh per
+    // primitive (LoadState::Proxy), proxies are then swapped for untextured
+    // geometry (Geometry) and textures come last (Full). Without it, steps
+    // add fully textured meshes, which is what upload() does.
+    // One upload at a time; the model must outlive it.
+    std::unique_ptr<Model> beginUpload(ParsedGltf parsed, bool progressive);
+    // Returns false once the model is complete
+    bool uploadStep(Model& model);
+    bool isUploading() const { return m_upload != nullptr; }
+
+    // After an upload with Options::hotReload has finished, the record of
+    // where the model's meshes and textures came from
+    std::unique_ptr<LoadRecord> takeLoadRecord() { return std::move(m_record); }
+
+    // Compares a new parse of a loaded file (with Options::hotReload) against
+    // its record, re-uploads the meshes, textures and materials whose data
+    // changed into their existing GL objects and updates the record.
+    // parsed is left intact for upload() when the result is Restructured.
+    ReloadResult reload(ParsedGltf& parsed, Model& model, LoadRecord& record);
+    // Re-decodes one external image file into the textures made from it,
+    // returns how many were updated
+    size_t reloadImageFile(const std::string& path, LoadRecord& record);
+
+    // CPU decode stages of an upload on their own, without GL, for benchmarks.
+    // readGeometry() fills one entry per triangle primitive in document
+    // order, pass null to skip vertices or indices. decodeImages() decodes
+    // every image to RGBA8 and returns the number of pixels.
+    static void readGeometry(const ParsedGltf& parsed, std::vector<std::vector<Vertex>>* vertices,
+                             std::vector<std::vector<unsigned int>>* indices);
+    static size_t decodeImages(const ParsedGltf& parsed);
+
+    void setOptions(const Options& options) { m_options = options; }
+    const Options& getOptions() const { return m_options; }
+
+    // When enabled (the default), .glb files are memory-mapped: only the JSON
+    // chunk is parsed and geometry is read straight from the mapped BIN chunk,
+    // whose pages are released as soon as each primitive is uploaded.
+    void setMapGlb(bool enabled) { m_options.mapGlb = enabled; }
+
+    // When enabled, unskinned primitives are pre-transformed into model space
+    // by their nodes, welded and merged into one mesh per material, keeping
+    // each primitive as a sub-range. Off by default.
+    void setStaticBatching(bool enabled) { m_options.staticBatching = enabled; }
+
+    // When enabled (the default), base color textures are resampled to
+    // power-of-two size classes and packed into one TextureArray per class,
+    // so materials differ only by a layer index instead of a binding.
+    void setTextureArrays(bool enabled) { m_options.textureArrays = enabled; }
+
 private:
+    struct UploadState;
+
+    bool parseSource(const std::string& path, GltfSource& source) const;
+    bool parseMappedGlb(const std::string& path, GltfSource& source) const;
+    // Textures and arrays are created in GpuResources and owned by model
+    TextureHandle loadTexture(const GltfSource& source, Model& model, int textureIndex,
+                              Texture::ColorSpace colorSpace = Texture::ColorSpace::Srgb);
+    bool loadTextureImage(const GltfSource& source, int imageIndex, Texture& texture);
+    Material loadMaterial(const GltfSource& source, Model& model, int materialIndex, bool withTextures);
+    void collectTextureArrays(const GltfSource& source, Model& model, UploadState& state);
+    void uploadArrayLayer(const GltfSource& source, UploadState& state);
+    void addProxies(const GltfSource& source, UploadState& state, Model& model);
+    void uploadPrimitive(const GltfSource& source, UploadState& state, Model& model);
+    // Geometry and skin streams of one primitive, refills a live mesh in place
+    void fillPrimitive(const GltfSource& source, int meshIndex, int primitiveIndex, bool skinned,
+                       const std::vector<uint16_t>& skinToJoint, Mesh& mesh);
+    std::unique_ptr<LoadRecord> makeLoadRecord(UploadState& state);
+    static void recordFiles(const GltfSource& source, LoadRecord& record);
+    void loadStaticBatches(const GltfSource& source, Model& model, const std::vector<bool>& meshSkinned,
+                           const std::vector<int>& nodeParents, bool withTextures,
+                           std::vector<Mesh>& meshes, std::vector<int>& materials);
+
     std::string m_basePath;
-    std::unordered_map<int, std::shared_ptr<Texture>> m_textureCache;
+    // By glTF texture index and the color space it is sampled in, a texture
+    // used both as color and as data is loaded once per space
+    using TextureKey = std::pair<int, Texture::ColorSpace>;
+    std::map<TextureKey, TextureHandle> m_textureCache;
+
+    struct ArrayLayer {
+        TextureArrayHandle array;
+        int layer = 0;
+    };
+    std::unordered_map<int, ArrayLayer> m_arrayLayers;  // by texture index
+    Options m_options;
+    std::unique_ptr<UploadState> m_upload;
+    std::unique_ptr<LoadRecord> m_record;
+    // Temporaries of the upload in progress, rewound after every step and
+    // released once the file is done
+    LinearArena m_arena;
+    uint64_t m_uploadHeapAllocations = 0;  // parse, beginUpload and steps so far
+};
+
+class GLTFLoader::LoadRecord {
+public:
+    LoadRecord();
+    ~LoadRecord();
+
+    const std::string& getPath() const { return m_path; }
+    const Options& getOptions() const { return m_options; }
+    // The document and its external buffers, a change to any needs a new parse
+    const std::vector<std::string>& getDocumentFiles() const { return m_documentFiles; }
+    // External images, reloadImageFile() handles these alone
+    const std::vector<std::string>& getImageFiles() const { return m_imageFiles; }
+
+private:
+    friend class GLTFLoader;
+
+    std::string m_path;
+    std::string m_name;
+    Options m_options;
+    std::vector<std::string> m_documentFiles;  // absolute
+    std::vector<std::string> m_imageFiles;
+    std::unique_ptr<GltfFingerprint> m_fingerprint;
+
+    // Model meshes in order: m_batchMaterials.size() static batches, then one per primitive
+    std::vector<int> m_batchMaterials;                 // glTF material of each batch
+    std::vector<std::pair<int, int>> m_primitives;     // glTF mesh and primitive
+    std::vector<bool> m_meshSkinned;
+    std::vector<uint16_t> m_skinToJoint;
+    std::map<TextureKey, TextureHandle> m_textures;
+    std::unordered_map<int, ArrayLayer> m_arrayLayers;
 };
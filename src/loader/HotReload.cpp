@@ -0,0 +1,159 @@
+#include "HotReload.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+bool contains(const std::vector<std::string>& files, const std::string& file) {
+    return std::find(files.begin(), files.end(), file) != files.end();
+}
+
+} // namespace
+
+HotReload::~HotReload() {
+    // The parse job's hand-off refers to this object, flush it before going away
+    m_jobs.wait(m_parseCounter);
+    m_jobs.runMainThreadJobs();
+}
+
+void HotReload::track(Model& model, std::unique_ptr<GLTFLoader::LoadRecord> record) {
+    if (!record) {
+        return;
+    }
+    watchFiles(*record);
+    m_entries.push_back({ &model, std::move(record) });
+}
+
+void HotReload::watchShaders(const std::string& directory) {
+    if (!m_watcher.watchDirectory(directory)) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(directory, error).lexically_normal();
+    if (!absolute.has_filename()) {
+        absolute = absolute.parent_path();
+    }
+    m_shaderDirectory = absolute.string();
+}
+
+void HotReload::watchFiles(const GLTFLoader::LoadRecord& record) {
+    for (const std::string& file : record.getDocumentFiles()) {
+        m_watcher.watch(file);
+    }
+    for (const std::string& file : record.getImageFiles()) {
+        m_watcher.watch(file);
+    }
+}
+
+void HotReload::queueParse(size_t entry) {
+    if (std::find(m_queue.begin(), m_queue.end(), entry) == m_queue.end()) {
+        m_queue.push_back(entry);
+    }
+}
+
+void HotReload::startParse() {
+    if (m_queue.empty()) {
+        return;
+    }
+    const size_t entry = m_queue.front();
+    m_queue.pop_front();
+    m_parsing = true;
+
+    const std::string path = m_entries[entry].record->getPath();
+    const GLTFLoader::Options options = m_entries[entry].record->getOptions();
+    m_jobs.run([this, entry, path, options] {
+        GLTFLoader parser;
+        parser.setOptions(options);
+        // Job functions must be copyable, so the result travels in a shared_ptr
+        auto parsed = std::make_shared<ParsedGltf>(parser.parse(path));
+        m_jobs.runOnMainThread([this, entry, parsed] {
+            m_parsed = std::make_unique<ParsedGltf>(std::move(*parsed));
+            m_parsedEntry = entry;
+            m_parsing = false;
+        });
+    }, &m_parseCounter);
+}
+
+HotReload::Changes HotReload::update(std::vector<std::unique_ptr<Model>>& models) {
+    Changes changes;
+    m_changed.clear();
+    m_watcher.poll(m_changed);
+
+    for (const std::string& file : m_changed) {
+        if (!m_shaderDirectory.empty() && std::filesystem::path(file).parent_path() == m_shaderDirectory) {
+            changes.shaders = true;
+            continue;
+        }
+        for (size_t e = 0; e < m_entries.size(); ++e) {
+            if (contains(m_entries[e].record->getDocumentFiles(), file)) {
+                queueParse(e);
+            }
+        }
+    }
+
+    // A queued parse picks up its model's images anyway, the rest are decoded right here
+    for (const std::string& file : m_changed) {
+        for (size_t e = 0; e < m_entries.size(); ++e) {
+            GLTFLoader::LoadRecord& record = *m_entries[e].record;
+            if (contains(record.getImageFiles(), file) &&
+                std::find(m_queue.begin(), m_queue.end(), e) == m_queue.end() &&
+                m_loader.reloadImageFile(file, record) > 0) {
+                changes.scene = true;
+            }
+        }
+    }
+
+    if (!m_parsing && !m_parsed) {
+        startParse();
+    }
+    if (m_parsed) {
+        ParsedGltf parsed = std::move(*m_parsed);
+        m_parsed.reset();
+        const size_t entry = m_parsedEntry;
+        startParse();
+        apply(entry, parsed, models, changes);
+    }
+    return changes;
+}
+
+void HotReload::apply(size_t entry, ParsedGltf& parsed, std::vector<std::unique_ptr<Model>>& models,
+                      Changes& changes) {
+    // Keep showing the last good version while the file is broken
+    if (!parsed.isValid()) {
+        return;
+    }
+    Entry& tracked = m_entries[entry];
+    auto slot = std::find_if(models.begin(), models.end(),
+                             [&tracked](const std::unique_ptr<Model>& model) { return model.get() == tracked.model; });
+    if (slot == models.end()) {
+        return;
+    }
+
+    switch (m_loader.reload(parsed, *tracked.model, *tracked.record)) {
+        case GLTFLoader::ReloadResult::Unchanged:
+        case GLTFLoader::ReloadResult::Failed:
+            return;
+        case GLTFLoader::ReloadResult::Updated:
+            changes.scene = true;
+            watchFiles(*tracked.record);  // the document may name new files
+            return;
+        case GLTFLoader::ReloadResult::Restructured:
+            break;
+    }
+
+    // Upload it anew; dropping the old model releases its meshes and textures
+    m_loader.setOptions(tracked.record->getOptions());
+    std::unique_ptr<Model> model = m_loader.upload(std::move(parsed));
+    std::unique_ptr<GLTFLoader::LoadRecord> record = m_loader.takeLoadRecord();
+    if (!model || !record) {
+        return;
+    }
+    std::cout << "Replaced model after structural change: " << record->getPath() << std::endl;
+    watchFiles(*record);
+    tracked.model = model.get();
+    tracked.record = std::move(record);
+    *slot = std::move(model);
+    changes.replacedModels.push_back(static_cast<size_t>(slot - models.begin()));
+    changes.scene = true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "GLTFLoader.hpp"
+#include "core/FileWatcher.hpp"
+#include "core/JobSystem.hpp"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Keeps loaded models and the shaders in step with their files while the
+// viewer runs. An edited external image is decoded again on its own; any
+// other change to a model's files parses it again as a job, and
+// GLTFLoader::reload patches the meshes, textures and materials whose data
+// changed in place. A model whose structure changed is uploaded again and
+// takes the old one's place.
+class HotReload {
+public:
+    explicit HotReload(JobSystem& jobs = JobSystem::instance()) : m_jobs(jobs) {}
+    // Waits for an in-flight parse
+    ~HotReload();
+
+    HotReload(const HotReload&) = delete;
+    HotReload& operator=(const HotReload&) = delete;
+
+    // Watches the files of a model loaded with GLTFLoader::Options::hotReload.
+    // The model must stay in the list passed to update(), which may replace it.
+    void track(Model& model, std::unique_ptr<GLTFLoader::LoadRecord> record);
+    // Any file written in this directory counts as a shader change
+    void watchShaders(const std::string& directory);
+
+    struct Changes {
+        bool scene = false;                  // meshes, textures or materials changed
+        bool shaders = false;                // reload the shader programs
+        std::vector<size_t> replacedModels;  // slots in models holding a new Model
+    };
+    // Polls the files and applies a finished parse. Parsed files arrive
+    // through JobSystem::runMainThreadJobs(), run it first.
+    Changes update(std::vector<std::unique_ptr<Model>>& models);
+
+    // Changes seen but not applied yet
+    bool isBusy() const { return m_parsing || m_parsed || !m_queue.empty() || m_watcher.hasPending(); }
+
+private:
+    struct Entry {
+        Model* model;
+        std::unique_ptr<GLTFLoader::LoadRecord> record;
+    };
+
+    void watchFiles(const GLTFLoader::LoadRecord& record);
+    void queueParse(size_t entry);
+    void startParse();
+    void apply(size_t entry, ParsedGltf& parsed, std::vector<std::unique_ptr<Model>>& models, Changes& changes);
+
+    JobSystem& m_jobs;
+    FileWatcher m_watcher;
+    std::string m_shaderDirectory;  // absolute
+
+    std::vector<Entry> m_entries;
+    std::deque<size_t> m_queue;  // entries waiting for a parse
+    JobCounter m_parseCounter;
+    bool m_parsing = false;      // until the main-thread job delivers the result
+    std::unique_ptr<ParsedGltf> m_parsed;
+    size_t m_parsedEntry = 0;
+
+    GLTFLoader m_loader;
+    std::vector<std::string> m_changed;  // reused by every poll
+};
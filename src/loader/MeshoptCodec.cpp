@@ -0,0 +1,437 @@
+#include "MeshoptCodec.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr unsigned char kVertexHeader = 0xa0;
+constexpr unsigned char kIndexHeader = 0xe0;
+constexpr unsigned char kSequenceHeader = 0xd0;
+
+constexpr size_t kVertexBlockSizeBytes = 8192;
+constexpr size_t kVertexBlockMaxSize = 256;
+constexpr size_t kByteGroupSize = 16;
+// Worst case bytes one group can consume: a 4-bit header group with every value escaped
+constexpr size_t kByteGroupDecodeLimit = 24;
+constexpr size_t kTailMinSize = 32;
+
+size_t vertexBlockSize(size_t stride) {
+    size_t result = (kVertexBlockSizeBytes / stride) & ~(kByteGroupSize - 1);
+    return std::min(result, kVertexBlockMaxSize);
+}
+
+unsigned char unzigzag8(unsigned char v) {
+    return static_cast<unsigned char>(-(v & 1) ^ (v >> 1));
+}
+
+// One group of 16 bytes, each stored in 0, 2, 4 or 8 bits. 2 and 4 bit values
+// of all ones escape to a full byte stored after the packed bits.
+const unsigned char* decodeBytesGroup(const unsigned char* data, unsigned char* buffer, int bitslog2) {
+    switch (bitslog2) {
+        case 0:
+            std::memset(buffer, 0, kByteGroupSize);
+            return data;
+        case 1:
+        case 2: {
+            const int bits = 1 << bitslog2;
+            const unsigned char escape = static_cast<unsigned char>((1 << bits) - 1);
+            const unsigned char* extra = data + bits * 2;  // 16 values * bits / 8
+            for (size_t i = 0; i < kByteGroupSize; ++i) {
+                const int shift = 8 - bits - int(i * bits % 8);
+                unsigned char enc = static_cast<unsigned char>((data[i * bits / 8] >> shift) & escape);
+                buffer[i] = enc == escape ? *extra++ : enc;
+            }
+            return extra;
+        }
+        default:
+            std::memcpy(buffer, data, kByteGroupSize);
+            return data + kByteGroupSize;
+    }
+}
+
+const unsigned char* decodeBytes(const unsigned char* data, const unsigned char* end, unsigned char* buffer,
+                                 size_t size) {
+    // Two header bits per group
+    const size_t headerSize = (size / kByteGroupSize + 3) / 4;
+    if (size_t(end - data) < headerSize) {
+        return nullptr;
+    }
+    const unsigned char* header = data;
+    data += headerSize;
+
+    for (size_t i = 0; i < size; i += kByteGroupSize) {
+        if (size_t(end - data) < kByteGroupDecodeLimit) {
+            return nullptr;
+        }
+        const size_t group = i / kByteGroupSize;
+        const int bitslog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data = decodeBytesGroup(data, buffer + i, bitslog2);
+    }
+    return data;
+}
+
+// Each byte column of a block is stored separately as zigzag deltas from the previous vertex
+const unsigned char* decodeVertexBlock(const unsigned char* data, const unsigned char* end,
+                                       unsigned char* vertices, size_t count, size_t stride,
+                                       unsigned char* lastVertex) {
+    unsigned char buffer[kVertexBlockMaxSize];
+    const size_t alignedCount = (count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+
+    for (size_t k = 0; k < stride; ++k) {
+        data = decodeBytes(data, end, buffer, alignedCount);
+        if (!data) {
+            return nullptr;
+        }
+
+        unsigned char p = lastVertex[k];
+        for (size_t i = 0; i < count; ++i) {
+            p = static_cast<unsigned char>(unzigzag8(buffer[i]) + p);
+            vertices[i * stride + k] = p;
+        }
+    }
+
+    std::memcpy(lastVertex, vertices + (count - 1) * stride, stride);
+    return data;
+}
+
+uint32_t decodeVByte(const unsigned char*& data, const unsigned char* end) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35 && data < end; shift += 7) {
+        unsigned char group = *data++;
+        result |= uint32_t(group & 127) << shift;
+        if (group < 128) {
+            break;
+        }
+    }
+    return result;
+}
+
+uint32_t decodeIndex(const unsigned char*& data, const unsigned char* end, uint32_t last) {
+    uint32_t v = decodeVByte(data, end);
+    uint32_t d = (v >> 1) ^ -int32_t(v & 1);
+    return last + d;
+}
+
+void writeIndex(void* destination, size_t i, size_t indexSize, uint32_t index) {
+    if (indexSize == 2) {
+        static_cast<uint16_t*>(destination)[i] = static_cast<uint16_t>(index);
+    } else {
+        static_cast<uint32_t*>(destination)[i] = index;
+    }
+}
+
+void pushVertexFifo(uint32_t* fifo, uint32_t v, size_t& offset, int advance = 1) {
+    fifo[offset] = v;
+    offset = (offset + advance) & 15;
+}
+
+void pushEdgeFifo(uint32_t (*fifo)[2], uint32_t a, uint32_t b, size_t& offset) {
+    fifo[offset][0] = a;
+    fifo[offset][1] = b;
+    offset = (offset + 1) & 15;
+}
+
+int16_t roundToShort(float v) {
+    return static_cast<int16_t>(int(v + (v >= 0.0f ? 0.5f : -0.5f)));
+}
+
+// Octahedral unit vectors in 4 signed components, the third holding the scale of 1.0
+template <typename T>
+void decodeFilterOct(T* data, size_t count) {
+    const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < count; ++i) {
+        float x = float(data[i * 4 + 0]);
+        float y = float(data[i * 4 + 1]);
+        float z = float(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+
+        // Fold the lower hemisphere back
+        float t = std::min(z, 0.0f);
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+
+        float s = max / std::sqrt(x * x + y * y + z * z);
+        data[i * 4 + 0] = static_cast<T>(int(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+        data[i * 4 + 1] = static_cast<T>(int(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+        data[i * 4 + 2] = static_cast<T>(int(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+    }
+}
+
+// Three smallest quaternion components, the fourth slot holds the largest one's index and a scale
+void decodeFilterQuat(int16_t* data, size_t count) {
+    const float scale = 1.0f / std::sqrt(2.0f);
+    for (size_t i = 0; i < count; ++i) {
+        int16_t* q = data + i * 4;
+        const int sf = q[3] | 3;
+        const float ss = scale / float(sf);
+
+        float x = float(q[0]) * ss;
+        float y = float(q[1]) * ss;
+        float z = float(q[2]) * ss;
+        float ww = 1.0f - x * x - y * y - z * z;
+        float w = std::sqrt(std::max(ww, 0.0f));
+
+        const int qc = q[3] & 3;
+        q[(qc + 1) & 3] = roundToShort(x * 32767.0f);
+        q[(qc + 2) & 3] = roundToShort(y * 32767.0f);
+        q[(qc + 3) & 3] = roundToShort(z * 32767.0f);
+        q[(qc + 0) & 3] = roundToShort(w * 32767.0f);
+    }
+}
+
+// 24-bit signed mantissa and 8-bit signed exponent per 32-bit float
+void decodeFilterExp(uint32_t* data, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t v = data[i];
+        const int m = int32_t(v << 8) >> 8;
+        const int e = int32_t(v) >> 24;
+        float f = std::ldexp(float(m), e);
+        std::memcpy(&data[i], &f, sizeof(f));
+    }
+}
+
+} // namespace
+
+namespace MeshoptCodec {
+
+bool decodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* source, size_t size) {
+    if (stride == 0 || stride > kVertexBlockMaxSize || stride % 4 != 0) {
+        return false;
+    }
+    if (size < 1 + stride || (source[0] & 0xf0) != kVertexHeader || (source[0] & 0x0f) != 0) {
+        return false;
+    }
+
+    const unsigned char* data = source + 1;
+    const unsigned char* end = source + size;
+
+    // The tail holds the first baseline vertex, zero-padded to at least 32 bytes
+    unsigned char lastVertex[kVertexBlockMaxSize];
+    std::memcpy(lastVertex, end - stride, stride);
+
+    unsigned char* vertices = static_cast<unsigned char*>(destination);
+    const size_t blockSize = vertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t blockCount = std::min(blockSize, count - offset);
+        data = decodeVertexBlock(data, end, vertices + offset * stride, blockCount, stride, lastVertex);
+        if (!data) {
+            return false;
+        }
+    }
+
+    return size_t(end - data) == std::max(stride, kTailMinSize);
+}
+
+bool decodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* source, size_t size) {
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+        return false;
+    }
+    // Header, one code byte per triangle and the 16-byte auxiliary table at the end
+    if (size < 1 + count / 3 + 16) {
+        return false;
+    }
+    const int version = source[0] & 0x0f;
+    if ((source[0] & 0xf0) != kIndexHeader || version > 1) {
+        return false;
+    }
+
+    uint32_t edgeFifo[16][2];
+    uint32_t vertexFifo[16];
+    std::memset(edgeFifo, -1, sizeof(edgeFifo));
+    std::memset(vertexFifo, -1, sizeof(vertexFifo));
+    size_t edgeFifoOffset = 0;
+    size_t vertexFifoOffset = 0;
+
+    uint32_t next = 0;
+    uint32_t last = 0;
+    const int fecMax = version >= 1 ? 13 : 15;
+
+    const unsigned char* code = source + 1;
+    const unsigned char* data = code + count / 3;
+    const unsigned char* dataSafeEnd = source + size - 16;
+    const unsigned char* codeAuxTable = dataSafeEnd;
+
+    for (size_t i = 0; i < count; i += 3) {
+        // Free indices take at most 3 vbytes of 5 bytes each, stay clear of the table
+        if (data > dataSafeEnd) {
+            return false;
+        }
+
+        const unsigned char codeTri = *code++;
+        if (codeTri < 0xf0) {
+            // Triangle shares an edge from the fifo
+            const int fe = codeTri >> 4;
+            const uint32_t a = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0];
+            const uint32_t b = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1];
+            uint32_t c = 0;
+
+            const int fec = codeTri & 15;
+            if (fec < fecMax) {
+                const uint32_t cf = vertexFifo[(vertexFifoOffset - 1 - fec) & 15];
+                c = fec == 0 ? next : cf;
+                const int fec0 = fec == 0;
+                next += fec0;
+                pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+            } else {
+                // 13 and 14 are -1/+1 from the last free index
+                last = c = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(data, dataSafeEnd, last);
+                pushVertexFifo(vertexFifo, c, vertexFifoOffset);
+            }
+
+            pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+
+            writeIndex(destination, i + 0, indexSize, a);
+            writeIndex(destination, i + 1, indexSize, b);
+            writeIndex(destination, i + 2, indexSize, c);
+        } else if (codeTri < 0xfe) {
+            // New triangle, b and c described by the table
+            const unsigned char codeAux = codeAuxTable[codeTri & 15];
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+
+            const uint32_t a = next++;
+
+            const uint32_t bf = vertexFifo[(vertexFifoOffset - feb) & 15];
+            const uint32_t b = feb == 0 ? next : bf;
+            const int feb0 = feb == 0;
+            next += feb0;
+
+            const uint32_t cf = vertexFifo[(vertexFifoOffset - fec) & 15];
+            const uint32_t c = fec == 0 ? next : cf;
+            const int fec0 = fec == 0;
+            next += fec0;
+
+            writeIndex(destination, i + 0, indexSize, a);
+            writeIndex(destination, i + 1, indexSize, b);
+            writeIndex(destination, i + 2, indexSize, c);
+
+            pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+            pushVertexFifo(vertexFifo, b, vertexFifoOffset, feb0);
+            pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+
+            pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+        } else {
+            // New triangle with an explicit aux byte, 0xff also makes a a free index
+            const unsigned char codeAux = *data++;
+            const int fea = codeTri == 0xfe ? 0 : 15;
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+
+            // Aux byte 0 restarts the new-vertex counter
+            if (codeAux == 0) {
+                next = 0;
+            }
+
+            uint32_t a = fea == 0 ? next++ : 0;
+            uint32_t b = feb == 0 ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15];
+            uint32_t c = fec == 0 ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15];
+
+            if (fea == 15) {
+                last = a = decodeIndex(data, dataSafeEnd, last);
+            }
+            if (feb == 15) {
+                last = b = decodeIndex(data, dataSafeEnd, last);
+            }
+            if (fec == 15) {
+                last = c = decodeIndex(data, dataSafeEnd, last);
+            }
+
+            writeIndex(destination, i + 0, indexSize, a);
+            writeIndex(destination, i + 1, indexSize, b);
+            writeIndex(destination, i + 2, indexSize, c);
+
+            pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+            pushVertexFifo(vertexFifo, b, vertexFifoOffset, (feb == 0) | (feb == 15));
+            pushVertexFifo(vertexFifo, c, vertexFifoOffset, (fec == 0) | (fec == 15));
+
+            pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+        }
+    }
+
+    return data == dataSafeEnd;
+}
+
+bool decodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* source, size_t size) {
+    if (indexSize != 2 && indexSize != 4) {
+        return false;
+    }
+    // Header, at least a byte per index and 4 bytes of padding
+    if (size < 1 + count + 4) {
+        return false;
+    }
+    const int version = source[0] & 0x0f;
+    if ((source[0] & 0xf0) != kSequenceHeader || version > 1) {
+        return false;
+    }
+
+    const unsigned char* data = source + 1;
+    const unsigned char* dataSafeEnd = source + size - 4;
+
+    // Deltas alternate between two baselines, the low bit picks one
+    uint32_t last[2] = { 0, 0 };
+    for (size_t i = 0; i < count; ++i) {
+        if (data >= dataSafeEnd) {
+            return false;
+        }
+        uint32_t v = decodeVByte(data, dataSafeEnd);
+        const uint32_t current = v & 1;
+        v >>= 1;
+        const uint32_t d = (v >> 1) ^ -int32_t(v & 1);
+        const uint32_t index = last[current] + d;
+        last[current] = index;
+        writeIndex(destination, i, indexSize, index);
+    }
+
+    return data == dataSafeEnd;
+}
+
+bool applyFilter(Filter filter, void* data, size_t count, size_t stride) {
+    switch (filter) {
+        case Filter::None:
+            return true;
+        case Filter::Octahedral:
+            if (stride == 4) {
+                decodeFilterOct(static_cast<int8_t*>(data), count);
+                return true;
+            }
+            if (stride == 8) {
+                decodeFilterOct(static_cast<int16_t*>(data), count);
+                return true;
+            }
+            return false;
+        case Filter::Quaternion:
+            if (stride != 8) {
+                return false;
+            }
+            decodeFilterQuat(static_cast<int16_t*>(data), count);
+            return true;
+        case Filter::Exponential:
+            if (stride % 4 != 0) {
+                return false;
+            }
+            decodeFilterExp(static_cast<uint32_t*>(data), count * (stride / 4));
+            return true;
+    }
+    return false;
+}
+
+bool decode(Mode mode, Filter filter, void* destination, size_t count, size_t stride,
+            const unsigned char* source, size_t size) {
+    switch (mode) {
+        case Mode::Attributes:
+            return decodeVertexBuffer(destination, count, stride, source, size) &&
+                   applyFilter(filter, destination, count, stride);
+        case Mode::Triangles:
+            return filter == Filter::None && decodeIndexBuffer(destination, count, stride, source, size);
+        case Mode::Indices:
+            return filter == Filter::None && decodeIndexSequence(destination, count, stride, source, size);
+    }
+    return false;
+}
+
+} // namespace MeshoptCodec
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Decoders for EXT_meshopt_compression buffer views: the meshoptimizer
+// vertex codec, index codecs and the octahedral/quaternion/exponential
+// filters, bitstream version 0 as the extension requires. All functions
+// return false on malformed input and never read outside the source range.
+namespace MeshoptCodec {
+
+enum class Mode : uint8_t {
+    Attributes,  // vertex codec, any stride that is a multiple of 4 up to 256
+    Triangles,   // index codec, triangle lists
+    Indices      // index sequence codec
+};
+
+enum class Filter : uint8_t {
+    None,
+    Octahedral,
+    Quaternion,
+    Exponential
+};
+
+// count elements of stride bytes into destination, which must hold count * stride bytes
+bool decodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* source, size_t size);
+// indexSize is 2 or 4 bytes
+bool decodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* source, size_t size);
+bool decodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* source, size_t size);
+
+// In-place filters applied after decodeVertexBuffer, false if stride doesn't suit the filter
+bool applyFilter(Filter filter, void* data, size_t count, size_t stride);
+
+// Decodes one buffer view: the codec for mode, then the filter
+bool decode(Mode mode, Filter filter, void* destination, size_t count, size_t stride,
+            const unsigned char* source, size_t size);
+
+} // namespace MeshoptCodec
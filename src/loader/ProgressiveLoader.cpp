@@ -0,0 +1,78 @@
+#include "ProgressiveLoader.hpp"
+#include "HotReload.hpp"
+#include <chrono>
+
+ProgressiveLoader::~ProgressiveLoader() {
+    // The parse job's hand-off refers to this loader, flush it before going away
+    m_jobs.wait(m_parseCounter);
+    m_jobs.runMainThreadJobs();
+}
+
+void ProgressiveLoader::add(const std::string& path, const GLTFLoader::Options& options) {
+    m_queue.push_back({ path, options });
+    ++m_total;
+    if (!m_parsing && !m_parsed) {
+        startParse();
+    }
+}
+
+void ProgressiveLoader::startParse() {
+    if (m_queue.empty()) {
+        return;
+    }
+    Request request = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_parsingOptions = request.options;
+    m_parsing = true;
+
+    m_jobs.run([this, request] {
+        GLTFLoader parser;
+        parser.setOptions(request.options);
+        // Job functions must be copyable, so the result travels in a shared_ptr
+        auto parsed = std::make_shared<ParsedGltf>(parser.parse(request.path));
+        m_jobs.runOnMainThread([this, parsed] {
+            m_parsed = std::make_unique<ParsedGltf>(std::move(*parsed));
+            m_parsing = false;
+        });
+    }, &m_parseCounter);
+}
+
+bool ProgressiveLoader::update(std::vector<std::unique_ptr<Model>>& models, double budgetMilliseconds) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    bool changed = false;
+
+    do {
+        if (m_current) {
+            if (!m_loader.uploadStep(*m_current)) {
+                if (m_hotReload) {
+                    m_hotReload->track(*m_current, m_loader.takeLoadRecord());
+                }
+                m_current = nullptr;
+                ++m_finished;
+            }
+            changed = true;
+            continue;
+        }
+
+        // Nothing to upload until the next parse is done, don't wait for it
+        if (!m_parsed) {
+            break;
+        }
+
+        ParsedGltf parsed = std::move(*m_parsed);
+        m_parsed.reset();
+        m_loader.setOptions(m_parsingOptions);
+        startParse();
+
+        if (auto model = m_loader.beginUpload(std::move(parsed), true)) {
+            m_current = model.get();
+            models.push_back(std::move(model));
+            changed = true;
+        } else {
+            ++m_finished;
+        }
+    } while (std::chrono::duration<double, std::milli>(Clock::now() - start).count() < budgetMilliseconds);
+
+    return changed;
+}
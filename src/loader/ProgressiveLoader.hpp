@@ -0,0 +1,62 @@
+#pragma once
+
+#include "GLTFLoader.hpp"
+#include "core/JobSystem.hpp"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class HotReload;
+
+// Streams models into a running scene. Files are parsed one ahead as a job,
+// which hands the result back through the job system's main-thread queue;
+// on the GL thread each model first shows up as bounding-box proxies, then
+// its geometry and textures are uploaded a step at a time within a
+// per-frame budget (see GLTFLoader::beginUpload).
+class ProgressiveLoader {
+public:
+    explicit ProgressiveLoader(JobSystem& jobs = JobSystem::instance()) : m_jobs(jobs) {}
+    // Waits for an in-flight parse
+    ~ProgressiveLoader();
+
+    ProgressiveLoader(const ProgressiveLoader&) = delete;
+    ProgressiveLoader& operator=(const ProgressiveLoader&) = delete;
+
+    // Queues a file, loaded with these options
+    void add(const std::string& path, const GLTFLoader::Options& options);
+
+    // Hands finished models loaded with GLTFLoader::Options::hotReload to it
+    void setHotReload(HotReload* hotReload) { m_hotReload = hotReload; }
+
+    // Uploads for up to budgetMilliseconds (at least one step if there is work),
+    // appending new models to models. Returns true if the scene changed.
+    // Parsed files arrive through JobSystem::runMainThreadJobs(), run it first.
+    bool update(std::vector<std::unique_ptr<Model>>& models, double budgetMilliseconds);
+
+    bool isIdle() const { return m_queue.empty() && !m_parsing && !m_parsed && !m_current; }
+    size_t getFinishedCount() const { return m_finished; }
+    size_t getTotalCount() const { return m_total; }
+
+private:
+    struct Request {
+        std::string path;
+        GLTFLoader::Options options;
+    };
+
+    void startParse();
+
+    JobSystem& m_jobs;
+
+    std::deque<Request> m_queue;
+    JobCounter m_parseCounter;
+    bool m_parsing = false;              // until the main-thread job delivers the result
+    std::unique_ptr<ParsedGltf> m_parsed;
+    GLTFLoader::Options m_parsingOptions;
+
+    GLTFLoader m_loader;
+    Model* m_current = nullptr;  // uploading, owned by the scene
+    HotReload* m_hotReload = nullptr;
+    size_t m_finished = 0;       // loaded or failed
+    size_t m_total = 0;
+};
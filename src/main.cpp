@@ -1,13 +1,78 @@
 #include "core/Window.hpp"
+#include "core/Arena.hpp"
+#include "core/JobSystem.hpp"
+#include "core/MemoryStats.hpp"
+#include "graphics/DynamicResolution.hpp"
+#include "graphics/GpuDeletionQueue.hpp"
+#include "graphics/GpuResources.hpp"
+#include "graphics/GLState.hpp"
 #include "graphics/Renderer.hpp"
 #include "scene/Camera.hpp"
+#include "scene/AnimationSystem.hpp"
 #include "loader/GLTFLoader.hpp"
+#include "loader/ProgressiveLoader.hpp"
+#include "loader/HotReload.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
 #include <vector>
 #include <memory>
 
+namespace {
+
+// Upload time per frame while models stream in
+constexpr double kLoadBudgetMilliseconds = 4.0;
+
+// GL object deletion time per frame, see GpuDeletionQueue
+constexpr double kDeleteBudgetMilliseconds = 1.0;
+
+// Longest sleep between checks for changes when nothing is being redrawn
+constexpr int kDefaultIdleTimeoutMilliseconds = 500;
+
+// --minimap: top-down view following the camera, in the top right corner
+constexpr float kMinimapHeight = 40.0f;
+constexpr int kMinimapFraction = 4;  // of the window height
+
+// Sum of all model transform versions, changes whenever any of them is moved
+uint64_t transformVersions(const std::vector<std::unique_ptr<Model>>& models) {
+    uint64_t version = models.size();
+    for (const auto& model : models) {
+        version += model->getTransform().getVersion();
+    }
+    return version;
+}
+
+// Starts a skinned model's first animation
+void startAnimation(AnimationSystem& animation, Model& model) {
+    if (model.getSkeleton() && !model.getAnimations().empty()) {
+        int instance = animation.createInstance(model.getSkeleton(), model.getAnimations().front());
+        model.setJointPaletteOffset(static_cast<int>(animation.getPaletteOffset(instance)));
+    }
+}
+
+void startAnimations(AnimationSystem& animation, std::vector<std::unique_ptr<Model>>& models, size_t first) {
+    for (size_t i = first; i < models.size(); ++i) {
+        startAnimation(animation, *models[i]);
+    }
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point startTime = Clock::now();
+    auto millisecondsSinceStart = [startTime] {
+        return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    };
+
+    // Created first so this thread, which owns the GL context, is its main thread
+    JobSystem& jobs = JobSystem::instance();
+
     Window window("Teo - OpenGL glTF Renderer", 1280, 720);
 
     if (!window.init()) {
@@ -25,20 +90,129 @@ int main(int argc, char* argv[]) {
 
     std::vector<std::unique_ptr<Model>> models;
 
-    // Load models from command line arguments
+    // Models stream in while the scene renders, unless --blocking is given.
+    // Options apply to the files that follow them.
     GLTFLoader loader;
+    GLTFLoader::Options options;
+    // --watch: models after it and the shaders follow edits to their files
+    HotReload hotReload;
+    bool watching = false;
+    ProgressiveLoader progressive;
+    progressive.setHotReload(&hotReload);
+    bool blocking = false;
+    bool printStats = false;
+    bool continuous = false;
+    int idleTimeoutMs = kDefaultIdleTimeoutMilliseconds;
+    bool dynamicResolutionEnabled = false;
+    bool minimap = false;
+    DynamicResolution::Settings resolutionSettings;
+    size_t modelPaths = 0;
     for (int i = 1; i < argc; ++i) {
-        auto model = loader.load(argv[i]);
-        if (model) {
-            models.push_back(std::move(model));
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            printStats = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            options.staticBatching = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--no-texture-arrays") == 0) {
+            options.textureArrays = false;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--watch") == 0) {
+            options.hotReload = true;
+            if (!watching) {
+                hotReload.watchShaders("shaders");
+                watching = true;
+            }
+            continue;
+        }
+        if (std::strcmp(argv[i], "--blocking") == 0) {
+            blocking = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--continuous") == 0) {
+            continuous = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            idleTimeoutMs = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--dynamic-resolution") == 0 && i + 1 < argc) {
+            dynamicResolutionEnabled = true;
+            resolutionSettings.targetMilliseconds = std::atof(argv[++i]);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--min-scale") == 0 && i + 1 < argc) {
+            resolutionSettings.minScale = static_cast<float>(std::atof(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--max-scale") == 0 && i + 1 < argc) {
+            resolutionSettings.maxScale = static_cast<float>(std::atof(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--scale-hysteresis") == 0 && i + 1 < argc) {
+            resolutionSettings.hysteresis = static_cast<float>(std::atof(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--sharpness") == 0 && i + 1 < argc) {
+            resolutionSettings.sharpness = static_cast<float>(std::atof(argv[++i]));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--no-prepass") == 0) {
+            renderer.setDepthPrepass(false);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--occlusion") == 0) {
+            renderer.setOcclusionCulling(true);
+            continue;
+        }
+        if (std::strcmp(argv[i], "--minimap") == 0) {
+            minimap = true;
+            continue;
+        }
+
+        ++modelPaths;
+        if (blocking) {
+            loader.setOptions(options);
+            if (auto model = loader.load(argv[i])) {
+                hotReload.track(*model, loader.takeLoadRecord());
+                models.push_back(std::move(model));
+            }
+        } else {
+            progressive.add(argv[i], options);
         }
     }
 
-    if (models.empty()) {
-        std::cout << "Usage: " << argv[0] << " <model.gltf/glb> [model2.gltf/glb] ..." << std::endl;
+    if (modelPaths == 0) {
+        std::cout << "Usage: " << argv[0] << " [--stats] [--no-prepass] [--occlusion] [--minimap] [--batch] [--no-texture-arrays] [--blocking] [--watch] [--continuous] [--idle-timeout ms] [--dynamic-resolution ms] [--min-scale s] [--max-scale s] [--scale-hysteresis h] [--sharpness s] <model.gltf/glb> [model2.gltf/glb] ..." << std::endl;
         std::cout << "No models loaded. Displaying empty scene." << std::endl;
     }
 
+    // Scene drawn at a scale that holds the target GPU time, upscaled to the window
+    DynamicResolution dynamicResolution;
+    if (dynamicResolutionEnabled) {
+        dynamicResolution.setSettings(resolutionSettings);
+        if (!dynamicResolution.init()) {
+            std::cerr << "Dynamic resolution disabled" << std::endl;
+            dynamicResolutionEnabled = false;
+        }
+    }
+
+    // Play the first animation of every skinned model
+    AnimationSystem animation;
+    startAnimations(animation, models, 0);
+
+    renderer.prewarmShaders(models);
+
+    // Load milestones, reported once each: first presented frame, first frame
+    // with a model in it, and the first frame with everything fully loaded
+    bool firstFrameReported = false;
+    bool firstModelReported = false;
+    bool fullDetailReported = modelPaths == 0;
+
     const float cameraSpeed = 5.0f;
     const float mouseSensitivity = 0.1f;
 
@@ -48,8 +222,124 @@ int main(int argc, char* argv[]) {
     std::cout << "  Space/Shift - Move up/down" << std::endl;
     std::cout << "  ESC - Release mouse / Exit" << std::endl;
 
+    // Frame rate and memory totals shown in the window caption
+    float overlayTime = 0.0f;
+    int overlayFrames = 0;
+    // GL state calls of the last frame, and over the whole run for --stats
+    GLState::Counters glCalls;
+    GLState::Counters glCallsTotal;
+    // Heap allocations of the last drawn frame, and over steady frames (nothing streaming or compiling) for --stats
+    uint64_t frameHeapAllocations = 0;
+    uint64_t steadyHeapAllocations = 0;
+    uint64_t steadyHeapAllocationsMax = 0;
+    uint64_t steadyFrames = 0;
+    uint64_t steadyFramesWithout = 0;
+    auto updateCaption = [&](const std::string& rate) {
+        MemoryStats::Totals gpu = MemoryStats::getGpuTotals();
+        MemoryStats::Totals cpu = MemoryStats::getCpuTotals();
+        const Renderer::FrameStats& frame = renderer.getFrameStats();
+        std::ostringstream caption;
+        caption << window.getTitle() << " | " << rate
+                << " | GPU " << MemoryStats::formatBytes(gpu.current)
+                << " (peak " << MemoryStats::formatBytes(gpu.peak) << ")"
+                << " | CPU " << MemoryStats::formatBytes(cpu.current)
+                << " (peak " << MemoryStats::formatBytes(cpu.peak) << ")"
+                << " | shadows " << std::fixed << std::setprecision(2)
+                << renderer.getShadowStats().gpuMilliseconds << " ms"
+                << " | draws " << frame.prepassDraws << "z/" << frame.opaqueDraws << "o/"
+                << frame.maskDraws << "m/" << frame.blendDraws << "b"
+                << " | binds " << frame.textureBinds
+                << " | materials " << GpuResources::materials().getEntryCount()
+                << " (" << frame.materialSwitches << " switches)"
+                << " | GL state calls " << glCalls.issued << " (" << glCalls.skipped << " skipped)"
+                << " | allocs " << frameHeapAllocations;
+        if (frame.meshletsTotal > 0) {
+            caption << " | meshlets " << frame.meshletsVisible << "/" << frame.meshletsTotal;
+        }
+        if (frame.subMeshesTotal > 0) {
+            caption << " | sub-meshes " << frame.subMeshesVisible << "/" << frame.subMeshesTotal;
+        }
+        if (renderer.isOcclusionCullingEnabled()) {
+            const HiZCulling::Stats& occlusion = renderer.getOcclusionStats();
+            caption << " | occluded " << occlusion.culled << "/" << occlusion.tested;
+        }
+        if (dynamicResolutionEnabled) {
+            const DynamicResolution::Stats& resolution = dynamicResolution.getStats();
+            caption << " | scale " << resolution.scale << " (" << resolution.renderWidth << "x"
+                    << resolution.renderHeight << ", " << resolution.gpuMilliseconds << " ms)";
+        }
+        if (!progressive.isIdle()) {
+            caption << " | loading " << progressive.getFinishedCount() << "/" << progressive.getTotalCount();
+        }
+        window.setCaption(caption.str());
+    };
+
+    // Unless --continuous, frames are only drawn while something changes:
+    // input, window events, camera or model transforms, streaming, animation
+    // or queued shader compiles. Otherwise the loop sleeps in SDL until an
+    // event arrives or the idle timeout passes.
+    bool redrawing = true;
+    uint64_t cameraVersion = camera.getVersion();
+    uint64_t modelVersion = transformVersions(models);
+
+    FrameArena& frameArena = FrameArena::instance();
+
+    // Viewports are refreshed every frame, the minimap follows the camera
+    Camera minimapCamera(45.0f, 1.0f);
+    std::vector<Renderer::View> views = { { &camera, glm::ivec4(0) }, { &minimapCamera, glm::ivec4(0) } };
+
     while (!window.shouldClose()) {
-        window.pollEvents();
+        if (continuous || redrawing) {
+            window.pollEvents();
+        } else {
+            window.waitEvents(idleTimeoutMs);
+        }
+        const uint64_t heapAllocationsBefore = MemoryStats::getHeapAllocationCount();
+        const bool steady = progressive.isIdle() && !renderer.hasPendingWork() && !hotReload.isBusy();
+        frameArena.beginFrame();
+
+        bool changed = window.hasChanged() || !firstFrameReported || renderer.hasPendingWork() ||
+                       animation.getInstanceCount() > 0;
+
+        // Work handed back by jobs, e.g. finished parses for the streaming below
+        jobs.runMainThreadJobs();
+
+        // Objects released during the last frame wait for its fence, idle iterations keep collecting
+        GpuDeletionQueue::endFrame();
+        GpuDeletionQueue::collect(kDeleteBudgetMilliseconds);
+
+        // Streaming: new models and swapped meshes change shaders and the static shadow casters
+        if (!progressive.isIdle()) {
+            changed = true;
+            const size_t firstNew = models.size();
+            if (progressive.update(models, kLoadBudgetMilliseconds)) {
+                startAnimations(animation, models, firstNew);
+                renderer.prewarmShaders(models);
+                renderer.invalidateShadowCache();
+            }
+        }
+
+        // Edited files: patched or replaced models need the same refresh as streamed ones
+        if (watching) {
+            HotReload::Changes reloaded = hotReload.update(models);
+            for (size_t slot : reloaded.replacedModels) {
+                startAnimation(animation, *models[slot]);
+            }
+            if (reloaded.scene) {
+                renderer.prewarmShaders(models);
+                renderer.invalidateShadowCache();
+                changed = true;
+            }
+            if (reloaded.shaders) {
+                renderer.reloadShaders();
+                if (dynamicResolutionEnabled) {
+                    dynamicResolution.reloadShaders();
+                }
+                changed = true;
+            }
+            // Keep polling while an edit settles or parses
+            changed |= hotReload.isBusy();
+        }
 
         float dt = window.getDeltaTime();
 
@@ -72,10 +362,116 @@ int main(int argc, char* argv[]) {
         // Update camera aspect ratio on window resize
         camera.setAspect(window.getAspectRatio());
 
+        const uint64_t newModelVersion = transformVersions(models);
+        if (camera.getVersion() != cameraVersion || newModelVersion != modelVersion) {
+            cameraVersion = camera.getVersion();
+            modelVersion = newModelVersion;
+            changed = true;
+        }
+
+        const bool wasRedrawing = redrawing;
+        redrawing = continuous || changed;
+        if (!redrawing) {
+            // Going idle, the caption would otherwise keep the last frame rate
+            if (wasRedrawing) {
+                updateCaption("idle");
+                overlayTime = 0.0f;
+                overlayFrames = 0;
+            }
+            continue;
+        }
+
+        overlayTime += dt;
+        ++overlayFrames;
+        if (overlayTime >= 0.5f) {
+            updateCaption(std::to_string(static_cast<int>(overlayFrames / overlayTime + 0.5f)) + " fps");
+            overlayTime = 0.0f;
+            overlayFrames = 0;
+        }
+
+        // Animation
+        if (animation.getInstanceCount() > 0) {
+            animation.update(dt);
+            renderer.uploadJointPalette(animation.getPalette());
+        }
+
         // Render
-        renderer.render(camera, models);
+        if (dynamicResolutionEnabled) {
+            dynamicResolution.begin(window.getWidth(), window.getHeight());
+        }
+        if (minimap) {
+            // Both views share one traversal, sort and set of uploads
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            const int size = std::max(viewport[3] / kMinimapFraction, 1);
+            const int margin = size / 16;
+            views[0].viewport = glm::ivec4(viewport[0], viewport[1], viewport[2], viewport[3]);
+            views[1].viewport = glm::ivec4(viewport[0] + viewport[2] - size - margin,
+                                           viewport[1] + viewport[3] - size - margin, size, size);
+            minimapCamera.setPosition(camera.getPosition() + glm::vec3(0.0f, kMinimapHeight, 0.0f));
+            minimapCamera.setRotation(camera.getYaw(), -89.0f);
+            renderer.render(views, models);
+        } else {
+            renderer.render(camera, models);
+        }
+        if (dynamicResolutionEnabled) {
+            dynamicResolution.end();
+        }
+
+        glCalls = GLState::getCounters();
+        glCallsTotal.issued += glCalls.issued;
+        glCallsTotal.skipped += glCalls.skipped;
+        GLState::resetCounters();
 
         window.swapBuffers();
+
+        frameHeapAllocations = MemoryStats::getHeapAllocationCount() - heapAllocationsBefore;
+        if (steady) {
+            ++steadyFrames;
+            steadyHeapAllocations += frameHeapAllocations;
+            steadyHeapAllocationsMax = std::max(steadyHeapAllocationsMax, frameHeapAllocations);
+            steadyFramesWithout += frameHeapAllocations == 0;
+        }
+
+        if (!firstFrameReported) {
+            firstFrameReported = true;
+            std::cout << "First frame: " << std::fixed << std::setprecision(1) << millisecondsSinceStart()
+                      << " ms" << std::endl;
+        }
+        if (!firstModelReported && !models.empty()) {
+            firstModelReported = true;
+            std::cout << "First model visible: " << std::fixed << std::setprecision(1) << millisecondsSinceStart()
+                      << " ms" << std::endl;
+        }
+        if (!fullDetailReported && progressive.isIdle()) {
+            fullDetailReported = true;
+            std::cout << "Full detail: " << std::fixed << std::setprecision(1) << millisecondsSinceStart()
+                      << " ms" << std::endl;
+        }
+    }
+
+    // Report while everything is still loaded, so current equals what the scene holds
+    if (printStats) {
+        MemoryStats::printReport(std::cout);
+        const size_t stateCalls = glCallsTotal.issued + glCallsTotal.skipped;
+        std::cout << "GL state calls: " << glCallsTotal.issued << " issued, " << glCallsTotal.skipped
+                  << " skipped as redundant (" << std::fixed << std::setprecision(1)
+                  << (stateCalls > 0 ? 100.0 * glCallsTotal.skipped / stateCalls : 0.0) << "%)" << std::endl;
+        std::cout << "Heap allocations per steady frame: " << std::setprecision(2)
+                  << (steadyFrames > 0 ? static_cast<double>(steadyHeapAllocations) / steadyFrames : 0.0)
+                  << " average, " << steadyHeapAllocationsMax << " max, " << steadyFramesWithout << "/"
+                  << steadyFrames << " frames with none" << std::endl;
+        if (renderer.isOcclusionCullingEnabled()) {
+            const HiZCulling::Stats& occlusion = renderer.getOcclusionStats();
+            std::cout << "Occlusion culling: " << occlusion.culled << " of " << occlusion.tested
+                      << " tested meshes culled, " << occlusion.revealed << " revealed within the frame" << std::endl;
+        }
+        if (dynamicResolutionEnabled) {
+            const DynamicResolution::Stats& resolution = dynamicResolution.getStats();
+            std::cout << "Dynamic resolution: scale " << resolution.scale << " (" << resolution.renderWidth << "x"
+                      << resolution.renderHeight << "), scene " << resolution.gpuMilliseconds << " ms, "
+                      << resolution.scaleChanges << " scale changes" << std::endl;
+        }
     }
 
     return 0;
@@ -0,0 +1,39 @@
+#include "AnimationClip.hpp"
+#include <algorithm>
+
+namespace {
+
+// Forward steps tried from the cached cursor before giving up and searching
+constexpr uint32_t kMaxLinearSteps = 4;
+
+} // namespace
+
+uint32_t AnimationClip::findKey(const float* keyTimes, uint32_t keyCount, float t, uint32_t& cursor) {
+    if (keyCount < 2 || t <= keyTimes[0]) {
+        cursor = 0;
+        return 0;
+    }
+
+    const uint32_t last = keyCount - 1;
+    if (t >= keyTimes[last]) {
+        cursor = last;
+        return last;
+    }
+
+    uint32_t k = std::min(cursor, last - 1);
+    if (keyTimes[k] <= t) {
+        for (uint32_t step = 0; step < kMaxLinearSteps; ++step) {
+            if (t < keyTimes[k + 1]) {
+                cursor = k;
+                return k;
+            }
+            ++k;
+        }
+    }
+
+    // upper_bound finds the first key after t, the one before it brackets t
+    const float* upper = std::upper_bound(keyTimes, keyTimes + keyCount, t);
+    k = static_cast<uint32_t>(upper - keyTimes) - 1;
+    cursor = k;
+    return k;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "core/MemoryStats.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class AnimationPath : uint8_t {
+    Translation,
+    Rotation,
+    Scale
+};
+
+enum class AnimationInterpolation : uint8_t {
+    Step,
+    Linear,
+    CubicSpline
+};
+
+struct AnimationChannel {
+    uint32_t joint = 0;
+    AnimationPath path = AnimationPath::Translation;
+    AnimationInterpolation interpolation = AnimationInterpolation::Linear;
+    uint32_t firstKey = 0;    // into AnimationClip::times
+    uint32_t keyCount = 0;
+    uint32_t firstValue = 0;  // into AnimationClip::values, 3 values per key for cubic splines
+};
+
+// Keyframes of all channels in two flat arrays: key times, which the
+// sampler scans, are kept apart from the values it then reads. Translations
+// and scales use xyz, rotations are quaternions stored as xyzw.
+struct AnimationClip {
+    std::string name;
+    float duration = 0.0f;
+
+    std::vector<AnimationChannel> channels;
+    std::vector<float> times;
+    std::vector<glm::vec4> values;
+
+    // Size of the arrays above, set by whoever fills them
+    TrackedMemory memory;
+
+    // Returns the key index k with times[k] <= t < times[k + 1] for a channel,
+    // starting from a cursor cached by the caller. Playback moves forward in
+    // small steps, so this is usually zero or one comparison; large or
+    // backward jumps (looping) fall back to a binary search.
+    static uint32_t findKey(const float* keyTimes, uint32_t keyCount, float t, uint32_t& cursor);
+};
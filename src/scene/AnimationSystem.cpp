@@ -0,0 +1,171 @@
+#include "AnimationSystem.hpp"
+#include "core/Arena.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Instances handed to a thread at a time, small enough to balance crowds
+// of mixed skeleton sizes, large enough to keep the shared counter cold
+constexpr size_t kInstancesPerChunk = 8;
+
+glm::quat toQuat(const glm::vec4& v) {
+    return glm::quat(v.w, v.x, v.y, v.z);
+}
+
+glm::vec4 hermite(const glm::vec4& v0, const glm::vec4& out0,
+                  const glm::vec4& in1, const glm::vec4& v1, float f, float dt) {
+    float f2 = f * f;
+    float f3 = f2 * f;
+    return (2.0f * f3 - 3.0f * f2 + 1.0f) * v0
+         + (f3 - 2.0f * f2 + f) * dt * out0
+         + (-2.0f * f3 + 3.0f * f2) * v1
+         + (f3 - f2) * dt * in1;
+}
+
+glm::mat4 composeTRS(const glm::vec3& t, const glm::quat& r, const glm::vec3& s) {
+    glm::mat4 m = glm::mat4_cast(r);
+    m[0] *= s.x;
+    m[1] *= s.y;
+    m[2] *= s.z;
+    m[3] = glm::vec4(t, 1.0f);
+    return m;
+}
+
+} // namespace
+
+AnimationSystem::AnimationSystem(JobSystem& jobs)
+    : m_jobs(jobs) {
+}
+
+int AnimationSystem::createInstance(std::shared_ptr<const Skeleton> skeleton,
+                                    std::shared_ptr<const AnimationClip> clip,
+                                    float startTime, float speed) {
+    Instance instance;
+    instance.time = startTime;
+    instance.speed = speed;
+    instance.paletteOffset = m_palette.size() / kPaletteRowsPerJoint;
+    instance.cursorOffset = m_cursors.size();
+    instance.cursorCount = clip ? clip->channels.size() : 0;
+
+    // Identity rows until the first update
+    for (size_t j = 0; j < skeleton->getJointCount(); ++j) {
+        m_palette.push_back(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f));
+        m_palette.push_back(glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+        m_palette.push_back(glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    }
+    m_cursors.resize(m_cursors.size() + instance.cursorCount, 0);
+
+    MemoryAssetScope scope("animation system");
+    m_memory.set(MemoryCategory::Animation,
+                 m_palette.capacity() * sizeof(glm::vec4) + m_cursors.capacity() * sizeof(uint32_t));
+
+    instance.skeleton = std::move(skeleton);
+    instance.clip = std::move(clip);
+    m_instances.push_back(std::move(instance));
+    return static_cast<int>(m_instances.size() - 1);
+}
+
+void AnimationSystem::update(float dt) {
+    std::function<void(size_t, size_t)> task = [this, dt](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            evaluate(m_instances[i], dt);
+        }
+    };
+    m_jobs.parallelFor(m_instances.size(), kInstancesPerChunk, task);
+}
+
+void AnimationSystem::evaluate(Instance& instance, float dt) {
+    const Skeleton& skeleton = *instance.skeleton;
+    const size_t jointCount = skeleton.getJointCount();
+
+    // Pose scratch from the worker's arena, rewound when the instance is done
+    ArenaScope scratch(LinearArena::forThread());
+    LinearArena& arena = scratch.arena();
+    glm::vec3* translations = arena.allocateArray<glm::vec3>(jointCount);
+    glm::quat* rotations = arena.allocateArray<glm::quat>(jointCount);
+    glm::vec3* scales = arena.allocateArray<glm::vec3>(jointCount);
+    glm::mat4* world = arena.allocateArray<glm::mat4>(jointCount);
+
+    std::copy(skeleton.restTranslations.begin(), skeleton.restTranslations.end(), translations);
+    std::copy(skeleton.restRotations.begin(), skeleton.restRotations.end(), rotations);
+    std::copy(skeleton.restScales.begin(), skeleton.restScales.end(), scales);
+
+    if (instance.clip) {
+        const AnimationClip& clip = *instance.clip;
+
+        instance.time += dt * instance.speed;
+        if (clip.duration > 0.0f) {
+            instance.time = std::fmod(instance.time, clip.duration);
+            if (instance.time < 0.0f) {
+                instance.time += clip.duration;
+            }
+        }
+        const float time = instance.time;
+
+        uint32_t* cursors = m_cursors.data() + instance.cursorOffset;
+        for (size_t c = 0; c < clip.channels.size(); ++c) {
+            const AnimationChannel& channel = clip.channels[c];
+            if (channel.joint >= jointCount || channel.keyCount == 0) {
+                continue;
+            }
+
+            const float* keyTimes = clip.times.data() + channel.firstKey;
+            const glm::vec4* values = clip.values.data() + channel.firstValue;
+            const uint32_t k = AnimationClip::findKey(keyTimes, channel.keyCount, time, cursors[c]);
+            const bool cubic = channel.interpolation == AnimationInterpolation::CubicSpline;
+            const uint32_t stride = cubic ? 3 : 1;
+            const uint32_t valueOffset = cubic ? 1 : 0;
+
+            glm::vec4 value(0.0f);
+            glm::quat rotation;
+            const bool isRotation = channel.path == AnimationPath::Rotation;
+
+            if (k + 1 >= channel.keyCount || channel.interpolation == AnimationInterpolation::Step) {
+                value = values[k * stride + valueOffset];
+                rotation = toQuat(value);
+            } else {
+                const float t0 = keyTimes[k];
+                const float t1 = keyTimes[k + 1];
+                const float span = t1 - t0;
+                const float f = span > 0.0f ? std::clamp((time - t0) / span, 0.0f, 1.0f) : 0.0f;
+
+                if (cubic) {
+                    value = hermite(values[k * 3 + 1], values[k * 3 + 2],
+                                    values[(k + 1) * 3], values[(k + 1) * 3 + 1], f, span);
+                    rotation = glm::normalize(toQuat(value));
+                } else if (isRotation) {
+                    rotation = glm::slerp(toQuat(values[k]), toQuat(values[k + 1]), f);
+                } else {
+                    value = glm::mix(values[k], values[k + 1], f);
+                }
+            }
+
+            switch (channel.path) {
+                case AnimationPath::Translation:
+                    translations[channel.joint] = glm::vec3(value);
+                    break;
+                case AnimationPath::Rotation:
+                    rotations[channel.joint] = rotation;
+                    break;
+                case AnimationPath::Scale:
+                    scales[channel.joint] = glm::vec3(value);
+                    break;
+            }
+        }
+    }
+
+    glm::vec4* palette = m_palette.data() + instance.paletteOffset * kPaletteRowsPerJoint;
+    for (size_t j = 0; j < jointCount; ++j) {
+        glm::mat4 local = composeTRS(translations[j], rotations[j], scales[j]);
+        int parent = skeleton.parents[j];
+        world[j] = parent < 0 ? skeleton.rootParentTransforms[j] * local : world[parent] * local;
+
+        // Affine skinning matrix as three rows, the shader rebuilds the fourth
+        glm::mat4 skin = world[j] * skeleton.inverseBindMatrices[j];
+        glm::vec4* rows = palette + j * kPaletteRowsPerJoint;
+        rows[0] = glm::vec4(skin[0][0], skin[1][0], skin[2][0], skin[3][0]);
+        rows[1] = glm::vec4(skin[0][1], skin[1][1], skin[2][1], skin[3][1]);
+        rows[2] = glm::vec4(skin[0][2], skin[1][2], skin[2][2], skin[3][2]);
+    }
+}
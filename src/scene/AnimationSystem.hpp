@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AnimationClip.hpp"
+#include "Skeleton.hpp"
+#include "core/MemoryStats.hpp"
+#include "core/JobSystem.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Plays animation clips on skeleton instances and writes their skinning
+// matrices into one shared palette, laid out instance after instance so the
+// whole thing uploads as a single buffer per frame.
+//
+// Each joint takes kPaletteRowsPerJoint vec4 rows: the top three rows of its
+// affine skinning matrix. Instances are sampled in parallel on the job
+// system, each instance is processed start to finish by one thread.
+class AnimationSystem {
+public:
+    static constexpr size_t kPaletteRowsPerJoint = 3;
+
+    explicit AnimationSystem(JobSystem& jobs = JobSystem::instance());
+
+    AnimationSystem(const AnimationSystem&) = delete;
+    AnimationSystem& operator=(const AnimationSystem&) = delete;
+
+    // Returns an instance id. The instance's palette slice starts at
+    // getPaletteOffset(id) joints and is fixed for its lifetime.
+    int createInstance(std::shared_ptr<const Skeleton> skeleton,
+                       std::shared_ptr<const AnimationClip> clip,
+                       float startTime = 0.0f, float speed = 1.0f);
+
+    // Advances all instances by dt seconds (looping) and rebuilds the palette
+    void update(float dt);
+
+    const std::vector<glm::vec4>& getPalette() const { return m_palette; }
+    size_t getPaletteOffset(int instance) const { return m_instances[instance].paletteOffset; }
+    size_t getInstanceCount() const { return m_instances.size(); }
+    size_t getJointCount() const { return m_palette.size() / kPaletteRowsPerJoint; }
+    unsigned getThreadCount() const { return m_jobs.getThreadCount(); }
+
+private:
+    struct Instance {
+        std::shared_ptr<const Skeleton> skeleton;
+        std::shared_ptr<const AnimationClip> clip;
+        float time = 0.0f;
+        float speed = 1.0f;
+        size_t paletteOffset = 0;  // in joints
+        size_t cursorOffset = 0;   // into m_cursors, one per clip channel
+        size_t cursorCount = 0;
+    };
+
+    void evaluate(Instance& instance, float dt);
+
+    std::vector<Instance> m_instances;
+    std::vector<uint32_t> m_cursors;
+    std::vector<glm::vec4> m_palette;
+    TrackedMemory m_memory;
+
+    JobSystem& m_jobs;
+};
@@ -8,26 +8,46 @@ Camera::Camera(float fov, float aspect, float near, float far)
 }
 
 void Camera::setPosition(const glm::vec3& pos) {
-    m_position = pos;
+    if (pos != m_position) {
+        m_position = pos;
+        ++m_version;
+    }
 }
 
 void Camera::setFov(float fov) {
-    m_fov = fov;
-    updateProjection();
+    if (fov != m_fov) {
+        m_fov = fov;
+        updateProjection();
+    }
 }
 
 void Camera::setAspect(float aspect) {
-    m_aspect = aspect;
-    updateProjection();
+    // Called every frame with the window's aspect, usually unchanged
+    if (aspect != m_aspect) {
+        m_aspect = aspect;
+        updateProjection();
+    }
 }
 
 void Camera::setClipPlanes(float near, float far) {
-    m_near = near;
-    m_far = far;
-    updateProjection();
+    if (near != m_near || far != m_far) {
+        m_near = near;
+        m_far = far;
+        updateProjection();
+    }
+}
+
+void Camera::setRotation(float yaw, float pitch) {
+    m_yaw = yaw;
+    m_pitch = std::clamp(pitch, -89.0f, 89.0f);
+    updateVectors();
 }
 
 void Camera::processMouseMovement(float xOffset, float yOffset, float sensitivity) {
+    if (xOffset == 0.0f && yOffset == 0.0f) {
+        return;
+    }
+
     m_yaw += xOffset * sensitivity;
     m_pitch -= yOffset * sensitivity;
 
@@ -37,9 +57,14 @@ void Camera::processMouseMovement(float xOffset, float yOffset, float sensitivit
 }
 
 void Camera::processKeyboard(const glm::vec3& direction, float speed) {
+    if (direction == glm::vec3(0.0f) || speed == 0.0f) {
+        return;
+    }
+
     m_position += m_front * direction.z * speed;
     m_position += m_right * direction.x * speed;
     m_position += m_worldUp * direction.y * speed;
+    ++m_version;
 }
 
 glm::mat4 Camera::getViewMatrix() const {
@@ -59,8 +84,10 @@ void Camera::updateVectors() {
     m_front = glm::normalize(front);
     m_right = glm::normalize(glm::cross(m_front, m_worldUp));
     m_up = glm::normalize(glm::cross(m_right, m_front));
+    ++m_version;
 }
 
 void Camera::updateProjection() {
     m_projection = glm::perspective(glm::radians(m_fov), m_aspect, m_near, m_far);
+    ++m_version;
 }
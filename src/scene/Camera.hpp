@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <cstdint>
 
 class Camera {
 public:
@@ -11,10 +12,16 @@ public:
     void setFov(float fov);
     void setAspect(float aspect);
     void setClipPlanes(float near, float far);
+    // Degrees, yaw -90 looks down -Z
+    void setRotation(float yaw, float pitch);
 
     const glm::vec3& getPosition() const { return m_position; }
     float getYaw() const { return m_yaw; }
     float getPitch() const { return m_pitch; }
+    float getFov() const { return m_fov; }  // vertical, degrees
+    float getAspect() const { return m_aspect; }
+    float getNear() const { return m_near; }
+    float getFar() const { return m_far; }
 
     void processMouseMovement(float xOffset, float yOffset, float sensitivity = 0.1f);
     void processKeyboard(const glm::vec3& direction, float speed);
@@ -26,6 +33,9 @@ public:
     glm::vec3 getRight() const { return m_right; }
     glm::vec3 getUp() const { return m_up; }
 
+    // Bumped by every call that actually changes the view or projection
+    uint64_t getVersion() const { return m_version; }
+
 private:
     void updateVectors();
     void updateProjection();
@@ -45,4 +55,5 @@ private:
     float m_far;
 
     glm::mat4 m_projection;
+    uint64_t m_version = 0;
 };
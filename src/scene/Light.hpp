@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+enum class LightType : uint8_t {
+    Directional,
+    Point,
+    Spot
+};
+
+// Punctual light as described by KHR_lights_punctual. Position and direction
+// are in the owning model's space, the renderer moves them to world space.
+struct Light {
+    LightType type = LightType::Point;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+
+    // Distance at which the light is cut off. glTF allows infinite range,
+    // the loader then picks the distance where it drops below visibility.
+    float range = 0.0f;
+
+    // Cone half-angles in radians, spot lights only
+    float innerConeAngle = 0.0f;
+    float outerConeAngle = 0.7853982f;
+};
@@ -1,5 +1,72 @@
 #include "Model.hpp"
+#include "graphics/GpuResources.hpp"
 
-void Model::addMesh(std::unique_ptr<Mesh> mesh) {
-    m_meshes.push_back(std::move(mesh));
+Model::~Model() {
+    for (MeshHandle mesh : m_meshes) {
+        GpuResources::meshes().destroy(mesh);
+    }
+    for (TextureHandle texture : m_textures) {
+        GpuResources::textures().destroy(texture);
+    }
+    for (TextureArrayHandle array : m_textureArrays) {
+        GpuResources::textureArrays().destroy(array);
+    }
+}
+
+void Model::addMesh(Mesh mesh) {
+    m_meshes.push_back(GpuResources::meshes().create(std::move(mesh)));
+}
+
+void Model::setMesh(size_t index, Mesh mesh) {
+    // Same slot, so the handle stays valid; the old buffers go to the deletion queue
+    getMesh(index) = std::move(mesh);
+}
+
+void Model::replaceMeshes(size_t first, size_t count, std::vector<Mesh> meshes) {
+    ResourcePool<Mesh>& pool = GpuResources::meshes();
+    for (size_t i = first; i < first + count; ++i) {
+        pool.destroy(m_meshes[i]);
+    }
+
+    std::vector<MeshHandle> handles;
+    handles.reserve(meshes.size());
+    for (Mesh& mesh : meshes) {
+        handles.push_back(pool.create(std::move(mesh)));
+    }
+    auto at = m_meshes.erase(m_meshes.begin() + first, m_meshes.begin() + first + count);
+    m_meshes.insert(at, handles.begin(), handles.end());
+}
+
+Mesh& Model::getMesh(size_t index) {
+    return *GpuResources::meshes().get(m_meshes[index]);
+}
+
+const Mesh& Model::getMesh(size_t index) const {
+    return *GpuResources::meshes().get(m_meshes[index]);
+}
+
+bool Model::computeBounds(glm::vec3& min, glm::vec3& max) const {
+    if (m_meshes.empty()) {
+        return false;
+    }
+
+    const glm::mat4 matrix = m_transform.getMatrix();
+    min = glm::vec3(1.0e30f);
+    max = glm::vec3(-1.0e30f);
+    for (size_t i = 0; i < m_meshes.size(); ++i) {
+        const Mesh& mesh = getMesh(i);
+        const glm::vec3& lo = mesh.getBoundsMin();
+        const glm::vec3& hi = mesh.getBoundsMax();
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 p((corner & 1) ? hi.x : lo.x, (corner & 2) ? hi.y : lo.y, (corner & 4) ? hi.z : lo.z);
+            glm::vec3 world = glm::vec3(matrix * glm::vec4(p, 1.0f));
+            min = glm::min(min, world);
+            max = glm::max(max, world);
+        }
+    }
+    return true;
+}
+
+void Model::addAnimation(std::shared_ptr<const AnimationClip> clip) {
+    m_animations.push_back(std::move(clip));
 }
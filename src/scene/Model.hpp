@@ -1,26 +1,76 @@
 #pragma once
 
 #include "Transform.hpp"
+#include "Skeleton.hpp"
+#include "AnimationClip.hpp"
+#include "Light.hpp"
 #include "graphics/Mesh.hpp"
 #include <vector>
 #include <memory>
 #include <string>
 
+// Meshes and textures live in GpuResources, a model owns handles to them
+// and releases them when it goes away.
 class Model {
 public:
     Model() = default;
+    ~Model();
 
-    void addMesh(std::unique_ptr<Mesh> mesh);
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
-    const std::vector<std::unique_ptr<Mesh>>& getMeshes() const { return m_meshes; }
+    void addMesh(Mesh mesh);
+    // Swap meshes in place while the model streams in, e.g. proxies for full geometry
+    void setMesh(size_t index, Mesh mesh);
+    void replaceMeshes(size_t first, size_t count, std::vector<Mesh> meshes);
+
+    // Textures referenced by this model's materials, released along with it
+    void addTexture(TextureHandle texture) { m_textures.push_back(texture); }
+    void addTextureArray(TextureArrayHandle array) { m_textureArrays.push_back(array); }
+
+    // World-space box around all meshes' bind-pose bounds, false if there are no meshes
+    bool computeBounds(glm::vec3& min, glm::vec3& max) const;
+
+    size_t getMeshCount() const { return m_meshes.size(); }
+    // Valid until meshes are created or destroyed anywhere, don't keep across frames
+    Mesh& getMesh(size_t index);
+    const Mesh& getMesh(size_t index) const;
+    const std::vector<MeshHandle>& getMeshHandles() const { return m_meshes; }
     Transform& getTransform() { return m_transform; }
     const Transform& getTransform() const { return m_transform; }
 
     const std::string& getName() const { return m_name; }
     void setName(const std::string& name) { m_name = name; }
 
+    // Least loaded stage of any of its meshes while streaming, Full otherwise
+    void setLoadState(LoadState state) { m_loadState = state; }
+    LoadState getLoadState() const { return m_loadState; }
+
+    // Skinned meshes of this model are driven by this skeleton
+    void setSkeleton(std::shared_ptr<const Skeleton> skeleton) { m_skeleton = std::move(skeleton); }
+    const std::shared_ptr<const Skeleton>& getSkeleton() const { return m_skeleton; }
+
+    void addAnimation(std::shared_ptr<const AnimationClip> clip);
+    const std::vector<std::shared_ptr<const AnimationClip>>& getAnimations() const { return m_animations; }
+
+    void addLight(const Light& light) { m_lights.push_back(light); }
+    const std::vector<Light>& getLights() const { return m_lights; }
+
+    // First palette joint of this model's animation instance, -1 if not animated
+    void setJointPaletteOffset(int offset) { m_jointPaletteOffset = offset; }
+    int getJointPaletteOffset() const { return m_jointPaletteOffset; }
+
 private:
-    std::vector<std::unique_ptr<Mesh>> m_meshes;
+    std::vector<MeshHandle> m_meshes;
+    std::vector<TextureHandle> m_textures;
+    std::vector<TextureArrayHandle> m_textureArrays;
     Transform m_transform;
     std::string m_name;
+    LoadState m_loadState = LoadState::Full;
+
+    std::shared_ptr<const Skeleton> m_skeleton;
+    std::vector<std::shared_ptr<const AnimationClip>> m_animations;
+    int m_jointPaletteOffset = -1;
+
+    std::vector<Light> m_lights;
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+#include <vector>
+
+// Joint hierarchy of a glTF skin, stored as parallel arrays in
+// parent-before-child order so world transforms resolve in one pass.
+// Vertex joint indices are remapped to this order at load time, so the
+// joint index is also the index into the skinning palette.
+struct Skeleton {
+    std::vector<int> parents;                     // -1 for roots
+    std::vector<glm::mat4> inverseBindMatrices;
+
+    // Rest pose, used for any path an animation does not drive
+    std::vector<glm::vec3> restTranslations;
+    std::vector<glm::quat> restRotations;
+    std::vector<glm::vec3> restScales;
+
+    // Accumulated transform of non-joint ancestors, only meaningful for roots
+    std::vector<glm::mat4> rootParentTransforms;
+
+    std::vector<std::string> names;
+
+    size_t getJointCount() const { return parents.size(); }
+};
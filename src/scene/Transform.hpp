@@ -3,21 +3,22 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <cstdint>
 
 class Transform {
 public:
     Transform() = default;
 
-    void setPosition(const glm::vec3& pos) { m_position = pos; m_dirty = true; }
-    void setRotation(const glm::quat& rot) { m_rotation = rot; m_dirty = true; }
-    void setScale(const glm::vec3& scale) { m_scale = scale; m_dirty = true; }
+    void setPosition(const glm::vec3& pos) { m_position = pos; markChanged(); }
+    void setRotation(const glm::quat& rot) { m_rotation = rot; markChanged(); }
+    void setScale(const glm::vec3& scale) { m_scale = scale; markChanged(); }
 
     const glm::vec3& getPosition() const { return m_position; }
     const glm::quat& getRotation() const { return m_rotation; }
     const glm::vec3& getScale() const { return m_scale; }
 
-    void translate(const glm::vec3& delta) { m_position += delta; m_dirty = true; }
-    void rotate(const glm::quat& delta) { m_rotation = delta * m_rotation; m_dirty = true; }
+    void translate(const glm::vec3& delta) { m_position += delta; markChanged(); }
+    void rotate(const glm::quat& delta) { m_rotation = delta * m_rotation; markChanged(); }
 
     const glm::mat4& getMatrix() const {
         if (m_dirty) {
@@ -42,7 +43,15 @@ public:
         return glm::normalize(m_rotation * glm::vec3(0.0f, 1.0f, 0.0f));
     }
 
+    // Bumped by every setter, lets callers notice changes without comparing matrices
+    uint64_t getVersion() const { return m_version; }
+
 private:
+    void markChanged() {
+        m_dirty = true;
+        ++m_version;
+    }
+
     void updateMatrix() const {
         m_matrix = glm::translate(glm::mat4(1.0f), m_position);
         m_matrix *= glm::mat4_cast(m_rotation);
@@ -56,4 +65,5 @@ private:
 
     mutable glm::mat4 m_matrix = glm::mat4(1.0f);
     mutable bool m_dirty = true;
+    uint64_t m_version = 0;
 };
@@ -0,0 +1,232 @@
+// Loader regression tests on small generated glTF files: normals decoded from
+// EXT_meshopt_compression octahedral streams and KHR_mesh_quantization
+// positions, read through GLTFLoader::readGeometry(). Exits non-zero on failure.
+//
+// Usage: teo_tests
+
+#include "loader/GLTFLoader.hpp"
+
+#include "json.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kByte = 5120;
+constexpr int kShort = 5122;
+constexpr int kFloat = 5126;
+
+int g_failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++g_failures;
+    }
+}
+
+bool near(const glm::vec3& a, const glm::vec3& b, float tolerance) {
+    return glm::length(a - b) <= tolerance;
+}
+
+size_t append(std::vector<unsigned char>& bin, const void* data, size_t bytes) {
+    const size_t offset = bin.size();
+    bin.insert(bin.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + bytes);
+    bin.resize((bin.size() + 3) & ~size_t(3), 0);
+    return offset;
+}
+
+// The meshopt vertex codec with every byte group stored raw, which the decoder
+// accepts like any other encoding. One block, so at most 256 elements.
+std::vector<unsigned char> encodeVertexBuffer(const unsigned char* data, size_t count, size_t stride) {
+    const size_t alignedCount = (count + 15) & ~size_t(15);
+    std::vector<unsigned char> result = { 0xa0 };
+    for (size_t k = 0; k < stride; ++k) {
+        result.insert(result.end(), (alignedCount / 16 + 3) / 4, 0xff);
+        unsigned char last = 0;
+        for (size_t i = 0; i < alignedCount; ++i) {
+            const unsigned char value = i < count ? data[i * stride + k] : last;
+            const int8_t delta = static_cast<int8_t>(value - last);
+            result.push_back(static_cast<unsigned char>((uint8_t(delta) << 1) ^ (delta < 0 ? 0xff : 0)));
+            last = value;
+        }
+    }
+    // Tail: the zero baseline vertex, padded to 32 bytes
+    result.resize(result.size() + std::max<size_t>(stride, 32), 0);
+    return result;
+}
+
+// Octahedral encoding as meshoptimizer's encodeFilterOct, with the third
+// component holding the scale of 1.0
+template <typename T>
+void encodeOct(const glm::vec3& normal, T* out) {
+    const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+    glm::vec3 n = normal / (std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z));
+    if (n.z < 0.0f) {
+        const float x = n.x;
+        n.x = (1.0f - std::fabs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        n.y = (1.0f - std::fabs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    out[0] = static_cast<T>(std::lround(n.x * max));
+    out[1] = static_cast<T>(std::lround(n.y * max));
+    out[2] = static_cast<T>(max);
+    out[3] = 0;
+}
+
+bool writeGltf(const std::filesystem::path& path, nlohmann::json doc, const std::vector<unsigned char>& bin) {
+    const std::filesystem::path binPath = std::filesystem::path(path).replace_extension(".bin");
+    doc["asset"] = { { "version", "2.0" } };
+    doc["buffers"].insert(doc["buffers"].begin(),
+                          nlohmann::json::object({ { "uri", binPath.filename().string() }, { "byteLength", bin.size() } }));
+
+    std::ofstream binFile(binPath, std::ios::binary);
+    binFile.write(reinterpret_cast<const char*>(bin.data()), static_cast<std::streamsize>(bin.size()));
+    std::ofstream gltfFile(path);
+    gltfFile << doc.dump();
+    return binFile.good() && gltfFile.good();
+}
+
+std::vector<Vertex> loadVertices(const std::filesystem::path& path) {
+    GLTFLoader loader;
+    const ParsedGltf parsed = loader.parse(path.string());
+    std::vector<std::vector<Vertex>> vertices;
+    if (parsed.isValid()) {
+        GLTFLoader::readGeometry(parsed, &vertices, nullptr);
+    }
+    return vertices.empty() ? std::vector<Vertex>() : vertices.front();
+}
+
+const std::vector<glm::vec3> kPositions = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+
+// One triangle whose normals are a meshopt ATTRIBUTES view with the OCTAHEDRAL
+// filter, T being int8_t (stride 4) or int16_t (stride 8)
+template <typename T>
+void testOctahedralNormals(const std::filesystem::path& directory, const char* name) {
+    const std::vector<glm::vec3> normals = { { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, -0.6f, -0.8f } };
+    const size_t stride = sizeof(T) * 4;
+
+    std::vector<T> encoded(normals.size() * 4);
+    for (size_t i = 0; i < normals.size(); ++i) {
+        encodeOct(normals[i], &encoded[i * 4]);
+    }
+    const std::vector<unsigned char> stream =
+        encodeVertexBuffer(reinterpret_cast<const unsigned char*>(encoded.data()), normals.size(), stride);
+
+    std::vector<unsigned char> bin;
+    const size_t positionOffset = append(bin, kPositions.data(), kPositions.size() * sizeof(glm::vec3));
+    const size_t streamOffset = append(bin, stream.data(), stream.size());
+
+    nlohmann::json doc;
+    doc["extensionsUsed"] = { "EXT_meshopt_compression" };
+    doc["buffers"] = nlohmann::json::array();
+    doc["buffers"].push_back({ { "byteLength", normals.size() * stride },
+                               { "extensions", { { "EXT_meshopt_compression", { { "fallback", true } } } } } });
+    doc["bufferViews"] = {
+        { { "buffer", 0 }, { "byteOffset", positionOffset }, { "byteLength", kPositions.size() * sizeof(glm::vec3) } },
+        { { "buffer", 1 },
+          { "byteLength", normals.size() * stride },
+          { "byteStride", stride },
+          { "extensions",
+            { { "EXT_meshopt_compression",
+                { { "buffer", 0 },
+                  { "byteOffset", streamOffset },
+                  { "byteLength", stream.size() },
+                  { "byteStride", stride },
+                  { "count", normals.size() },
+                  { "mode", "ATTRIBUTES" },
+                  { "filter", "OCTAHEDRAL" } } } } } }
+    };
+    doc["accessors"] = {
+        { { "bufferView", 0 }, { "componentType", kFloat }, { "count", kPositions.size() }, { "type", "VEC3" },
+          { "min", { 0, 0, 0 } }, { "max", { 1, 1, 0 } } },
+        { { "bufferView", 1 }, { "componentType", sizeof(T) == 1 ? kByte : kShort }, { "normalized", true },
+          { "count", normals.size() }, { "type", "VEC3" } }
+    };
+    doc["meshes"] = { { { "primitives", { { { "attributes", { { "POSITION", 0 }, { "NORMAL", 1 } } } } } } } };
+    doc["nodes"] = { { { "mesh", 0 } } };
+    doc["scenes"] = { { { "nodes", { 0 } } } };
+    doc["scene"] = 0;
+
+    const std::filesystem::path path = directory / (std::string(name) + ".gltf");
+    if (!writeGltf(path, doc, bin)) {
+        check(false, std::string(name) + ": writing " + path.string());
+        return;
+    }
+
+    const std::vector<Vertex> vertices = loadVertices(path);
+    check(vertices.size() == normals.size(), std::string(name) + ": vertex count");
+    const float tolerance = sizeof(T) == 1 ? 0.02f : 0.001f;
+    for (size_t i = 0; i < std::min(vertices.size(), normals.size()); ++i) {
+        check(near(vertices[i].normal, normals[i], tolerance), std::string(name) + ": normal " + std::to_string(i));
+        check(near(vertices[i].position, kPositions[i], 0.0f), std::string(name) + ": position " + std::to_string(i));
+    }
+}
+
+// KHR_mesh_quantization positions as unnormalized shorts, which keep their
+// integer values for the node transform to scale
+void testQuantizedPositions(const std::filesystem::path& directory) {
+    const int16_t positions[3][4] = { { 0, 0, 0, 0 }, { 100, -200, 300, 0 }, { -32768, 32767, 1, 0 } };
+
+    std::vector<unsigned char> bin;
+    const size_t offset = append(bin, positions, sizeof(positions));
+
+    nlohmann::json doc;
+    doc["extensionsUsed"] = { "KHR_mesh_quantization" };
+    doc["extensionsRequired"] = { "KHR_mesh_quantization" };
+    doc["buffers"] = nlohmann::json::array();
+    doc["bufferViews"] = {
+        { { "buffer", 0 }, { "byteOffset", offset }, { "byteLength", sizeof(positions) }, { "byteStride", 8 } }
+    };
+    doc["accessors"] = { { { "bufferView", 0 }, { "componentType", kShort }, { "count", 3 }, { "type", "VEC3" },
+                           { "min", { -32768, -200, 0 } }, { "max", { 100, 32767, 300 } } } };
+    doc["meshes"] = { { { "primitives", { { { "attributes", { { "POSITION", 0 } } } } } } } };
+    doc["nodes"] = { { { "mesh", 0 }, { "scale", { 0.01, 0.01, 0.01 } } } };
+    doc["scenes"] = { { { "nodes", { 0 } } } };
+    doc["scene"] = 0;
+
+    const std::filesystem::path path = directory / "quantized_positions.gltf";
+    if (!writeGltf(path, doc, bin)) {
+        check(false, "quantized positions: writing " + path.string());
+        return;
+    }
+
+    const std::vector<Vertex> vertices = loadVertices(path);
+    check(vertices.size() == 3, "quantized positions: vertex count");
+    for (size_t i = 0; i < std::min<size_t>(vertices.size(), 3); ++i) {
+        const glm::vec3 expected(positions[i][0], positions[i][1], positions[i][2]);
+        check(near(vertices[i].position, expected, 0.0f), "quantized positions: position " + std::to_string(i));
+    }
+}
+
+} // namespace
+
+int main() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "teo_tests";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "Failed to create " << directory.string() << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    testOctahedralNormals<int8_t>(directory, "octahedral_normals_8");
+    testOctahedralNormals<int16_t>(directory, "octahedral_normals_16");
+    testQuantizedPositions(directory);
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All loader tests passed" << std::endl;
+    return 0;
+}
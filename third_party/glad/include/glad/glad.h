@@ -5,6 +5,8 @@
 #ifndef GLAD_H
 #define GLAD_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,6 +44,8 @@ typedef signed char GLbyte;
 typedef unsigned short GLushort;
 typedef ptrdiff_t GLsizeiptr;
 typedef ptrdiff_t GLintptr;
+typedef unsigned long long GLuint64;
+typedef struct __GLsync* GLsync;
 
 /* OpenGL constants */
 #define GL_FALSE 0
@@ -94,6 +98,10 @@ typedef ptrdiff_t GLintptr;
 #define GL_LINEAR_MIPMAP_LINEAR 0x2703
 #define GL_REPEAT 0x2901
 #define GL_CLAMP_TO_EDGE 0x812F
+#define GL_MIRRORED_REPEAT 0x8370
+#define GL_LINEAR_MIPMAP_NEAREST 0x2701
+#define GL_NEAREST_MIPMAP_LINEAR 0x2702
+#define GL_MAX_ARRAY_TEXTURE_LAYERS 0x88FF
 
 /* Pixel formats */
 #define GL_RED 0x1903
@@ -147,10 +155,93 @@ typedef ptrdiff_t GLintptr;
 #define GL_VERSION 0x1F02
 #define GL_SHADING_LANGUAGE_VERSION 0x8B8C
 
+/* Texture buffers */
+#define GL_TEXTURE_BUFFER 0x8C2A
+#define GL_RGBA32F 0x8814
+#define GL_STREAM_DRAW 0x88E0
+
+/* Clustered lighting */
+#define GL_VIEWPORT 0x0BA2
+#define GL_R16UI 0x8234
+#define GL_R32UI 0x8236
+#define GL_RG32UI 0x823C
+
+/* Shadow maps and timer queries */
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_DEPTH_COMPONENT 0x1902
+#define GL_DEPTH_COMPONENT24 0x81A6
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_TEXTURE_COMPARE_MODE 0x884C
+#define GL_TEXTURE_COMPARE_FUNC 0x884D
+#define GL_COMPARE_REF_TO_TEXTURE 0x884E
+#define GL_CLAMP_TO_BORDER 0x812D
+#define GL_TEXTURE_BORDER_COLOR 0x1004
+#define GL_POLYGON_OFFSET_FILL 0x8037
+#define GL_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+
+/* Depth pre-pass */
+#define GL_EQUAL 0x0202
+
+/* Offscreen readback */
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_STREAM_READ 0x88E1
+#define GL_MAP_READ_BIT 0x0001
+#define GL_RENDERBUFFER 0x8D41
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_PACK_ALIGNMENT 0x0D05
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#define GL_WAIT_FAILED 0x911D
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+
+/* Texture arrays */
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+
+/* Mapped buffer writes */
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#define GL_COPY_WRITE_BUFFER 0x8F37
+
+/* Timer queries */
+#define GL_TIMESTAMP 0x8E28
+
+/* Occlusion culling */
+#define GL_R32F 0x822E
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_NEAREST_MIPMAP_NEAREST 0x2700
+#define GL_ANY_SAMPLES_PASSED 0x8C2F
+#define GL_QUERY_WAIT 0x8E13
+#define GL_DEPTH 0x1801
+#define GL_DEPTH_STENCIL 0x84F9
+#define GL_UNSIGNED_INT_24_8 0x84FA
+#define GL_FLOAT_32_UNSIGNED_INT_24_8_REV 0x8DAD
+#define GL_DEPTH_COMPONENT16 0x81A5
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#define GL_DEPTH24_STENCIL8 0x88F0
+#define GL_DEPTH32F_STENCIL8 0x8CAD
+#define GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE 0x8216
+#define GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE 0x8217
+#define GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE 0x8211
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+#define GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE 0x8CD0
+#define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+
 /* Function declarations */
 typedef void (APIENTRYP PFNGLCLEARPROC)(GLbitfield mask);
 typedef void (APIENTRYP PFNGLCLEARCOLORPROC)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
 typedef void (APIENTRYP PFNGLVIEWPORTPROC)(GLint x, GLint y, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLSCISSORPROC)(GLint x, GLint y, GLsizei width, GLsizei height);
 typedef void (APIENTRYP PFNGLENABLEPROC)(GLenum cap);
 typedef void (APIENTRYP PFNGLDISABLEPROC)(GLenum cap);
 typedef void (APIENTRYP PFNGLBLENDFUNCPROC)(GLenum sfactor, GLenum dfactor);
@@ -215,10 +306,80 @@ typedef void (APIENTRYP PFNGLGENERATEMIPMAPPROC)(GLenum target);
 typedef void (APIENTRYP PFNGLDRAWARRAYSPROC)(GLenum mode, GLint first, GLsizei count);
 typedef void (APIENTRYP PFNGLDRAWELEMENTSPROC)(GLenum mode, GLsizei count, GLenum type, const void *indices);
 
+/* Buffer updates and texture buffers */
+typedef void (APIENTRYP PFNGLBUFFERSUBDATAPROC)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
+typedef void (APIENTRYP PFNGLTEXBUFFERPROC)(GLenum target, GLenum internalformat, GLuint buffer);
+typedef void (APIENTRYP PFNGLVERTEXATTRIBIPOINTERPROC)(GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer);
+
+/* Clustered lighting */
+typedef void (APIENTRYP PFNGLGETINTEGERVPROC)(GLenum pname, GLint *data);
+
+/* Clustered lighting */
+typedef void (APIENTRYP PFNGLUNIFORM3IPROC)(GLint location, GLint v0, GLint v1, GLint v2);
+
+/* Shadow maps and timer queries */
+typedef void (APIENTRYP PFNGLGENFRAMEBUFFERSPROC)(GLsizei n, GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLDELETEFRAMEBUFFERSPROC)(GLsizei n, const GLuint *framebuffers);
+typedef void (APIENTRYP PFNGLBINDFRAMEBUFFERPROC)(GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRYP PFNGLCHECKFRAMEBUFFERSTATUSPROC)(GLenum target);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURELAYERPROC)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer);
+typedef void (APIENTRYP PFNGLTEXIMAGE3DPROC)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels);
+typedef void (APIENTRYP PFNGLTEXPARAMETERFVPROC)(GLenum target, GLenum pname, const GLfloat *params);
+typedef void (APIENTRYP PFNGLDRAWBUFFERPROC)(GLenum buf);
+typedef void (APIENTRYP PFNGLREADBUFFERPROC)(GLenum src);
+typedef void (APIENTRYP PFNGLPOLYGONOFFSETPROC)(GLfloat factor, GLfloat units);
+typedef void (APIENTRYP PFNGLBLITFRAMEBUFFERPROC)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+typedef void (APIENTRYP PFNGLGENQUERIESPROC)(GLsizei n, GLuint *ids);
+typedef void (APIENTRYP PFNGLDELETEQUERIESPROC)(GLsizei n, const GLuint *ids);
+typedef void (APIENTRYP PFNGLBEGINQUERYPROC)(GLenum target, GLuint id);
+typedef void (APIENTRYP PFNGLENDQUERYPROC)(GLenum target);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTIVPROC)(GLuint id, GLenum pname, GLint *params);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUI64VPROC)(GLuint id, GLenum pname, GLuint64 *params);
+
+/* Depth pre-pass */
+typedef void (APIENTRYP PFNGLCOLORMASKPROC)(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+typedef void (APIENTRYP PFNGLDEPTHMASKPROC)(GLboolean flag);
+
+/* Offscreen readback */
+typedef void (APIENTRYP PFNGLGENRENDERBUFFERSPROC)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRYP PFNGLDELETERENDERBUFFERSPROC)(GLsizei n, const GLuint* renderbuffers);
+typedef void (APIENTRYP PFNGLBINDRENDERBUFFERPROC)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRYP PFNGLRENDERBUFFERSTORAGEPROC)(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLFRAMEBUFFERRENDERBUFFERPROC)(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+typedef void (APIENTRYP PFNGLREADPIXELSPROC)(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+typedef void (APIENTRYP PFNGLPIXELSTOREIPROC)(GLenum pname, GLint param);
+typedef void* (APIENTRYP PFNGLMAPBUFFERRANGEPROC)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef GLboolean (APIENTRYP PFNGLUNMAPBUFFERPROC)(GLenum target);
+typedef GLsync (APIENTRYP PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef GLenum (APIENTRYP PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRYP PFNGLDELETESYNCPROC)(GLsync sync);
+
+/* Multi-draw */
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSPROC)(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount);
+
+/* Texture arrays */
+typedef void (APIENTRYP PFNGLTEXSUBIMAGE3DPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+
+/* Timer queries */
+typedef void (APIENTRYP PFNGLQUERYCOUNTERPROC)(GLuint id, GLenum target);
+
+/* Framebuffer objects */
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTURE2DPROC)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+
+/* Texture updates */
+typedef void (APIENTRYP PFNGLTEXSUBIMAGE2DPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+
+/* Occlusion culling */
+typedef void (APIENTRYP PFNGLBEGINCONDITIONALRENDERPROC)(GLuint id, GLenum mode);
+typedef void (APIENTRYP PFNGLENDCONDITIONALRENDERPROC)(void);
+typedef void (APIENTRYP PFNGLGETQUERYOBJECTUIVPROC)(GLuint id, GLenum pname, GLuint *params);
+typedef void (APIENTRYP PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC)(GLenum target, GLenum attachment, GLenum pname, GLint *params);
+
 /* Function pointers */
 GLAPI PFNGLCLEARPROC glad_glClear;
 GLAPI PFNGLCLEARCOLORPROC glad_glClearColor;
 GLAPI PFNGLVIEWPORTPROC glad_glViewport;
+GLAPI PFNGLSCISSORPROC glad_glScissor;
 GLAPI PFNGLENABLEPROC glad_glEnable;
 GLAPI PFNGLDISABLEPROC glad_glDisable;
 GLAPI PFNGLBLENDFUNCPROC glad_glBlendFunc;
@@ -276,10 +437,68 @@ GLAPI PFNGLGENERATEMIPMAPPROC glad_glGenerateMipmap;
 GLAPI PFNGLDRAWARRAYSPROC glad_glDrawArrays;
 GLAPI PFNGLDRAWELEMENTSPROC glad_glDrawElements;
 
+GLAPI PFNGLBUFFERSUBDATAPROC glad_glBufferSubData;
+GLAPI PFNGLTEXBUFFERPROC glad_glTexBuffer;
+GLAPI PFNGLVERTEXATTRIBIPOINTERPROC glad_glVertexAttribIPointer;
+
+GLAPI PFNGLGETINTEGERVPROC glad_glGetIntegerv;
+
+GLAPI PFNGLUNIFORM3IPROC glad_glUniform3i;
+
+GLAPI PFNGLGENFRAMEBUFFERSPROC glad_glGenFramebuffers;
+GLAPI PFNGLDELETEFRAMEBUFFERSPROC glad_glDeleteFramebuffers;
+GLAPI PFNGLBINDFRAMEBUFFERPROC glad_glBindFramebuffer;
+GLAPI PFNGLCHECKFRAMEBUFFERSTATUSPROC glad_glCheckFramebufferStatus;
+GLAPI PFNGLFRAMEBUFFERTEXTURELAYERPROC glad_glFramebufferTextureLayer;
+GLAPI PFNGLTEXIMAGE3DPROC glad_glTexImage3D;
+GLAPI PFNGLTEXPARAMETERFVPROC glad_glTexParameterfv;
+GLAPI PFNGLDRAWBUFFERPROC glad_glDrawBuffer;
+GLAPI PFNGLREADBUFFERPROC glad_glReadBuffer;
+GLAPI PFNGLPOLYGONOFFSETPROC glad_glPolygonOffset;
+GLAPI PFNGLBLITFRAMEBUFFERPROC glad_glBlitFramebuffer;
+GLAPI PFNGLGENQUERIESPROC glad_glGenQueries;
+GLAPI PFNGLDELETEQUERIESPROC glad_glDeleteQueries;
+GLAPI PFNGLBEGINQUERYPROC glad_glBeginQuery;
+GLAPI PFNGLENDQUERYPROC glad_glEndQuery;
+GLAPI PFNGLGETQUERYOBJECTIVPROC glad_glGetQueryObjectiv;
+GLAPI PFNGLGETQUERYOBJECTUI64VPROC glad_glGetQueryObjectui64v;
+
+GLAPI PFNGLCOLORMASKPROC glad_glColorMask;
+GLAPI PFNGLDEPTHMASKPROC glad_glDepthMask;
+
+GLAPI PFNGLGENRENDERBUFFERSPROC glad_glGenRenderbuffers;
+GLAPI PFNGLDELETERENDERBUFFERSPROC glad_glDeleteRenderbuffers;
+GLAPI PFNGLBINDRENDERBUFFERPROC glad_glBindRenderbuffer;
+GLAPI PFNGLRENDERBUFFERSTORAGEPROC glad_glRenderbufferStorage;
+GLAPI PFNGLFRAMEBUFFERRENDERBUFFERPROC glad_glFramebufferRenderbuffer;
+GLAPI PFNGLREADPIXELSPROC glad_glReadPixels;
+GLAPI PFNGLPIXELSTOREIPROC glad_glPixelStorei;
+GLAPI PFNGLMAPBUFFERRANGEPROC glad_glMapBufferRange;
+GLAPI PFNGLUNMAPBUFFERPROC glad_glUnmapBuffer;
+GLAPI PFNGLFENCESYNCPROC glad_glFenceSync;
+GLAPI PFNGLCLIENTWAITSYNCPROC glad_glClientWaitSync;
+GLAPI PFNGLDELETESYNCPROC glad_glDeleteSync;
+
+GLAPI PFNGLMULTIDRAWELEMENTSPROC glad_glMultiDrawElements;
+
+GLAPI PFNGLTEXSUBIMAGE3DPROC glad_glTexSubImage3D;
+
+GLAPI PFNGLQUERYCOUNTERPROC glad_glQueryCounter;
+
+GLAPI PFNGLFRAMEBUFFERTEXTURE2DPROC glad_glFramebufferTexture2D;
+
+GLAPI PFNGLTEXSUBIMAGE2DPROC glad_glTexSubImage2D;
+
+GLAPI PFNGLBEGINCONDITIONALRENDERPROC glad_glBeginConditionalRender;
+GLAPI PFNGLENDCONDITIONALRENDERPROC glad_glEndConditionalRender;
+GLAPI PFNGLGETQUERYOBJECTUIVPROC glad_glGetQueryObjectuiv;
+GLAPI PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC glad_glGetFramebufferAttachmentParameteriv;
+
 /* Macro aliases */
 #define glClear glad_glClear
 #define glClearColor glad_glClearColor
 #define glViewport glad_glViewport
+#define glScissor glad_glScissor
 #define glEnable glad_glEnable
 #define glDisable glad_glDisable
 #define glBlendFunc glad_glBlendFunc
@@ -337,6 +556,63 @@ GLAPI PFNGLDRAWELEMENTSPROC glad_glDrawElements;
 #define glDrawArrays glad_glDrawArrays
 #define glDrawElements glad_glDrawElements
 
+#define glBufferSubData glad_glBufferSubData
+#define glTexBuffer glad_glTexBuffer
+#define glVertexAttribIPointer glad_glVertexAttribIPointer
+
+#define glGetIntegerv glad_glGetIntegerv
+
+#define glUniform3i glad_glUniform3i
+
+#define glGenFramebuffers glad_glGenFramebuffers
+#define glDeleteFramebuffers glad_glDeleteFramebuffers
+#define glBindFramebuffer glad_glBindFramebuffer
+#define glCheckFramebufferStatus glad_glCheckFramebufferStatus
+#define glFramebufferTextureLayer glad_glFramebufferTextureLayer
+#define glTexImage3D glad_glTexImage3D
+#define glTexParameterfv glad_glTexParameterfv
+#define glDrawBuffer glad_glDrawBuffer
+#define glReadBuffer glad_glReadBuffer
+#define glPolygonOffset glad_glPolygonOffset
+#define glBlitFramebuffer glad_glBlitFramebuffer
+#define glGenQueries glad_glGenQueries
+#define glDeleteQueries glad_glDeleteQueries
+#define glBeginQuery glad_glBeginQuery
+#define glEndQuery glad_glEndQuery
+#define glGetQueryObjectiv glad_glGetQueryObjectiv
+#define glGetQueryObjectui64v glad_glGetQueryObjectui64v
+
+#define glColorMask glad_glColorMask
+#define glDepthMask glad_glDepthMask
+
+#define glGenRenderbuffers glad_glGenRenderbuffers
+#define glDeleteRenderbuffers glad_glDeleteRenderbuffers
+#define glBindRenderbuffer glad_glBindRenderbuffer
+#define glRenderbufferStorage glad_glRenderbufferStorage
+#define glFramebufferRenderbuffer glad_glFramebufferRenderbuffer
+#define glReadPixels glad_glReadPixels
+#define glPixelStorei glad_glPixelStorei
+#define glMapBufferRange glad_glMapBufferRange
+#define glUnmapBuffer glad_glUnmapBuffer
+#define glFenceSync glad_glFenceSync
+#define glClientWaitSync glad_glClientWaitSync
+#define glDeleteSync glad_glDeleteSync
+
+#define glMultiDrawElements glad_glMultiDrawElements
+
+#define glTexSubImage3D glad_glTexSubImage3D
+
+#define glQueryCounter glad_glQueryCounter
+
+#define glFramebufferTexture2D glad_glFramebufferTexture2D
+
+#define glTexSubImage2D glad_glTexSubImage2D
+
+#define glBeginConditionalRender glad_glBeginConditionalRender
+#define glEndConditionalRender glad_glEndConditionalRender
+#define glGetQueryObjectuiv glad_glGetQueryObjectuiv
+#define glGetFramebufferAttachmentParameteriv glad_glGetFramebufferAttachmentParameteriv
+
 /* Loader function */
 int gladLoadGLLoader(void* (*load)(const char *name));
 
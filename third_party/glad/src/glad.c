@@ -9,6 +9,7 @@
 PFNGLCLEARPROC glad_glClear = NULL;
 PFNGLCLEARCOLORPROC glad_glClearColor = NULL;
 PFNGLVIEWPORTPROC glad_glViewport = NULL;
+PFNGLSCISSORPROC glad_glScissor = NULL;
 PFNGLENABLEPROC glad_glEnable = NULL;
 PFNGLDISABLEPROC glad_glDisable = NULL;
 PFNGLBLENDFUNCPROC glad_glBlendFunc = NULL;
@@ -66,6 +67,63 @@ PFNGLGENERATEMIPMAPPROC glad_glGenerateMipmap = NULL;
 PFNGLDRAWARRAYSPROC glad_glDrawArrays = NULL;
 PFNGLDRAWELEMENTSPROC glad_glDrawElements = NULL;
 
+PFNGLBUFFERSUBDATAPROC glad_glBufferSubData = NULL;
+PFNGLTEXBUFFERPROC glad_glTexBuffer = NULL;
+PFNGLVERTEXATTRIBIPOINTERPROC glad_glVertexAttribIPointer = NULL;
+
+PFNGLGETINTEGERVPROC glad_glGetIntegerv = NULL;
+
+PFNGLUNIFORM3IPROC glad_glUniform3i = NULL;
+
+PFNGLGENFRAMEBUFFERSPROC glad_glGenFramebuffers = NULL;
+PFNGLDELETEFRAMEBUFFERSPROC glad_glDeleteFramebuffers = NULL;
+PFNGLBINDFRAMEBUFFERPROC glad_glBindFramebuffer = NULL;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC glad_glCheckFramebufferStatus = NULL;
+PFNGLFRAMEBUFFERTEXTURELAYERPROC glad_glFramebufferTextureLayer = NULL;
+PFNGLTEXIMAGE3DPROC glad_glTexImage3D = NULL;
+PFNGLTEXPARAMETERFVPROC glad_glTexParameterfv = NULL;
+PFNGLDRAWBUFFERPROC glad_glDrawBuffer = NULL;
+PFNGLREADBUFFERPROC glad_glReadBuffer = NULL;
+PFNGLPOLYGONOFFSETPROC glad_glPolygonOffset = NULL;
+PFNGLBLITFRAMEBUFFERPROC glad_glBlitFramebuffer = NULL;
+PFNGLGENQUERIESPROC glad_glGenQueries = NULL;
+PFNGLDELETEQUERIESPROC glad_glDeleteQueries = NULL;
+PFNGLBEGINQUERYPROC glad_glBeginQuery = NULL;
+PFNGLENDQUERYPROC glad_glEndQuery = NULL;
+PFNGLGETQUERYOBJECTIVPROC glad_glGetQueryObjectiv = NULL;
+PFNGLGETQUERYOBJECTUI64VPROC glad_glGetQueryObjectui64v = NULL;
+
+PFNGLCOLORMASKPROC glad_glColorMask = NULL;
+PFNGLDEPTHMASKPROC glad_glDepthMask = NULL;
+
+PFNGLGENRENDERBUFFERSPROC glad_glGenRenderbuffers = NULL;
+PFNGLDELETERENDERBUFFERSPROC glad_glDeleteRenderbuffers = NULL;
+PFNGLBINDRENDERBUFFERPROC glad_glBindRenderbuffer = NULL;
+PFNGLRENDERBUFFERSTORAGEPROC glad_glRenderbufferStorage = NULL;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glad_glFramebufferRenderbuffer = NULL;
+PFNGLREADPIXELSPROC glad_glReadPixels = NULL;
+PFNGLPIXELSTOREIPROC glad_glPixelStorei = NULL;
+PFNGLMAPBUFFERRANGEPROC glad_glMapBufferRange = NULL;
+PFNGLUNMAPBUFFERPROC glad_glUnmapBuffer = NULL;
+PFNGLFENCESYNCPROC glad_glFenceSync = NULL;
+PFNGLCLIENTWAITSYNCPROC glad_glClientWaitSync = NULL;
+PFNGLDELETESYNCPROC glad_glDeleteSync = NULL;
+
+PFNGLMULTIDRAWELEMENTSPROC glad_glMultiDrawElements = NULL;
+
+PFNGLTEXSUBIMAGE3DPROC glad_glTexSubImage3D = NULL;
+
+PFNGLQUERYCOUNTERPROC glad_glQueryCounter = NULL;
+
+PFNGLFRAMEBUFFERTEXTURE2DPROC glad_glFramebufferTexture2D = NULL;
+
+PFNGLTEXSUBIMAGE2DPROC glad_glTexSubImage2D = NULL;
+
+PFNGLBEGINCONDITIONALRENDERPROC glad_glBeginConditionalRender = NULL;
+PFNGLENDCONDITIONALRENDERPROC glad_glEndConditionalRender = NULL;
+PFNGLGETQUERYOBJECTUIVPROC glad_glGetQueryObjectuiv = NULL;
+PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC glad_glGetFramebufferAttachmentParameteriv = NULL;
+
 static void* (* glad_loader)(const char*) = NULL;
 
 static void* load(const char* name) {
@@ -79,6 +137,7 @@ int gladLoadGLLoader(void* (*loader)(const char *name)) {
     glad_glClear = (PFNGLCLEARPROC)load("glClear");
     glad_glClearColor = (PFNGLCLEARCOLORPROC)load("glClearColor");
     glad_glViewport = (PFNGLVIEWPORTPROC)load("glViewport");
+    glad_glScissor = (PFNGLSCISSORPROC)load("glScissor");
     glad_glEnable = (PFNGLENABLEPROC)load("glEnable");
     glad_glDisable = (PFNGLDISABLEPROC)load("glDisable");
     glad_glBlendFunc = (PFNGLBLENDFUNCPROC)load("glBlendFunc");
@@ -136,5 +195,62 @@ int gladLoadGLLoader(void* (*loader)(const char *name)) {
     glad_glDrawArrays = (PFNGLDRAWARRAYSPROC)load("glDrawArrays");
     glad_glDrawElements = (PFNGLDRAWELEMENTSPROC)load("glDrawElements");
 
+    glad_glBufferSubData = (PFNGLBUFFERSUBDATAPROC)load("glBufferSubData");
+    glad_glTexBuffer = (PFNGLTEXBUFFERPROC)load("glTexBuffer");
+    glad_glVertexAttribIPointer = (PFNGLVERTEXATTRIBIPOINTERPROC)load("glVertexAttribIPointer");
+
+    glad_glGetIntegerv = (PFNGLGETINTEGERVPROC)load("glGetIntegerv");
+
+    glad_glUniform3i = (PFNGLUNIFORM3IPROC)load("glUniform3i");
+
+    glad_glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)load("glGenFramebuffers");
+    glad_glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)load("glDeleteFramebuffers");
+    glad_glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)load("glBindFramebuffer");
+    glad_glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)load("glCheckFramebufferStatus");
+    glad_glFramebufferTextureLayer = (PFNGLFRAMEBUFFERTEXTURELAYERPROC)load("glFramebufferTextureLayer");
+    glad_glTexImage3D = (PFNGLTEXIMAGE3DPROC)load("glTexImage3D");
+    glad_glTexParameterfv = (PFNGLTEXPARAMETERFVPROC)load("glTexParameterfv");
+    glad_glDrawBuffer = (PFNGLDRAWBUFFERPROC)load("glDrawBuffer");
+    glad_glReadBuffer = (PFNGLREADBUFFERPROC)load("glReadBuffer");
+    glad_glPolygonOffset = (PFNGLPOLYGONOFFSETPROC)load("glPolygonOffset");
+    glad_glBlitFramebuffer = (PFNGLBLITFRAMEBUFFERPROC)load("glBlitFramebuffer");
+    glad_glGenQueries = (PFNGLGENQUERIESPROC)load("glGenQueries");
+    glad_glDeleteQueries = (PFNGLDELETEQUERIESPROC)load("glDeleteQueries");
+    glad_glBeginQuery = (PFNGLBEGINQUERYPROC)load("glBeginQuery");
+    glad_glEndQuery = (PFNGLENDQUERYPROC)load("glEndQuery");
+    glad_glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC)load("glGetQueryObjectiv");
+    glad_glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)load("glGetQueryObjectui64v");
+
+    glad_glColorMask = (PFNGLCOLORMASKPROC)load("glColorMask");
+    glad_glDepthMask = (PFNGLDEPTHMASKPROC)load("glDepthMask");
+
+    glad_glGenRenderbuffers = (PFNGLGENRENDERBUFFERSPROC)load("glGenRenderbuffers");
+    glad_glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC)load("glDeleteRenderbuffers");
+    glad_glBindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC)load("glBindRenderbuffer");
+    glad_glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC)load("glRenderbufferStorage");
+    glad_glFramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFERPROC)load("glFramebufferRenderbuffer");
+    glad_glReadPixels = (PFNGLREADPIXELSPROC)load("glReadPixels");
+    glad_glPixelStorei = (PFNGLPIXELSTOREIPROC)load("glPixelStorei");
+    glad_glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)load("glMapBufferRange");
+    glad_glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)load("glUnmapBuffer");
+    glad_glFenceSync = (PFNGLFENCESYNCPROC)load("glFenceSync");
+    glad_glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)load("glClientWaitSync");
+    glad_glDeleteSync = (PFNGLDELETESYNCPROC)load("glDeleteSync");
+
+    glad_glMultiDrawElements = (PFNGLMULTIDRAWELEMENTSPROC)load("glMultiDrawElements");
+
+    glad_glTexSubImage3D = (PFNGLTEXSUBIMAGE3DPROC)load("glTexSubImage3D");
+
+    glad_glQueryCounter = (PFNGLQUERYCOUNTERPROC)load("glQueryCounter");
+
+    glad_glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)load("glFramebufferTexture2D");
+
+    glad_glTexSubImage2D = (PFNGLTEXSUBIMAGE2DPROC)load("glTexSubImage2D");
+
+    glad_glBeginConditionalRender = (PFNGLBEGINCONDITIONALRENDERPROC)load("glBeginConditionalRender");
+    glad_glEndConditionalRender = (PFNGLENDCONDITIONALRENDERPROC)load("glEndConditionalRender");
+    glad_glGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVPROC)load("glGetQueryObjectuiv");
+    glad_glGetFramebufferAttachmentParameteriv = (PFNGLGETFRAMEBUFFERATTACHMENTPARAMETERIVPROC)load("glGetFramebufferAttachmentParameteriv");
+
     return glad_glClear != NULL;
 }
@@ -0,0 +1,214 @@
+// Headless batch thumbnails: renders every glTF file given (directories are
+// searched recursively) without a window and writes one PNG per model,
+// reporting images per second. The next file is parsed as a job while the
+// current one uploads and renders; PNG encoding runs on writer
+// threads behind asynchronous readback.
+//
+// Usage: teo_thumbnails [--size WxH] [--out dir] [--batch] <model.gltf/glb | dir> ...
+//
+// Runs on Mesa's llvmpipe through EGL's surfaceless platform, no GPU or
+// display server needed.
+
+#include "core/HeadlessContext.hpp"
+#include "core/JobSystem.hpp"
+#include "graphics/GpuDeletionQueue.hpp"
+#include "graphics/OffscreenCapture.hpp"
+#include "graphics/Renderer.hpp"
+#include "loader/GLTFLoader.hpp"
+#include "scene/Camera.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// GL object deletion time per image, the previous model's objects are freed while the next one loads
+constexpr double kDeleteBudgetMilliseconds = 2.0;
+
+bool isGltf(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".gltf" || ext == ".glb";
+}
+
+void collectInputs(const std::string& argument, std::vector<std::string>& files) {
+    std::error_code error;
+    if (!fs::is_directory(argument, error)) {
+        files.push_back(argument);
+        return;
+    }
+
+    std::vector<std::string> found;
+    for (const auto& entry : fs::recursive_directory_iterator(argument, error)) {
+        if (entry.is_regular_file() && isGltf(entry.path())) {
+            found.push_back(entry.path().string());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+}
+
+// Output name from the file stem, numbered when two inputs share a stem
+std::string outputPath(const fs::path& outDir, const std::string& input, std::set<std::string>& used) {
+    std::string stem = fs::path(input).stem().string();
+    std::string name = stem;
+    for (int n = 2; !used.insert(name).second; ++n) {
+        name = stem + "_" + std::to_string(n);
+    }
+    return (outDir / (name + ".png")).string();
+}
+
+// Three-quarter view from above, distance chosen so the bounding sphere fits the narrower fov
+void frameCamera(Camera& camera, const glm::vec3& min, const glm::vec3& max) {
+    const glm::vec3 center = (min + max) * 0.5f;
+    const float radius = std::max(glm::length(max - min) * 0.5f, 1.0e-3f);
+
+    const float verticalFov = glm::radians(camera.getFov());
+    const float horizontalFov = 2.0f * std::atan(std::tan(verticalFov * 0.5f) * camera.getAspect());
+    const float distance = radius / std::sin(std::min(verticalFov, horizontalFov) * 0.5f);
+
+    camera.setRotation(-60.0f, -25.0f);
+    camera.setPosition(center - camera.getForward() * distance);
+    camera.setClipPlanes(std::max(distance - radius * 1.1f, distance * 0.01f), distance + radius * 1.1f);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int width = 512;
+    int height = 512;
+    std::string outDir = "thumbnails";
+    std::vector<std::string> files;
+    GLTFLoader loader;
+    // Created here so this thread, which owns the GL context, is its main thread
+    JobSystem& jobs = JobSystem::instance();
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "Invalid --size, expected WxH" << std::endl;
+                return 1;
+            }
+            continue;
+        }
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+            continue;
+        }
+        if (std::strcmp(argv[i], "--batch") == 0) {
+            loader.setStaticBatching(true);
+            continue;
+        }
+        collectInputs(argv[i], files);
+    }
+
+    if (files.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--size WxH] [--out dir] [--batch] <model.gltf/glb | dir> ..." << std::endl;
+        return 1;
+    }
+
+    std::error_code error;
+    fs::create_directories(outDir, error);
+    if (error) {
+        std::cerr << "Failed to create " << outDir << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    HeadlessContext context;
+    if (!context.init()) {
+        return 1;
+    }
+
+    OffscreenCapture capture(width, height);
+    if (!capture.init()) {
+        return 1;
+    }
+
+    Renderer renderer;
+    if (!renderer.init()) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return 1;
+    }
+
+    Camera camera(45.0f, static_cast<float>(width) / height);
+    std::set<std::string> usedNames;
+    size_t skipped = 0;
+
+    using Clock = std::chrono::steady_clock;
+    double waitSeconds = 0.0;
+    double uploadSeconds = 0.0;
+    double renderSeconds = 0.0;
+    const auto start = Clock::now();
+
+    // Parse runs one file ahead of upload and render
+    ParsedGltf next;
+    JobCounter parsing;
+    auto parseAhead = [&jobs, &loader, &next, &parsing](const std::string& path) {
+        jobs.run([&loader, &next, path] { next = loader.parse(path); }, &parsing);
+    };
+    parseAhead(files[0]);
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto t0 = Clock::now();
+        GpuDeletionQueue::endFrame();
+        GpuDeletionQueue::collect(kDeleteBudgetMilliseconds);
+        jobs.wait(parsing);
+        ParsedGltf parsed = std::move(next);
+        if (i + 1 < files.size()) {
+            parseAhead(files[i + 1]);
+        }
+        auto t1 = Clock::now();
+
+        std::vector<std::unique_ptr<Model>> models;
+        if (auto model = loader.upload(std::move(parsed))) {
+            models.push_back(std::move(model));
+        }
+        glm::vec3 min, max;
+        if (models.empty() || !models[0]->computeBounds(min, max)) {
+            std::cerr << "Skipping " << files[i] << std::endl;
+            ++skipped;
+            continue;
+        }
+        auto t2 = Clock::now();
+
+        frameCamera(camera, min, max);
+        renderer.invalidateShadowCache();
+        capture.bind();
+        renderer.render(camera, models);
+        capture.capture(outputPath(outDir, files[i], usedNames));
+        auto t3 = Clock::now();
+
+        waitSeconds += std::chrono::duration<double>(t1 - t0).count();
+        uploadSeconds += std::chrono::duration<double>(t2 - t1).count();
+        renderSeconds += std::chrono::duration<double>(t3 - t2).count();
+    }
+
+    capture.finish();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const size_t written = capture.getWrittenCount();
+    const size_t rendered = files.size() - skipped;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "\nThumbnails: " << written << " written, " << skipped + capture.getFailedCount() << " failed, "
+              << width << "x" << height << " -> " << outDir << std::endl;
+    std::cout << "  " << seconds << " s, " << (seconds > 0.0 ? written / seconds : 0.0) << " images/s" << std::endl;
+    if (rendered > 0) {
+        std::cout << "  per image: parse wait " << waitSeconds * 1000.0 / rendered << " ms, upload "
+                  << uploadSeconds * 1000.0 / rendered << " ms, render + readback "
+                  << renderSeconds * 1000.0 / rendered << " ms" << std::endl;
+    }
+
+    return written == files.size() ? 0 : 1;
+}